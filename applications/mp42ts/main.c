@@ -36,6 +36,9 @@
 #define MP42TS_PRINT_FREQ 634 /*refresh printed info every CLOCK_REFRESH ms*/
 #define MP42TS_VIDEO_FREQ 1000 /*meant to send AVC IDR only every CLOCK_REFRESH ms*/
 
+#define MP42TS_PCK_PER_DGRAM 7 /*number of TS packets per UDP datagram or RTP packet*/
+#define MP42TS_DGRAM_PER_BATCH 16 /*number of datagrams fetched from the muxer and sent at once*/
+
 static GFINLINE void usage(const char * progname) 
 {
 	fprintf(stderr, "USAGE: %s -rate=R [[-prog=prog1]..[-prog=progn]] [-audio=url] [-video=url] [-mpeg4-carousel=n] [-mpeg4] [-time=n] [-src=file] DST [[DST]]\n"
@@ -137,10 +140,9 @@ static GF_Err mp4_input_ctrl(GF_ESInterface *ifce, u32 act_type, void *param)
 	case GF_ESI_INPUT_DATA_FLUSH:
 	{
 		GF_ESIPacket pck;
-		if (!priv->sample) 
-			priv->sample = gf_isom_get_sample(priv->mp4, priv->track, priv->sample_number+1, NULL);
-
-		if (!priv->sample) return GF_IO_ERR;
+		/*the sample is reused and its data lent by the file when possible, the muxer copies it*/
+		if (!gf_isom_get_sample_ex(priv->mp4, priv->track, priv->sample_number+1, NULL, priv->sample, 1)) 
+			return GF_IO_ERR;
 
 		pck.flags = 0;
 		pck.flags = GF_ESI_DATA_AU_START | GF_ESI_DATA_HAS_CTS;
@@ -202,7 +204,7 @@ static GF_Err mp4_input_ctrl(GF_ESInterface *ifce, u32 act_type, void *param)
 			ifce->output_ctrl(ifce, GF_ESI_OUTPUT_DATA_DISPATCH, &pck);
 		}
 
-		gf_isom_sample_del(&priv->sample);
+		gf_isom_sample_release(priv->sample);
 		priv->sample_number++;
 		if (priv->sample_number==priv->sample_count) {
 			if (priv->loop) {
@@ -226,6 +228,7 @@ static GF_Err mp4_input_ctrl(GF_ESInterface *ifce, u32 act_type, void *param)
 		return GF_OK;
 
 	case GF_ESI_INPUT_DESTROY:
+		if (priv->sample) gf_isom_sample_del(&priv->sample);
 		if (priv->dsi) gf_free(priv->dsi);
 		if (ifce->decoder_config) {
 			gf_free(ifce->decoder_config);
@@ -250,6 +253,7 @@ static void fill_isom_es_ifce(GF_ESInterface *ifce, GF_ISOFile *mp4, u32 track_n
 
 	priv->mp4 = mp4;
 	priv->track = track_num;
+	priv->sample = gf_isom_sample_new();
 	priv->loop = 1;
 	priv->sample_count = gf_isom_get_sample_count(mp4, track_num);
 
@@ -1553,12 +1557,50 @@ static GF_Err write_manifest(char *manifest, char *segment_dir, u32 segment_dura
 	}
 }
 
+/*sends the packets on the network outputs, MP42TS_PCK_PER_DGRAM packets per datagram or RTP packet*/
+static void send_packets(GF_Socket *udp_sk, GF_RTPChannel *rtp, GF_RTPHeader *hdr, GF_M2TS_Mux *muxer, char *pck, u32 nb_pck)
+{
+	const char *dgrams[MP42TS_DGRAM_PER_BATCH];
+	u32 dgram_sizes[MP42TS_DGRAM_PER_BATCH];
+	u32 i, nb_dgrams, nb_sent, ts;
+	GF_Err e;
+
+	nb_dgrams = 0;
+	for (i=0; i<nb_pck; i+=MP42TS_PCK_PER_DGRAM) {
+		dgrams[nb_dgrams] = pck + 188*i;
+		dgram_sizes[nb_dgrams] = 188 * MIN(MP42TS_PCK_PER_DGRAM, nb_pck - i);
+		nb_dgrams++;
+	}
+	if (udp_sk != NULL) {
+		e = gf_sk_send_multiple(udp_sk, dgrams, dgram_sizes, nb_dgrams, &nb_sent); 
+		if (e) {
+			fprintf(stderr, "Error %s sending UDP packet - %d datagrams out of %d not sent\n", gf_error_to_string(e), nb_dgrams - nb_sent, nb_dgrams);
+		}
+	}
+	if (rtp != NULL) {
+		/*muxer clock at 90k*/
+		ts = muxer->time.sec*90000 + muxer->time.nanosec*9/100000;
+		/*FIXME - better discontinuity check*/
+		hdr->Marker = (ts < hdr->TimeStamp) ? 1 : 0;
+		hdr->TimeStamp = ts;
+		for (i=0; i<nb_dgrams; i++) {
+			hdr->SequenceNumber++;
+			e = gf_rtp_send_packet(rtp, hdr, (char *) dgrams[i], dgram_sizes[i], 0);
+			if (e) {
+				fprintf(stderr, "Error %s sending RTP packet\n", gf_error_to_string(e));
+			}
+			hdr->Marker = 0;
+		}
+	}
+}
+
 int main(int argc, char **argv)
 {
 	/********************/
 	/*   declarations   */
 	/********************/
-	const char *ts_pck;
+	char ts_pck[188*MP42TS_PCK_PER_DGRAM*MP42TS_DGRAM_PER_BATCH];
+	u32 nb_pck, max_pck, nb_pending, nb_sent;
 	GF_Err e;
 	u32 run_time;
 	Bool real_time;
@@ -1597,6 +1639,7 @@ int main(int argc, char **argv)
 	/***********************/
 	real_time = 0;	
 	ts_output_file = NULL;
+	nb_pending = 0;
 	video_buffer = NULL;
 	last_video_time = 0;
 	audio_input_type = 0;
@@ -1782,7 +1825,7 @@ int main(int argc, char **argv)
 	/*****************/
 	last_print_time = gf_sys_clock();
 	while (run) {
-		u32 ts, status;
+		u32 status;
 
 		/*check for some audio input from the network*/
 		if (audio_input_ip) {
@@ -1815,10 +1858,11 @@ int main(int argc, char **argv)
 			}
 		}
 
-		/*flush all packets*/
-		while ((ts_pck = gf_m2ts_mux_process(muxer, &status)) != NULL) {
+		/*flush all packets - segments are cut on a packet basis*/
+		max_pck = segment_duration ? 1 : MP42TS_PCK_PER_DGRAM*MP42TS_DGRAM_PER_BATCH - nb_pending;
+		while ((nb_pck = gf_m2ts_mux_process_packets(muxer, ts_pck + 188*nb_pending, max_pck, &status)) != 0) {
 			if (ts_output_file != NULL) {
-				fwrite(ts_pck, 1, 188, ts_output_file); 
+				fwrite(ts_pck + 188*nb_pending, 188, nb_pck, ts_output_file); 
 				if (segment_duration && (muxer->time.sec > prev_seg_time.sec + segment_duration)) {
 					prev_seg_time = muxer->time;
 					fclose(ts_output_file);
@@ -1857,27 +1901,20 @@ int main(int argc, char **argv)
 				} 
 			}
 
-			if (ts_output_udp_sk != NULL) {
-				e = gf_sk_send(ts_output_udp_sk, (char*)ts_pck, 188); 
-				if (e) {
-					fprintf(stderr, "Error %s sending UDP packet\n", gf_error_to_string(e));
-				}
-			}
-			if (ts_output_rtp != NULL) {
-				hdr.SequenceNumber++;
-				/*muxer clock at 90k*/
-				ts = muxer->time.sec*90000 + muxer->time.nanosec*9/100000;
-				/*FIXME - better discontinuity check*/
-				hdr.Marker = (ts < hdr.TimeStamp) ? 1 : 0;
-				hdr.TimeStamp = ts;
-				e = gf_rtp_send_packet(ts_output_rtp, &hdr, (char*)ts_pck, 188, 0);
-				if (e) {
-					fprintf(stderr, "Error %s sending RTP packet\n", gf_error_to_string(e));
+			if (ts_output_udp_sk || ts_output_rtp) {
+				/*only full datagrams are sent, the remaining packets wait for the next round*/
+				nb_pending += nb_pck;
+				nb_sent = nb_pending - (nb_pending % MP42TS_PCK_PER_DGRAM);
+				if (nb_sent) {
+					send_packets(ts_output_udp_sk, ts_output_rtp, &hdr, muxer, ts_pck, nb_sent);
+					nb_pending -= nb_sent;
+					memmove(ts_pck, ts_pck + 188*nb_sent, 188*nb_pending);
 				}
 			}
-			if (status>=GF_M2TS_STATE_PADDING) {
+			if ((nb_pck<max_pck) || (status>=GF_M2TS_STATE_PADDING)) {
 				break;
 			}
+			if (!segment_duration) max_pck = MP42TS_PCK_PER_DGRAM*MP42TS_DGRAM_PER_BATCH - nb_pending;
 		}
 
 		/*push video*/
@@ -1913,6 +1950,8 @@ int main(int argc, char **argv)
 			break;
 		}
 	}
+	/*send the last incomplete datagram*/
+	if (nb_pending) send_packets(ts_output_udp_sk, ts_output_rtp, &hdr, muxer, ts_pck, nb_pending);
 
 
 exit:
@@ -2363,7 +2363,7 @@ static void mpd_duration(Double duration, char *duration_string)
 	Double s;
 
 	h = (u32) (duration/3600);
-	m = (u32) (duration-h*60)/60;
+	m = (u32) (duration-h*3600)/60;
 	s = (duration - h*3600 - m*60);
 	if (h) sprintf(duration_string, "PT%dH%dM%.2fS", h, m, s);	
 	else if (m) sprintf(duration_string, "PT%dM%.2fS", m, s);	
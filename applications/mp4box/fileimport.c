@@ -1285,6 +1285,47 @@ err_exit:
 	return e;
 }
 
+/*DASH-ing with the live segmenter: segments are produced as samples are appended to the input (typically a
+fragmented file being recorded). Segmenting ends once no sample was appended for timeout_ms*/
+GF_Err dash_live_file(GF_ISOFile *input, char *outfile, Double InterleavingTime, Double dash_duration, Bool seg_at_rap, u32 frags_per_sidx, Bool daisy_chain_sidx, char *seg_name, char *seg_ext, u32 timeout_ms)
+{
+	GF_Err e;
+	u32 i, nb_samples, prev_nb_samples, last_update;
+	GF_DASHLiveSegmenter *dasher = gf_dash_live_new(outfile, seg_name, seg_ext, InterleavingTime, dash_duration, seg_at_rap, frags_per_sidx, daisy_chain_sidx);
+	if (!dasher) return GF_IO_ERR;
+
+	e = GF_OK;
+	for (i=0; i<gf_isom_get_track_count(input); i++) {
+		if (gf_isom_get_media_type(input, i+1) == GF_ISOM_MEDIA_HINT) continue;
+		e = gf_dash_live_add_track(dasher, input, i+1, NULL);
+		if (e) goto exit;
+	}
+
+	prev_nb_samples = 0;
+	last_update = gf_sys_clock();
+	while (1) {
+		e = gf_dash_live_process_input(dasher, input);
+		if (e) goto exit;
+		/*nothing more will come*/
+		if (!gf_isom_is_fragmented(input)) break;
+
+		nb_samples = 0;
+		for (i=0; i<gf_isom_get_track_count(input); i++) nb_samples += gf_isom_get_sample_count(input, i+1);
+		if (nb_samples != prev_nb_samples) {
+			prev_nb_samples = nb_samples;
+			last_update = gf_sys_clock();
+		} else if (gf_sys_clock() - last_update > timeout_ms) {
+			break;
+		}
+		gf_sleep(10);
+	}
+	e = gf_dash_live_close(dasher);
+
+exit:
+	gf_dash_live_del(dasher);
+	return e;
+}
+
 GF_Err cat_multiple_files(GF_ISOFile *dest, char *fileName, u32 import_flags, Double force_fps, u32 frames_per_sample, char *tmp_dir, Bool force_cat);
 
 GF_Err cat_isomedia_file(GF_ISOFile *dest, char *fileName, u32 import_flags, Double force_fps, u32 frames_per_sample, char *tmp_dir, Bool force_cat)
@@ -50,6 +50,7 @@ void convert_file_info(char *inName, u32 trackID);
 GF_Err import_file(GF_ISOFile *dest, char *inName, u32 import_flags, Double force_fps, u32 frames_per_sample);
 GF_Err split_isomedia_file(GF_ISOFile *mp4, Double split_dur, u32 split_size_kb, char *inName, Double InterleavingTime, Double chunk_start, const char *tmpdir);
 GF_Err cat_isomedia_file(GF_ISOFile *mp4, char *fileName, u32 import_flags, Double force_fps, u32 frames_per_sample, char *tmp_dir, Bool force_cat);
+GF_Err dash_live_file(GF_ISOFile *input, char *outfile, Double InterleavingTime, Double dash_duration, Bool seg_at_rap, u32 frags_per_sidx, Bool daisy_chain_sidx, char *seg_name, char *seg_ext, u32 timeout_ms);
 
 #ifndef GPAC_DISABLE_SCENE_ENCODER
 GF_Err EncodeFile(char *in, GF_ISOFile *mp4, GF_SMEncodeOptions *opts, FILE *logs);
@@ -243,6 +244,14 @@ void PrintGeneralUsage()
 			"                       Ignored if segments are stored in the output file.\n"
 			" -daisy-chain         Uses daisy-chain SIDX instead of hierarchical. Ignored if frags/sidx is 0.\n"
 			" -dash-ctx FILE       Stores/restore DASH timing from FILE.\n"
+			" -dash-rep FILE       adds FILE as an alternate representation of the input file in the MPD.\n"
+			"                       Can be used several times. Segments are aligned on the input file.\n"
+			"                       Ignores -dash-ctx.\n"
+			" -dash-threads N      number of threads used to DASH representations. Default is one per CPU,\n"
+			"                       and never more than one per file\n"
+			" -dash-live T         uses the live segmenter: segments and MPD are written as samples are appended\n"
+			"                       to the input, which can be a fragmented file being recorded. DASH-ing ends\n"
+			"                       when no sample was appended for T milliseconds. Ignores -dash-ctx and -dash-rep.\n"
 			"\n");
 }
 
@@ -1222,6 +1231,10 @@ int mp4boxMain(int argc, char **argv)
 	Bool use_url_template=0;
 	Bool seg_at_rap =0;
 	char *seg_ext = "m4s";
+	char *dash_reps[MAX_CUMUL_OPS];
+	u32 nb_dash_reps = 0;
+	u32 dash_threads = 0;
+	u32 dash_live_timeout = 0;
 
 	if (argc < 2) {
 		PrintUsage();
@@ -1501,6 +1514,24 @@ int mp4boxMain(int argc, char **argv)
 			CHECK_NEXT_ARG
 			dash_ctx = argv[i+1];
 			i++;
+		} else if (!stricmp(arg, "-dash-rep")) {
+			CHECK_NEXT_ARG
+			if (nb_dash_reps>=MAX_CUMUL_OPS-1) {
+				fprintf(stdout, "Sorry - no more than %d representations allowed\n", MAX_CUMUL_OPS-1);
+				return 1;
+			}
+			dash_reps[nb_dash_reps] = argv[i+1];
+			nb_dash_reps++;
+			i++;
+		} else if (!stricmp(arg, "-dash-threads")) {
+			CHECK_NEXT_ARG
+			dash_threads = atoi(argv[i+1]);
+			i++;
+		} else if (!stricmp(arg, "-dash-live")) {
+			CHECK_NEXT_ARG
+			dash_live_timeout = atoi(argv[i+1]);
+			if (!dash_live_timeout) dash_live_timeout = 1;
+			i++;
 		} else if (!stricmp(arg, "-daisy-chain")) {
 			daisy_chain_sidx = 1;
 		} else if (!stricmp(arg, "-url-template")) {
@@ -3049,7 +3080,56 @@ int mp4boxMain(int argc, char **argv)
 		while (outfile[strlen(outfile)-1] != '.') outfile[strlen(outfile)-1] = 0;
 		outfile[strlen(outfile)-1] = 0;
 		if (!outName) strcat(outfile, "_dash");
-		e = gf_media_fragment_file(file, outfile, InterleavingTime, seg_at_rap ? 2 : 1, dash_duration, seg_name, seg_ext, frags_per_sidx, daisy_chain_sidx, use_url_template, dash_ctx);
+		if (dash_live_timeout) {
+			e = dash_live_file(file, outfile, InterleavingTime, dash_duration, seg_at_rap, frags_per_sidx, daisy_chain_sidx, seg_name, seg_ext, dash_live_timeout);
+		} else if (nb_dash_reps) {
+			GF_ISOFile *rep_files[MAX_CUMUL_OPS];
+			char *rep_outs[MAX_CUMUL_OPS], *rep_segs[MAX_CUMUL_OPS];
+			char szMPD[GF_MAX_PATH];
+			u32 nb_reps = 1;
+
+			memset(rep_outs, 0, sizeof(char *)*MAX_CUMUL_OPS);
+			memset(rep_segs, 0, sizeof(char *)*MAX_CUMUL_OPS);
+			rep_files[0] = file;
+			rep_outs[0] = gf_strdup(outfile);
+			e = GF_OK;
+			for (i=0; i<nb_dash_reps; i++) {
+				char szRep[GF_MAX_PATH];
+				rep_files[nb_reps] = gf_isom_open(dash_reps[i], GF_ISOM_OPEN_READ, NULL);
+				if (!rep_files[nb_reps]) {
+					e = gf_isom_last_error(NULL);
+					fprintf(stdout, "Error opening representation %s: %s\n", dash_reps[i], gf_error_to_string(e));
+					break;
+				}
+				strcpy(szRep, dash_reps[i]);
+				if (strrchr(szRep, '.')) strrchr(szRep, '.')[0] = 0;
+				strcat(szRep, "_dash");
+				rep_outs[nb_reps] = gf_strdup(szRep);
+				nb_reps++;
+			}
+			if (seg_name) {
+				for (i=0; i<nb_reps; i++) {
+					char szSeg[GF_MAX_PATH];
+					sprintf(szSeg, "%s_rep%d", seg_name, i+1);
+					rep_segs[i] = gf_strdup(szSeg);
+				}
+			}
+			if (!e && (strlen(outfile) + 5 > GF_MAX_PATH)) {
+				fprintf(stdout, "Output name %s too long\n", outfile);
+				e = GF_BAD_PARAM;
+			}
+			if (!e) {
+				sprintf(szMPD, "%s.mpd", outfile);
+				e = gf_media_fragment_files(rep_files, rep_outs, seg_name ? rep_segs : NULL, nb_reps, szMPD, InterleavingTime, seg_at_rap ? 2 : 1, dash_duration, seg_ext, frags_per_sidx, daisy_chain_sidx, use_url_template, dash_threads);
+			}
+			for (i=0; i<nb_reps; i++) {
+				if (i) gf_isom_delete(rep_files[i]);
+				if (rep_outs[i]) gf_free(rep_outs[i]);
+				if (rep_segs[i]) gf_free(rep_segs[i]);
+			}
+		} else {
+			e = gf_media_fragment_file(file, outfile, InterleavingTime, seg_at_rap ? 2 : 1, dash_duration, seg_name, seg_ext, frags_per_sidx, daisy_chain_sidx, use_url_template, dash_ctx);
+		}
 		if (e) fprintf(stdout, "Error while DASH-ing file: %s\n", gf_error_to_string(e));
 		gf_isom_delete(file);
 		gf_sys_close();
@@ -0,0 +1,190 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Copyright (c) ENST 2007-200X
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / bitstream reader benchmark
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+#include <gpac/internal/media_dev.h>
+#include <gpac/constants.h>
+
+/*Exp-Golomb reader working the same way as the H264 parser: peek a byte to count leading zeros then read the code at once*/
+static u32 get_ue(GF_BitStream *bs)
+{
+	u32 nb_zeros = 0, coded = 0, read = 0;
+	while (gf_bs_available(bs)) {
+		read = gf_bs_peek_bits(bs, 8, 0);
+		if (read) break;
+		gf_bs_read_int(bs, 8);
+		nb_zeros += 8;
+	}
+	while (read && !(read & 0x80)) {
+		read <<= 1;
+		coded++;
+	}
+	gf_bs_read_int(bs, coded);
+	nb_zeros += coded;
+	return gf_bs_read_int(bs, nb_zeros + 1) - 1;
+}
+
+/*locates the next 3 bytes start code - kept local so that the benchmark can be built against older libraries*/
+static u32 next_start_code(const u8 *data, u32 data_len)
+{
+	u32 i;
+	for (i=0; i+2<data_len; i++) {
+		if (!data[i] && !data[i+1] && (data[i+2]==1)) return i;
+	}
+	return data_len;
+}
+
+/*builds a buffer of Exp-Golomb codes with small values, as found in parameter sets and slice headers*/
+static u32 build_golomb(u8 *data, u32 size)
+{
+	u32 nb_codes = 0, seed = 1;
+	GF_BitStream *bs = gf_bs_new((char *) data, size, GF_BITSTREAM_WRITE);
+	/*keep room for the last code*/
+	while (gf_bs_get_position(bs) + 8 < size) {
+		u32 v, nb_bits;
+		seed = seed * 1103515245 + 12345;
+		v = ((seed >> 16) & 0x3FF) >> ((seed >> 8) & 7);
+		nb_bits = 0;
+		while ((v+1) >> (nb_bits+1)) nb_bits++;
+		if (nb_bits) gf_bs_write_int(bs, 0, nb_bits);
+		gf_bs_write_int(bs, v+1, nb_bits+1);
+		nb_codes++;
+	}
+	gf_bs_del(bs);
+	return nb_codes;
+}
+
+static void usage()
+{
+	fprintf(stdout, "Usage: bench_bitstream [options] [input_file]\n"
+		"\n"
+		"Measures the memory bitstream reader throughput on Exp-Golomb codes and, if an\n"
+		"H264 Annex-B file is given, on its SPS, PPS and slice headers.\n"
+		"Only public functions are used: build against another library version to compare\n"
+		"\n"
+		"-loops N:   number of runs (default 20)\n"
+		"\n"
+	);
+}
+
+int main(int argc, char **argv)
+{
+	u8 *data;
+	u32 i, size, loops, nb_codes, time;
+	u64 sum;
+	char *input = NULL;
+
+	loops = 20;
+	for (i=1; i<(u32) argc; i++) {
+		char *arg = argv[i];
+		if (!strcmp(arg, "-h")) { usage(); return 0; }
+		else if (!strcmp(arg, "-loops") && (i+1<(u32) argc)) loops = atoi(argv[++i]);
+		else input = arg;
+	}
+
+	gf_sys_init(0);
+
+	/*Exp-Golomb decoding*/
+	size = 1024*1024;
+	data = (u8 *) malloc(sizeof(u8) * size);
+	memset(data, 0, size);
+	nb_codes = build_golomb(data, size);
+
+	sum = 0;
+	time = gf_sys_clock();
+	for (i=0; i<loops; i++) {
+		u32 j;
+		GF_BitStream *bs = gf_bs_new((char *) data, size, GF_BITSTREAM_READ);
+		for (j=0; j<nb_codes; j++) sum += get_ue(bs);
+		gf_bs_del(bs);
+	}
+	time = gf_sys_clock() - time;
+	fprintf(stdout, "%d Exp-Golomb codes - %d loops - checksum "LLU"\n", nb_codes, loops, sum);
+	fprintf(stdout, "Exp-Golomb decoding: %d ms (%.2f Mcodes/s)\n", time, time ? ((Double) nb_codes) * loops / 1000 / time : 0);
+	free(data);
+
+	/*H264 parameter sets and slice headers*/
+	if (input) {
+		u32 nb_nalus, nb_slices;
+		AVCState *avc;
+		FILE *f = fopen(input, "rb");
+		if (!f) {
+			fprintf(stderr, "Cannot open %s\n", input);
+			gf_sys_close();
+			return 1;
+		}
+		fseek(f, 0, SEEK_END);
+		size = (u32) ftell(f);
+		fseek(f, 0, SEEK_SET);
+		data = (u8 *) malloc(sizeof(u8) * size);
+		size = (u32) fread(data, 1, size, f);
+		fclose(f);
+
+		avc = (AVCState *) malloc(sizeof(AVCState));
+		nb_nalus = nb_slices = 0;
+		time = gf_sys_clock();
+		for (i=0; i<loops; i++) {
+			u32 pos;
+			memset(avc, 0, sizeof(AVCState));
+			pos = next_start_code(data, size);
+			while (pos < size) {
+				u32 nal_size, nal_type;
+				u8 *nal;
+				pos += 3;
+				nal = data + pos;
+				nal_size = next_start_code(nal, size - pos);
+				pos += nal_size;
+				/*trailing zero of a 4 bytes start code*/
+				while (nal_size && !nal[nal_size-1]) nal_size--;
+				if (nal_size < 2) continue;
+
+				nal_type = nal[0] & 0x1F;
+				switch (nal_type) {
+				case GF_AVC_NALU_SEQ_PARAM:
+					AVC_ReadSeqInfo((char *) nal+1, nal_size-1, avc, 0, NULL);
+					break;
+				case GF_AVC_NALU_PIC_PARAM:
+					AVC_ReadPictParamSet((char *) nal+1, nal_size-1, avc);
+					break;
+				case GF_AVC_NALU_NON_IDR_SLICE:
+				case GF_AVC_NALU_IDR_SLICE:
+				{
+					GF_BitStream *bs = gf_bs_new((char *) nal+1, nal_size-1, GF_BITSTREAM_READ);
+					AVC_ParseNALU(bs, nal[0], avc);
+					gf_bs_del(bs);
+					if (!i) nb_slices++;
+				}
+					break;
+				}
+				if (!i) nb_nalus++;
+			}
+		}
+		time = gf_sys_clock() - time;
+		fprintf(stdout, "%s: %d NAL units - %d slices - %d loops\n", input, nb_nalus, nb_slices, loops);
+		fprintf(stdout, "H264 headers parsing: %d ms (%.2f kNALU/s)\n", time, time ? ((Double) nb_nalus) * loops / time : 0);
+		free(avc);
+		free(data);
+	}
+
+	gf_sys_close();
+	return 0;
+}
@@ -0,0 +1,238 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Copyright (c) ENST 2007-200X
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / color conversion benchmark
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+#include <gpac/color.h>
+#include <gpac/constants.h>
+
+/*straightforward pixel by pixel converter, only used to check the output of gf_stretch_bits. This is not the
+scalar code of gf_stretch_bits and is not timed*/
+static s32 RGB_Y[256], B_U[256], G_U[256], G_V[256], R_V[256];
+
+#define SCALEBITS_OUT	13
+#define FIX_OUT(x)		((unsigned short) ((x) * (1L<<SCALEBITS_OUT) + 0.5))
+#define col_clip(a)		MAX(0, MIN(255, a))
+
+static void ref_init()
+{
+	s32 i;
+	for (i=0; i<256; i++) {
+		RGB_Y[i] = FIX_OUT(1.164) * (i - 16);
+		B_U[i] = FIX_OUT(2.018) * (i - 128);
+		G_U[i] = FIX_OUT(0.391) * (i - 128);
+		G_V[i] = FIX_OUT(0.813) * (i - 128);
+		R_V[i] = FIX_OUT(1.596) * (i - 128);
+	}
+}
+
+static void ref_pixel(u8 *rgb, u8 y, u8 u, u8 v)
+{
+	s32 rgb_y = RGB_Y[y];
+	rgb[0] = col_clip( (rgb_y + R_V[v]) >> SCALEBITS_OUT);
+	rgb[1] = col_clip( (rgb_y - G_U[u] - G_V[v]) >> SCALEBITS_OUT);
+	rgb[2] = col_clip( (rgb_y + B_U[u]) >> SCALEBITS_OUT);
+}
+
+/*pixel by pixel conversion with the nearest neighbour scaling of gf_stretch_bits*/
+static void ref_convert(GF_VideoSurface *dst, GF_VideoSurface *src)
+{
+	u32 i, j, bpp;
+	s32 inc_x = (src->width << 16) / dst->width;
+	s32 inc_y = (src->height << 16) / dst->height;
+	bpp = (dst->pixel_format==GF_PIXEL_RGB_24) ? 3 : 4;
+
+	for (j=0; j<dst->height; j++) {
+		u32 row = (u32) (((u64) j * inc_y) >> 16);
+		u8 *out = (u8 *) dst->video_buffer + j*dst->pitch_y;
+		for (i=0; i<dst->width; i++) {
+			u8 rgb[3], y, u, v;
+			u32 col = (u32) (((u64) i * inc_x) >> 16);
+			if (src->pixel_format==GF_PIXEL_YUY2) {
+				u8 *p = (u8 *) src->video_buffer + row*src->pitch_y + 4*(col/2);
+				y = p[2*(col%2)];
+				u = p[1];
+				v = p[3];
+			} else {
+				u8 *pY = (u8 *) src->video_buffer;
+				u8 *pU = pY + src->pitch_y*src->height;
+				u8 *pV = pU + src->pitch_y*src->height/4;
+				y = pY[row*src->pitch_y + col];
+				u = pU[(row/2)*src->pitch_y/2 + col/2];
+				v = pV[(row/2)*src->pitch_y/2 + col/2];
+			}
+			ref_pixel(rgb, y, u, v);
+			switch (dst->pixel_format) {
+			case GF_PIXEL_RGB_32:
+				out[0] = rgb[2]; out[1] = rgb[1]; out[2] = rgb[0]; out[3] = 0xFF;
+				break;
+			case GF_PIXEL_RGBA:
+				out[0] = rgb[0]; out[1] = rgb[1]; out[2] = rgb[2]; out[3] = 0xFF;
+				break;
+			default:
+				out[0] = rgb[0]; out[1] = rgb[1]; out[2] = rgb[2];
+				break;
+			}
+			out += bpp;
+		}
+	}
+}
+
+/*builds a frame with smooth gradients, noise and saturated areas*/
+static void build_frame(u8 *data, u32 size)
+{
+	u32 i, seed = 1;
+	for (i=0; i<size; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (u8) ( (i/7) + ((seed >> 16) & 0x1F) );
+		if ((seed >> 24) < 8) data[i] = (seed & 0x100) ? 0xFF : 0;
+	}
+}
+
+static const char *fmt_name(u32 pf)
+{
+	switch (pf) {
+	case GF_PIXEL_I420: return "I420";
+	case GF_PIXEL_YUY2: return "YUY2";
+	case GF_PIXEL_RGB_24: return "RGB24";
+	case GF_PIXEL_RGB_32: return "RGB32";
+	case GF_PIXEL_RGBA: return "RGBA";
+	}
+	return "unknown";
+}
+
+static void usage()
+{
+	fprintf(stdout, "Usage: bench_colorconv [options]\n"
+		"\n"
+		"Times YUV to RGB conversions with gf_stretch_bits and checks the output pixels against\n"
+		"a reference converter. To compare with the scalar code, run it against a library built\n"
+		"without SIMD support\n"
+		"\n"
+		"-width N:   source width (default 1920)\n"
+		"-height N:  source height (default 1080)\n"
+		"-loops N:   number of conversions per test (default 20)\n"
+		"\n"
+	);
+}
+
+int main(int argc, char **argv)
+{
+	u8 *yuv, *yuyv, *ref_out, *out;
+	u32 i, t, width, height, loops, nb_errors;
+	struct {
+		u32 src_pf, dst_pf;
+		/*output size in percent of the source one*/
+		u32 scale;
+	} tests[] = {
+		{GF_PIXEL_I420, GF_PIXEL_RGBA, 100},
+		{GF_PIXEL_I420, GF_PIXEL_RGB_32, 100},
+		{GF_PIXEL_I420, GF_PIXEL_RGB_24, 100},
+		{GF_PIXEL_YUY2, GF_PIXEL_RGBA, 100},
+		{GF_PIXEL_I420, GF_PIXEL_RGB_32, 66},
+		{GF_PIXEL_I420, GF_PIXEL_RGBA, 150},
+		{GF_PIXEL_YUY2, GF_PIXEL_RGB_32, 66},
+	};
+
+	width = 1920;
+	height = 1080;
+	loops = 20;
+	for (i=1; i<(u32) argc; i++) {
+		char *arg = argv[i];
+		if (!strcmp(arg, "-h")) { usage(); return 0; }
+		else if (!strcmp(arg, "-width") && (i+1<(u32) argc)) width = atoi(argv[++i]);
+		else if (!strcmp(arg, "-height") && (i+1<(u32) argc)) height = atoi(argv[++i]);
+		else if (!strcmp(arg, "-loops") && (i+1<(u32) argc)) loops = atoi(argv[++i]);
+	}
+	/*4:2:0 frames*/
+	width = (width + 1) & ~1;
+	height = (height + 1) & ~1;
+	if (!width || !height) {
+		usage();
+		return 1;
+	}
+
+	gf_sys_init(0);
+	ref_init();
+
+	yuv = (u8 *) malloc(sizeof(u8) * width * height * 3 / 2);
+	build_frame(yuv, width * height * 3 / 2);
+	yuyv = (u8 *) malloc(sizeof(u8) * width * height * 2);
+	build_frame(yuyv, width * height * 2);
+	/*largest output*/
+	ref_out = (u8 *) malloc(sizeof(u8) * 4 * (width*3/2 + 1) * (height*3/2 + 1));
+	out = (u8 *) malloc(sizeof(u8) * 4 * (width*3/2 + 1) * (height*3/2 + 1));
+
+	fprintf(stdout, "%dx%d source - %d loops\n", width, height, loops);
+	nb_errors = 0;
+	for (t=0; t<sizeof(tests)/sizeof(tests[0]); t++) {
+		GF_VideoSurface src, dst, ref;
+		u32 l, time, bpp, size;
+
+		memset(&src, 0, sizeof(GF_VideoSurface));
+		src.width = width;
+		src.height = height;
+		src.pixel_format = tests[t].src_pf;
+		if (src.pixel_format==GF_PIXEL_YUY2) {
+			src.pitch_y = 2*width;
+			src.video_buffer = (char *) yuyv;
+		} else {
+			src.pitch_y = width;
+			src.video_buffer = (char *) yuv;
+		}
+
+		memset(&dst, 0, sizeof(GF_VideoSurface));
+		dst.width = width * tests[t].scale / 100;
+		dst.height = height * tests[t].scale / 100;
+		dst.pixel_format = tests[t].dst_pf;
+		bpp = (dst.pixel_format==GF_PIXEL_RGB_24) ? 3 : 4;
+		dst.pitch_x = bpp;
+		dst.pitch_y = bpp * dst.width;
+		size = dst.pitch_y * dst.height;
+		ref = dst;
+		ref.video_buffer = (char *) ref_out;
+		dst.video_buffer = (char *) out;
+		memset(ref_out, 0, size);
+		memset(out, 0, size);
+
+		ref_convert(&ref, &src);
+
+		time = gf_sys_clock();
+		for (l=0; l<loops; l++) gf_stretch_bits(&dst, &src, NULL, NULL, 0xFF, 0, NULL, NULL);
+		time = gf_sys_clock() - time;
+
+		fprintf(stdout, "%s -> %s %dx%d: stretch_bits %d ms (%.2f fps)", fmt_name(src.pixel_format), fmt_name(dst.pixel_format), dst.width, dst.height,
+			time, time ? 1000.0 * loops / time : 0);
+		if (memcmp(ref_out, out, size)) {
+			fprintf(stdout, " - MISMATCH\n");
+			nb_errors++;
+		} else {
+			fprintf(stdout, "\n");
+		}
+	}
+
+	free(yuv);
+	free(yuyv);
+	free(ref_out);
+	free(out);
+	gf_sys_close();
+	return nb_errors ? 1 : 0;
+}
@@ -0,0 +1,295 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Copyright (c) ENST 2007-200X
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / 2D rasterizer benchmark
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+#include <gpac/modules/raster2d.h>
+#include <gpac/constants.h>
+
+#define TEX_SIZE	256
+
+typedef struct
+{
+	GF_Path *path;
+	GF_STENCIL sten;
+} DrawItem;
+
+static u32 nb_items = 0;
+static DrawItem items[64];
+
+static void add_item(GF_Path *path, GF_STENCIL sten)
+{
+	items[nb_items].path = path;
+	items[nb_items].sten = sten;
+	nb_items++;
+}
+
+static GF_STENCIL solid_brush(GF_Raster2D *r2d, GF_Color col)
+{
+	GF_STENCIL sten = r2d->stencil_new(r2d, GF_STENCIL_SOLID);
+	r2d->stencil_set_brush_color(sten, col);
+	return sten;
+}
+
+/*builds the scene: opaque and transparent solid shapes with anti-aliased edges, linear and radial gradients
+with transparent stops and a rotated transparent texture, as found in SVG/BIFS content*/
+static void build_scene(GF_Raster2D *r2d, u32 width, u32 height, u32 *texture)
+{
+	u32 i, j;
+	Fixed w = INT2FIX(width);
+	Fixed h = INT2FIX(height);
+	GF_Path *path;
+	GF_STENCIL sten;
+	GF_Matrix2D mx;
+	Fixed pos[3];
+	GF_Color cols[3];
+
+	/*opaque rectangles at sub-pixel positions*/
+	for (i=0; i<8; i++) {
+		for (j=0; j<5; j++) {
+			path = gf_path_new();
+			gf_path_add_rect(path, w*i/8 + FLT2FIX(0.3f), h*j/5 + FLT2FIX(0.6f), w/10, h/7);
+			add_item(path, solid_brush(r2d, GF_COL_ARGB(0xFF, 30*i, 50*j, 0x80)));
+		}
+	}
+	/*transparent ellipses*/
+	for (i=0; i<12; i++) {
+		path = gf_path_new();
+		gf_path_add_ellipse(path, w*(2*i+1)/24, h/2 + h*(i%3)/10, w/8, h/3);
+		add_item(path, solid_brush(r2d, GF_COL_ARGB(0x80 + 8*i, 20*i, 0xFF - 20*i, 0x40)));
+	}
+	/*linear gradient with a transparent stop*/
+	path = gf_path_new();
+	gf_path_add_move_to(path, w/10, h/10);
+	gf_path_add_cubic_to(path, w/2, 0, w/2, h, w*9/10, h*9/10);
+	gf_path_add_line_to(path, w*9/10, h/2);
+	gf_path_add_cubic_to(path, w/2, h/3, w/3, h/2, w/10, h/10);
+	gf_path_close(path);
+	sten = r2d->stencil_new(r2d, GF_STENCIL_LINEAR_GRADIENT);
+	pos[0] = 0;
+	pos[1] = FIX_ONE/2;
+	pos[2] = FIX_ONE;
+	cols[0] = GF_COL_ARGB(0xFF, 0xFF, 0, 0);
+	cols[1] = GF_COL_ARGB(0x60, 0, 0xFF, 0);
+	cols[2] = GF_COL_ARGB(0xFF, 0, 0, 0xFF);
+	r2d->stencil_set_linear_gradient(sten, w/10, h/10, w*9/10, h*9/10);
+	r2d->stencil_set_gradient_interpolation(sten, pos, cols, 3);
+	add_item(path, sten);
+	/*opaque radial gradient*/
+	path = gf_path_new();
+	gf_path_add_ellipse(path, w/2, h/2, h/2, h/2);
+	sten = r2d->stencil_new(r2d, GF_STENCIL_RADIAL_GRADIENT);
+	cols[0] = GF_COL_ARGB(0xFF, 0xFF, 0xFF, 0xFF);
+	cols[1] = GF_COL_ARGB(0xFF, 0xFF, 0x80, 0);
+	cols[2] = GF_COL_ARGB(0xFF, 0x40, 0, 0x40);
+	r2d->stencil_set_radial_gradient(sten, w/2, h/2, w/2 - h/8, h/2 - h/8, h/4, h/4);
+	r2d->stencil_set_gradient_interpolation(sten, pos, cols, 3);
+	add_item(path, sten);
+	/*rotated texture*/
+	path = gf_path_new();
+	gf_path_add_rect_center(path, w/2, h/2, w*2/3, h*2/3);
+	sten = r2d->stencil_new(r2d, GF_STENCIL_TEXTURE);
+	r2d->stencil_set_texture(sten, (char *) texture, TEX_SIZE, TEX_SIZE, 4*TEX_SIZE, GF_PIXEL_ARGB, GF_PIXEL_ARGB, 0);
+	r2d->stencil_set_tiling(sten, GF_TEXTURE_REPEAT_S | GF_TEXTURE_REPEAT_T);
+	gf_mx2d_init(mx);
+	gf_mx2d_add_scale(&mx, gf_divfix(w, INT2FIX(2*TEX_SIZE)), gf_divfix(h, INT2FIX(2*TEX_SIZE)));
+	gf_mx2d_add_rotation(&mx, w/2, h/2, GF_PI/12);
+	r2d->stencil_set_matrix(sten, &mx);
+	add_item(path, sten);
+	/*transparent star*/
+	path = gf_path_new();
+	for (i=0; i<10; i++) {
+		Fixed a = GF_PI*i/5;
+		Fixed r = (i%2) ? h/8 : h*3/8;
+		Fixed x = w/2 + gf_mulfix(r, gf_cos(a));
+		Fixed y = h/2 + gf_mulfix(r, gf_sin(a));
+		if (!i) gf_path_add_move_to(path, x, y);
+		else gf_path_add_line_to(path, x, y);
+	}
+	gf_path_close(path);
+	add_item(path, solid_brush(r2d, GF_COL_ARGB(0xC0, 0xFF, 0xFF, 0)));
+}
+
+static void draw_scene(GF_Raster2D *r2d, GF_SURFACE surf, u32 width, u32 height)
+{
+	u32 i;
+	GF_IRect rc;
+	/*transparent background with an opaque half, so that both cases of the ARGB/RGBA blenders are used*/
+	r2d->surface_clear(surf, NULL, 0);
+	rc.x = 0;
+	rc.y = 0;
+	rc.width = width/2;
+	rc.height = height;
+	r2d->surface_clear(surf, &rc, GF_COL_ARGB(0xFF, 0x20, 0x28, 0x30));
+
+	for (i=0; i<nb_items; i++) {
+		r2d->surface_set_path(surf, items[i].path);
+		r2d->surface_fill(surf, items[i].sten);
+	}
+}
+
+static void build_texture(u32 *data)
+{
+	u32 i, j;
+	for (j=0; j<TEX_SIZE; j++) {
+		for (i=0; i<TEX_SIZE; i++) {
+			u8 a = ((i/32 + j/32) % 2) ? 0xFF : (u8) (i ^ j);
+			data[j*TEX_SIZE + i] = GF_COL_ARGB(a, i, j, 0xFF - i);
+		}
+	}
+}
+
+static const char *fmt_name(u32 pf)
+{
+	switch (pf) {
+	case GF_PIXEL_ARGB: return "ARGB";
+	case GF_PIXEL_RGBA: return "RGBA";
+	case GF_PIXEL_RGB_32: return "RGB32";
+	case GF_PIXEL_BGR_32: return "BGR32";
+	case GF_PIXEL_RGB_24: return "RGB24";
+	case GF_PIXEL_BGR_24: return "BGR24";
+	case GF_PIXEL_RGB_565: return "RGB565";
+	}
+	return "unknown";
+}
+
+static void usage()
+{
+	fprintf(stdout, "Usage: bench_raster [options]\n"
+		"\n"
+		"Renders a fixed set of paths (solid, transparent, gradient and texture fills) with the\n"
+		"2D rasterizer module on surfaces of each supported pixel format. The checksum of each\n"
+		"rendering is printed so that two rasterizer builds can be compared\n"
+		"\n"
+		"-width N:   surface width (default 1920)\n"
+		"-height N:  surface height (default 1080)\n"
+		"-loops N:   number of frames per format (default 20)\n"
+		"-mod DIR:   modules directory (default is the application directory)\n"
+		"-raster M:  rasterizer module name (default \"GPAC 2D Raster\")\n"
+		"\n"
+	);
+}
+
+int main(int argc, char **argv)
+{
+	char szModDir[GF_MAX_PATH], *sep;
+	const char *mod_name = "GPAC 2D Raster";
+	const char *cfg_name = "bench_raster.cfg";
+	u32 i, t, width, height, loops;
+	u32 *texture;
+	char *pixels;
+	FILE *f;
+	GF_Config *cfg;
+	GF_ModuleManager *modules;
+	GF_Raster2D *r2d;
+	u32 formats[] = {GF_PIXEL_ARGB, GF_PIXEL_RGBA, GF_PIXEL_RGB_32, GF_PIXEL_BGR_32, GF_PIXEL_RGB_24, GF_PIXEL_BGR_24, GF_PIXEL_RGB_565};
+
+	strcpy(szModDir, argv[0]);
+	sep = strrchr(szModDir, '/');
+	if (!sep) sep = strrchr(szModDir, '\\');
+	if (sep) sep[0] = 0;
+	else strcpy(szModDir, ".");
+
+	width = 1920;
+	height = 1080;
+	loops = 20;
+	for (i=1; i<(u32) argc; i++) {
+		char *arg = argv[i];
+		if (!strcmp(arg, "-h")) { usage(); return 0; }
+		else if (!strcmp(arg, "-width") && (i+1<(u32) argc)) width = atoi(argv[++i]);
+		else if (!strcmp(arg, "-height") && (i+1<(u32) argc)) height = atoi(argv[++i]);
+		else if (!strcmp(arg, "-loops") && (i+1<(u32) argc)) loops = atoi(argv[++i]);
+		else if (!strcmp(arg, "-mod") && (i+1<(u32) argc)) strcpy(szModDir, argv[++i]);
+		else if (!strcmp(arg, "-raster") && (i+1<(u32) argc)) mod_name = argv[++i];
+	}
+	if (!width || !height) {
+		usage();
+		return 1;
+	}
+
+	gf_sys_init(0);
+
+	/*the module manager needs a configuration file for its cache*/
+	f = fopen(cfg_name, "wt");
+	if (f) fclose(f);
+	cfg = gf_cfg_new(NULL, cfg_name);
+	modules = gf_modules_new(szModDir, cfg);
+	r2d = modules ? (GF_Raster2D *) gf_modules_load_interface_by_name(modules, mod_name, GF_RASTER_2D_INTERFACE) : NULL;
+	if (!r2d) {
+		fprintf(stderr, "Cannot load rasterizer %s from %s\n", mod_name, szModDir);
+		if (modules) gf_modules_del(modules);
+		if (cfg) gf_cfg_del(cfg);
+		gf_delete_file(cfg_name);
+		gf_sys_close();
+		return 1;
+	}
+
+	texture = (u32 *) malloc(sizeof(u32) * TEX_SIZE * TEX_SIZE);
+	build_texture(texture);
+	build_scene(r2d, width, height, texture);
+	pixels = (char *) malloc(sizeof(char) * 4 * width * height);
+
+	fprintf(stdout, "%s - %dx%d - %d paths - %d frames\n", r2d->module_name, width, height, nb_items, loops);
+	for (t=0; t<sizeof(formats)/sizeof(formats[0]); t++) {
+		u32 l, time, bpp;
+		GF_SURFACE surf = r2d->surface_new(r2d, 0);
+		switch (formats[t]) {
+		case GF_PIXEL_RGB_24:
+		case GF_PIXEL_BGR_24:
+			bpp = 3;
+			break;
+		case GF_PIXEL_RGB_565:
+			bpp = 2;
+			break;
+		default:
+			bpp = 4;
+			break;
+		}
+		memset(pixels, 0, sizeof(char) * 4 * width * height);
+		if (r2d->surface_attach_to_buffer(surf, pixels, width, height, bpp, bpp*width, formats[t]) != GF_OK) {
+			fprintf(stdout, "%s: not supported\n", fmt_name(formats[t]));
+			r2d->surface_delete(surf);
+			continue;
+		}
+		r2d->surface_set_raster_level(surf, GF_RASTER_HIGH_QUALITY);
+
+		time = gf_sys_clock();
+		for (l=0; l<loops; l++) draw_scene(r2d, surf, width, height);
+		time = gf_sys_clock() - time;
+
+		fprintf(stdout, "%s: %d ms (%.2f fps) - checksum %08X\n", fmt_name(formats[t]), time, time ? 1000.0 * loops / time : 0, gf_crc_32(pixels, bpp*width*height));
+		r2d->surface_detach(surf);
+		r2d->surface_delete(surf);
+	}
+
+	for (i=0; i<nb_items; i++) {
+		gf_path_del(items[i].path);
+		r2d->stencil_delete(items[i].sten);
+	}
+	free(pixels);
+	free(texture);
+	gf_modules_close_interface((GF_BaseInterface *) r2d);
+	gf_modules_del(modules);
+	gf_cfg_del(cfg);
+	gf_delete_file(cfg_name);
+	gf_sys_close();
+	return 0;
+}
@@ -0,0 +1,250 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Copyright (c) ENST 2007-200X
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / RTP reorderer benchmark
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+#include <gpac/internal/ietf_dev.h>
+
+/*naive sorted list reorderer, used as a baseline: one allocation and one copy per packet, sorted insertion.
+This is not the previous GPAC reorderer, it has no sequence number tracking, no bounds check and no timeout*/
+typedef struct __ref_item
+{
+	struct __ref_item *next;
+	u32 seq_num;
+	char *pck;
+	u32 size;
+} RefItem;
+
+typedef struct
+{
+	RefItem *in;
+	u32 Count, MaxCount;
+} RefReorder;
+
+/*16 bits sequence number comparison*/
+static Bool seq_before(u32 a, u32 b)
+{
+	return (((b - a) & 0xFFFF) && (((b - a) & 0xFFFF) < 0x8000)) ? 1 : 0;
+}
+
+static void ref_add(RefReorder *po, char *pck, u32 size, u32 seq_num)
+{
+	RefItem *cur, *it = (RefItem *) gf_malloc(sizeof(RefItem));
+	it->seq_num = seq_num;
+	it->size = size;
+	it->next = NULL;
+	it->pck = (char *) gf_malloc(sizeof(char) * size);
+	memcpy(it->pck, pck, sizeof(char) * size);
+
+	if (!po->in || seq_before(seq_num, po->in->seq_num)) {
+		it->next = po->in;
+		po->in = it;
+		po->Count++;
+		return;
+	}
+	cur = po->in;
+	while (1) {
+		if (cur->seq_num == seq_num) {
+			gf_free(it->pck);
+			gf_free(it);
+			return;
+		}
+		if (!cur->next || seq_before(seq_num, cur->next->seq_num)) {
+			it->next = cur->next;
+			cur->next = it;
+			po->Count++;
+			return;
+		}
+		cur = cur->next;
+	}
+}
+
+/*releases the head when the next one follows it or when the queue is full*/
+static char *ref_get(RefReorder *po, u32 *size, Bool flush)
+{
+	RefItem *it;
+	char *pck;
+	*size = 0;
+	if (!po->in) return NULL;
+	if (!flush && (po->Count < po->MaxCount) && (!po->in->next || (((po->in->seq_num + 1) & 0xFFFF) != po->in->next->seq_num))) return NULL;
+	it = po->in;
+	po->in = it->next;
+	po->Count--;
+	*size = it->size;
+	pck = it->pck;
+	gf_free(it);
+	return pck;
+}
+
+typedef struct
+{
+	u32 key, seq_num;
+} ShuffleItem;
+
+static int shuffle_cmp(const void *a, const void *b)
+{
+	const ShuffleItem *s1 = (const ShuffleItem *)a;
+	const ShuffleItem *s2 = (const ShuffleItem *)b;
+	if (s1->key != s2->key) return (s1->key < s2->key) ? -1 : 1;
+	return (s1->seq_num < s2->seq_num) ? -1 : 1;
+}
+
+/*builds a packet sequence: each packet is delayed by up to max_disp positions, some packets are lost*/
+static u32 build_capture(u32 *seq_nums, u32 nb_pck, u32 first_seq, u32 max_disp, u32 loss)
+{
+	u32 i, nb, seed = 1;
+	ShuffleItem *items = (ShuffleItem *) malloc(sizeof(ShuffleItem) * nb_pck);
+	nb = 0;
+	for (i=0; i<nb_pck; i++) {
+		seed = seed * 1103515245 + 12345;
+		if (loss && ((seed >> 16) % 1000 < loss)) continue;
+		seed = seed * 1103515245 + 12345;
+		items[nb].key = i + (max_disp ? (seed >> 16) % (max_disp+1) : 0);
+		/*unwrapped, for the sort*/
+		items[nb].seq_num = first_seq + i;
+		nb++;
+	}
+	qsort(items, nb, sizeof(ShuffleItem), shuffle_cmp);
+	for (i=0; i<nb; i++) seq_nums[i] = items[i].seq_num & 0xFFFF;
+	free(items);
+	return nb;
+}
+
+/*checks the output order*/
+static void check_output(char *pck, u32 *last_seq, u32 *nb_out, u32 *nb_misordered)
+{
+	u32 seq_num = ((pck[2] << 8) & 0xFF00) | (pck[3] & 0xFF);
+	if ((*nb_out) && !seq_before(*last_seq, seq_num)) (*nb_misordered)++;
+	*last_seq = seq_num;
+	(*nb_out)++;
+}
+
+static void usage()
+{
+	fprintf(stdout, "Usage: bench_rtpreorder [options]\n"
+		"\n"
+		"Replays a shuffled RTP packet sequence through the RTP reorderer and through the\n"
+		"a naive sorted list reorderer\n"
+		"\n"
+		"-nb N:      number of packets (default 200000)\n"
+		"-size N:    packet size in bytes (default 1328)\n"
+		"-disp N:    max delay of a packet in the sequence, in packets (default 8)\n"
+		"-loss N:    lost packets per thousand (default 0)\n"
+		"-queue N:   reordering queue size (default 64)\n"
+		"-loops N:   number of replays (default 5)\n"
+		"\n"
+	);
+}
+
+int main(int argc, char **argv)
+{
+	char *pck;
+	u32 *seq_nums;
+	u32 i, nb_pck, size, disp, loss, queue, loops, nb, l, ref_time, time;
+	u32 ref_out, ref_bad, out, bad;
+
+	nb_pck = 200000;
+	size = 1328;
+	disp = 8;
+	loss = 0;
+	queue = 64;
+	loops = 5;
+	for (i=1; i<(u32) argc; i++) {
+		char *arg = argv[i];
+		if (!strcmp(arg, "-h")) { usage(); return 0; }
+		else if (!strcmp(arg, "-nb") && (i+1<(u32) argc)) nb_pck = atoi(argv[++i]);
+		else if (!strcmp(arg, "-size") && (i+1<(u32) argc)) size = atoi(argv[++i]);
+		else if (!strcmp(arg, "-disp") && (i+1<(u32) argc)) disp = atoi(argv[++i]);
+		else if (!strcmp(arg, "-loss") && (i+1<(u32) argc)) loss = atoi(argv[++i]);
+		else if (!strcmp(arg, "-queue") && (i+1<(u32) argc)) queue = atoi(argv[++i]);
+		else if (!strcmp(arg, "-loops") && (i+1<(u32) argc)) loops = atoi(argv[++i]);
+	}
+	if (size < 12) size = 12;
+	if (queue < 2) queue = 2;
+
+	gf_sys_init(0);
+
+	seq_nums = (u32 *) malloc(sizeof(u32) * nb_pck);
+	/*start close to the sequence number wrap*/
+	nb = build_capture(seq_nums, nb_pck, 0xFF00, disp, loss);
+	pck = (char *) malloc(sizeof(char) * size);
+	memset(pck, 0, sizeof(char) * size);
+	pck[0] = (char) 0x80;
+
+	ref_out = ref_bad = 0;
+	ref_time = gf_sys_clock();
+	for (l=0; l<loops; l++) {
+		RefReorder ref;
+		u32 last = 0, pck_size;
+		char *res;
+		memset(&ref, 0, sizeof(RefReorder));
+		ref.MaxCount = queue;
+		ref_out = ref_bad = 0;
+		for (i=0; i<nb; i++) {
+			pck[2] = (seq_nums[i] >> 8) & 0xFF;
+			pck[3] = seq_nums[i] & 0xFF;
+			ref_add(&ref, pck, size, seq_nums[i]);
+			res = ref_get(&ref, &pck_size, 0);
+			if (res) {
+				check_output(res, &last, &ref_out, &ref_bad);
+				gf_free(res);
+			}
+		}
+		while ((res = ref_get(&ref, &pck_size, 1)) != NULL) {
+			check_output(res, &last, &ref_out, &ref_bad);
+			gf_free(res);
+		}
+	}
+	ref_time = gf_sys_clock() - ref_time;
+
+	out = bad = 0;
+	time = gf_sys_clock();
+	for (l=0; l<loops; l++) {
+		GF_RTPReorder *po = gf_rtp_reorderer_new(queue, 1);
+		u32 last = 0, pck_size;
+		char *res;
+		out = bad = 0;
+		for (i=0; i<nb; i++) {
+			pck[2] = (seq_nums[i] >> 8) & 0xFF;
+			pck[3] = seq_nums[i] & 0xFF;
+			gf_rtp_reorderer_add(po, pck, size, seq_nums[i]);
+			res = (char *) gf_rtp_reorderer_get(po, &pck_size);
+			if (res) check_output(res, &last, &out, &bad);
+		}
+		/*lost packets are waited for at most 1 ms*/
+		while (po->Count) {
+			res = (char *) gf_rtp_reorderer_get(po, &pck_size);
+			if (res) check_output(res, &last, &out, &bad);
+			else gf_sleep(1);
+		}
+		gf_rtp_reorderer_del(po);
+	}
+	time = gf_sys_clock() - time;
+
+	fprintf(stdout, "%d packets of %d bytes - max delay %d - %d lost - queue %d - %d loops\n", nb, size, disp, nb_pck - nb, queue, loops);
+	fprintf(stdout, "sorted list: %d ms (%.2f kpck/s) - %d output - %d out of order\n", ref_time, ref_time ? ((Double) nb) * loops / ref_time : 0, ref_out, ref_bad);
+	fprintf(stdout, "pooled:      %d ms (%.2f kpck/s) - %d output - %d out of order\n", time, time ? ((Double) nb) * loops / time : 0, out, bad);
+
+	free(pck);
+	free(seq_nums);
+	gf_sys_close();
+	return bad ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Copyright (c) ENST 2007-200X
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / start code scanner benchmark
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+#include <gpac/avparse.h>
+
+/*byte-serial scanner, as used by the parsers before the vectorized one*/
+static u32 ref_next_start_code(const u8 *data, u32 data_len, u32 *sc_size)
+{
+	u32 i, v = 0xffffffff;
+	for (i=0; i<data_len; i++) {
+		v = ( (v<<8) & 0xFFFFFF00) | data[i];
+		if (v == 0x00000001) {
+			*sc_size = 4;
+			return i-3;
+		}
+		if ((v & 0x00FFFFFF) == 0x00000001) {
+			*sc_size = 3;
+			return i-2;
+		}
+	}
+	*sc_size = 0;
+	return data_len;
+}
+
+/*builds an Annex-B like buffer: random payloads with some zero bytes, separated by 3 or 4 bytes start codes*/
+static u32 build_buffer(u8 *data, u32 size, u32 nal_size)
+{
+	u32 i, pos, nb_sc, seed = 1;
+	pos = nb_sc = 0;
+	while (pos + 4 < size) {
+		u32 len;
+		if (nb_sc % 2) data[pos++] = 0;
+		data[pos++] = 0;
+		data[pos++] = 0;
+		data[pos++] = 1;
+		nb_sc++;
+		len = nal_size / 2 + (seed % nal_size);
+		for (i=0; (i<len) && (pos<size); i++) {
+			seed = seed * 1103515245 + 12345;
+			data[pos] = (u8) (seed >> 16);
+			/*emulation prevention: never 00 00 0x in payloads*/
+			if (!data[pos] && pos && !data[pos-1]) data[pos] = 3;
+			pos++;
+		}
+	}
+	while (pos<size) data[pos++] = 0x55;
+	return nb_sc;
+}
+
+static void usage()
+{
+	fprintf(stdout, "Usage: bench_startcode [options] [input_file]\n"
+		"\n"
+		"Compares the byte-serial and vectorized start code scanners on an Annex-B buffer.\n"
+		"If no input is given, a synthetic buffer is generated\n"
+		"\n"
+		"-size N:    synthetic buffer size in kbytes (default 16384)\n"
+		"-nal N:     average synthetic NAL size in bytes (default 1500)\n"
+		"-loops N:   number of scans of the buffer (default 10)\n"
+		"\n"
+	);
+}
+
+int main(int argc, char **argv)
+{
+	u8 *data;
+	u32 i, size, nal_size, loops, nb_sc, ref_time, time;
+	u64 sum_ref, sum;
+	char *input = NULL;
+
+	size = 16384;
+	nal_size = 1500;
+	loops = 10;
+	for (i=1; i<(u32) argc; i++) {
+		char *arg = argv[i];
+		if (!strcmp(arg, "-h")) { usage(); return 0; }
+		else if (!strcmp(arg, "-size") && (i+1<(u32) argc)) size = atoi(argv[++i]);
+		else if (!strcmp(arg, "-nal") && (i+1<(u32) argc)) nal_size = atoi(argv[++i]);
+		else if (!strcmp(arg, "-loops") && (i+1<(u32) argc)) loops = atoi(argv[++i]);
+		else input = arg;
+	}
+	if (!nal_size) nal_size = 1;
+
+	gf_sys_init(0);
+
+	if (input) {
+		FILE *f = fopen(input, "rb");
+		if (!f) {
+			fprintf(stderr, "Cannot open %s\n", input);
+			gf_sys_close();
+			return 1;
+		}
+		fseek(f, 0, SEEK_END);
+		size = (u32) ftell(f);
+		fseek(f, 0, SEEK_SET);
+		data = (u8 *) malloc(sizeof(u8) * size);
+		size = (u32) fread(data, 1, size, f);
+		fclose(f);
+	} else {
+		size *= 1024;
+		data = (u8 *) malloc(sizeof(u8) * size);
+		build_buffer(data, size, nal_size);
+	}
+
+	/*check both scanners report the same start codes*/
+	nb_sc = 0;
+	i = 0;
+	while (i<size) {
+		u32 sc_ref, sc, pos_ref, pos;
+		pos_ref = ref_next_start_code(data+i, size-i, &sc_ref);
+		pos = gf_media_nalu_next_start_code(data+i, size-i, &sc);
+		if ((pos_ref != pos) || (sc_ref != sc)) {
+			fprintf(stderr, "Mismatch at offset %d: reference %d (size %d) - scanner %d (size %d)\n", i, i+pos_ref, sc_ref, i+pos, sc);
+			free(data);
+			gf_sys_close();
+			return 1;
+		}
+		if (!sc) break;
+		nb_sc++;
+		i += pos + sc;
+	}
+
+	sum_ref = 0;
+	ref_time = gf_sys_clock();
+	for (i=0; i<loops; i++) {
+		u32 pos = 0;
+		while (pos<size) {
+			u32 sc;
+			pos += ref_next_start_code(data+pos, size-pos, &sc);
+			if (!sc) break;
+			sum_ref += pos;
+			pos += sc;
+		}
+	}
+	ref_time = gf_sys_clock() - ref_time;
+
+	sum = 0;
+	time = gf_sys_clock();
+	for (i=0; i<loops; i++) {
+		u32 pos = 0;
+		while (pos<size) {
+			u32 sc;
+			pos += gf_media_nalu_next_start_code(data+pos, size-pos, &sc);
+			if (!sc) break;
+			sum += pos;
+			pos += sc;
+		}
+	}
+	time = gf_sys_clock() - time;
+
+	fprintf(stdout, "%d bytes - %d start codes - %d loops\n", size, nb_sc, loops);
+	fprintf(stdout, "byte-serial: %d ms (%.2f MB/s)\n", ref_time, ref_time ? ((Double) size) * loops / 1000 / ref_time : 0);
+	fprintf(stdout, "vectorized:  %d ms (%.2f MB/s)\n", time, time ? ((Double) size) * loops / 1000 / time : 0);
+	if (sum != sum_ref) fprintf(stderr, "Checksum mismatch\n");
+
+	free(data);
+	gf_sys_close();
+	return (sum != sum_ref) ? 1 : 0;
+}
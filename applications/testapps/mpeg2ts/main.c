@@ -18,7 +18,15 @@ void on_m2ts_event(GF_M2TS_Demuxer *ts, u32 evt_type, void *par)
 		fprintf(stdout, "Service connected (PAT found)\n");
 		break;
 	case GF_M2TS_EVT_PMT_FOUND:
-		fprintf(stdout, "Program list found - %d streams\n", gf_list_count( ((GF_M2TS_Program*)par)->streams) );
+	{
+		u32 i;
+		GF_M2TS_Program *prog = (GF_M2TS_Program*)par;
+		fprintf(stdout, "Program list found - %d streams\n", gf_list_count(prog->streams) );
+		for (i=0; i<gf_list_count(prog->streams); i++) {
+			GF_M2TS_ES *es = gf_list_get(prog->streams, i);
+			if ((es->pid == dump_pid) && !(es->flags & GF_M2TS_ES_IS_SECTION)) gf_m2ts_set_pes_framing((GF_M2TS_PES *)es, GF_M2TS_PES_FRAMING_DEFAULT);
+		}
+	}
 		break;
 	case GF_M2TS_EVT_PMT_UPDATE:
 		fprintf(stdout, "Program list updated - %d streams\n", gf_list_count( ((GF_M2TS_Program*)par)->streams) );
@@ -46,9 +54,27 @@ int main(int argc, char **argv)
 	u32 size, fsize, fdone;
 	GF_M2TS_Demuxer *ts;
 
-	FILE *src = fopen(argv[1], "rb");
+	Bool filter = 0;
+	FILE *src;
+
+	if (argc < 2) {
+		fprintf(stdout, "Usage: mpeg2ts file.ts [-pid N]\n"
+			"Dumps the PES payload of PID N (default %d) to pes.mp3. With -pid, other PIDs are filtered out\n", dump_pid);
+		return 1;
+	}
+	if ((argc > 3) && !strcmp(argv[2], "-pid")) {
+		dump_pid = atoi(argv[3]);
+		filter = 1;
+	}
+	src = fopen(argv[1], "rb");
+	if (!src) return 1;
 	ts = gf_m2ts_demux_new();
 	ts->on_event = on_m2ts_event;
+	/*only the PAT, the PMTs and the dumped PID are parsed*/
+	if (filter) {
+		gf_m2ts_demux_set_pid_filtering(ts, 1);
+		gf_m2ts_demux_allow_pid(ts, dump_pid, 1);
+	}
 
 	fseek(src, 0, SEEK_END);
 	fsize = ftell(src);
@@ -0,0 +1,930 @@
+/*
+ *			GPAC - Multimedia Framework C SDK
+ *
+ *			Copyright (c) ENST 2007-200X
+ *					All rights reserved
+ *
+ *  This file is part of GPAC / RTSP file server
+ *
+ *  GPAC is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  GPAC is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+#include <gpac/ietf.h>
+#include <gpac/isomedia.h>
+#include <gpac/network.h>
+#include <gpac/thread.h>
+
+/*max packets sent per stream and per system call*/
+#define RTSP_SEND_BATCH		32
+/*max sockets watched by a worker: one RTSP connection and one RTCP socket per stream*/
+#define RTSP_MAX_POLL		1024
+/*max wait time of a worker when no packet is due, in ms*/
+#define RTSP_MAX_WAIT		20
+
+/*type of the objects registered in a poller - always first member*/
+enum
+{
+	RTSP_POLL_CONNECTION = 1,
+	RTSP_POLL_RTCP,
+};
+
+typedef struct __rtsp_server RTSPServer;
+typedef struct __rtsp_worker RTSPWorker;
+typedef struct __rtsp_client RTSPClient;
+
+typedef struct
+{
+	u32 type;
+	RTSPClient *client;
+	/*hint track*/
+	u32 track, track_id, timescale;
+	u32 ssrc, ts_offset, sn_offset;
+	GF_Socket *rtp, *rtcp;
+	u16 port;
+	/*next packet to send and its transmission time in hint timescale*/
+	char *pck;
+	u32 pck_size, trans_ts;
+	Bool eos;
+	/*shared packet cache of the track if any, next packet to send in the cache and its sequence number*/
+	GF_ISOHintCache *cache;
+	u32 cache_pck;
+	u16 seq;
+} RTSPStream;
+
+struct __rtsp_client
+{
+	u32 type;
+	RTSPWorker *worker;
+	GF_RTSPSession *rtsp;
+	/*the socket of the RTSP connection as registered in the poller*/
+	GF_Socket *conn;
+	char peer[GF_MAX_IP_NAME_LEN];
+
+	/*one file per client as the hint reader state is kept in the file*/
+	GF_ISOFile *file;
+	char *file_name;
+	char *session_id;
+	GF_List *streams;
+
+	Bool playing, closed;
+	/*clock at PLAY time and start of the played range, in ms*/
+	u32 play_clock, start_ms, pause_ms;
+	u32 last_activity;
+};
+
+struct __rtsp_worker
+{
+	RTSPServer *srv;
+	GF_Thread *th;
+	GF_SockPoll *poll;
+	/*clients handed by the acceptor, protected by the mutex*/
+	GF_Mutex *mx;
+	GF_List *pending;
+	GF_List *clients;
+	/*number of clients served, read by the acceptor*/
+	u32 nb_clients;
+	GF_RTSPCommand *com;
+	GF_RTSPResponse *rsp;
+	/*packets sent*/
+	u64 nb_pck, nb_bytes;
+	/*RTSP_SEND_BATCH packets of the largest cached packet size, where cached packets are patched*/
+	char *scratch;
+	u32 scratch_size;
+};
+
+/*packets of a hint track, shared by all the clients of the track*/
+typedef struct
+{
+	char *file_name;
+	u32 track_id;
+	GF_ISOHintCache *cache;
+} RTSPCache;
+
+struct __rtsp_server
+{
+	char *root;
+	u32 nb_workers, timeout;
+	RTSPWorker *workers;
+	/*RTP/RTCP port pairs shared by all workers*/
+	GF_Mutex *port_mx;
+	u16 port_first, port_last, next_port;
+	Bool run;
+	/*packet caches, kept until exit and protected by the mutex*/
+	Bool use_cache;
+	char *cache_dir;
+	GF_Mutex *cache_mx;
+	GF_List *caches;
+};
+
+
+static void rtsp_stream_del(RTSPStream *st)
+{
+	if (st->rtcp) gf_sk_poll_remove(st->client->worker->poll, st->rtcp);
+	if (st->rtp) gf_sk_del(st->rtp);
+	if (st->rtcp) gf_sk_del(st->rtcp);
+	if (st->pck) gf_free(st->pck);
+	gf_free(st);
+}
+
+/*releases the media resources of the client but keeps the RTSP connection*/
+static void rtsp_client_reset(RTSPClient *cl)
+{
+	while (gf_list_count(cl->streams)) {
+		RTSPStream *st = (RTSPStream *) gf_list_get(cl->streams, 0);
+		gf_list_rem(cl->streams, 0);
+		rtsp_stream_del(st);
+	}
+	if (cl->session_id) gf_free(cl->session_id);
+	cl->session_id = NULL;
+	if (cl->file) gf_isom_close(cl->file);
+	cl->file = NULL;
+	if (cl->file_name) gf_free(cl->file_name);
+	cl->file_name = NULL;
+	cl->playing = 0;
+}
+
+static void rtsp_client_del(RTSPClient *cl)
+{
+	rtsp_client_reset(cl);
+	gf_list_del(cl->streams);
+	if (cl->conn) gf_sk_poll_remove(cl->worker->poll, cl->conn);
+	gf_rtsp_session_del(cl->rtsp);
+	gf_free(cl);
+}
+
+/*maps an RTSP URL to a file under the server root, without the track control string*/
+static char *rtsp_get_file_name(RTSPServer *srv, char *url)
+{
+	char *path, *sep, *name;
+	if (!url) return NULL;
+	path = strstr(url, "://");
+	path = path ? strchr(path+3, '/') : strchr(url, '/');
+	if (!path) return NULL;
+	while (*path == '/') path++;
+	if (!*path || strstr(path, "..")) return NULL;
+
+	name = (char *) gf_malloc(sizeof(char) * (strlen(srv->root) + strlen(path) + 2));
+	sprintf(name, "%s/%s", srv->root, path);
+	sep = strstr(name, "/trackID=");
+	if (sep) sep[0] = 0;
+	if (name[strlen(name)-1] == '/') name[strlen(name)-1] = 0;
+	return name;
+}
+
+/*opens the requested file if not already done*/
+static u32 rtsp_client_open(RTSPClient *cl, char *url)
+{
+	char *name = rtsp_get_file_name(cl->worker->srv, url);
+	if (!name) return NC_RTSP_Not_Found;
+	if (cl->file && !strcmp(name, cl->file_name)) {
+		gf_free(name);
+		return NC_RTSP_OK;
+	}
+	/*a single presentation per RTSP session*/
+	if (cl->session_id) {
+		gf_free(name);
+		return NC_RTSP_Aggregate_Operation_Not_Allowed;
+	}
+	rtsp_client_reset(cl);
+	cl->file = gf_isom_open(name, GF_ISOM_OPEN_READ, NULL);
+	if (!cl->file) {
+		gf_free(name);
+		return NC_RTSP_Not_Found;
+	}
+	cl->file_name = name;
+	return NC_RTSP_OK;
+}
+
+static Double rtsp_client_get_duration(RTSPClient *cl)
+{
+	u32 timescale = gf_isom_get_timescale(cl->file);
+	return timescale ? ((Double) (s64) gf_isom_get_duration(cl->file)) / timescale : 0;
+}
+
+/*appends a string to the SDP being built*/
+static void rtsp_sdp_append(char **sdp, u32 *size, const char *str)
+{
+	u32 len = (u32) strlen(str);
+	u32 cur = *sdp ? (u32) strlen(*sdp) : 0;
+	if (cur + len + 1 > *size) {
+		*size = 2 * (cur + len + 1);
+		*sdp = (char *) gf_realloc(*sdp, sizeof(char) * (*size));
+		if (!cur) (*sdp)[0] = 0;
+	}
+	strcat(*sdp, str);
+}
+
+static u32 rtsp_describe(RTSPClient *cl, GF_RTSPCommand *com, GF_RTSPResponse *rsp)
+{
+	char line[GF_MAX_IP_NAME_LEN + 200], ip[GF_MAX_IP_NAME_LEN];
+	const char *sdp_data;
+	char *sdp;
+	u32 i, sdp_size, sdp_len, nb_tracks;
+	u32 code = rtsp_client_open(cl, com->service_name);
+	if (code != NC_RTSP_OK) return code;
+
+	sdp = NULL;
+	sdp_size = 0;
+	strcpy(ip, "0.0.0.0");
+	gf_rtsp_get_session_ip(cl->rtsp, ip);
+	sprintf(line, "v=0\r\no=- %u 1 IN IP4 %s\r\ns=%s\r\nc=IN IP4 0.0.0.0\r\nt=0 0\r\n", gf_sys_clock(), ip, strrchr(cl->file_name, '/') + 1);
+	rtsp_sdp_append(&sdp, &sdp_size, line);
+	sprintf(line, "a=range:npt=0-%.3f\r\n", rtsp_client_get_duration(cl));
+	rtsp_sdp_append(&sdp, &sdp_size, line);
+	if ((gf_isom_sdp_get(cl->file, &sdp_data, &sdp_len) == GF_OK) && sdp_data && sdp_len) {
+		char *movie_sdp = (char *) gf_malloc(sizeof(char) * (sdp_len+1));
+		memcpy(movie_sdp, sdp_data, sdp_len);
+		movie_sdp[sdp_len] = 0;
+		rtsp_sdp_append(&sdp, &sdp_size, movie_sdp);
+		gf_free(movie_sdp);
+	}
+
+	/*the track SDPs written by the hinter carry the trackID controls*/
+	nb_tracks = 0;
+	for (i=0; i<gf_isom_get_track_count(cl->file); i++) {
+		char *track_sdp;
+		if (gf_isom_get_media_type(cl->file, i+1) != GF_ISOM_MEDIA_HINT) continue;
+		if ((gf_isom_sdp_track_get(cl->file, i+1, &sdp_data, &sdp_len) != GF_OK) || !sdp_data || !sdp_len) continue;
+		track_sdp = (char *) gf_malloc(sizeof(char) * (sdp_len+1));
+		memcpy(track_sdp, sdp_data, sdp_len);
+		track_sdp[sdp_len] = 0;
+		rtsp_sdp_append(&sdp, &sdp_size, track_sdp);
+		gf_free(track_sdp);
+		nb_tracks++;
+	}
+	/*only hinted files are served*/
+	if (!nb_tracks) {
+		gf_free(sdp);
+		return NC_RTSP_Unsupported_Media_Type;
+	}
+	rsp->body = sdp;
+	rsp->Content_Type = gf_strdup("application/sdp");
+	rsp->Content_Base = (char *) gf_malloc(sizeof(char) * (strlen(com->service_name) + 2));
+	strcpy(rsp->Content_Base, com->service_name);
+	if (com->service_name[strlen(com->service_name)-1] != '/') strcat(rsp->Content_Base, "/");
+	return NC_RTSP_OK;
+}
+
+/*binds an RTP/RTCP socket pair to the client ports*/
+static GF_Err rtsp_stream_setup_sockets(RTSPServer *srv, RTSPStream *st, char *peer, u16 client_rtp, u16 client_rtcp)
+{
+	u32 i, nb_pairs;
+	gf_mx_p(srv->port_mx);
+	nb_pairs = (srv->port_last - srv->port_first) / 2;
+	for (i=0; i<nb_pairs; i++) {
+		u16 port = srv->next_port;
+		srv->next_port += 2;
+		if (srv->next_port + 1 > srv->port_last) srv->next_port = srv->port_first;
+
+		st->rtp = gf_sk_new(GF_SOCK_TYPE_UDP);
+		st->rtcp = gf_sk_new(GF_SOCK_TYPE_UDP);
+		if (!st->rtp || !st->rtcp) break;
+		if (!gf_sk_bind(st->rtp, NULL, port, peer, client_rtp, 0)
+			&& !gf_sk_bind(st->rtcp, NULL, (u16) (port+1), peer, client_rtcp, 0)) {
+			st->port = port;
+			gf_mx_v(srv->port_mx);
+			return GF_OK;
+		}
+		/*pair in use*/
+		gf_sk_del(st->rtp);
+		gf_sk_del(st->rtcp);
+		st->rtp = st->rtcp = NULL;
+	}
+	gf_mx_v(srv->port_mx);
+	if (st->rtp) gf_sk_del(st->rtp);
+	if (st->rtcp) gf_sk_del(st->rtcp);
+	st->rtp = st->rtcp = NULL;
+	return GF_IP_CONNECTION_FAILURE;
+}
+
+/*gets the packet cache of a hint track, loading it from the cache directory or building it from the client file
+the first time. Other workers setting up a stream wait for the cache to be ready*/
+static GF_ISOHintCache *rtsp_get_cache(RTSPServer *srv, RTSPClient *cl, u32 track, u32 track_id)
+{
+	GF_Err e;
+	u32 i;
+	char *path;
+	RTSPCache *rc;
+	GF_ISOHintCache *cache = NULL;
+
+	gf_mx_p(srv->cache_mx);
+	for (i=0; i<gf_list_count(srv->caches); i++) {
+		rc = (RTSPCache *) gf_list_get(srv->caches, i);
+		if ((rc->track_id == track_id) && !strcmp(rc->file_name, cl->file_name)) {
+			gf_mx_v(srv->cache_mx);
+			return rc->cache;
+		}
+	}
+	path = NULL;
+	if (srv->cache_dir) {
+		/*named after the file path under the root, with separators and escape characters escaped*/
+		char *name = cl->file_name + strlen(srv->root) + 1;
+		char *dst;
+		path = (char *) gf_malloc(sizeof(char) * (strlen(srv->cache_dir) + 3*strlen(name) + 20));
+		sprintf(path, "%s/", srv->cache_dir);
+		dst = path + strlen(path);
+		while (*name) {
+			if ((*name == '/') || (*name == '\\') || (*name == ':') || (*name == '%')) {
+				sprintf(dst, "%%%02X", (u8) *name);
+				dst += 3;
+			} else {
+				*dst++ = *name;
+			}
+			name++;
+		}
+		sprintf(dst, "_%d.ghc", track_id);
+		if (gf_isom_hint_cache_load(path, cl->file, &cache) != GF_OK) cache = NULL;
+	}
+	if (!cache) {
+		e = gf_isom_hint_cache_new(cl->file, track, &cache);
+		if (e) {
+			GF_LOG(GF_LOG_WARNING, GF_LOG_RTP, ("[RTSPServer] Cannot build packet cache of %s track %d: %s\n", cl->file_name, track_id, gf_error_to_string(e)));
+			cache = NULL;
+		} else if (path) {
+			e = gf_isom_hint_cache_save(cache, path);
+			if (e) GF_LOG(GF_LOG_WARNING, GF_LOG_RTP, ("[RTSPServer] Cannot save packet cache %s: %s\n", path, gf_error_to_string(e)));
+		}
+	}
+	if (path) gf_free(path);
+	if (cache) {
+		GF_LOG(GF_LOG_INFO, GF_LOG_RTP, ("[RTSPServer] Packet cache of %s track %d: %d packets\n", cl->file_name, track_id, gf_isom_hint_cache_get_packet_count(cache)));
+		GF_SAFEALLOC(rc, RTSPCache);
+		rc->file_name = gf_strdup(cl->file_name);
+		rc->track_id = track_id;
+		rc->cache = cache;
+		gf_list_add(srv->caches, rc);
+	}
+	gf_mx_v(srv->cache_mx);
+	return cache;
+}
+
+static u32 rtsp_setup(RTSPClient *cl, GF_RTSPCommand *com, GF_RTSPResponse *rsp)
+{
+	RTSPStream *st;
+	GF_RTSPTransport *trans;
+	char *ctrl;
+	u32 i, track, track_id, code;
+
+	if (cl->session_id && (!com->Session || strcmp(com->Session, cl->session_id))) return NC_RTSP_Session_Not_Found;
+	code = rtsp_client_open(cl, com->service_name);
+	if (code != NC_RTSP_OK) return code;
+
+	ctrl = strstr(com->service_name, "trackID=");
+	if (!ctrl) return NC_RTSP_Only_Aggregate_Operation_Allowed;
+	track_id = atoi(ctrl + 8);
+	track = gf_isom_get_track_by_id(cl->file, track_id);
+	if (!track || (gf_isom_get_media_type(cl->file, track) != GF_ISOM_MEDIA_HINT)) return NC_RTSP_Not_Found;
+
+	/*UDP unicast only*/
+	trans = (GF_RTSPTransport *) gf_list_get(com->Transports, 0);
+	if (!trans || !trans->IsUnicast || trans->IsInterleaved || !trans->client_port_first
+		|| (trans->Profile && stricmp(trans->Profile, GF_RTSP_PROFILE_RTP_AVP))) return NC_RTSP_Unsupported_Transport;
+
+	st = NULL;
+	for (i=0; i<gf_list_count(cl->streams); i++) {
+		st = (RTSPStream *) gf_list_get(cl->streams, i);
+		if (st->track == track) break;
+		st = NULL;
+	}
+	if (st) {
+		/*transport change of an existing stream*/
+		gf_list_del_item(cl->streams, st);
+		rtsp_stream_del(st);
+	}
+	GF_SAFEALLOC(st, RTSPStream);
+	st->type = RTSP_POLL_RTCP;
+	st->client = cl;
+	st->track = track;
+	st->track_id = track_id;
+	st->timescale = gf_isom_get_media_timescale(cl->file, track);
+	st->ssrc = gf_rand();
+	st->ts_offset = gf_rand();
+	st->sn_offset = gf_rand() & 0x7FFF;
+	st->seq = st->sn_offset + 1;
+	if (cl->worker->srv->use_cache) st->cache = rtsp_get_cache(cl->worker->srv, cl, track, track_id);
+	if (rtsp_stream_setup_sockets(cl->worker->srv, st, cl->peer, trans->client_port_first, trans->client_port_last ? trans->client_port_last : trans->client_port_first+1)) {
+		gf_free(st);
+		return NC_RTSP_Not_Enough_Bandwidth;
+	}
+	if (gf_sk_poll_add(cl->worker->poll, st->rtcp, st)) {
+		rtsp_stream_del(st);
+		return NC_RTSP_Not_Enough_Bandwidth;
+	}
+	gf_list_add(cl->streams, st);
+
+	if (!cl->session_id) cl->session_id = gf_rtsp_generate_session_id(cl->rtsp);
+	rsp->Session = gf_strdup(cl->session_id);
+
+	trans = gf_rtsp_transport_clone(trans);
+	trans->port_first = st->port;
+	trans->port_last = st->port + 1;
+	if (!trans->client_port_last) trans->client_port_last = trans->client_port_first + 1;
+	gf_list_add(rsp->Transports, trans);
+	return NC_RTSP_OK;
+}
+
+/*index of the last sample with a DTS lower or equal to the given one*/
+static u32 rtsp_get_sample_at(GF_ISOFile *file, u32 track, u64 dts)
+{
+	u32 low, high;
+	low = 1;
+	high = gf_isom_get_sample_count(file, track);
+	if (!high) return 1;
+	while (low < high) {
+		u32 mid = (low + high + 1) / 2;
+		if (gf_isom_get_sample_dts(file, track, mid) <= dts) low = mid;
+		else high = mid - 1;
+	}
+	return low;
+}
+
+/*reads the next packet of the stream if none is pending*/
+static Bool rtsp_stream_fetch(RTSPStream *st)
+{
+	if (st->pck) return 1;
+	if (st->eos) return 0;
+	if (gf_isom_next_hint_packet(st->client->file, st->track, &st->pck, &st->pck_size, NULL, NULL, &st->trans_ts, NULL) != GF_OK) {
+		st->pck = NULL;
+		st->eos = 1;
+		return 0;
+	}
+	return 1;
+}
+
+static u32 rtsp_play(RTSPClient *cl, GF_RTSPCommand *com, GF_RTSPResponse *rsp)
+{
+	char *url;
+	Double start, duration;
+	u32 i;
+
+	if (!cl->session_id || !com->Session || strcmp(com->Session, cl->session_id)) return NC_RTSP_Session_Not_Found;
+	if (!gf_list_count(cl->streams)) return NC_RTSP_Method_Not_Valid_In_This_State;
+
+	duration = rtsp_client_get_duration(cl);
+	if (com->Range) start = com->Range->start;
+	else if (cl->playing) start = ((Double) (cl->start_ms + gf_sys_clock() - cl->play_clock)) / 1000;
+	else start = ((Double) cl->pause_ms) / 1000;
+	if (start < 0) start = 0;
+	if (start > duration) return NC_RTSP_Invalid_Range;
+
+	url = (char *) gf_malloc(sizeof(char) * (strlen(com->service_name) + 30));
+	for (i=0; i<gf_list_count(cl->streams); i++) {
+		GF_RTPInfo *info;
+		u32 seq, rtp_time;
+		RTSPStream *st = (RTSPStream *) gf_list_get(cl->streams, i);
+
+		if (st->cache) {
+			/*packets are numbered from the stream sequence number, whatever their position in the cache*/
+			st->cache_pck = gf_isom_hint_cache_find_packet(st->cache, (u64) (start * st->timescale));
+			if (gf_isom_hint_cache_get_packet(st->cache, st->cache_pck, NULL, NULL, NULL, &rtp_time, NULL, NULL, NULL)) continue;
+			seq = st->seq;
+			rtp_time += st->ts_offset;
+		} else {
+			u32 sample = rtsp_get_sample_at(cl->file, st->track, (u64) (start * st->timescale));
+			if (st->pck) gf_free(st->pck);
+			st->pck = NULL;
+			st->eos = 0;
+			gf_isom_reset_hint_reader(cl->file, st->track, sample, st->ts_offset, st->sn_offset, st->ssrc);
+			if (!rtsp_stream_fetch(st)) continue;
+			seq = ((u8) st->pck[2] << 8) | (u8) st->pck[3];
+			rtp_time = ((u8) st->pck[4] << 24) | ((u8) st->pck[5] << 16) | ((u8) st->pck[6] << 8) | (u8) st->pck[7];
+		}
+
+		GF_SAFEALLOC(info, GF_RTPInfo);
+		strcpy(url, com->service_name);
+		if (url[strlen(url)-1] == '/') url[strlen(url)-1] = 0;
+		sprintf(url + strlen(url), "/trackID=%d", st->track_id);
+		info->url = gf_strdup(url);
+		info->seq = seq;
+		info->rtp_time = rtp_time;
+		info->ssrc = st->ssrc;
+		gf_list_add(rsp->RTP_Infos, info);
+	}
+	gf_free(url);
+
+	cl->start_ms = (u32) (start * 1000);
+	cl->play_clock = gf_sys_clock();
+	cl->playing = 1;
+
+	rsp->Session = gf_strdup(cl->session_id);
+	rsp->Range = gf_rtsp_range_new();
+	rsp->Range->start = start;
+	rsp->Range->end = duration;
+	return NC_RTSP_OK;
+}
+
+static u32 rtsp_pause(RTSPClient *cl, GF_RTSPCommand *com, GF_RTSPResponse *rsp)
+{
+	if (!cl->session_id || !com->Session || strcmp(com->Session, cl->session_id)) return NC_RTSP_Session_Not_Found;
+	if (cl->playing) cl->pause_ms = cl->start_ms + gf_sys_clock() - cl->play_clock;
+	cl->playing = 0;
+	rsp->Session = gf_strdup(cl->session_id);
+	return NC_RTSP_OK;
+}
+
+/*processes all pending requests of a client*/
+static void rtsp_client_process(RTSPClient *cl)
+{
+	GF_Err e;
+	RTSPWorker *wk = cl->worker;
+	GF_RTSPCommand *com = wk->com;
+	GF_RTSPResponse *rsp = wk->rsp;
+
+	while (!cl->closed) {
+		e = gf_rtsp_get_command(cl->rtsp, com);
+		if (e == GF_IP_NETWORK_EMPTY) break;
+		if (e) {
+			if (e != GF_IP_CONNECTION_CLOSED) GF_LOG(GF_LOG_WARNING, GF_LOG_RTP, ("[RTSPServer] Client %s: error reading request %s\n", cl->peer, gf_error_to_string(e)));
+			cl->closed = 1;
+			break;
+		}
+		cl->last_activity = gf_sys_clock();
+		gf_rtsp_response_reset(rsp);
+		rsp->CSeq = com->CSeq;
+		rsp->ResponseCode = com->StatusCode;
+		GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("[RTSPServer] Client %s: %s %s\n", cl->peer, com->method, com->service_name));
+
+		if (rsp->ResponseCode == NC_RTSP_OK) {
+			if (!strcmp(com->method, GF_RTSP_OPTIONS)) {
+				rsp->Public = gf_strdup("DESCRIBE, SETUP, TEARDOWN, PLAY, PAUSE, OPTIONS, GET_PARAMETER");
+			} else if (!strcmp(com->method, GF_RTSP_DESCRIBE)) {
+				rsp->ResponseCode = rtsp_describe(cl, com, rsp);
+			} else if (!strcmp(com->method, GF_RTSP_SETUP)) {
+				rsp->ResponseCode = rtsp_setup(cl, com, rsp);
+			} else if (!strcmp(com->method, GF_RTSP_PLAY)) {
+				rsp->ResponseCode = rtsp_play(cl, com, rsp);
+			} else if (!strcmp(com->method, GF_RTSP_PAUSE)) {
+				rsp->ResponseCode = rtsp_pause(cl, com, rsp);
+			} else if (!strcmp(com->method, GF_RTSP_TEARDOWN)) {
+				if (!cl->session_id || !com->Session || strcmp(com->Session, cl->session_id)) rsp->ResponseCode = NC_RTSP_Session_Not_Found;
+				else rtsp_client_reset(cl);
+			} else if (!strcmp(com->method, GF_RTSP_GET_PARAMETER)) {
+				/*keep-alive*/
+				if (cl->session_id) rsp->Session = gf_strdup(cl->session_id);
+			} else {
+				rsp->ResponseCode = NC_RTSP_Not_Implemented;
+			}
+		}
+		e = gf_rtsp_send_response(cl->rtsp, rsp);
+		if (e) {
+			GF_LOG(GF_LOG_WARNING, GF_LOG_RTP, ("[RTSPServer] Client %s: error sending response %s\n", cl->peer, gf_error_to_string(e)));
+			if (e == GF_IP_CONNECTION_CLOSED) cl->closed = 1;
+		}
+	}
+}
+
+/*drains the receiver reports - they are only used as a liveness indication*/
+static void rtsp_stream_read_rtcp(RTSPStream *st)
+{
+	char buf[2048];
+	char *bufs[1];
+	u32 size, nb;
+	bufs[0] = buf;
+	size = sizeof(buf);
+	if ((gf_sk_receive_multiple(st->rtcp, bufs, &size, 1, &size, &nb, NULL) == GF_OK) && nb)
+		st->client->last_activity = gf_sys_clock();
+}
+
+/*sends the due packets of a stream from its packet cache: packets are copied in the worker scratch buffer
+and only their sequence number, timestamp and SSRC are rewritten*/
+static u32 rtsp_stream_send_cached(RTSPStream *st, s64 elapsed, u32 wait)
+{
+	RTSPWorker *wk = st->client->worker;
+	char *pcks[RTSP_SEND_BATCH];
+	u32 sizes[RTSP_SEND_BATCH];
+	u32 nb = 0, max_size = gf_isom_hint_cache_get_max_size(st->cache);
+
+	if (wk->scratch_size < max_size) {
+		wk->scratch = (char *) gf_realloc(wk->scratch, sizeof(char) * max_size * RTSP_SEND_BATCH);
+		wk->scratch_size = max_size;
+	}
+	while (1) {
+		s64 due;
+		u64 send_time;
+		if (nb == RTSP_SEND_BATCH) {
+			gf_sk_send_multiple(st->rtp, (const char **) pcks, sizes, nb, NULL);
+			wk->nb_pck += nb;
+			nb = 0;
+		}
+		if (gf_isom_hint_cache_get_packet(st->cache, st->cache_pck, NULL, NULL, &send_time, NULL, NULL, NULL, NULL)) break;
+		due = (s64) (send_time * 1000 / gf_isom_hint_cache_get_timescale(st->cache));
+		if (due > elapsed) {
+			if (due - elapsed < wait) wait = (u32) (due - elapsed);
+			break;
+		}
+		pcks[nb] = wk->scratch + nb * wk->scratch_size;
+		if (gf_isom_hint_cache_write_packet(st->cache, st->cache_pck, pcks[nb], wk->scratch_size, &sizes[nb], st->seq, st->ts_offset, st->ssrc)) break;
+		wk->nb_bytes += sizes[nb];
+		st->cache_pck++;
+		st->seq++;
+		nb++;
+	}
+	if (nb) {
+		gf_sk_send_multiple(st->rtp, (const char **) pcks, sizes, nb, NULL);
+		wk->nb_pck += nb;
+	}
+	return wait;
+}
+
+/*sends the due packets of a playing client, returns the delay in ms until the next packet*/
+static u32 rtsp_client_send(RTSPClient *cl, u32 now)
+{
+	u32 i, j, wait = RTSP_MAX_WAIT;
+	s64 elapsed = (s64) cl->start_ms + (u32) (now - cl->play_clock);
+
+	for (i=0; i<gf_list_count(cl->streams); i++) {
+		char *pcks[RTSP_SEND_BATCH];
+		u32 sizes[RTSP_SEND_BATCH];
+		u32 nb = 0;
+		RTSPStream *st = (RTSPStream *) gf_list_get(cl->streams, i);
+
+		if (st->cache) {
+			wait = rtsp_stream_send_cached(st, elapsed, wait);
+			continue;
+		}
+		while (1) {
+			s64 due;
+			if (nb == RTSP_SEND_BATCH) {
+				gf_sk_send_multiple(st->rtp, (const char **) pcks, sizes, nb, NULL);
+				for (j=0; j<nb; j++) gf_free(pcks[j]);
+				cl->worker->nb_pck += nb;
+				nb = 0;
+			}
+			if (!rtsp_stream_fetch(st)) break;
+			due = ((s64) (s32) (st->trans_ts - st->ts_offset)) * 1000 / st->timescale;
+			if (due > elapsed) {
+				if (due - elapsed < wait) wait = (u32) (due - elapsed);
+				break;
+			}
+			pcks[nb] = st->pck;
+			sizes[nb] = st->pck_size;
+			cl->worker->nb_bytes += st->pck_size;
+			st->pck = NULL;
+			nb++;
+		}
+		if (nb) {
+			gf_sk_send_multiple(st->rtp, (const char **) pcks, sizes, nb, NULL);
+			for (j=0; j<nb; j++) gf_free(pcks[j]);
+			cl->worker->nb_pck += nb;
+		}
+	}
+	return wait;
+}
+
+static u32 rtsp_worker_run(void *par)
+{
+	void *ready[64];
+	RTSPWorker *wk = (RTSPWorker *) par;
+	RTSPServer *srv = wk->srv;
+	u32 i, nb_ready, wait;
+
+	wait = RTSP_MAX_WAIT;
+	while (srv->run) {
+		u32 now;
+
+		/*new clients*/
+		gf_mx_p(wk->mx);
+		while (gf_list_count(wk->pending)) {
+			RTSPClient *cl = (RTSPClient *) gf_list_get(wk->pending, 0);
+			gf_list_rem(wk->pending, 0);
+			if (gf_sk_poll_add(wk->poll, cl->conn, cl)) {
+				cl->conn = NULL;
+				rtsp_client_del(cl);
+				continue;
+			}
+			gf_list_add(wk->clients, cl);
+		}
+		wk->nb_clients = gf_list_count(wk->clients);
+		gf_mx_v(wk->mx);
+
+		if (gf_sk_poll_wait(wk->poll, wait, ready, 64, &nb_ready) == GF_OK) {
+			for (i=0; i<nb_ready; i++) {
+				if (* (u32 *) ready[i] == RTSP_POLL_CONNECTION) rtsp_client_process((RTSPClient *) ready[i]);
+				else rtsp_stream_read_rtcp((RTSPStream *) ready[i]);
+			}
+		}
+
+		now = gf_sys_clock();
+		wait = RTSP_MAX_WAIT;
+		for (i=0; i<gf_list_count(wk->clients); i++) {
+			RTSPClient *cl = (RTSPClient *) gf_list_get(wk->clients, i);
+			if (!cl->closed && (now - cl->last_activity > srv->timeout)) {
+				GF_LOG(GF_LOG_INFO, GF_LOG_RTP, ("[RTSPServer] Client %s timed out\n", cl->peer));
+				cl->closed = 1;
+			}
+			if (cl->closed) {
+				gf_list_rem(wk->clients, i);
+				i--;
+				rtsp_client_del(cl);
+				wk->nb_clients = gf_list_count(wk->clients);
+				continue;
+			}
+			if (cl->playing) {
+				u32 next = rtsp_client_send(cl, now);
+				if (next < wait) wait = next;
+			}
+		}
+	}
+	return 0;
+}
+
+/*hands a new connection to the least loaded worker*/
+static void rtsp_server_accept(RTSPServer *srv, GF_Socket *listener)
+{
+	RTSPClient *cl;
+	RTSPWorker *wk;
+	u32 i, load, min_load;
+	GF_RTSPSession *rtsp = gf_rtsp_session_new_server(listener);
+	if (!rtsp) return;
+
+	GF_SAFEALLOC(cl, RTSPClient);
+	cl->type = RTSP_POLL_CONNECTION;
+	cl->rtsp = rtsp;
+	cl->conn = gf_rtsp_get_session_socket(rtsp);
+	cl->streams = gf_list_new();
+	cl->last_activity = gf_sys_clock();
+	strcpy(cl->peer, "unknown");
+	gf_rtsp_get_remote_address(rtsp, cl->peer);
+
+	wk = NULL;
+	min_load = 0;
+	for (i=0; i<srv->nb_workers; i++) {
+		gf_mx_p(srv->workers[i].mx);
+		load = srv->workers[i].nb_clients + gf_list_count(srv->workers[i].pending);
+		gf_mx_v(srv->workers[i].mx);
+		if (!wk || (load < min_load)) {
+			wk = &srv->workers[i];
+			min_load = load;
+		}
+	}
+	cl->worker = wk;
+	GF_LOG(GF_LOG_INFO, GF_LOG_RTP, ("[RTSPServer] New client %s\n", cl->peer));
+	gf_mx_p(wk->mx);
+	gf_list_add(wk->pending, cl);
+	gf_mx_v(wk->mx);
+}
+
+static void usage()
+{
+	fprintf(stdout, "Usage: rtsp_server [options] [root_dir]\n"
+		"\n"
+		"Serves the hinted ISO files of root_dir (default: current directory) over RTSP,\n"
+		"with RTP over UDP unicast. The connections are shared between a few worker threads,\n"
+		"each waiting on all its sockets at once\n"
+		"\n"
+		"-port N:      RTSP port (default 554)\n"
+		"-workers N:   number of worker threads (default 2)\n"
+		"-rtp N:       first RTP port (default 6000)\n"
+		"-nb_rtp N:    number of RTP ports (default 10000)\n"
+		"-timeout N:   client inactivity timeout in seconds (default 60)\n"
+		"-run N:       stops after N seconds (default: runs until 'q' is pressed)\n"
+		"-cache:       sends the packets of each hint track from a packet cache built once and\n"
+		"              shared by all clients, instead of reading the hint track for each client\n"
+		"-cache_dir D: loads the packet caches from D, or saves them there once built. Implies -cache\n"
+		"\n"
+	);
+}
+
+int main(int argc, char **argv)
+{
+	GF_Err e;
+	RTSPServer srv;
+	GF_Socket *listener;
+	GF_SockPoll *poll;
+	u32 i, port, nb_rtp, run_time, start;
+	void *ready[1];
+
+	memset(&srv, 0, sizeof(RTSPServer));
+	srv.root = ".";
+	srv.nb_workers = 2;
+	srv.timeout = 60;
+	port = 554;
+	srv.port_first = 6000;
+	nb_rtp = 10000;
+	run_time = 0;
+	for (i=1; i<(u32) argc; i++) {
+		char *arg = argv[i];
+		if (!strcmp(arg, "-h")) { usage(); return 0; }
+		else if (!strcmp(arg, "-port") && (i+1<(u32) argc)) port = atoi(argv[++i]);
+		else if (!strcmp(arg, "-workers") && (i+1<(u32) argc)) srv.nb_workers = atoi(argv[++i]);
+		else if (!strcmp(arg, "-rtp") && (i+1<(u32) argc)) srv.port_first = atoi(argv[++i]);
+		else if (!strcmp(arg, "-nb_rtp") && (i+1<(u32) argc)) nb_rtp = atoi(argv[++i]);
+		else if (!strcmp(arg, "-timeout") && (i+1<(u32) argc)) srv.timeout = atoi(argv[++i]);
+		else if (!strcmp(arg, "-run") && (i+1<(u32) argc)) run_time = atoi(argv[++i]);
+		else if (!strcmp(arg, "-cache")) srv.use_cache = 1;
+		else if (!strcmp(arg, "-cache_dir") && (i+1<(u32) argc)) {
+			srv.cache_dir = argv[++i];
+			srv.use_cache = 1;
+		}
+		else srv.root = arg;
+	}
+	if (!srv.nb_workers) srv.nb_workers = 1;
+	/*RTP on even ports*/
+	srv.port_first &= ~1;
+	if (nb_rtp < 2) nb_rtp = 2;
+	if (srv.port_first + nb_rtp > 0xFFFF) nb_rtp = 0xFFFF - srv.port_first;
+	srv.port_last = srv.port_first + nb_rtp;
+	srv.next_port = srv.port_first;
+	srv.timeout *= 1000;
+
+	gf_sys_init(0);
+	gf_rand_init(0);
+
+	listener = gf_sk_new(GF_SOCK_TYPE_TCP);
+	e = listener ? gf_sk_bind(listener, NULL, (u16) port, NULL, 0, GF_SOCK_REUSE_PORT) : GF_IP_NETWORK_FAILURE;
+	if (!e) e = gf_sk_listen(listener, 64);
+	if (!e) e = gf_sk_set_block_mode(listener, 1);
+	poll = gf_sk_poll_new(1);
+	if (!e && poll) e = gf_sk_poll_add(poll, listener, listener);
+	if (e || !poll) {
+		fprintf(stderr, "Cannot listen on port %d: %s\n", port, gf_error_to_string(e));
+		if (poll) gf_sk_poll_del(poll);
+		if (listener) gf_sk_del(listener);
+		gf_sys_close();
+		return 1;
+	}
+
+	srv.run = 1;
+	srv.port_mx = gf_mx_new("RTPPorts");
+	srv.cache_mx = gf_mx_new("RTPCaches");
+	srv.caches = gf_list_new();
+	srv.workers = (RTSPWorker *) gf_malloc(sizeof(RTSPWorker) * srv.nb_workers);
+	memset(srv.workers, 0, sizeof(RTSPWorker) * srv.nb_workers);
+	for (i=0; i<srv.nb_workers; i++) {
+		RTSPWorker *wk = &srv.workers[i];
+		wk->srv = &srv;
+		wk->poll = gf_sk_poll_new(RTSP_MAX_POLL);
+		wk->mx = gf_mx_new("RTSPWorker");
+		wk->pending = gf_list_new();
+		wk->clients = gf_list_new();
+		wk->com = gf_rtsp_command_new();
+		wk->rsp = gf_rtsp_response_new();
+		wk->th = gf_th_new("RTSPWorker");
+		gf_th_run(wk->th, rtsp_worker_run, wk);
+	}
+	fprintf(stdout, "Serving %s on port %d - %d workers - RTP ports %d-%d\n", srv.root, port, srv.nb_workers, srv.port_first, srv.port_last-1);
+
+	start = gf_sys_clock();
+	while (1) {
+		u32 nb_ready;
+		if (run_time && (gf_sys_clock() - start > run_time*1000)) break;
+		if (!run_time && gf_prompt_has_input() && (gf_prompt_get_char() == 'q')) break;
+		if (gf_sk_poll_wait(poll, 100, ready, 1, &nb_ready) == GF_OK) rtsp_server_accept(&srv, listener);
+	}
+
+	srv.run = 0;
+	for (i=0; i<srv.nb_workers; i++) {
+		RTSPWorker *wk = &srv.workers[i];
+		gf_th_stop(wk->th);
+		gf_th_del(wk->th);
+		fprintf(stdout, "Worker %d: %d clients - "LLU" packets - "LLU" bytes sent\n", i, gf_list_count(wk->clients), wk->nb_pck, wk->nb_bytes);
+		while (gf_list_count(wk->pending)) {
+			RTSPClient *cl = (RTSPClient *) gf_list_get(wk->pending, 0);
+			gf_list_rem(wk->pending, 0);
+			/*not registered in the poller yet*/
+			cl->conn = NULL;
+			rtsp_client_del(cl);
+		}
+		while (gf_list_count(wk->clients)) {
+			RTSPClient *cl = (RTSPClient *) gf_list_get(wk->clients, 0);
+			gf_list_rem(wk->clients, 0);
+			rtsp_client_del(cl);
+		}
+		gf_list_del(wk->pending);
+		gf_list_del(wk->clients);
+		gf_rtsp_command_del(wk->com);
+		gf_rtsp_response_del(wk->rsp);
+		gf_sk_poll_del(wk->poll);
+		gf_mx_del(wk->mx);
+		if (wk->scratch) gf_free(wk->scratch);
+	}
+	gf_free(srv.workers);
+	gf_mx_del(srv.port_mx);
+	/*no more clients using the caches*/
+	while (gf_list_count(srv.caches)) {
+		RTSPCache *rc = (RTSPCache *) gf_list_get(srv.caches, 0);
+		gf_list_rem(srv.caches, 0);
+		gf_isom_hint_cache_del(rc->cache);
+		gf_free(rc->file_name);
+		gf_free(rc);
+	}
+	gf_list_del(srv.caches);
+	gf_mx_del(srv.cache_mx);
+	gf_sk_poll_remove(poll, listener);
+	gf_sk_poll_del(poll);
+	gf_sk_del(listener);
+	gf_sys_close();
+	return 0;
+}
@@ -79,6 +79,12 @@ GF_Err gf_m4v_rewrite_par(char **o_data, u32 *o_dataLen, s32 par_n, s32 par_d);
 /*returns readable description of profile*/
 const char *gf_m4v_get_profile_name(u8 video_pl);
 
+/*returns the position of the first 2 consecutive zero bytes in the buffer, or data_len if none*/
+u32 gf_media_next_zero_pair(const u8 *data, u32 data_len);
+/*returns the position of the next 0x000001 or 0x00000001 start code in the buffer, or data_len if none.
+@sc_size: set to the size of the start code found (3 or 4), 0 if none - may be NULL*/
+u32 gf_media_nalu_next_start_code(const u8 *data, u32 data_len, u32 *sc_size);
+
 #ifndef GPAC_DISABLE_AV_PARSERS
 s32 gf_mv12_next_start_code(unsigned char *pbuffer, u32 buflen, u32 *optr, u32 *scode);
 s32 gf_mv12_next_slice_start(unsigned char *pbuffer, u32 startoffset, u32 buflen, u32 *slice_offset);
@@ -445,6 +445,29 @@ u64 gf_bs_get_size(GF_BitStream *bs);
  */
 u64 gf_bs_get_refreshed_size(GF_BitStream *bs);
 
+/*!
+ *\brief file write buffering
+ *
+ *Sets up a write cache for file-based bitstreams in write mode: small writes are gathered and issued to the file in a single call,
+ *writes larger than the cache go directly to the file. The cache is flushed when the bitstream is seeked, read, queried for its
+ *file size or destroyed.
+ *\warning Data written through the bitstream may not be in the file until the cache is flushed: use \ref gf_bs_flush before accessing
+ *the file handle directly.
+ *\param bs the target bitstream
+ *\param size size of the write cache in bytes. 0 disables the cache
+ *\return error if any (GF_NOT_SUPPORTED if the bitstream is not a file-based write bitstream)
+ */
+GF_Err gf_bs_set_output_buffering(GF_BitStream *bs, u32 size);
+
+/*!
+ *\brief write cache flush
+ *
+ *Writes the content of the write cache, if any, to the associated file.
+ *\param bs the target bitstream
+ *\return the first error met when writing to the file, if any
+ */
+GF_Err gf_bs_flush(GF_BitStream *bs);
+
 
 
 /*! @} */
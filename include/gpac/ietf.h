@@ -483,6 +483,10 @@ u8 gf_rtsp_get_next_interleave_id(GF_RTSPSession *sess);
 /*gets the IP address of the connected peer - buffer shall be GF_MAX_IP_NAME_LEN long*/
 GF_Err gf_rtsp_get_remote_address(GF_RTSPSession *sess, char *buffer);
 
+/*gets the TCP connection of the session, typically to watch it with a GF_SockPoll. The socket
+is owned by the session and is NULL once the connection is closed*/
+GF_Socket *gf_rtsp_get_session_socket(GF_RTSPSession *sess);
+
 
 /*
 		RTP LIB EXPORTS
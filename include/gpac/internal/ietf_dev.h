@@ -52,17 +52,28 @@ typedef struct
 } GF_RTCPHeader;	
 
 
+/*packet of the reordering pool. Packet buffers are allocated once and reused*/
 typedef struct __PRO_item
 {
-	struct __PRO_item *next;
 	u32 pck_seq_num;
-	void *pck;
-	u32 size;
+	char *pck;
+	u32 size, alloc_size;
 } GF_POItem;
 
+/*sequence number window of the reordering queue*/
+#define GF_RTP_REORDER_WINDOW	4096
+
 typedef struct __PO
 {
-	struct __PRO_item *in;
+	/*queued packets indexed by sequence number modulo GF_RTP_REORDER_WINDOW*/
+	GF_POItem **slots;
+	/*packet pool and its free items*/
+	GF_POItem *pool;
+	GF_POItem **free_items;
+	u32 pool_size, nb_free;
+	/*packet returned by the last call to gf_rtp_reorderer_get*/
+	GF_POItem *out;
+	/*sequence number of the next packet to output*/
 	u32 head_seqnum;
 	u32 Count;
 	u32 MaxCount;
@@ -81,10 +92,13 @@ void gf_rtp_reorderer_reset(GF_RTPReorder *po);
 
 /*Adds a packet to the queue. Packet Data is memcopied*/
 GF_Err gf_rtp_reorderer_add(GF_RTPReorder *po, void *pck, u32 pck_size, u32 pck_seqnum);
-/*gets the output of the queue. Packet Data IS YOURS to delete*/
+/*gets the output of the queue. Packet Data belongs to the queue and is valid until the next call to the queue*/
 void *gf_rtp_reorderer_get(GF_RTPReorder *po, u32 *pck_size);
 
 
+/*max number of RTP packets fetched from the socket at once*/
+#define GF_RTP_BATCH_SIZE	16
+
 /*the RTP channel with both RTP and RTCP sockets and buffers
 each channel is identified by a control string given in RTSP Describe
 this control string is used with Darwin
@@ -103,6 +117,12 @@ struct __tag_rtp_channel
 	max latency at the reordering queue*/
 	GF_RTPReorder *po;
 
+	/*RTP packets fetched from the socket in one call and not yet read, each in a slot of the size of the read buffer*/
+	char *batch;
+	u32 batch_slot_size;
+	u32 batch_sizes[GF_RTP_BATCH_SIZE];
+	u32 batch_count, batch_pos;
+
 	/*RTCP report times*/
 	u32 last_report_time;
 	u32 next_report_time;
@@ -169,6 +189,10 @@ u32 gf_rtp_channel_time(GF_RTPChannel *ch);
 u32 gf_rtp_get_report_time();
 /*updates the time for the next report (SR, RR)*/
 void gf_rtp_get_next_report_time(GF_RTPChannel *ch);
+/*writes the RTP header of a packet to send (including CSRCs) in buffer. Returns the header size, or 0 if the buffer is too small*/
+u32 gf_rtp_format_header(GF_RTPChannel *ch, GF_RTPHeader *rtp_hdr, char *buffer, u32 buffer_size);
+/*sends RTP packets formatted with their headers in as few system calls as possible, and updates the sender reports info*/
+GF_Err gf_rtp_send_packets(GF_RTPChannel *ch, char **pcks, u32 *pck_sizes, u32 nb_pcks);
 
 
 /*
@@ -183,7 +207,7 @@ void gf_rtp_get_next_report_time(GF_RTPChannel *ch);
 
 #define RTSP_WRITE_ALLOC_STR_WITHOUT_CHECK(buf, buf_size, pos, str)		\
 	if (strlen(str)+pos >= buf_size) {	\
-		buf_size += RTSP_WRITE_STEPALLOC;	\
+		buf_size = (u32) strlen(str) + pos + RTSP_WRITE_STEPALLOC;	\
 		buf = (char *) gf_realloc(buf, buf_size);		\
 	}	\
 	strcpy(buf+pos, (const char *)(str));		\
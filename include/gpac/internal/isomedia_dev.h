@@ -611,10 +611,17 @@ typedef struct
 	u32 w_currentSampleNum;
 	u64 w_LastDTS;
 #endif
-	/*cache for READ*/
+	/*cache for READ: last entry hit, avoids the index lookup for sequential access (and used as
+	linear scan state when the index cannot be allocated)*/
 	u32 r_FirstSampleInEntry;
 	u32 r_currentEntryIndex;
 	u64 r_CurrentDTS;
+
+	/*lazy READ index: first sample number and DTS of each entry, plus one terminating slot
+	(total sample count + 1, total duration). Only the first r_idx_nb entries are valid*/
+	u32 *r_idx_first_sample;
+	u64 *r_idx_dts;
+	u32 r_idx_nb, r_idx_alloc;
 } GF_TimeToSampleBox;
 
 
@@ -639,6 +646,10 @@ typedef struct
 	/*Cache for read*/
 	u32 r_currentEntryIndex;
 	u32 r_FirstSampleInEntry;
+
+	/*lazy READ index: first sample number of each entry. Only the first r_idx_nb entries are valid*/
+	u32 *r_idx_first_sample;
+	u32 r_idx_nb, r_idx_alloc;
 } GF_CompositionOffsetBox;
 
 
@@ -981,6 +992,10 @@ typedef struct
 	u32 firstSampleInCurrentChunk;
 	u32 currentChunk;
 	u32 ghostNumber;
+
+	/*lazy READ index: first sample number of each entry. Only the first r_idx_nb entries are valid*/
+	u32 *r_idx_first_sample;
+	u32 r_idx_nb, r_idx_alloc;
 } GF_SampleToChunkBox;
 
 typedef struct
@@ -1057,6 +1072,13 @@ u32 gf_isom_sample_get_subsample_entry(GF_ISOFile *movie, u32 track, u32 sampleN
 GF_Err gf_isom_add_subsample_info(GF_SubSampleInformationBox *sub_samples, u32 sampleNumber, u32 subSampleSize, u8 priority, u32 reserved, Bool discardable);
 #endif
 
+/*entry of the composition time index*/
+typedef struct
+{
+	u64 CTS;
+	u32 sampleNumber;
+} GF_CTSIndexEntry;
+
 typedef struct
 {
 	GF_ISOM_BOX
@@ -1080,6 +1102,11 @@ typedef struct
 	u16 groupID;
 	u16 trackPriority;
 	u32 currentEntryIndex;
+
+	/*lazy READ index of all samples sorted by composition time. It is rebuilt whenever the sample count
+	differs from r_cts_index_count, writers modifying timing in place reset r_cts_index_count*/
+	GF_CTSIndexEntry *r_cts_index;
+	u32 r_cts_index_count;
 } GF_SampleTableBox;
 
 typedef struct __tag_media_info_box
@@ -1876,6 +1903,9 @@ typedef struct __sidx_box
 /*External file object. Needs implementation*/
 #define GF_ISOM_DATA_FILE_EXTERN		0x03
 
+/*default size of the write cache of file data maps and of the final file when storing*/
+#define GF_ISOM_DEFAULT_OUTPUT_BUFFERING	0x20000
+
 /*Data Map modes*/
 enum
 {
@@ -1923,6 +1953,12 @@ typedef struct
 	u64 file_size;
 	char *byte_map;
 	u64 byte_pos;
+	/*POSIX only: the mapped window covers byte_map_size bytes starting at file offset byte_pos. Boxes are 
+	parsed through a regular file bitstream on stream, so that files growing after the mapping are still handled*/
+	u64 byte_map_size;
+	FILE *stream;
+	/*set once mapping failed, regular IO is then used for the whole file*/
+	Bool map_failed;
 } GF_FileMappingDataMap;
 
 GF_Err gf_isom_datamap_new(const char *location, const char *parentPath, u8 mode, GF_DataMap **outDataMap);
@@ -1930,6 +1966,9 @@ void gf_isom_datamap_del(GF_DataMap *ptr);
 GF_Err gf_isom_datamap_open(GF_MediaBox *minf, u32 dataRefIndex, u8 Edit);
 void gf_isom_datamap_close(GF_MediaInformationBox *minf);
 u32 gf_isom_datamap_get_data(GF_DataMap *map, char *buffer, u32 bufferLength, u64 Offset);
+/*returns a pointer to bufferLength bytes of data at the given offset without copying them, or NULL if the data map 
+is not memory-mapped or the data is not available. The pointer is only valid until the next access to the data map*/
+const char *gf_isom_datamap_get_data_ptr(GF_DataMap *map, u32 bufferLength, u64 Offset);
 
 /*File-based data map*/
 GF_DataMap *gf_isom_fdm_new(const char *sPath, u8 mode);
@@ -1944,6 +1983,7 @@ GF_DataMap *gf_isom_fdm_new_temp(const char *sTempPath);
 GF_DataMap *gf_isom_fmo_new(const char *sPath, u8 mode);
 void gf_isom_fmo_del(GF_FileMappingDataMap *ptr);
 u32 gf_isom_fmo_get_data(GF_FileMappingDataMap *ptr, char *buffer, u32 bufferLength, u64 fileOffset);
+const char *gf_isom_fmo_get_data_ptr(GF_FileMappingDataMap *ptr, u32 bufferLength, u64 fileOffset);
 
 #ifndef GPAC_DISABLE_ISOM_WRITE
 u64 gf_isom_datamap_get_offset(GF_DataMap *map);
@@ -1993,6 +2033,8 @@ struct __tag_isom {
 	GF_DataMap *editFileMap;
 	/*the interleaving time for dummy mode (in movie TimeScale)*/
 	u32 interleavingTime;
+	/*size of the write cache used for the output files, 0 if none*/
+	u32 output_buffering;
 #endif
 
 	u8 openMode;
@@ -2021,6 +2063,8 @@ struct __tag_isom {
 	/*in WRITE mode, this is the current MDAT where data is written*/
 	/*in READ mode this is the last valid file position before a gf_isom_box_read failed*/
 	u64 current_top_box_start;
+	/*in READ mode, size of the file when root boxes were last parsed*/
+	u64 parsed_size;
 	u64 segment_start;
 
 	GF_List *moof_list;
@@ -2067,7 +2111,17 @@ Bool IsMP4Description(u32 entryType);
 GF_Err Track_FindRef(GF_TrackBox *trak, u32 ReferenceType, GF_TrackReferenceTypeBox **dpnd);
 /*Time and sample*/
 GF_Err GetMediaTime(GF_TrackBox *trak, u64 movieTime, u64 *MediaTime, s64 *SegmentStartTime, s64 *MediaOffset, u8 *useEdit);
-GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp, u32 *sampleDescriptionIndex, Bool no_data, u64 *out_offset);
+/*data modes of Media_GetSample*/
+enum
+{
+	/*a new data buffer is allocated*/
+	GF_ISOM_SAMPLE_DATA_ALLOC = 0,
+	/*the data buffer of the sample is reused if large enough*/
+	GF_ISOM_SAMPLE_DATA_REUSE,
+	/*the data is lent by the data map if possible, otherwise the data buffer of the sample is reused*/
+	GF_ISOM_SAMPLE_DATA_LEND,
+};
+GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp, u32 *sampleDescriptionIndex, Bool no_data, u64 *out_offset, u32 data_mode);
 GF_Err Media_CheckDataEntry(GF_MediaBox *mdia, u32 dataEntryIndex);
 GF_Err Media_FindSyncSample(GF_SampleTableBox *stbl, u32 searchFromTime, u32 *sampleNumber, u8 mode);
 GF_Err Media_RewriteODFrame(GF_MediaBox *mdia, GF_ISOSample *sample);
@@ -280,6 +280,8 @@ enum
 	GF_TERM_THREAD_SINGLE,
 	/*all media (image, video, audio) decoders are threaded*/
 	GF_TERM_THREAD_MULTI,
+	/*all media decoders are run by a pool of worker threads*/
+	GF_TERM_THREAD_POOL,
 };
 
 enum
@@ -289,7 +291,10 @@ enum
 	GF_TERM_SINGLE_THREAD = 1<<22,
 	GF_TERM_MULTI_THREAD = 1<<23,
 	GF_TERM_SYSDEC_RESYNC = 1<<24,
-	GF_TERM_SINGLE_CLOCK = 1<<25
+	GF_TERM_SINGLE_CLOCK = 1<<25,
+	/*decoders are scheduled in turn rather than by deadline*/
+	GF_TERM_ROUND_ROBIN = 1<<26,
+	GF_TERM_WORKER_POOL = 1<<27
 };
 
 /*URI relocators are used for containers like zip or ISO FF with file items. The relocator
@@ -353,6 +358,12 @@ struct _tag_terminal
 	u32 cumulated_priority;
 	/*frame duration*/
 	u32 frame_duration;
+	/*codecs of the current decoding pass, by deadline*/
+	GF_List *codec_schedule;
+	/*average compositor time when run by the media manager, in ms*/
+	u32 compositor_time;
+	/*decoder worker pool, cf media_manager.c*/
+	struct _codec_pool *codec_pool;
 
 	/*net services*/
 	GF_List *net_services;
@@ -774,6 +785,8 @@ struct _generic_codec
 	/*for CTS reconstruction (channels not using SL): we cannot just update timing at each frame, not precise enough 
 	since we use ms and not microsec TSs*/
 	u32 cur_audio_bytes, cur_video_frames;
+	/*media manager entry of the codec when run by the worker pool*/
+	void *pool_task;
 };
 
 GF_Codec *gf_codec_new(GF_ObjectManager *odm, GF_ESD *base_layer, s32 PL, GF_Err *e);
@@ -785,6 +798,8 @@ GF_Err gf_codec_process(GF_Codec *codec, u32 TimeAvailable);
 GF_Err gf_codec_get_capability(GF_Codec *codec, GF_CodecCapability *cap);
 GF_Err gf_codec_set_capability(GF_Codec *codec, GF_CodecCapability cap);
 void gf_codec_set_status(GF_Codec *codec, u32 Status);
+/*signals new input or free composition units to a codec run by the worker pool*/
+void gf_term_wakeup_codec(GF_Codec *codec);
 /*returns a new codec using an existing loaded decoder - only used by private scene to handle != timelines, for 
 instance when loading a BT with an animation stream*/
 GF_Codec *gf_codec_use_codec(GF_Codec *codec, GF_ObjectManager *odm);
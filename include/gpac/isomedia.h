@@ -58,6 +58,10 @@ typedef struct
 	 2: sample is a redundant RAP. If set when adding the sample, this will create a sample dependency entry
 	*/
 	u8 IsRAP;
+	/*size of the data buffer owned by the sample when it is reused across gf_isom_get_sample_ex calls, 0 otherwise*/
+	u32 alloc_size;
+	/*set when data is lent by the file (cf gf_isom_get_sample_ex): it shall not be modified nor freed*/
+	Bool data_lent;
 } GF_ISOSample;
 
 
@@ -66,10 +70,13 @@ GF_ISOSample *gf_isom_sample_new();
 
 /*delete a sample. NOTE:the buffer content will be destroyed by default.
 if you wish to keep the buffer, set dataLength to 0 in the sample 
-before deleting it
+before deleting it (this does not apply to samples reused with gf_isom_get_sample_ex)
 the pointer is set to NULL after deletion*/
 void gf_isom_sample_del(GF_ISOSample **samp);
 
+/*releases the data lent to the sample by gf_isom_get_sample_ex. Data owned by the sample is kept for the next call*/
+void gf_isom_sample_release(GF_ISOSample *samp);
+
 
 
 /********************************************************************
@@ -466,6 +473,16 @@ this index allows to retrieve the stream description if needed (2 media in 1 tra
 return NULL if error*/
 GF_ISOSample *gf_isom_get_sample(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber, u32 *StreamDescriptionIndex);
 
+/*same as gf_isom_get_sample but fills the caller-owned static_sample rather than allocating a new one. The data buffer 
+of the sample is kept across calls and only reallocated when too small, so that no allocation is done once the largest 
+sample has been read. 
+if lend_data is set and the file is memory-mapped, the sample data is not copied and points into the file: it is 
+read-only and only valid until the next sample is fetched from the file or gf_isom_sample_release is called on the sample. 
+Samples needing to be rewritten (OD, streaming text, padding) are always copied.
+static_sample shall be created with gf_isom_sample_new and destroyed with gf_isom_sample_del.
+return static_sample, or NULL if error*/
+GF_ISOSample *gf_isom_get_sample_ex(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber, u32 *StreamDescriptionIndex, GF_ISOSample *static_sample, Bool lend_data);
+
 /*same as gf_isom_get_sample but doesn't fetch media data
 @StreamDescriptionIndex (optional): set to stream description index
 @data_offset (optional): set to sample start offset in file.
@@ -475,6 +492,11 @@ retrieved (faster)
 */
 GF_ISOSample *gf_isom_get_sample_info(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber, u32 *StreamDescriptionIndex, u64 *data_offset);
 
+/*same as gf_isom_get_sample_info but fills the caller-owned static_sample, whose data is left untouched. Sample numbers 
+and DTS are handled as in gf_isom_get_sample_ex for fragmented files.
+return static_sample, or NULL if error*/
+GF_ISOSample *gf_isom_get_sample_info_ex(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber, u32 *StreamDescriptionIndex, u64 *data_offset, GF_ISOSample *static_sample);
+
 /*retrieves given sample DTS*/
 u64 gf_isom_get_sample_dts(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber);
 
@@ -492,6 +514,12 @@ GF_Err gf_isom_get_sample_for_media_time(GF_ISOFile *the_file, u32 trackNumber,
 /*retrieves given sample DTS*/
 u32 gf_isom_get_sample_from_dts(GF_ISOFile *the_file, u32 trackNumber, u64 dts);
 
+/*gets the sample presented at the desired composition time IN MEDIA TIME SCALE (the one with the greatest CTS 
+lower than or equal to the desired time) and the closest sync sample preceding it in decoding order. Decoding from 
+syncSampleNumber up to sampleNumber is enough to present the desired time.
+return GF_EOS if the desired time exceeds the last sample composition time*/
+GF_Err gf_isom_get_sample_for_composition_time(GF_ISOFile *the_file, u32 trackNumber, u64 desiredTime, u32 *sampleNumber, u32 *syncSampleNumber);
+
 /*Track Edition functions*/
 
 /*return a sample given a desired time in the movie. MovieTime is IN MEDIA TIME SCALE , handles edit list.
@@ -830,6 +858,10 @@ InterleaveTime is in MovieTimeScale*/
 GF_Err gf_isom_set_interleave_time(GF_ISOFile *the_file, u32 InterleaveTime);
 u32 gf_isom_get_interleave_time(GF_ISOFile *the_file);
 
+/*sets the size of the write cache used for the output files (sample storage and final file), 0 disables it.
+Small writes (boxes, samples) are gathered and issued to the file in a single call*/
+GF_Err gf_isom_set_output_buffering(GF_ISOFile *the_file, u32 size);
+
 /*set the copyright in one language.*/
 GF_Err gf_isom_set_copyright(GF_ISOFile *the_file, const char *threeCharCode, char *notice);
 
@@ -1069,6 +1101,10 @@ footprint low when playing segments. Note however that seeking in the file is th
 GF_Err gf_isom_release_segment(GF_ISOFile *movie, Bool reset_tables);
 /*opens a new segment file. Access to samples in previous segments is no longer possible*/
 GF_Err gf_isom_open_segment(GF_ISOFile *movie, const char *fileName);
+/*destroys the sample tables of all tracks of a fragmented file opened for reading, keeping the file open. Samples
+loaded later on (cf gf_isom_refresh_fragmented) keep their numbers and decoding times, previous samples can no
+longer be accessed. This keeps the memory footprint low when reading a growing file*/
+GF_Err gf_isom_reset_tables(GF_ISOFile *movie);
 
 #ifndef GPAC_DISBALE_ISOM_FRAGMENTS
 
@@ -1438,6 +1474,40 @@ as the hint sample timestamp + ts_offset, some packets may need to be sent earli
 */
 GF_Err gf_isom_next_hint_packet(GF_ISOFile *the_file, u32 trackNumber, char **pck_data, u32 *pck_size, Bool *disposable, Bool *repeated, u32 *trans_ts, u32 *sample_num);
 
+
+/*RTP packet cache of a hint track: all packets of the track are built once and indexed, so that any number
+of readers (typically the clients of a server playing the same file) only copy them and patch their own
+sequence number, timestamp offset and SSRC. Once built, the cache no longer depends on the file and is
+read-only, hence it can be shared between threads. Packet numbers are 1-based*/
+typedef struct __tag_isom_hint_cache GF_ISOHintCache;
+
+/*builds the packet cache of an RTP hint track. This uses (and resets) the hint reader of the track*/
+GF_Err gf_isom_hint_cache_new(GF_ISOFile *the_file, u32 trackNumber, GF_ISOHintCache **cache);
+/*writes the cache to disk. The cache format is platform-dependent (host byte order)*/
+GF_Err gf_isom_hint_cache_save(GF_ISOHintCache *cache, const char *fileName);
+/*loads a cache written with gf_isom_hint_cache_save. The file is memory-mapped when possible and shall not
+be modified while the cache is in use. If the_file is set, the cache is rejected if it was not built from
+a file of the same size and modification time*/
+GF_Err gf_isom_hint_cache_load(const char *fileName, GF_ISOFile *the_file, GF_ISOHintCache **cache);
+void gf_isom_hint_cache_del(GF_ISOHintCache *cache);
+u32 gf_isom_hint_cache_get_packet_count(GF_ISOHintCache *cache);
+/*timescale of the hint track, in which send times and RTP timestamps are expressed*/
+u32 gf_isom_hint_cache_get_timescale(GF_ISOHintCache *cache);
+/*size of the biggest packet*/
+u32 gf_isom_hint_cache_get_max_size(GF_ISOHintCache *cache);
+/*returns the first packet of the last hint sample sent at or before send_time, 0 if the cache is empty*/
+u32 gf_isom_hint_cache_find_packet(GF_ISOHintCache *cache, u64 send_time);
+/*gets a cached packet. All output parameters are optional
+@pck_data: pointer to the packet in the cache, with a 0 SSRC and timestamp offset and an unspecified sequence number
+@send_time: DTS of the hint sample of the packet
+@rtp_ts: RTP timestamp of the packet, without offset
+other parameters as in gf_isom_next_hint_packet
+returns GF_EOS if the packet number is greater than the number of packets*/
+GF_Err gf_isom_hint_cache_get_packet(GF_ISOHintCache *cache, u32 pck_num, const char **pck_data, u32 *pck_size, u64 *send_time, u32 *rtp_ts, Bool *disposable, Bool *repeated, u32 *sample_num);
+/*copies a cached packet in buffer with the given sequence number, timestamp offset and SSRC
+returns GF_EOS if the packet number is greater than the number of packets*/
+GF_Err gf_isom_hint_cache_write_packet(GF_ISOHintCache *cache, u32 pck_num, char *buffer, u32 buffer_size, u32 *pck_size, u16 seq_num, u32 ts_offset, u32 ssrc);
+
 #endif /*GPAC_DISABLE_ISOM_HINTING*/
 
 
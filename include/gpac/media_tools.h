@@ -218,6 +218,47 @@ GF_Err gf_media_import_chapters(GF_ISOFile *file, char *chap_file, Double import
 @dash_mode: 0 = DASH not used, 1 = DASH used without GOP spliting, 2 = DASH used with GOP spliting, */
 GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_duration_sec, u32 dash_mode, Double dash_duration_sec, char *seg_rad_name, char *seg_ext, u32 fragments_per_sidx, Bool daisy_chain_sidx, Bool use_url_template, const char *dash_ctx);
 
+/*DASH-ing of several representations of the same content in a single MPD. Representations are segmented in parallel
+on nb_threads threads (0 for one thread per CPU), never more than one per representation. Segment boundaries are computed once on the reference 
+track of the first input, so that segments are aligned across representations.
+@inputs, @output_files, @seg_rad_names: input file, output name and optional segment name of each representation, with 
+the same semantics as in gf_media_fragment_file
+@mpd_name: name of the MPD file
+other parameters are the same as in gf_media_fragment_file, @dash_mode shall not be 0*/
+GF_Err gf_media_fragment_files(GF_ISOFile **inputs, char **output_files, char **seg_rad_names, u32 nb_inputs, const char *mpd_name, Double max_duration_sec, u32 dash_mode, Double dash_duration_sec, char *seg_ext, u32 fragments_per_sidx, Bool daisy_chain_sidx, Bool use_url_template, u32 nb_threads);
+
+/*live DASH segmenter: samples are pushed as they are produced and each segment is written, and the MPD updated, 
+as soon as the segment duration is reached on the reference track (first visual track, or first track). The input
+sample tables are never needed*/
+typedef struct __dash_live_segmenter GF_DASHLiveSegmenter;
+
+/*creates a new live segmenter. The initialization segment is @output_file.mp4 and the MPD @output_file.mpd
+@seg_rad_name: if set, segments are written in @seg_rad_name_segN.@seg_ext files, otherwise they are appended to the
+initialization segment
+@max_duration_sec: fragment duration
+@dash_duration_sec: segment duration
+@seg_at_rap: segments start on a RAP of the reference track*/
+GF_DASHLiveSegmenter *gf_dash_live_new(char *output_file, char *seg_rad_name, char *seg_ext, Double max_duration_sec, Double dash_duration_sec, Bool seg_at_rap, u32 fragments_per_sidx, Bool daisy_chain_sidx);
+/*gets the output movie, can be used to create tracks before calling gf_dash_live_add_track with no input*/
+GF_ISOFile *gf_dash_live_get_movie(GF_DASHLiveSegmenter *dasher);
+/*declares a track to be segmented. If @input is set, the track is cloned from @trackNumber in @input (only sample
+descriptions are used), otherwise @trackNumber is a track of the output movie. All tracks must be declared before 
+the first sample is added. @TrackID is set to the ID of the track in the output*/
+GF_Err gf_dash_live_add_track(GF_DASHLiveSegmenter *dasher, GF_ISOFile *input, u32 trackNumber, u32 *TrackID);
+/*pushes a sample of the given track. The sample is copied and written with its fragment, once the duration of the
+fragment is reached on the reference track. Since the sample duration is given by the next sample of the track, 
+samples shall be pushed in decoding order*/
+GF_Err gf_dash_live_add_sample(GF_DASHLiveSegmenter *dasher, u32 TrackID, GF_ISOSample *sample, u32 sampleDescriptionIndex, u8 padding_bits);
+/*pushes all samples of @input available since the last call for the tracks declared from @input. If @input is 
+fragmented (typically opened with gf_isom_open_progressive while being written), new fragments are loaded first
+and the sample tables of @input are reset once all their samples are pushed (cf gf_isom_reset_tables).
+Incomplete samples are left for the next call*/
+GF_Err gf_dash_live_process_input(GF_DASHLiveSegmenter *dasher, GF_ISOFile *input);
+/*flushes pending samples, closes the last segment and writes the final MPD*/
+GF_Err gf_dash_live_close(GF_DASHLiveSegmenter *dasher);
+/*destroys the segmenter*/
+void gf_dash_live_del(GF_DASHLiveSegmenter *dasher);
+
 /*make the file ISMA compliant: creates ISMA BIFS / OD tracks if needed, and update audio/video IDs
 the file should not contain more than one audio and one video track
 @keepImage: if set, generates system info if image is found - only used for image imports
@@ -394,6 +394,8 @@ typedef struct tag_m2ts_pes
 	u32 pes_end_packet_number;
 
 	u32 pes_start_packet_number;
+	/*byte position of the first packet of the PES in the data given to the demuxer*/
+	u64 pes_start_byte_pos;
 	/* PCR info related to the PES start */
 	/* Last PCR value received for this program and associated packet number */
 	u64 last_pcr_value;
@@ -586,9 +588,12 @@ struct tag_m2ts_demux
 	/*private user data*/
 	void *user;
 
-	/*private resync buffer*/
-	char *buffer;
-	u32 buffer_size, alloc_size;
+	/*private resync buffer: incomplete packet left over by the previous call to gf_m2ts_process_data*/
+	char buffer[188];
+	u32 buffer_size;
+	/*position of the next data given to gf_m2ts_process_data, and of the packet being processed, counted
+	in bytes from the first data given to the demuxer (skipped bytes included)*/
+	u64 data_pos, pck_byte_pos;
 	/*default transport PID filters*/
 	GF_M2TS_SectionFilter *pat, *cat, *nit, *sdt, *eit, *tdt_tot_st;
 
@@ -614,6 +619,22 @@ struct tag_m2ts_demux
 
 	const char *(*query_next)(void *udta);
 	void *udta_query;
+
+	/*PID filtering: when on, packets on PIDs not set in pid_filter are dropped right after their header*/
+	Bool pid_filtering;
+	u32 pid_filter[GF_M2TS_MAX_STREAMS/32];
+	/*program number selected through gf_m2ts_demux_select_program, 0 if none*/
+	u32 selected_program;
+
+	/*live sources (socket, DVB) with a demuxer thread: the receive thread only pushes TS packets in the ring,
+	section and PES processing is done by the demux worker thread*/
+	struct __m2ts_pck_ring *ring;
+	GF_Thread *demux_th;
+	/*ring statistics in TS packets: highest occupancy seen and packets dropped because the ring was full*/
+	u32 ring_max_occupancy, ring_drops;
+
+	/*seek index of the local file, set and destroyed by user. When present, start_range is resolved through it*/
+	struct __m2ts_index *index;
 };
 
 GF_M2TS_Demuxer *gf_m2ts_demux_new();
@@ -622,9 +643,71 @@ void gf_m2ts_reset_parsers(GF_M2TS_Demuxer *ts);
 GF_ESD *gf_m2ts_get_esd(GF_M2TS_ES *es);
 GF_Err gf_m2ts_set_pes_framing(GF_M2TS_PES *pes, u32 mode);
 GF_Err gf_m2ts_process_data(GF_M2TS_Demuxer *ts, char *data, u32 data_size);
+/*turns PID filtering on or off. When on, only the PAT, the PMTs and the allowed PIDs are processed, streams on
+other PIDs are not created when parsing the PMTs*/
+void gf_m2ts_demux_set_pid_filtering(GF_M2TS_Demuxer *ts, Bool enable);
+/*allows or forbids a PID when PID filtering is on*/
+void gf_m2ts_demux_allow_pid(GF_M2TS_Demuxer *ts, u32 pid, Bool allow);
+/*turns PID filtering on and selects a single program: its PMT, PCR and elementary stream PIDs are allowed as they
+are signaled, PMTs of other programs are never parsed*/
+void gf_m2ts_demux_select_program(GF_M2TS_Demuxer *ts, u32 program_number);
+/*gets the receive ring statistics in TS packets: current and highest occupancy, capacity and dropped packets.
+All values are 0 if the demuxer does not use a receive thread*/
+void gf_m2ts_demux_get_ring_stats(GF_M2TS_Demuxer *ts, u32 *occupancy, u32 *max_occupancy, u32 *capacity, u32 *drops);
 u32 gf_dvb_get_freq_from_url(const char *channels_config_path, const char *url);
 
 
+/*TS seek index entry: a random access point of the indexed stream*/
+typedef struct
+{
+	/*offset in the file of the TS packet starting the random access PES*/
+	u64 offset;
+	/*PTS of the random access point, 90 kHz, unwrapped*/
+	u64 pts;
+	/*last PCR of the program before the random access point, 27 MHz*/
+	u64 pcr;
+} GF_M2TS_IndexEntry;
+
+/*TS seek index of a file, built in a single demux pass. The file may keep growing, the index is then updated
+from where it stopped. Entries are sorted by offset and PTS*/
+typedef struct __m2ts_index
+{
+	GF_M2TS_IndexEntry *entries;
+	u32 nb_entries, alloc_entries;
+	/*indexed program and stream: the first video stream of the program, or its first stream if no video*/
+	u32 program_number, pid;
+	/*first and last PTS of the indexed stream, 90 kHz, unwrapped*/
+	u64 first_pts, last_pts;
+	/*size of the file covered by the index*/
+	u64 indexed_size;
+	/*size and modification time of the indexed file, set by the caller before saving and checked by the
+	caller after loading to detect a stale sidecar*/
+	u64 source_size, source_mtime;
+
+	/*private*/
+	Bool has_pts;
+	GF_M2TS_Demuxer *demux;
+	u64 demux_start;
+	char *buffer;
+	GF_Mutex *mx;
+} GF_M2TS_Index;
+
+GF_M2TS_Index *gf_m2ts_index_new();
+void gf_m2ts_index_del(GF_M2TS_Index *idx);
+/*indexes at most max_size bytes (0 for no limit) of the file from where the index stopped. Only complete TS
+packets are indexed. Returns GF_EOS if no new packet is available*/
+GF_Err gf_m2ts_index_update(GF_M2TS_Index *idx, FILE *ts_file, u64 max_size);
+/*finds the last random access point at or before start (in seconds from the first indexed PTS). Returns GF_EOS
+if start is after the last indexed PTS, offset and pts are then the ones of the last random access point, or 0
+and the first PTS if no random access point is indexed yet*/
+GF_Err gf_m2ts_index_find(GF_M2TS_Index *idx, Double start, u64 *offset, u64 *pts);
+/*gets the duration covered by the index in seconds*/
+Double gf_m2ts_index_get_duration(GF_M2TS_Index *idx);
+/*saves or loads the index as a sidecar file*/
+GF_Err gf_m2ts_index_save(GF_M2TS_Index *idx, const char *file_name);
+GF_Err gf_m2ts_index_load(GF_M2TS_Index *idx, const char *file_name);
+
+
 
 u32 gf_m2ts_crc32_check(char *data, u32 len);
 
@@ -1018,6 +1101,11 @@ GF_M2TS_Mux_Program *gf_m2ts_mux_program_add(GF_M2TS_Mux *muxer, u32 program_num
 GF_M2TS_Mux_Stream *gf_m2ts_program_stream_add(GF_M2TS_Mux_Program *program, GF_ESInterface *ifce, u32 pid, Bool is_pcr);
 void gf_m2ts_mux_update_config(GF_M2TS_Mux *mux, Bool reset_time);
 const char *gf_m2ts_mux_process(GF_M2TS_Mux *muxer, u32 *status);
+/*!
+ * fills buffer with up to nb_packets consecutive TS packets (188 bytes each) and returns the number of packets written.
+ * Stops after a padding packet or when no packet is ready, with status set as in gf_m2ts_mux_process
+ */
+u32 gf_m2ts_mux_process_packets(GF_M2TS_Mux *muxer, char *buffer, u32 nb_packets, u32 *status);
 u32 gf_m2ts_get_sys_clock(GF_M2TS_Mux *muxer);
 u32 gf_m2ts_get_ts_clock(GF_M2TS_Mux *muxer);
 
@@ -224,6 +224,17 @@ GF_Err gf_sk_connect(GF_Socket *sock, const char *peer_name, u16 port, const cha
  *\param length the data length to send
  */
 GF_Err gf_sk_send(GF_Socket *sock, const char *buffer, u32 length);
+/*!
+ *\brief multiple data emission
+ *
+ *Sends several buffers on the socket, one datagram per buffer for UDP sockets, using as few system calls as possible. The socket must be in a bound or connected mode
+ *\param sock the socket object
+ *\param buffers the data buffers to send
+ *\param lengths the data length of each buffer
+ *\param nb_buffers the number of buffers to send
+ *\param nb_sent set to the number of buffers sent, which are always the first ones, even when an error is returned - may be NULL
+ */
+GF_Err gf_sk_send_multiple(GF_Socket *sock, const char **buffers, const u32 *lengths, u32 nb_buffers, u32 *nb_sent);
 /*!
  *\brief data reception
  * 
@@ -235,6 +246,19 @@ GF_Err gf_sk_send(GF_Socket *sock, const char *buffer, u32 length);
  *\param read the actual number of bytes received
  */
 GF_Err gf_sk_receive(GF_Socket *sock, char *buffer, u32 length, u32 start_from, u32 *read);
+/*!
+ *\brief multiple data reception
+ * 
+ *Fetches several datagrams on a socket, one per buffer, using as few system calls as possible. The function waits for the first datagram as \ref gf_sk_receive does, then only fetches the datagrams already received. For TCP sockets, each buffer is filled by a regular read. The socket must be in a bound or connected state
+ *\param sock the socket object
+ *\param buffers the reception buffers
+ *\param lengths the allocated size of each reception buffer. Datagrams larger than their buffer are dropped and reported with a 0 size
+ *\param nb_buffers the number of reception buffers
+ *\param sizes the size of each datagram received
+ *\param nb_received the number of datagrams received
+ *\param timestamps optional reception time of each datagram in microseconds since 1970, as given by the kernel when supported. May be NULL
+ */
+GF_Err gf_sk_receive_multiple(GF_Socket *sock, char **buffers, const u32 *lengths, u32 nb_buffers, u32 *sizes, u32 *nb_received, u64 *timestamps);
 /*!
  *\brief socket listening
  *
@@ -364,6 +388,62 @@ GF_Err gf_sk_receive_wait(GF_Socket *sock, char *buffer, u32 length, u32 start_f
 s32 gf_sk_get_handle(GF_Socket *sock);
 
 
+/*!
+ *\brief socket poller object
+ *
+ *The socket poller waits for read readiness on a set of sockets at once, using epoll when available and select otherwise.
+ *A poller is not thread-safe: it shall be used by a single thread, which is typically the one reading the polled sockets.
+ */
+typedef struct __tag_sock_poll GF_SockPoll;
+
+/*!
+ *\brief socket poller constructor
+ *
+ *Constructs a socket poller.
+ *\param max_sockets the maximum number of sockets the poller will watch
+ *\return the poller object, or NULL if not enough resources
+ */
+GF_SockPoll *gf_sk_poll_new(u32 max_sockets);
+/*!
+ *\brief socket poller destructor
+ *
+ *Deletes a socket poller. The watched sockets are not closed.
+ *\param poll the poller object
+ */
+void gf_sk_poll_del(GF_SockPoll *poll);
+/*!
+ *\brief adds a socket to a poller
+ *
+ *Adds a socket to the set of watched sockets. The socket shall be removed from the poller before being destroyed.
+ *\param poll the poller object
+ *\param sock the socket object
+ *\param udta opaque user data reported by \ref gf_sk_poll_wait when the socket is readable
+ *\return error if any. GF_OUT_OF_MEM is returned if the poller already watches its maximum number of sockets
+ */
+GF_Err gf_sk_poll_add(GF_SockPoll *poll, GF_Socket *sock, void *udta);
+/*!
+ *\brief removes a socket from a poller
+ *
+ *Removes a socket from the set of watched sockets.
+ *\param poll the poller object
+ *\param sock the socket object
+ *\return error if any
+ */
+GF_Err gf_sk_poll_remove(GF_SockPoll *poll, GF_Socket *sock);
+/*!
+ *\brief waits for readable sockets
+ *
+ *Waits until at least one of the watched sockets has data to read (or is closed, or a connection is pending on a listening socket).
+ *\param poll the poller object
+ *\param timeout_ms maximum wait time in milliseconds
+ *\param udtas array filled with the user data of the readable sockets
+ *\param max_udtas the size of the udtas array
+ *\param nb_ready set to the number of readable sockets
+ *\return error if any. GF_IP_NETWORK_EMPTY is returned if the wait timed out
+ */
+GF_Err gf_sk_poll_wait(GF_SockPoll *poll, u32 timeout_ms, void **udtas, u32 max_udtas, u32 *nb_ready);
+
+
 /*!
  *\brief gets ipv6 support
  *
@@ -102,6 +102,25 @@ void gf_rtp_streamer_disable_auto_rtcp(GF_RTPStreamer *streamer);
 
 GF_Err gf_rtp_streamer_send_rtcp(GF_RTPStreamer *streamer, Bool force_ts, u32 rtp_ts);
 
+/*!
+ *	\brief sets packet pacing
+ *
+ *	Packets are queued and sent at the given rate rather than as soon as an AU is packetized. Queued packets are sent by the next send or flush calls. By default the pacing rate is twice the bandwidth given at creation, and packets are sent as soon as possible if no bandwidth was given
+ *	\param streamer RTP streamer object
+ *	\param bitrate pacing rate in bits per second, 0 disables pacing
+ *	\param max_delay max time in milliseconds a packet can wait in the queue, 0 for default (100 ms)
+ */
+GF_Err gf_rtp_streamer_set_pacing(GF_RTPStreamer *streamer, u32 bitrate, u32 max_delay);
+
+/*!
+ *	\brief sends queued packets
+ *
+ *	Sends the queued packets allowed by the pacing. This should be called regularly when pacing is on.
+ *	\param streamer RTP streamer object
+ *	\param force if set, all queued packets are sent
+ */
+GF_Err gf_rtp_streamer_flush(GF_RTPStreamer *streamer, Bool force);
+
 /*! @} */
 
 #ifdef __cplusplus
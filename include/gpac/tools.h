@@ -606,6 +606,14 @@ u32 gf_sys_clock();
  */
 void gf_sleep(u32 ms);
 
+/*!
+ *	\brief Processor count
+ *
+ *	Gets the number of processors available to the calling process.
+ *	\return number of processors, 1 if unknown.
+ */
+u32 gf_sys_get_cpu_count();
+
 /*!
  *	\brief CRC32 compute
  *
@@ -66,6 +66,16 @@ static void init_reader(ISOMChannel *ch)
 		/*take care of seeking out of the track range*/
 		if (ch->duration<ch->start) {
 			ch->last_state = gf_isom_get_sample_for_movie_time(ch->owner->mov, ch->track, ch->duration, &ivar, GF_ISOM_SEARCH_SYNC_BACKWARD, &ch->sample, &ch->sample_num);
+		}
+		/*composition offsets: seek on the sample presented at start time, and decode from the sync sample preceding it*/
+		else if (ch->start && !ch->has_edit_list && gf_isom_has_time_offset(ch->owner->mov, ch->track)) {
+			u32 sample_num;
+			ch->last_state = gf_isom_get_sample_for_composition_time(ch->owner->mov, ch->track, ch->start, &sample_num, &ch->sample_num);
+			if (ch->last_state==GF_OK)
+				ch->sample = gf_isom_get_sample(ch->owner->mov, ch->track, ch->sample_num, &ivar);
+			/*start is after the last sample: position on it so that the channel reports end of stream*/
+			else if (ch->last_state==GF_EOS)
+				ch->sample_num = gf_isom_get_sample_count(ch->owner->mov, ch->track);
 		} else {
 			ch->last_state = gf_isom_get_sample_for_movie_time(ch->owner->mov, ch->track, ch->start, &ivar, GF_ISOM_SEARCH_SYNC_BACKWARD, &ch->sample, &ch->sample_num);
 		}
@@ -62,8 +62,16 @@ typedef struct
 	char * network_buffer;
 	u32 network_buffer_size;
 
+	/*seek index of local files, built in the background while playing*/
+	GF_M2TS_Index *index;
+	GF_Thread *index_th;
+	Bool index_run, save_index;
+	char *index_src;
 }M2TSIn;
 
+/*TS bytes indexed between two checks of the stop flag*/
+#define M2TS_INDEX_CHUNK	(188*8192)
+
 
 static void M2TS_GetNetworkType(GF_InputService *plug,M2TSIn *reader);
 
@@ -694,6 +702,103 @@ static const char *M2TS_QueryNextFile(void *udta)
 }
 
 
+static void M2TS_GetIndexName(M2TSIn *m2ts, char *szIndex)
+{
+	strcpy(szIndex, m2ts->index_src);
+	strcat(szIndex, ".tsidx");
+}
+
+static u32 M2TS_IndexRun(void *par)
+{
+	char szIndex[GF_MAX_PATH+10];
+	Bool saved = 0;
+	M2TSIn *m2ts = (M2TSIn *) par;
+	FILE *f = gf_f64_open(m2ts->index_src, "rb");
+	if (!f) return 0;
+
+	while (m2ts->index_run) {
+		GF_Err e = gf_m2ts_index_update(m2ts->index, f, M2TS_INDEX_CHUNK);
+		if (e == GF_OK) {
+			saved = 0;
+			continue;
+		}
+		/*whole file indexed: save the sidecar index once, then wait for the file to grow*/
+		if (!saved && m2ts->save_index) {
+			M2TS_GetIndexName(m2ts, szIndex);
+			gf_f64_seek(f, 0, SEEK_END);
+			m2ts->index->source_size = gf_f64_tell(f);
+			m2ts->index->source_mtime = gf_file_modification_time(m2ts->index_src);
+			e = gf_m2ts_index_save(m2ts->index, szIndex);
+			if (e) GF_LOG(GF_LOG_WARNING, GF_LOG_CONTAINER, ("[M2TS In] Cannot save seek index %s: %s\n", szIndex, gf_error_to_string(e)));
+			saved = 1;
+		}
+		gf_sleep(200);
+	}
+	fclose(f);
+	return 0;
+}
+
+static void M2TS_CloseIndex(M2TSIn *m2ts)
+{
+	if (m2ts->index_th) {
+		m2ts->index_run = 0;
+		gf_th_stop(m2ts->index_th);
+		gf_th_del(m2ts->index_th);
+		m2ts->index_th = NULL;
+	}
+	m2ts->ts->index = NULL;
+	if (m2ts->index) gf_m2ts_index_del(m2ts->index);
+	m2ts->index = NULL;
+	if (m2ts->index_src) gf_free(m2ts->index_src);
+	m2ts->index_src = NULL;
+}
+
+static void M2TS_SetupIndex(GF_InputService *plug, M2TSIn *m2ts, const char *url)
+{
+	char szIndex[GF_MAX_PATH+10];
+	const char *opt;
+	char *frag;
+	u64 file_size;
+	FILE *f;
+
+	M2TS_CloseIndex(m2ts);
+	if (strlen(url) >= GF_MAX_PATH) return;
+	m2ts->index_src = gf_strdup(url);
+	frag = strrchr(m2ts->index_src, '#');
+	if (frag) frag[0] = 0;
+	f = gf_f64_open(m2ts->index_src, "rb");
+	if (!f) {
+		gf_free(m2ts->index_src);
+		m2ts->index_src = NULL;
+		return;
+	}
+	gf_f64_seek(f, 0, SEEK_END);
+	file_size = gf_f64_tell(f);
+	fclose(f);
+
+	opt = gf_modules_get_option((GF_BaseInterface *)plug, "MPEG2TS", "SaveSeekIndex");
+	if (!opt) gf_modules_set_option((GF_BaseInterface *)plug, "MPEG2TS", "SaveSeekIndex", "no");
+	m2ts->save_index = (opt && !strcmp(opt, "yes")) ? 1 : 0;
+
+	m2ts->index = gf_m2ts_index_new();
+	M2TS_GetIndexName(m2ts, szIndex);
+	if (gf_m2ts_index_load(m2ts->index, szIndex) == GF_OK) {
+		/*sidecar index of another file, or of a previous version of this one*/
+		if ((m2ts->index->source_size != file_size) || (m2ts->index->source_mtime != gf_file_modification_time(m2ts->index_src))) {
+			gf_m2ts_index_del(m2ts->index);
+			m2ts->index = gf_m2ts_index_new();
+		} else {
+			GF_LOG(GF_LOG_INFO, GF_LOG_CONTAINER, ("[M2TS In] Loaded seek index %s: %d entries\n", szIndex, m2ts->index->nb_entries));
+		}
+	}
+	m2ts->ts->index = m2ts->index;
+
+	m2ts->index_run = 1;
+	m2ts->index_th = gf_th_new("MPEG-2 TS Index");
+	gf_th_set_priority(m2ts->index_th, GF_THREAD_PRIORITY_LOW);
+	gf_th_run(m2ts->index_th, M2TS_IndexRun, m2ts);
+}
+
 static GF_Err M2TS_ConnectService(GF_InputService *plug, GF_ClientService *serv, const char *url)
 {
 	GF_Err e;	
@@ -717,6 +822,10 @@ static GF_Err M2TS_ConnectService(GF_InputService *plug, GF_ClientService *serv,
 			e = TSDemux_DemuxPlay(m2ts->ts);
 		}
 	} else {
+		/*local file: index it for seeking*/
+		if (strnicmp(url, "udp://", 6) && strnicmp(url, "mpegts-udp://", 13) && strnicmp(url, "mpegts-tcp://", 13) && strnicmp(url, "dvb://", 6)) {
+			M2TS_SetupIndex(plug, m2ts, url);
+		}
 		e = TSDemux_Demux_Setup(m2ts->ts,url,0);
 	}
 
@@ -732,6 +841,7 @@ static GF_Err M2TS_CloseService(GF_InputService *plug)
 	GF_M2TS_Demuxer* ts = m2ts->ts;
 
 	TSDemux_CloseDemux(ts);	
+	M2TS_CloseIndex(m2ts);
 	
 	
 	if (ts->dnload) gf_term_download_del(ts->dnload);
@@ -918,6 +1028,18 @@ static GF_Err M2TS_ServiceCommand(GF_InputService *plug, GF_NetworkCommand *com)
 		com->buffer.min = 0;
 		return GF_OK;
 	case GF_NET_CHAN_DURATION:
+		if (m2ts->index) {
+			u64 indexed_size;
+			gf_mx_p(m2ts->index->mx);
+			indexed_size = m2ts->index->indexed_size;
+			gf_mx_v(m2ts->index->mx);
+			if (indexed_size) {
+				Double dur = gf_m2ts_index_get_duration(m2ts->index);
+				/*extrapolated while the file is being indexed*/
+				if (indexed_size < ts->file_size) dur = dur * (s64) ts->file_size / (s64) indexed_size;
+				ts->duration = dur;
+			}
+		}
 		com->duration.duration = ts->duration;
 		return GF_OK;
 	case GF_NET_CHAN_PLAY:
@@ -42,6 +42,12 @@ extern "C" {
 #define GF_RGB_444_SUPORT
 #endif
 
+/*SSE2 span fillers and blenders - they work on the byte layout of the surface, little endian only*/
+#if !defined(EVG_BIG_ENDIAN) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#define EVG_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 
 typedef struct _evg_surface EVGSurface;
 
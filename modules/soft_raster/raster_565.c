@@ -39,6 +39,86 @@ mul255(s32 a, s32 b)
 	return ((a + 1) * b) >> 8;
 }
 
+#ifdef EVG_USE_SSE2
+
+/*blends r, g, b over 8 565 pixels, each channel becoming (src*(a+1) + dst*(255-a))>>8, which is mul255(a, src-dst)+dst.
+m and inv hold a+1 and 255-a for each pixel*/
+static GFINLINE __m128i blend_8_565(__m128i d, __m128i sr, __m128i sg, __m128i sb, __m128i m, __m128i inv)
+{
+	__m128i mr = _mm_set1_epi16(0xf8);
+	__m128i mg = _mm_set1_epi16(0xfc);
+	__m128i dr = _mm_and_si128(_mm_srli_epi16(d, 8), mr);
+	__m128i dg = _mm_and_si128(_mm_srli_epi16(d, 3), mg);
+	__m128i db = _mm_and_si128(_mm_slli_epi16(d, 3), mr);
+	dr = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(sr, m), _mm_mullo_epi16(dr, inv)), 8);
+	dg = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(sg, m), _mm_mullo_epi16(dg, inv)), 8);
+	db = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(sb, m), _mm_mullo_epi16(db, inv)), 8);
+	/*GF_COL_565*/
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_and_si128(dr, mr), 8), _mm_slli_epi16(_mm_and_si128(dg, mg), 3)), _mm_srli_epi16(db, 3));
+}
+
+/*fills count 565 pixels with val, 8 pixels at a time. Returns the number of pixels filled*/
+static u32 fill_run_565(u16 *dst, u16 val, u32 count)
+{
+	u32 i, nb = count & ~7;
+	__m128i v = _mm_set1_epi16((s16) val);
+	for (i=0; i<nb; i+=8) {
+		_mm_storeu_si128((__m128i *) dst, v);
+		dst += 8;
+	}
+	return nb;
+}
+
+/*blends a constant color over 565 pixels, 8 pixels at a time. Returns the number of pixels blended*/
+static u32 blend_const_run_565(u16 *dst, u32 count, u8 r, u8 g, u8 b, u8 a)
+{
+	u32 i, nb = count & ~7;
+	__m128i sr = _mm_set1_epi16(r);
+	__m128i sg = _mm_set1_epi16(g);
+	__m128i sb = _mm_set1_epi16(b);
+	__m128i m = _mm_set1_epi16(a+1);
+	__m128i inv = _mm_set1_epi16(255-a);
+	for (i=0; i<nb; i+=8) {
+		__m128i d = _mm_loadu_si128((__m128i *) dst);
+		_mm_storeu_si128((__m128i *) dst, blend_8_565(d, sr, sg, sb, m, inv));
+		dst += 8;
+	}
+	return nb;
+}
+
+/*blends ARGB stencil colors over 565 pixels with the span coverage, 8 pixels at a time. Pixels with a 0 alpha
+color are left untouched. Returns the number of pixels blended*/
+static u32 blend_var_run_565(u16 *dst, u32 *col, u32 count, u8 coverage)
+{
+	u32 i, nb = count & ~7;
+	__m128i zero = _mm_setzero_si128();
+	__m128i one = _mm_set1_epi16(1);
+	__m128i c255 = _mm_set1_epi16(0xFF);
+	__m128i bmask = _mm_set1_epi32(0xFF);
+	__m128i cov = _mm_set1_epi16(coverage);
+	for (i=0; i<nb; i+=8) {
+		__m128i sr, sg, sb, a, keep, res;
+		__m128i c0 = _mm_loadu_si128((__m128i *) col);
+		__m128i c1 = _mm_loadu_si128((__m128i *) (col+4));
+		__m128i d = _mm_loadu_si128((__m128i *) dst);
+		sb = _mm_packs_epi32(_mm_and_si128(c0, bmask), _mm_and_si128(c1, bmask));
+		sg = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(c0, 8), bmask), _mm_and_si128(_mm_srli_epi32(c1, 8), bmask));
+		sr = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(c0, 16), bmask), _mm_and_si128(_mm_srli_epi32(c1, 16), bmask));
+		a = _mm_packs_epi32(_mm_srli_epi32(c0, 24), _mm_srli_epi32(c1, 24));
+		keep = _mm_cmpeq_epi16(a, zero);
+		/*mul255(col_a, coverage)*/
+		a = _mm_srli_epi16(_mm_mullo_epi16(_mm_add_epi16(a, one), cov), 8);
+		res = blend_8_565(d, sr, sg, sb, _mm_add_epi16(a, one), _mm_sub_epi16(c255, a));
+		res = _mm_or_si128(_mm_andnot_si128(keep, res), _mm_and_si128(keep, d));
+		_mm_storeu_si128((__m128i *) dst, res);
+		dst += 8;
+		col += 8;
+	}
+	return nb;
+}
+
+#endif
+
 
 /*
 			RGB 565 part
@@ -71,6 +151,14 @@ void overmask_565_const_run(u32 src, u16 *dst, s32 dst_pitch_x, u32 count)
 	u8 srcg = (src >> 8) & 0xff;
 	u8 srcb = (src >> 0) & 0xff;
 
+#ifdef EVG_USE_SSE2
+	if (dst_pitch_x==2) {
+		u32 done = blend_const_run_565(dst, count, srcr, srcg, srcb, srca);
+		dst += done;
+		count -= done;
+	}
+#endif
+
 	while (count) {
 		register u16 val = *dst;
 		register u8 dstr = (val >> 8) & 0xf8;
@@ -108,6 +196,13 @@ void evg_565_fill_const(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 			fin = (a<<24) | (col_no_a);
 			overmask_565_const_run(fin, (u16*) (dst+x), surf->pitch_x, len);
 		} else {
+#ifdef EVG_USE_SSE2
+			if (surf->pitch_x==2) {
+				u32 done = fill_run_565((u16 *) (dst + x), col565, len);
+				x += 2*done;
+				len -= done;
+			}
+#endif
 			while (len--) {
 				*(u16*) (dst + x) = col565;
 				x+=surf->pitch_x;
@@ -151,6 +246,14 @@ void evg_565_fill_var(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 		surf->sten->fill_run(surf->sten, surf, spans[i].x, y, len);
 		col = surf->stencil_pix_run;
 		x = spans[i].x * surf->pitch_x;
+#ifdef EVG_USE_SSE2
+		if (surf->pitch_x==2) {
+			u32 done = blend_var_run_565((u16 *) (dst + x), col, len, spanalpha);
+			x += 2*done;
+			col += done;
+			len -= done;
+		}
+#endif
 		while (len--) {
 			col_a = GF_COL_A(*col);
 			if (col_a) {
@@ -184,7 +287,14 @@ GF_Err evg_surface_clear_565(GF_SURFACE surf, GF_IRect rc, GF_Color col)
 
 	for (y=0; y<h; y++) {
 		u8 *data = _this->pixels + (sy+y) * st + _this->pitch_x*sx;
-		for (x=0; x<w; x++)  {
+		x = 0;
+#ifdef EVG_USE_SSE2
+		if (_this->pitch_x==2) {
+			x = fill_run_565((u16 *) data, val, w);
+			data += 2*x;
+		}
+#endif
+		for (; x<w; x++)  {
 			*(u16*) data = val;
 			data += _this->pitch_x;
 		}
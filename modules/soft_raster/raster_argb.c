@@ -32,6 +32,141 @@ mul255(s32 a, s32 b)
 	return ((a+1) * b) >> 8;
 }
 
+#ifdef EVG_USE_SSE2
+
+/*swaps the red and blue bytes of an ARGB color, for RGBA/BGR32 memory layout*/
+#define EVG_SWAP_RB(_c)	( ((_c) & 0xFF00FF00) | (((_c)>>16) & 0xFF) | (((_c) & 0xFF)<<16) )
+
+/*blending modes of the SSE2 runs*/
+enum
+{
+	/*dst alpha is 0: the source pixel is copied (ARGB/RGBA)*/
+	EVG_BLEND_EMPTY = 1,
+	/*dst alpha is 0xFF: alpha is left to 0xFF (RGBA)*/
+	EVG_BLEND_KEEP_OPAQUE = 1<<1,
+	/*no alpha channel, alpha is set to 0xFF (RGB32/BGR32)*/
+	EVG_BLEND_NO_ALPHA = 1<<2,
+	/*stencil colors are written in R, G, B order (RGBA/BGR32)*/
+	EVG_BLEND_SWAP_RB = 1<<3
+};
+
+/*fills count 32 bit pixels with val*/
+static void fill_run_32(u8 *dst, u32 val, u32 count)
+{
+	__m128i v = _mm_set1_epi32((s32) val);
+	while (count>=4) {
+		_mm_storeu_si128((__m128i *) dst, v);
+		dst += 16;
+		count -= 4;
+	}
+	while (count) {
+		*(u32 *) dst = val;
+		dst += 4;
+		count--;
+	}
+}
+
+/*blends a constant color over 32 bit pixels, 4 pixels at a time. Each byte of a pixel becomes (S + dst*I)>>8,
+S and I being given per byte of the pixel: this gives the same results as mul255(a, src-dst)+dst (S=src*(a+1), I=255-a)
+and as mul255(a, src) + (((256-a)*dst)>>8) (S=mul255(a, src)<<8, I=256-a). Returns the number of pixels blended*/
+static u32 blend_const_run_32(u8 *dst, u32 count, const u16 *S, const u16 *I, u32 flags, u32 empty_val)
+{
+	u32 i, nb = count & ~3;
+	__m128i zero = _mm_setzero_si128();
+	__m128i amask = _mm_set1_epi32(0xFF000000);
+	__m128i empty = _mm_set1_epi32((s32) empty_val);
+	__m128i s = _mm_set_epi16(S[3], S[2], S[1], S[0], S[3], S[2], S[1], S[0]);
+	__m128i inv = _mm_set_epi16(I[3], I[2], I[1], I[0], I[3], I[2], I[1], I[0]);
+
+	for (i=0; i<nb; i+=4) {
+		__m128i res, lo, hi;
+		__m128i d = _mm_loadu_si128((__m128i *) dst);
+		lo = _mm_unpacklo_epi8(d, zero);
+		hi = _mm_unpackhi_epi8(d, zero);
+		lo = _mm_srli_epi16(_mm_add_epi16(s, _mm_mullo_epi16(lo, inv)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(s, _mm_mullo_epi16(hi, inv)), 8);
+		res = _mm_packus_epi16(lo, hi);
+		if (flags & EVG_BLEND_EMPTY) {
+			__m128i z = _mm_cmpeq_epi32(_mm_and_si128(d, amask), zero);
+			res = _mm_or_si128(_mm_andnot_si128(z, res), _mm_and_si128(z, empty));
+		}
+		if (flags & EVG_BLEND_KEEP_OPAQUE) {
+			__m128i o = _mm_cmpeq_epi32(_mm_and_si128(d, amask), amask);
+			res = _mm_or_si128(res, _mm_and_si128(o, amask));
+		}
+		_mm_storeu_si128((__m128i *) dst, res);
+		dst += 16;
+	}
+	return nb;
+}
+
+/*blends ARGB stencil colors over 32 bit pixels with the span coverage, 4 pixels at a time. Pixels with a 0 alpha
+color are left untouched. Returns the number of pixels blended*/
+static u32 blend_var_run_32(u8 *dst, u32 *col, u32 count, u8 coverage, u32 flags)
+{
+	u32 i, nb = count & ~3;
+	__m128i zero = _mm_setzero_si128();
+	__m128i one = _mm_set1_epi16(1);
+	__m128i c255 = _mm_set1_epi16(0xFF);
+	__m128i hmask = _mm_set1_epi16((s16) 0xFF00);
+	__m128i cov = _mm_set1_epi16(coverage);
+	__m128i amask = _mm_set1_epi32(0xFF000000);
+	/*alpha lanes of 2 unpacked pixels*/
+	__m128i alane = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+	__m128i aone = _mm_and_si128(alane, one);
+
+	for (i=0; i<nb; i+=4) {
+		__m128i res, keep, half[2], alpha[2];
+		u32 j;
+		__m128i c = _mm_loadu_si128((__m128i *) col);
+		__m128i d = _mm_loadu_si128((__m128i *) dst);
+
+		if (flags & EVG_BLEND_SWAP_RB) {
+			__m128i rb = _mm_and_si128(c, _mm_set1_epi32(0x00FF00FF));
+			c = _mm_or_si128(_mm_and_si128(c, _mm_set1_epi32(0xFF00FF00)), _mm_or_si128(_mm_srli_epi32(rb, 16), _mm_slli_epi32(rb, 16)));
+		}
+		for (j=0; j<2; j++) {
+			__m128i cl, dl, a, m, sv, iv;
+			cl = j ? _mm_unpackhi_epi8(c, zero) : _mm_unpacklo_epi8(c, zero);
+			dl = j ? _mm_unpackhi_epi8(d, zero) : _mm_unpacklo_epi8(d, zero);
+			/*srca = mul255(col_a, coverage) on the 4 lanes of each pixel*/
+			a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(cl, 0xFF), 0xFF);
+			a = _mm_srli_epi16(_mm_mullo_epi16(_mm_add_epi16(a, one), cov), 8);
+			m = _mm_add_epi16(a, one);
+			/*color: mul255(srca, src-dst)+dst, alpha: mul255(srca, srca) + mul255(255-srca, dsta)*/
+			sv = _mm_mullo_epi16(cl, m);
+			sv = _mm_or_si128(_mm_andnot_si128(alane, sv), _mm_and_si128(alane, _mm_and_si128(_mm_mullo_epi16(a, m), hmask)));
+			iv = _mm_add_epi16(_mm_sub_epi16(c255, a), aone);
+			half[j] = _mm_srli_epi16(_mm_add_epi16(sv, _mm_mullo_epi16(dl, iv)), 8);
+			alpha[j] = a;
+		}
+		res = _mm_packus_epi16(half[0], half[1]);
+
+		if (flags & EVG_BLEND_NO_ALPHA) {
+			res = _mm_or_si128(res, amask);
+		} else {
+			if (flags & EVG_BLEND_EMPTY) {
+				/*source pixel with the blended alpha*/
+				__m128i src = _mm_or_si128(_mm_andnot_si128(amask, c), _mm_and_si128(amask, _mm_packus_epi16(alpha[0], alpha[1])));
+				__m128i z = _mm_cmpeq_epi32(_mm_and_si128(d, amask), zero);
+				res = _mm_or_si128(_mm_andnot_si128(z, res), _mm_and_si128(z, src));
+			}
+			if (flags & EVG_BLEND_KEEP_OPAQUE) {
+				__m128i o = _mm_cmpeq_epi32(_mm_and_si128(d, amask), amask);
+				res = _mm_or_si128(res, _mm_and_si128(o, amask));
+			}
+		}
+		keep = _mm_cmpeq_epi32(_mm_and_si128(c, amask), zero);
+		res = _mm_or_si128(_mm_andnot_si128(keep, res), _mm_and_si128(keep, d));
+		_mm_storeu_si128((__m128i *) dst, res);
+		dst += 16;
+		col += 4;
+	}
+	return nb;
+}
+
+#endif
+
 /*
 		32 bit ARGB
 */
@@ -45,7 +180,7 @@ static void overmask_bgra(u32 src, u8 *dst, u32 alpha)
 	s32 dsta = dst[3];
 	srca = mul255(srca, alpha);
 	if (dsta) {
-		s32 dstr = dst[1];
+		s32 dstr = dst[2];
 		s32 dstg = dst[1];
 		s32 dstb = dst[0];
 		dst[0] = mul255(srca, srcb - dstb) + dstb;
@@ -67,6 +202,21 @@ static void overmask_bgra_const_run(u32 src, u8 *dst, s32 dst_pitch_x, u32 count
 	s32 srcg = (src >> 8) & 0xff;
 	s32 srcb = (src >> 0) & 0xff;
 
+#ifdef EVG_USE_SSE2
+	if (dst_pitch_x==4) {
+		u16 S[4], I[4];
+		u32 done;
+		S[0] = srcb*(srca+1);
+		S[1] = srcg*(srca+1);
+		S[2] = srcr*(srca+1);
+		S[3] = mul255(srca, srca)<<8;
+		I[0] = I[1] = I[2] = 255-srca;
+		I[3] = 256-srca;
+		done = blend_const_run_32(dst, count, S, I, EVG_BLEND_EMPTY, src);
+		dst += 4*done;
+		count -= done;
+	}
+#endif
 
 	while (count) {
 		s32 dsta = dst[3];
@@ -81,7 +231,7 @@ static void overmask_bgra_const_run(u32 src, u8 *dst, s32 dst_pitch_x, u32 count
 			dst[2] = mul255(srca, srcr - dstr) + dstr;
 			dst[3] = mul255(srca, srca) + mul255(255-srca, dsta);
 		} else {
-			dst[0] = srcr;
+			dst[0] = srcb;
 			dst[1] = srcg;
 			dst[2] = srcr;
 			dst[3] = srca;
@@ -116,6 +266,12 @@ void evg_bgra_fill_const(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 			fin = (a<<24) | col_no_a;
 			overmask_bgra_const_run(fin, dst + x, surf->pitch_x, len);
 		} else {
+#ifdef EVG_USE_SSE2
+			if (surf->pitch_x==4) {
+				fill_run_32(dst + x, col, len);
+				continue;
+			}
+#endif
 			while (len--) {
 				dst[x] = col_b;
 				dst[x+1] = col_g;
@@ -162,6 +318,14 @@ void evg_bgra_fill_var(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 		surf->sten->fill_run(surf->sten, surf, spans[i].x, y, len);
 		x = spans[i].x * surf->pitch_x;
 		col = surf->stencil_pix_run;
+#ifdef EVG_USE_SSE2
+		if (surf->pitch_x==4) {
+			u32 done = blend_var_run_32(dst + x, col, len, spanalpha, EVG_BLEND_EMPTY);
+			x += 4*done;
+			col += done;
+			len -= done;
+		}
+#endif
 		while (len--) {
 			_col = *col;
 			col_a = GF_COL_A(_col);
@@ -209,6 +373,12 @@ GF_Err evg_surface_clear_bgra(GF_SURFACE surf, GF_IRect rc, GF_Color col)
 	if (!use_memset) {
 		for (y = 0; y < h; y++) {
 			data = _this ->pixels + (sy+y)* st + _this->pitch_x*sx;
+#ifdef EVG_USE_SSE2
+			if (_this->pitch_x==4) {
+				fill_run_32(data, col, w);
+				continue;
+			}
+#endif
 			for (x = 0; x < w; x++) {
 				data[0] = col_b;
 				data[1] = col_g;
@@ -257,6 +427,22 @@ GFINLINE static void overmask_bgrx_const_run(u32 src, u8 *dst, s32 dst_pitch_x,
 	u32 srcb = mul255(srca, ((src) & 0xff)) ;
 	u32 inva = 1 + 0xFF - srca;
 
+#ifdef EVG_USE_SSE2
+	if (dst_pitch_x==4) {
+		u16 S[4], I[4];
+		u32 done;
+		S[0] = srcb<<8;
+		S[1] = srcg<<8;
+		S[2] = srcr<<8;
+		S[3] = 0xFF00;
+		I[0] = I[1] = I[2] = inva;
+		I[3] = 0;
+		done = blend_const_run_32(dst, count, S, I, 0, 0);
+		dst += 4*done;
+		count -= done;
+	}
+#endif
+
 	while (count) {
 		dst[0] = srcb + ((inva*dst[0])>>8);
 		dst[1] = srcg + ((inva*dst[1])>>8);
@@ -291,6 +477,12 @@ void evg_bgrx_fill_const(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 			fin = (spana<<24) | col_no_a;
 			overmask_bgrx_const_run(fin, dst + x, surf->pitch_x, len);
 		} else {
+#ifdef EVG_USE_SSE2
+			if (surf->pitch_x==4) {
+				fill_run_32(dst + x, col | 0xFF000000, len);
+				continue;
+			}
+#endif
 			while (len--) {
 				dst[x] = col_b;
 				dst[x+1] = col_g;
@@ -337,6 +529,14 @@ void evg_bgrx_fill_var(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 		surf->sten->fill_run(surf->sten, surf, spans[i].x, y, len);
 		col = surf->stencil_pix_run;
 		x = spans[i].x * surf->pitch_x;
+#ifdef EVG_USE_SSE2
+		if (surf->pitch_x==4) {
+			u32 done = blend_var_run_32(dst + x, col, len, spanalpha, EVG_BLEND_NO_ALPHA);
+			x += 4*done;
+			col += done;
+			len -= done;
+		}
+#endif
 		while (len--) {
 			u32 _col = *col;
 			col_a = GF_COL_A(_col);
@@ -386,6 +586,22 @@ GFINLINE static void overmask_rgbx_const_run(u32 src, u8 *dst, s32 dst_pitch_x,
 	u32 srcb = mul255(srca, ((src) & 0xff)) ;
 	u32 inva = 1 + 0xFF - srca;
 
+#ifdef EVG_USE_SSE2
+	if (dst_pitch_x==4) {
+		u16 S[4], I[4];
+		u32 done;
+		S[0] = srcr<<8;
+		S[1] = srcg<<8;
+		S[2] = srcb<<8;
+		S[3] = 0;
+		I[0] = I[1] = I[2] = inva;
+		I[3] = 256;
+		done = blend_const_run_32(dst, count, S, I, 0, 0);
+		dst += 4*done;
+		count -= done;
+	}
+#endif
+
 	while (count) {
 		dst[0] = srcr + ((inva*dst[0])>>8);
 		dst[1] = srcg + ((inva*dst[1])>>8);
@@ -420,6 +636,12 @@ void evg_rgbx_fill_const(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 			fin = (spana<<24) | col_no_a;
 			overmask_rgbx_const_run(fin, dst + x, surf->pitch_x, len);
 		} else {
+#ifdef EVG_USE_SSE2
+			if (surf->pitch_x==4) {
+				fill_run_32(dst + x, EVG_SWAP_RB(col) | 0xFF000000, len);
+				continue;
+			}
+#endif
 			while (len--) {
 				dst[x] = r;
 				dst[x+1] = g;
@@ -466,6 +688,14 @@ void evg_rgbx_fill_var(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 		surf->sten->fill_run(surf->sten, surf, spans[i].x, y, len);
 		col = surf->stencil_pix_run;
 		x = spans[i].x * surf->pitch_x;
+#ifdef EVG_USE_SSE2
+		if (surf->pitch_x==4) {
+			u32 done = blend_var_run_32(dst + x, col, len, spanalpha, EVG_BLEND_NO_ALPHA | EVG_BLEND_SWAP_RB);
+			x += 4*done;
+			col += done;
+			len -= done;
+		}
+#endif
 		while (len--) {
 			_col = *col;
 			col_a = GF_COL_A(_col);
@@ -504,6 +734,12 @@ GF_Err evg_surface_clear_rgbx(GF_SURFACE surf, GF_IRect rc, GF_Color col)
 	col = GF_COL_ARGB(0xFF, b, g, r);
 	for (y = 0; y < h; y++) {
 		u8 *data = _this ->pixels + (y + sy) * _this->pitch_y + st*sx;
+#ifdef EVG_USE_SSE2
+		if (st==4) {
+			fill_run_32(data, col, w);
+			continue;
+		}
+#endif
 		for (x = 0; x < w; x++) {
 			data[0] = r;
 			data[1] = g;
@@ -553,6 +789,22 @@ GFINLINE static void overmask_rgba_const_run(u32 src, u8 *dst, s32 dst_pitch_x,
 	u8 srcg = GF_COL_G(src);
 	u8 srcb = GF_COL_B(src);
 
+#ifdef EVG_USE_SSE2
+	if (dst_pitch_x==4) {
+		u16 S[4], I[4];
+		u32 done;
+		S[0] = srcr*(srca+1);
+		S[1] = srcg*(srca+1);
+		S[2] = srcb*(srca+1);
+		S[3] = mul255(srca, srca)<<8;
+		I[0] = I[1] = I[2] = 255-srca;
+		I[3] = 256-srca;
+		done = blend_const_run_32(dst, count, S, I, EVG_BLEND_EMPTY | EVG_BLEND_KEEP_OPAQUE, EVG_SWAP_RB(src));
+		dst += 4*done;
+		count -= done;
+	}
+#endif
+
 	while (count) {
 		u8 dsta = dst[3];
 		/*special case for RGBA: if dst alpha is 0, consider the surface is empty and copy pixel*/
@@ -603,6 +855,12 @@ void evg_rgba_fill_const(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 			fin = (new_a<<24) | col_no_a;
 			overmask_rgba_const_run(fin, p, surf->pitch_x, len);
 		} else {
+#ifdef EVG_USE_SSE2
+			if (surf->pitch_x==4) {
+				fill_run_32((u8 *) p, EVG_SWAP_RB(col), len);
+				continue;
+			}
+#endif
 			while (len--) {
 				*(p) = r;
 				*(p+1) = g;
@@ -650,6 +908,14 @@ void evg_rgba_fill_var(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 		spanalpha = spans[i].coverage;
 		surf->sten->fill_run(surf->sten, surf, spans[i].x, y, len);
 		col = surf->stencil_pix_run;
+#ifdef EVG_USE_SSE2
+		if (surf->pitch_x==4) {
+			u32 done = blend_var_run_32(p, col, len, spanalpha, EVG_BLEND_EMPTY | EVG_BLEND_KEEP_OPAQUE | EVG_BLEND_SWAP_RB);
+			p += 4*done;
+			col += done;
+			len -= done;
+		}
+#endif
 		while (len--) {
 			col_a = GF_COL_A(*col);
 			if (col_a) {
@@ -697,6 +963,12 @@ GF_Err evg_surface_clear_rgba(GF_SURFACE surf, GF_IRect rc, GF_Color col)
 	if (!use_memset) {
 		for (y = 0; y < h; y++) {
 			data = _this ->pixels + (sy+y)* st + _this->pitch_x * rc.x;
+#ifdef EVG_USE_SSE2
+			if (_this->pitch_x==4) {
+				fill_run_32(data, EVG_SWAP_RB(col), w);
+				continue;
+			}
+#endif
 			for (x = 0; x < w; x++) {
 				*(data) = r;
 				*(data+1) = g;
@@ -32,6 +32,101 @@ mul255(s32 a, s32 b)
 	return ((a + 1) * b) >> 8;
 }
 
+#ifdef EVG_USE_SSE2
+
+/*blends 16 24 bit pixels, each byte becoming (src*(a+1) + dst*(255-a))>>8, which is mul255(a, src-dst)+dst.
+src and alpha give the source value and a for each of the 48 bytes*/
+static GFINLINE void blend_16_24(u8 *dst, const u8 *src, const u8 *alpha)
+{
+	u32 i;
+	__m128i zero = _mm_setzero_si128();
+	__m128i one = _mm_set1_epi16(1);
+	__m128i c255 = _mm_set1_epi16(0xFF);
+	for (i=0; i<3; i++) {
+		__m128i d = _mm_loadu_si128((__m128i *) (dst + 16*i));
+		__m128i s = _mm_loadu_si128((__m128i *) (src + 16*i));
+		__m128i a = _mm_loadu_si128((__m128i *) (alpha + 16*i));
+		__m128i al = _mm_unpacklo_epi8(a, zero);
+		__m128i ah = _mm_unpackhi_epi8(a, zero);
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), _mm_add_epi16(al, one)), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(c255, al)));
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), _mm_add_epi16(ah, one)), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(c255, ah)));
+		_mm_storeu_si128((__m128i *) (dst + 16*i), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+	}
+}
+
+/*fills count 24 bit pixels with the c0, c1, c2 bytes, 16 pixels at a time. Returns the number of pixels filled*/
+static u32 fill_run_24(u8 *dst, u32 count, u8 c0, u8 c1, u8 c2)
+{
+	u8 pat[48];
+	__m128i v0, v1, v2;
+	u32 i, nb = count & ~15;
+	for (i=0; i<16; i++) {
+		pat[3*i] = c0;
+		pat[3*i+1] = c1;
+		pat[3*i+2] = c2;
+	}
+	v0 = _mm_loadu_si128((__m128i *) pat);
+	v1 = _mm_loadu_si128((__m128i *) (pat+16));
+	v2 = _mm_loadu_si128((__m128i *) (pat+32));
+	for (i=0; i<nb; i+=16) {
+		_mm_storeu_si128((__m128i *) dst, v0);
+		_mm_storeu_si128((__m128i *) (dst+16), v1);
+		_mm_storeu_si128((__m128i *) (dst+32), v2);
+		dst += 48;
+	}
+	return nb;
+}
+
+/*blends a constant color over 24 bit pixels, 16 pixels at a time. Returns the number of pixels blended*/
+static u32 blend_const_run_24(u8 *dst, u32 count, u8 c0, u8 c1, u8 c2, u8 a)
+{
+	u8 src[48], alpha[48];
+	u32 i, nb = count & ~15;
+	for (i=0; i<16; i++) {
+		src[3*i] = c0;
+		src[3*i+1] = c1;
+		src[3*i+2] = c2;
+	}
+	memset(alpha, a, sizeof(u8)*48);
+	for (i=0; i<nb; i+=16) {
+		blend_16_24(dst, src, alpha);
+		dst += 48;
+	}
+	return nb;
+}
+
+/*blends ARGB stencil colors over 24 bit pixels with the span coverage, 16 pixels at a time. Pixels with a 0 alpha
+color are left untouched. Returns the number of pixels blended*/
+static u32 blend_var_run_24(u8 *dst, u32 *col, u32 count, u8 coverage, Bool is_rgb)
+{
+	/*one extra byte for the 32 bit writes of the last pixel*/
+	u8 src[49], alpha[49];
+	u32 i, j, nb = count & ~15;
+	for (i=0; i<nb; i+=16) {
+		for (j=0; j<16; j++) {
+			u32 c = col[j];
+			u32 a = c >> 24;
+			if (a) {
+				a = mul255(a, coverage);
+				if (is_rgb) c = ((c>>16) & 0xFF) | (c & 0xFF00) | ((c & 0xFF)<<16);
+				*(u32 *) (src + 3*j) = c;
+			} else {
+				/*blending the pixel with itself leaves it untouched*/
+				src[3*j] = dst[3*j];
+				src[3*j+1] = dst[3*j+1];
+				src[3*j+2] = dst[3*j+2];
+			}
+			*(u32 *) (alpha + 3*j) = a * 0x010101;
+		}
+		blend_16_24(dst, src, alpha);
+		dst += 48;
+		col += 16;
+	}
+	return nb;
+}
+
+#endif
+
 
 /*
 			RGB part
@@ -61,6 +156,14 @@ static void overmask_rgb_const_run(u32 src, char *dst, s32 dst_pitch_x, u32 coun
 	u8 srcg = (src >> 8) & 0xff;
 	u8 srcb = (src) & 0xff;
 
+#ifdef EVG_USE_SSE2
+	if ((dst_pitch_x==3) && (count>=16)) {
+		u32 done = blend_const_run_24((u8 *) dst, count, srcr, srcg, srcb, srca);
+		dst += 3*done;
+		count -= done;
+	}
+#endif
+
 	while (count) {
 		u8 dstr = *(dst);
 		u8 dstg = *(dst+1);
@@ -98,6 +201,13 @@ void evg_rgb_fill_const(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 			fin = (a<<24) | col_no_a;
 			overmask_rgb_const_run(fin, p, surf->pitch_x, len);
 		} else {
+#ifdef EVG_USE_SSE2
+			if (surf->pitch_x==3) {
+				u32 done = fill_run_24((u8 *) p, len, r, g, b);
+				p += 3*done;
+				len -= done;
+			}
+#endif
 			while (len--) {
 				*(p) = r;
 				*(p + 1) = g;
@@ -145,6 +255,14 @@ void evg_rgb_fill_var(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 		surf->sten->fill_run(surf->sten, surf, spans[i].x, y, len);
 		col = surf->stencil_pix_run;
 		x = surf->pitch_x * spans[i].x;
+#ifdef EVG_USE_SSE2
+		if (surf->pitch_x==3) {
+			u32 done = blend_var_run_24((u8 *) dst + x, col, len, spanalpha, 1);
+			x += 3*done;
+			col += done;
+			len -= done;
+		}
+#endif
 		while (len--) {
 			col_a = GF_COL_A(*col);
 			if (col_a) {
@@ -181,7 +299,14 @@ GF_Err evg_surface_clear_rgb(GF_SURFACE surf, GF_IRect rc, GF_Color col)
 
 	for (y = 0; y < h; y++) {
 		char *data = _this ->pixels + (y + sy) * st + _this->pitch_x*sx;
-		for (x = 0; x < w; x++) {
+		x = 0;
+#ifdef EVG_USE_SSE2
+		if (_this->pitch_x==3) {
+			x = fill_run_24((u8 *) data, w, r, g, b);
+			data += 3*x;
+		}
+#endif
+		for (; x < w; x++) {
 			*(data) = r;
 			*(data+1) = g;
 			*(data+2) = b;
@@ -221,6 +346,14 @@ static void overmask_bgr_const_run(u32 src, char *dst, s32 dst_pitch_x, u32 coun
 	u8 srcg = (src >> 8) & 0xff;
 	u8 srcb = (src) & 0xff;
 
+#ifdef EVG_USE_SSE2
+	if ((dst_pitch_x==3) && (count>=16)) {
+		u32 done = blend_const_run_24((u8 *) dst, count, srcb, srcg, srcr, srca);
+		dst += 3*done;
+		count -= done;
+	}
+#endif
+
 	while (count) {
 		u8 dstb = *(dst);
 		u8 dstg = *(dst+1);
@@ -258,6 +391,13 @@ void evg_bgr_fill_const(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 			fin = (a<<24) | col_no_a;
 			overmask_bgr_const_run(fin, p, surf->pitch_x, len);
 		} else {
+#ifdef EVG_USE_SSE2
+			if (surf->pitch_x==3) {
+				u32 done = fill_run_24((u8 *) p, len, b, g, r);
+				p += 3*done;
+				len -= done;
+			}
+#endif
 			while (len--) {
 				*(p) = b;
 				*(p + 1) = g;
@@ -304,6 +444,14 @@ void evg_bgr_fill_var(s32 y, s32 count, EVG_Span *spans, EVGSurface *surf)
 		surf->sten->fill_run(surf->sten, surf, x, y, len);
 		x *= surf->pitch_x;
 		col = surf->stencil_pix_run;
+#ifdef EVG_USE_SSE2
+		if (surf->pitch_x==3) {
+			u32 done = blend_var_run_24((u8 *) dst + x, col, len, spanalpha, 0);
+			x += 3*done;
+			col += done;
+			len -= done;
+		}
+#endif
 		while (len--) {
 			_col = *col;
 			col_a = GF_COL_A(_col);
@@ -341,7 +489,14 @@ GF_Err evg_surface_clear_bgr(GF_SURFACE surf, GF_IRect rc, GF_Color col)
 
 	for (y = 0; y < h; y++) {
 		char *data = _this ->pixels + (y+sy) * st + _this->pitch_x*sx;
-		for (x = 0; x < w; x++) {
+		x = 0;
+#ifdef EVG_USE_SSE2
+		if (_this->pitch_x==3) {
+			x = fill_run_24((u8 *) data, w, b, g, r);
+			data += 3*x;
+		}
+#endif
+		for (; x < w; x++) {
 			*(data) = b;
 			*(data+1) = g;
 			*(data+2) = r;
@@ -44,6 +44,7 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_sys_close) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sleep) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sys_clock) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_sys_get_cpu_count) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sys_get_rti) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sys_get_battery_state) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_get_default_cache_directory) )
@@ -158,6 +159,8 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_get_position) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_get_size) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_bs_get_refreshed_size) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_bs_set_output_buffering) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_bs_flush) )
 
 /* Thread */
 #pragma comment (linker, EXPORT_SYMBOL(gf_th_new) )
@@ -192,7 +195,9 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_sk_bind) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sk_connect) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sk_send) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_sk_send_multiple) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sk_receive) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_sk_receive_multiple) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sk_listen) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sk_accept) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sk_server_mode) )
@@ -205,6 +210,11 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_sk_is_multicast_address) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sk_send_wait) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_sk_receive_wait) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_sk_poll_new) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_sk_poll_del) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_sk_poll_add) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_sk_poll_remove) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_sk_poll_wait) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_url_is_local) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_url_get_absolute_path) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_url_concatenate) )
@@ -537,6 +547,7 @@
 #ifndef GPAC_DISABLE_ISOM
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_sample_new) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_sample_del) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_sample_release) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_last_error) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_probe_file) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_open) )
@@ -555,6 +566,7 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_is_track_fragmented) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_release_segment) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_open_segment) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_reset_tables) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_refresh_fragmented) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_track_count) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_timescale) )
@@ -582,9 +594,12 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_count) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_sample_padding) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_ex) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_info) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_info_ex) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_for_media_time) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_for_movie_time) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_for_composition_time) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_dts) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_sample_duration) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_edit_segment_count) )
@@ -667,6 +682,16 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_payt_info) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_reset_hint_reader) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_next_hint_packet) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_hint_cache_new) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_hint_cache_save) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_hint_cache_load) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_hint_cache_del) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_hint_cache_get_packet_count) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_hint_cache_get_timescale) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_hint_cache_get_max_size) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_hint_cache_find_packet) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_hint_cache_get_packet) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_hint_cache_write_packet) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_sdp_get) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_sdp_track_get) )
 # ifndef GPAC_DISABLE_ISOM_DUMP
@@ -697,6 +722,7 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_storage_mode) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_storage_mode) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_interleave_time) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_output_buffering) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_get_interleave_time) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_copyright) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_set_media_type) )
@@ -854,6 +880,8 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_rtp_streamer_format_sdp_header) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_rtp_streamer_disable_auto_rtcp) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_rtp_streamer_send_rtcp) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_rtp_streamer_set_pacing) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_rtp_streamer_flush) )
 
 
 #pragma comment (linker, EXPORT_SYMBOL(gf_isom_streamer_new) )
@@ -939,6 +967,7 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_rtsp_get_session_ip) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_rtsp_get_next_interleave_id) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_rtsp_get_remote_address) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_rtsp_get_session_socket) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_rtsp_get_session_port) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_rtp_new) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_rtp_del) )
@@ -1029,6 +1058,14 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_media_change_par) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_media_change_pl) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_media_fragment_file) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_media_fragment_files) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dash_live_new) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dash_live_get_movie) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dash_live_add_track) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dash_live_add_sample) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dash_live_process_input) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dash_live_close) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_dash_live_del) )
 #endif /*GPAC_DISABLE_MEDIA_IMPORT*/
 
 
@@ -1091,6 +1128,8 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_img_png_file_dec) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_img_png_enc) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m4v_get_profile_name) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_media_next_zero_pair) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_media_nalu_next_start_code) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_mp3_version) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_mp3_version_name) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m4a_object_type_name) )
@@ -1529,6 +1568,17 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_new) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_del) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_process_data) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_set_pid_filtering) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_allow_pid) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_select_program) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_demux_get_ring_stats) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_new) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_del) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_update) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_find) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_get_duration) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_save) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_index_load) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_reset_parsers) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_set_pes_framing) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_get_stream_name) )
@@ -1543,6 +1593,7 @@
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_program_stream_update_sl_config) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_update_config) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_process) )
+#pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_mux_process_packets) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_get_sys_clock) )
 #pragma comment (linker, EXPORT_SYMBOL(gf_m2ts_get_ts_clock) )
 #endif /*GPAC_DISABLE_MPEG2TS_MUX*/
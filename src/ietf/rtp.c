@@ -51,6 +51,7 @@ void gf_rtp_del(GF_RTPChannel *ch)
 	if (ch->net_info.destination) gf_free(ch->net_info.destination);
 	if (ch->net_info.Profile) gf_free(ch->net_info.Profile);
 	if (ch->po) gf_rtp_reorderer_del(ch->po);
+	if (ch->batch) gf_free(ch->batch);
 	if (ch->send_buffer) gf_free(ch->send_buffer);
 
 	if (ch->CName) gf_free(ch->CName);
@@ -114,6 +115,8 @@ void gf_rtp_reset_buffers(GF_RTPChannel *ch)
 	if (ch->rtp) gf_sk_reset(ch->rtp);
 	if (ch->rtcp) gf_sk_reset(ch->rtcp);
 	if (ch->po) gf_rtp_reorderer_reset(ch->po);
+	/*drop the datagrams fetched before the reset*/
+	ch->batch_pos = ch->batch_count = 0;
 	/*also reset ssrc*/
 	//ch->SenderSSRC = 0;
 	ch->first_SR = 1;
@@ -327,22 +330,51 @@ u32 gf_rtp_read_rtp(GF_RTPChannel *ch, char *buffer, u32 buffer_size)
 	//only if the socket exist (otherwise RTSP interleaved channel)
 	if (!ch || !ch->rtp) return 0;
 
-	e = gf_sk_receive(ch->rtp, buffer, buffer_size, 0, &res);
-	if (!res || e || (res < 12)) res = 0;
+	/*fetch all pending packets at once, they are then served one by one*/
+	if (ch->batch_pos == ch->batch_count) {
+		char *buffers[GF_RTP_BATCH_SIZE];
+		u32 i, lengths[GF_RTP_BATCH_SIZE];
+		ch->batch_pos = ch->batch_count = 0;
+		/*slots are as large as the caller buffer, so that no packet it could read is truncated*/
+		if (ch->batch_slot_size < buffer_size) {
+			char *batch = (char *) gf_realloc(ch->batch, sizeof(char) * GF_RTP_BATCH_SIZE * buffer_size);
+			if (batch) {
+				ch->batch = batch;
+				ch->batch_slot_size = buffer_size;
+			}
+		}
+		if (ch->batch_slot_size >= buffer_size) {
+			for (i=0; i<GF_RTP_BATCH_SIZE; i++) {
+				buffers[i] = ch->batch + i*ch->batch_slot_size;
+				lengths[i] = ch->batch_slot_size;
+			}
+			e = gf_sk_receive_multiple(ch->rtp, buffers, lengths, GF_RTP_BATCH_SIZE, ch->batch_sizes, &ch->batch_count, NULL);
+			if (e) ch->batch_count = 0;
+		}
+	}
+	res = 0;
+	pck = NULL;
+	/*skip dropped datagrams*/
+	while ((ch->batch_pos < ch->batch_count) && !ch->batch_sizes[ch->batch_pos]) ch->batch_pos++;
+	if (ch->batch_pos < ch->batch_count) {
+		pck = ch->batch + ch->batch_pos * ch->batch_slot_size;
+		res = ch->batch_sizes[ch->batch_pos];
+		ch->batch_pos++;
+		if ((res < 12) || (res > buffer_size)) res = 0;
+	}
 
 	//add the packet to our Queue if any
 	if (ch->po) {
 		if (res) {
-			seq_num = ((buffer[2] << 8) & 0xFF00) | (buffer[3] & 0xFF);
-			gf_rtp_reorderer_add(ch->po, (void *) buffer, res, seq_num);
+			seq_num = ((pck[2] << 8) & 0xFF00) | (pck[3] & 0xFF);
+			gf_rtp_reorderer_add(ch->po, (void *) pck, res, seq_num);
 		}
 
 		//pck queue may need to be flushed
 		pck = (char *) gf_rtp_reorderer_get(ch->po, &res);
-		if (pck) {
-			memcpy(buffer, pck, res);
-			gf_free(pck);
-		}
+		if (pck) memcpy(buffer, pck, res);
+	} else if (res) {
+		memcpy(buffer, pck, res);
 	}
 	/*monitor keep-alive period*/
 	if (ch->nat_keepalive_time_period) {
@@ -521,31 +553,14 @@ Double gf_rtp_get_current_time(GF_RTPChannel *ch)
 
 
 
-GF_EXPORT
-GF_Err gf_rtp_send_packet(GF_RTPChannel *ch, GF_RTPHeader *rtp_hdr, char *pck, u32 pck_size, Bool fast_send)
+u32 gf_rtp_format_header(GF_RTPChannel *ch, GF_RTPHeader *rtp_hdr, char *buffer, u32 buffer_size)
 {
-	GF_Err e;
 	u32 i, Start;
-	char *hdr = NULL;
-
 	GF_BitStream *bs;
 
-	if (!ch || !rtp_hdr 
-		|| !ch->send_buffer 
-		|| !pck 
-		|| (rtp_hdr->CSRCCount && !rtp_hdr->CSRC) 
-		|| (rtp_hdr->CSRCCount > 15)) return GF_BAD_PARAM;
-	
-	if (rtp_hdr->CSRCCount) fast_send=0;
-
-	if (12 + pck_size + 4*rtp_hdr->CSRCCount > ch->send_buffer_size) return GF_IO_ERR; 
+	if (12 + 4*rtp_hdr->CSRCCount > buffer_size) return 0;
 
-	if (fast_send) {
-		hdr = pck - 12;
-		bs = gf_bs_new(hdr, 12, GF_BITSTREAM_WRITE);
-	} else {
-		bs = gf_bs_new(ch->send_buffer, ch->send_buffer_size, GF_BITSTREAM_WRITE);
-	}
+	bs = gf_bs_new(buffer, 12 + 4*rtp_hdr->CSRCCount, GF_BITSTREAM_WRITE);
 	//write header
 	gf_bs_write_int(bs, rtp_hdr->Version, 2);
 	gf_bs_write_int(bs, rtp_hdr->Padding, 1);
@@ -563,17 +578,12 @@ GF_Err gf_rtp_send_packet(GF_RTPChannel *ch, GF_RTPHeader *rtp_hdr, char *pck, u
 	//nb: RTP header is always aligned
 	Start = (u32) gf_bs_get_position(bs);
 	gf_bs_del(bs);
+	return Start;
+}
 
-	//copy payload
-	if (fast_send) {
-		e = gf_sk_send(ch->rtp, hdr, pck_size+12);
-	} else {
-		memcpy(ch->send_buffer + Start, pck, pck_size);		
-		e = gf_sk_send(ch->rtp, ch->send_buffer, Start + pck_size);
-	}
-	if (e) return e;
-
-	//Update RTCP for sender reports
+/*updates RTCP sender stats once a packet is sent*/
+static void gf_rtp_on_packet_sent(GF_RTPChannel *ch, u32 TimeStamp, u32 payload_size)
+{
 	ch->pck_sent_since_last_sr += 1;
 	if (ch->first_SR) {
 		//get a new report time
@@ -583,11 +593,66 @@ GF_Err gf_rtp_send_packet(GF_RTPChannel *ch, GF_RTPHeader *rtp_hdr, char *pck, u
 		ch->first_SR = 0;
 	}
 
-	ch->num_payload_bytes += pck_size;
+	ch->num_payload_bytes += payload_size;
 	ch->num_pck_sent += 1;
 	//store timing
-	ch->last_pck_ts = rtp_hdr->TimeStamp;
+	ch->last_pck_ts = TimeStamp;
+}
+
+GF_EXPORT
+GF_Err gf_rtp_send_packet(GF_RTPChannel *ch, GF_RTPHeader *rtp_hdr, char *pck, u32 pck_size, Bool fast_send)
+{
+	GF_Err e;
+	u32 Start;
+
+	if (!ch || !rtp_hdr 
+		|| !ch->send_buffer 
+		|| !pck 
+		|| (rtp_hdr->CSRCCount && !rtp_hdr->CSRC) 
+		|| (rtp_hdr->CSRCCount > 15)) return GF_BAD_PARAM;
+	
+	if (rtp_hdr->CSRCCount) fast_send=0;
+
+	if (12 + pck_size + 4*rtp_hdr->CSRCCount > ch->send_buffer_size) return GF_IO_ERR; 
+
+	//copy payload
+	if (fast_send) {
+		gf_rtp_format_header(ch, rtp_hdr, pck - 12, 12);
+		e = gf_sk_send(ch->rtp, pck - 12, pck_size+12);
+	} else {
+		Start = gf_rtp_format_header(ch, rtp_hdr, ch->send_buffer, ch->send_buffer_size);
+		memcpy(ch->send_buffer + Start, pck, pck_size);		
+		e = gf_sk_send(ch->rtp, ch->send_buffer, Start + pck_size);
+	}
+	if (e) return e;
+
+	//Update RTCP for sender reports
+	gf_rtp_on_packet_sent(ch, rtp_hdr->TimeStamp, pck_size);
+	gf_net_get_ntp(&ch->last_pck_ntp_sec, &ch->last_pck_ntp_frac);
+
+	if (!ch->no_auto_rtcp) gf_rtp_send_rtcp_report(ch, NULL, NULL);
+	return GF_OK;
+}
+
+GF_Err gf_rtp_send_packets(GF_RTPChannel *ch, char **pcks, u32 *pck_sizes, u32 nb_pcks)
+{
+	GF_Err e;
+	u32 i, nb_sent;
+
+	if (!ch || !ch->rtp || !pcks || !pck_sizes) return GF_BAD_PARAM;
+	if (!nb_pcks) return GF_OK;
+
+	e = gf_sk_send_multiple(ch->rtp, (const char **) pcks, pck_sizes, nb_pcks, &nb_sent);
+	if (!nb_sent) return e;
+
+	//Update RTCP for sender reports, including the packets sent before an error
+	for (i=0; i<nb_sent; i++) {
+		char *pck = pcks[i];
+		u32 TimeStamp = ((u8) pck[4] << 24) | ((u8) pck[5] << 16) | ((u8) pck[6] << 8) | (u8) pck[7];
+		gf_rtp_on_packet_sent(ch, TimeStamp, pck_sizes[i] - 12 - 4*(pck[0] & 0x0F));
+	}
 	gf_net_get_ntp(&ch->last_pck_ntp_sec, &ch->last_pck_ntp_frac);
+	if (e) return e;
 
 	if (!ch->no_auto_rtcp) gf_rtp_send_rtcp_report(ch, NULL, NULL);
 	return GF_OK;
@@ -745,205 +810,177 @@ void gf_rtp_get_ports(GF_RTPChannel *ch, u16 *rtp_port, u16 *rtcp_port)
 
 GF_RTPReorder *gf_rtp_reorderer_new(u32 MaxCount, u32 MaxDelay)
 {
+	u32 i;
 	GF_RTPReorder *tmp;
 	
 	if (MaxCount <= 1 || !MaxDelay) return NULL;
+	/*all queued packets must fit in the sequence number window*/
+	if (MaxCount > GF_RTP_REORDER_WINDOW/2) MaxCount = GF_RTP_REORDER_WINDOW/2;
 
 	GF_SAFEALLOC(tmp , GF_RTPReorder);
 	tmp->MaxCount = MaxCount;
 	tmp->MaxDelay = MaxDelay;
+
+	tmp->slots = (GF_POItem **) gf_malloc(sizeof(GF_POItem *) * GF_RTP_REORDER_WINDOW);
+	memset(tmp->slots, 0, sizeof(GF_POItem *) * GF_RTP_REORDER_WINDOW);
+	/*queued packets, plus the one being added and the one last output*/
+	tmp->pool_size = MaxCount + 2;
+	tmp->pool = (GF_POItem *) gf_malloc(sizeof(GF_POItem) * tmp->pool_size);
+	memset(tmp->pool, 0, sizeof(GF_POItem) * tmp->pool_size);
+	tmp->free_items = (GF_POItem **) gf_malloc(sizeof(GF_POItem *) * tmp->pool_size);
+	for (i=0; i<tmp->pool_size; i++) tmp->free_items[i] = &tmp->pool[i];
+	tmp->nb_free = tmp->pool_size;
 	return tmp;
 }
 
-static void DelItem(GF_POItem *it)
+void gf_rtp_reorderer_del(GF_RTPReorder *po)
 {
-	if (it) {
-		if (it->next) DelItem(it->next);
-		gf_free(it->pck);
-		gf_free(it);
+	u32 i;
+	for (i=0; i<po->pool_size; i++) {
+		if (po->pool[i].pck) gf_free(po->pool[i].pck);
 	}
+	gf_free(po->pool);
+	gf_free(po->free_items);
+	gf_free(po->slots);
+	gf_free(po);
 }
 
-
-void gf_rtp_reorderer_del(GF_RTPReorder *po)
+/*puts back all queued packets in the pool*/
+static void gf_rtp_reorderer_flush(GF_RTPReorder *po)
 {
-	if (po->in) DelItem(po->in);
-	gf_free(po);
+	u32 i;
+	for (i=0; i<GF_RTP_REORDER_WINDOW && po->Count; i++) {
+		if (!po->slots[i]) continue;
+		po->free_items[po->nb_free++] = po->slots[i];
+		po->slots[i] = NULL;
+		po->Count--;
+	}
 }
 
 void gf_rtp_reorderer_reset(GF_RTPReorder *po)
 {
 	if (!po) return;
 
-	if (po->in) DelItem(po->in);
+	gf_rtp_reorderer_flush(po);
+	if (po->out) po->free_items[po->nb_free++] = po->out;
+	po->out = NULL;
 	po->head_seqnum = 0;
 	po->Count = 0;
 	po->IsInit = 0;
-	po->in = NULL;
+	po->LastTime = 0;
 }
 
 GF_Err gf_rtp_reorderer_add(GF_RTPReorder *po, void *pck, u32 pck_size, u32 pck_seqnum)
 {
-	GF_POItem *it, *cur;
-	u32 bounds;
+	GF_POItem *it;
+	u32 dist, pos;
 
 	if (!po) return GF_BAD_PARAM;
 
-	it = (GF_POItem *) gf_malloc(sizeof(GF_POItem));
-	it->pck_seq_num = pck_seqnum;
-	it->next = NULL;
-	it->size = pck_size;
-	it->pck = gf_malloc(pck_size);
-	memcpy(it->pck, pck, pck_size);
+	//this is 16 bit seq num, as we work with RTP only for now
+	pck_seqnum &= 0xFFFF;
 	/*reset timeout*/
 	po->LastTime = 0;
 
-	//no input, this packet will be the input
-	if (!po->in) {
-		//the seq num was not initialized
-		if (!po->head_seqnum) {
-			po->head_seqnum = pck_seqnum;
-		} else if (!po->IsInit) {
-			//this is not in our current range for init
-			if (ABSDIFF(po->head_seqnum, pck_seqnum) > SN_CHECK_OFFSET) goto discard;
-			po->IsInit = 1;
-		}
-
-		po->in = it;
-		po->Count += 1;
-		return GF_OK;
+	//the seq num was not initialized
+	if (!po->IsInit) {
+		po->head_seqnum = pck_seqnum;
+		po->IsInit = 1;
+	} else if (po->IsInit == 1) {
+		//this is not in our current range for init
+		if (ABSDIFF(po->head_seqnum, pck_seqnum) > SN_CHECK_OFFSET) goto discard;
+		po->IsInit = 2;
 	}
 
-	//this is 16 bitr seq num, as we work with RTP only for now
-	bounds = 0;
-	if ( (po->head_seqnum >= 0xf000 ) || (po->head_seqnum <= 0x1000) ) bounds = 0x2000;
+	/*distance to the next packet to output*/
+	dist = (pck_seqnum - po->head_seqnum) & 0xFFFF;
+	//late packet, already output or skipped
+	if (dist >= 0x10000 - GF_RTP_REORDER_WINDOW) goto discard;
+	//sequence jump (forward or far backward), resync on this packet
+	if (dist >= GF_RTP_REORDER_WINDOW) {
+		GF_LOG(GF_LOG_WARNING, GF_LOG_RTP, ("[rtp] Packet Reorderer: sequence jump from %d to %d, dropping %d queued packets\n", po->head_seqnum, pck_seqnum, po->Count));
+		gf_rtp_reorderer_flush(po);
+		po->head_seqnum = pck_seqnum;
+	}
 
-	//first check the head of the list
+	pos = pck_seqnum % GF_RTP_REORDER_WINDOW;
 	//same seq num, we drop
-	if (po->in->pck_seq_num == pck_seqnum) goto discard;
-
-	if ( ( (u16) (pck_seqnum + bounds) <= (u16) (po->in->pck_seq_num + bounds) )
-		&& ( (u16) (pck_seqnum + bounds) >= (u16) (po->head_seqnum + bounds)) ) {
-
-		it->next = po->in;
-		po->in = it;
-		po->Count += 1;
-
-		GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("[rtp] Packet Reorderer: inserting packet %d at head\n", pck_seqnum));
-		return GF_OK;
+	if (po->slots[pos]) goto discard;
+	if (!po->nb_free) {
+		GF_LOG(GF_LOG_WARNING, GF_LOG_RTP, ("[rtp] Packet Reorderer: queue full\n"));
+		goto discard;
 	}
 
-	//no, insert at the right place
-	cur = po->in;
-
-	while (1) {
-		//same seq num, we drop
-		if (cur->pck_seq_num == pck_seqnum) goto discard;
-
-		//end of list
-		if (!cur->next) {
-			cur->next = it;
-			po->Count += 1;
-#ifndef GPAC_DISABLE_LOG
-			if (cur->pck_seq_num +1 != it->pck_seq_num) 
-				GF_LOG(GF_LOG_WARNING, GF_LOG_RTP, ("[rtp] Packet Reorderer: got %d expected %d\n", cur->pck_seq_num+1, it->pck_seq_num));
-
-			GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("[rtp] Packet Reorderer: Appending packet %d\n", pck_seqnum));
-#endif
-			return GF_OK;
-		}
-
-		//are we in the bounds ??
-		if ( ( (u16) (cur->pck_seq_num + bounds) < (u16) (pck_seqnum + bounds) )
-			&& ( (u16) (pck_seqnum + bounds) < (u16) (cur->next->pck_seq_num + bounds)) ) {
-
-			//insert
-			it->next = cur->next;
-			cur->next = it;
-			po->Count += 1;
-
-			GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("[rtp] Packet Reorderer: Inserting packet %d", pck_seqnum));
-			//done
-			return GF_OK;
-		}
-		cur = cur->next;
+	it = po->free_items[--po->nb_free];
+	if (it->alloc_size < pck_size) {
+		it->pck = (char *) gf_realloc(it->pck, sizeof(char) * pck_size);
+		it->alloc_size = pck_size;
 	}
-	
+	memcpy(it->pck, pck, sizeof(char) * pck_size);
+	it->size = pck_size;
+	it->pck_seq_num = pck_seqnum;
+	po->slots[pos] = it;
+	po->Count += 1;
+	GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("[rtp] Packet Reorderer: queuing packet %d\n", pck_seqnum));
+	return GF_OK;
 
 discard:
-	gf_free(it->pck);
-	gf_free(it);
 	GF_LOG(GF_LOG_ERROR, GF_LOG_RTP, ("[rtp] Packet Reorderer: Dropping packet %d", pck_seqnum));
 	return GF_OK;
 }
 
 //retrieve the first available packet. Note that the behavior will be undefined if the first
 //ever received packet if its SeqNum was unknown
-//the BUFFER is yours, you must delete it
+//the BUFFER is only valid until the next call to the reorderer
 void *gf_rtp_reorderer_get(GF_RTPReorder *po, u32 *pck_size)
 {
-	GF_POItem *t;
-	u32 bounds;
-	void *ret;
+	GF_POItem *it;
+	u32 pos, expected;
 
 	if (!po || !pck_size) return NULL;
 
 	*pck_size = 0;
 
-	//empty queue
-	if (!po->in) return NULL;
-
-	//check we have received the first packet
-	if ( po->head_seqnum && po->MaxCount
-		&& (po->MaxCount > po->Count) 
-		&& (po->in->pck_seq_num != po->head_seqnum)) 
-		return NULL;
-
-	//no entry
-	if (!po->in->next) goto check_timeout;
-
-	bounds = 0;
-	if ( (po->head_seqnum >= 0xf000 ) || (po->head_seqnum <= 0x1000) ) bounds = 0x2000;
-
-	//release the output if SN in order or maxCount reached
-	if (( (u16) (po->in->pck_seq_num + bounds + 1) == (u16) (po->in->next->pck_seq_num + bounds)) 
-		|| (po->MaxCount && (po->Count >= po->MaxCount)) ) {
-
-#ifndef GPAC_DISABLE_LOG
-		if (po->in->pck_seq_num + 1 != po->in->next->pck_seq_num) 
-			GF_LOG(GF_LOG_WARNING, GF_LOG_RTP, ("[rtp] Packet Reorderer: Fetched %d expected %d\n", po->in->pck_seq_num, po->in->next->pck_seq_num));
-#endif
-		goto send_it;
+	//release the previous output
+	if (po->out) {
+		po->free_items[po->nb_free++] = po->out;
+		po->out = NULL;
 	}
-	//update timing
-	else {
-check_timeout:
-		if (!po->LastTime) {
-			po->LastTime = gf_sys_clock();
-			GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("[rtp] Packet Reorderer: starting timeout at %d\n", po->LastTime));
-			return NULL;
-		}
-		//if exceeding the delay send the head
-		if (gf_sys_clock() - po->LastTime >= po->MaxDelay) {
+
+	//empty queue
+	if (!po->Count) return NULL;
+
+	pos = po->head_seqnum % GF_RTP_REORDER_WINDOW;
+	if (!po->slots[pos]) {
+		//missing packet, wait for it unless maxCount is reached or the delay is exceeded
+		if (po->Count < po->MaxCount) {
+			if (!po->LastTime) {
+				po->LastTime = gf_sys_clock();
+				GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("[rtp] Packet Reorderer: starting timeout at %d\n", po->LastTime));
+				return NULL;
+			}
+			if (gf_sys_clock() - po->LastTime < po->MaxDelay) return NULL;
 			GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("[rtp] Packet Reorderer: Forcing output after %d ms wait (max allowed %d)\n", gf_sys_clock() - po->LastTime, po->MaxDelay));
-			goto send_it;
 		}
+		//skip the missing packets, all queued ones are in the window after the head
+		expected = po->head_seqnum;
+		while (!po->slots[pos]) {
+			po->head_seqnum = (po->head_seqnum + 1) & 0xFFFF;
+			pos = po->head_seqnum % GF_RTP_REORDER_WINDOW;
+		}
+		GF_LOG(GF_LOG_WARNING, GF_LOG_RTP, ("[rtp] Packet Reorderer: Fetched %d expected %d\n", po->head_seqnum, expected));
+		po->LastTime = 0;
 	}
-	return NULL;
 
-
-send_it:
-	GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("[rtp] Packet Reorderer: Fetching %d\n", po->in->pck_seq_num));
-	*pck_size = po->in->size;
-	t = po->in;
-	po->in = po->in->next;
-	//no other output. reset the head seqnum
-	po->head_seqnum = po->in ? po->in->pck_seq_num : 0;
+	it = po->slots[pos];
+	po->slots[pos] = NULL;
 	po->Count -= 1;
-	//release the item
-	ret = t->pck;
-	gf_free(t);
-	return ret;
+	po->head_seqnum = (it->pck_seq_num + 1) & 0xFFFF;
+	GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("[rtp] Packet Reorderer: Fetching %d\n", it->pck_seq_num));
+
+	po->out = it;
+	*pck_size = it->size;
+	return it->pck;
 }
 
 #endif /*GPAC_DISABLE_STREAMING*/
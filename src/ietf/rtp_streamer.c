@@ -33,37 +33,141 @@
 
 #ifndef GPAC_DISABLE_STREAMING
 
+/*max number of packets waiting to be sent*/
+#define RTP_SEND_QUEUE_SIZE	128
+/*max number of packets sent per system call*/
+#define RTP_SEND_BATCH	32
+/*default max time a packet waits in the send queue, in ms*/
+#define RTP_PACING_MAX_DELAY	100
+
 struct __rtp_streamer
 {
 	GP_RTPPacketizer *packetizer;
 	GF_RTPChannel *channel; 
 
-	/* The current packet being formed */
+	/* The current packet being formed, taken from the packet pool*/
 	char *buffer;
 	u32 payload_len, buffer_alloc;
 
+	/*packet buffers, allocated when first needed and reused, and the free ones*/
+	char *pool[RTP_SEND_QUEUE_SIZE];
+	u32 nb_pool;
+	char *free_pcks[RTP_SEND_QUEUE_SIZE];
+	u32 nb_free;
+	/*packets waiting to be sent, in order, with their size and queuing time*/
+	char *queue[RTP_SEND_QUEUE_SIZE];
+	u32 queue_sizes[RTP_SEND_QUEUE_SIZE], queue_times[RTP_SEND_QUEUE_SIZE];
+	u32 queue_first, queue_count;
+
+	/*token bucket pacing: rate in bytes per sec (0 to send as soon as possible), bucket level and depth in bytes, last update in microsec*/
+	u32 pace_rate, pace_max_delay;
+	Double pace_tokens, pace_burst;
+	u64 pace_last_time;
+
 	Double ts_scale;
 };
 
+static u64 rtp_stream_get_time()
+{
+	u32 sec, frac;
+	gf_net_get_ntp(&sec, &frac);
+	return ((u64) sec) * 1000000 + ((((u64) frac) * 1000000) >> 32);
+}
+
+/*sends the packets allowed by the pacing, all packets if force is set*/
+static GF_Err rtp_stream_flush(GF_RTPStreamer *rtp, Bool force)
+{
+	GF_Err e = GF_OK;
+	u32 now = gf_sys_clock();
+
+	if (rtp->pace_rate) {
+		u64 time = rtp_stream_get_time();
+		if (rtp->pace_last_time && (time > rtp->pace_last_time)) {
+			rtp->pace_tokens += ((Double) (s64) (time - rtp->pace_last_time)) * rtp->pace_rate / 1000000;
+			if (rtp->pace_tokens > rtp->pace_burst) rtp->pace_tokens = rtp->pace_burst;
+		}
+		rtp->pace_last_time = time;
+	}
+
+	while (rtp->queue_count) {
+		char *pcks[RTP_SEND_BATCH];
+		u32 i, nb_pcks, sizes[RTP_SEND_BATCH];
+
+		nb_pcks = 0;
+		while ((nb_pcks < RTP_SEND_BATCH) && (nb_pcks < rtp->queue_count)) {
+			u32 idx = (rtp->queue_first + nb_pcks) % RTP_SEND_QUEUE_SIZE;
+			if (rtp->pace_rate) {
+				/*packets waiting for too long are sent anyway*/
+				if (!force && (rtp->pace_tokens < rtp->queue_sizes[idx]) && (now - rtp->queue_times[idx] < rtp->pace_max_delay)) break;
+				rtp->pace_tokens -= rtp->queue_sizes[idx];
+				if (rtp->pace_tokens < 0) rtp->pace_tokens = 0;
+			}
+			pcks[nb_pcks] = rtp->queue[idx];
+			sizes[nb_pcks] = rtp->queue_sizes[idx];
+			nb_pcks++;
+		}
+		if (!nb_pcks) break;
+
+		e = gf_rtp_send_packets(rtp->channel, pcks, sizes, nb_pcks);
+		if (e) {
+			GF_LOG(GF_LOG_ERROR, GF_LOG_RTP, ("Error %s sending %d RTP packets\n", gf_error_to_string(e), nb_pcks));
+		}
+		/*packets are not sent again on error*/
+		for (i=0; i<nb_pcks; i++) {
+			rtp->free_pcks[rtp->nb_free++] = pcks[i];
+		}
+		rtp->queue_first = (rtp->queue_first + nb_pcks) % RTP_SEND_QUEUE_SIZE;
+		rtp->queue_count -= nb_pcks;
+	}
+	return e;
+}
 
 /*callbacks from packetizer to channel*/
 
+/*gets a packet buffer from the pool, sending queued packets if all buffers are used*/
+static void rtp_stream_get_buffer(GF_RTPStreamer *rtp)
+{
+	if (rtp->buffer) return;
+	if (!rtp->nb_free) {
+		if (rtp->nb_pool < RTP_SEND_QUEUE_SIZE) {
+			rtp->pool[rtp->nb_pool] = gf_malloc(sizeof(char) * rtp->buffer_alloc);
+			rtp->free_pcks[rtp->nb_free++] = rtp->pool[rtp->nb_pool];
+			rtp->nb_pool++;
+		} else {
+			rtp_stream_flush(rtp, 1);
+		}
+	}
+	rtp->buffer = rtp->free_pcks[--rtp->nb_free];
+	rtp->payload_len = 0;
+}
+
 static void rtp_stream_on_new_packet(void *cbk, GF_RTPHeader *header)
 {
+	GF_RTPStreamer *rtp = cbk;
+	rtp_stream_get_buffer(rtp);
 }
 
 static void rtp_stream_on_packet_done(void *cbk, GF_RTPHeader *header)
 {
+	u32 idx;
 	GF_RTPStreamer *rtp = cbk;
-	GF_Err e = gf_rtp_send_packet(rtp->channel, header, rtp->buffer+12, rtp->payload_len, 1);
-	
-#ifndef GPAC_DISABLE_LOG
-	if (e) {
-		GF_LOG(GF_LOG_ERROR, GF_LOG_RTP, ("Error %s sending RTP packet\n", gf_error_to_string(e)));
-	} else {
-		GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("RTP SN %u - TS %u - M %u - Size %u\n", header->SequenceNumber, header->TimeStamp, header->Marker, rtp->payload_len + 12));
+	rtp_stream_get_buffer(rtp);
+
+	/*oversized packet, its data was discarded*/
+	if (rtp->payload_len + 12 > rtp->buffer_alloc) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_RTP, ("Error %s sending RTP packet\n", gf_error_to_string(GF_IO_ERR)));
+		rtp->payload_len = 0;
+		return;
 	}
-#endif
+	gf_rtp_format_header(rtp->channel, header, rtp->buffer, 12);
+	GF_LOG(GF_LOG_DEBUG, GF_LOG_RTP, ("RTP SN %u - TS %u - M %u - Size %u\n", header->SequenceNumber, header->TimeStamp, header->Marker, rtp->payload_len + 12));
+
+	idx = (rtp->queue_first + rtp->queue_count) % RTP_SEND_QUEUE_SIZE;
+	rtp->queue[idx] = rtp->buffer;
+	rtp->queue_sizes[idx] = rtp->payload_len + 12;
+	rtp->queue_times[idx] = gf_sys_clock();
+	rtp->queue_count++;
+	rtp->buffer = NULL;
 	rtp->payload_len = 0;
 }
 
@@ -71,6 +175,7 @@ static void rtp_stream_on_data(void *cbk, char *data, u32 data_size, Bool is_hea
 {
 	GF_RTPStreamer *rtp = cbk;
 	if (!data ||!data_size) return;
+	rtp_stream_get_buffer(rtp);
 
 	if (rtp->payload_len+data_size+12 > rtp->buffer_alloc) {
 		GF_LOG(GF_LOG_ERROR, GF_LOG_RTP, ("[RTP] Packet size %d bigger than MTU size %d - discarding\n", rtp->payload_len+data_size+12, rtp->buffer_alloc));
@@ -448,7 +553,9 @@ GF_RTPStreamer *gf_rtp_streamer_new_extended(u32 streamType, u32 oti, u32 timeSc
 	stream->ts_scale /= timeScale;
 
 	stream->buffer_alloc = MTU+12;
-	stream->buffer = gf_malloc(sizeof(char) * stream->buffer_alloc);
+
+	/*pace at twice the average rate (kbps) of the media, leaving room for the larger AUs*/
+	if (bandwidth) gf_rtp_streamer_set_pacing(stream, 2*1000*bandwidth, 0);
 
 	return stream;
 }
@@ -467,13 +574,38 @@ GF_RTPStreamer *gf_rtp_streamer_new(u32 streamType, u32 oti, u32 timeScale,
 void gf_rtp_streamer_del(GF_RTPStreamer *streamer)
 {
 	if (streamer) {
-		if (streamer->channel) gf_rtp_del(streamer->channel);
+		u32 i;
+		if (streamer->channel) {
+			rtp_stream_flush(streamer, 1);
+			gf_rtp_del(streamer->channel);
+		}
 		if (streamer->packetizer) gf_rtp_builder_del(streamer->packetizer);
-		if (streamer->buffer) gf_free(streamer->buffer);				
+		for (i=0; i<streamer->nb_pool; i++) gf_free(streamer->pool[i]);
 		gf_free(streamer);
 	}
 }
 
+GF_Err gf_rtp_streamer_set_pacing(GF_RTPStreamer *streamer, u32 bitrate, u32 max_delay)
+{
+	if (!streamer) return GF_BAD_PARAM;
+	/*queued packets were scheduled with the previous rate*/
+	rtp_stream_flush(streamer, 1);
+	streamer->pace_rate = bitrate / 8;
+	streamer->pace_max_delay = max_delay ? max_delay : RTP_PACING_MAX_DELAY;
+	/*2 ms of data, and at least a few packets*/
+	streamer->pace_burst = streamer->pace_rate / 500;
+	if (streamer->pace_burst < 4*streamer->buffer_alloc) streamer->pace_burst = 4*streamer->buffer_alloc;
+	streamer->pace_tokens = streamer->pace_burst;
+	streamer->pace_last_time = 0;
+	return GF_OK;
+}
+
+GF_Err gf_rtp_streamer_flush(GF_RTPStreamer *streamer, Bool force)
+{
+	if (!streamer) return GF_BAD_PARAM;
+	return rtp_stream_flush(streamer, force);
+}
+
 #if !defined(GPAC_DISABLE_ISOM) && !defined(GPAC_DISABLE_STREAMING)
 
 void gf_media_format_ttxt_sdp(GP_RTPPacketizer *builder, char *payload_name, char *sdpLine, GF_ISOFile *file, u32 track)
@@ -697,6 +829,7 @@ GF_Err gf_rtp_streamer_append_sdp(GF_RTPStreamer *rtp, u16 ESID, char *dsi, u32
 
 GF_Err gf_rtp_streamer_send_data(GF_RTPStreamer *rtp, char *data, u32 size, u32 fullsize, u64 cts, u64 dts, Bool is_rap, Bool au_start, Bool au_end, u32 au_sn, u32 sampleDuration, u32 sampleDescIndex)
 {
+	GF_Err e;
 	rtp->packetizer->sl_header.compositionTimeStamp = (u64) (cts*rtp->ts_scale);
 	rtp->packetizer->sl_header.decodingTimeStamp = (u64) (dts*rtp->ts_scale);
 	rtp->packetizer->sl_header.randomAccessPointFlag = is_rap;
@@ -706,7 +839,10 @@ GF_Err gf_rtp_streamer_send_data(GF_RTPStreamer *rtp, char *data, u32 size, u32
 	rtp->packetizer->sl_header.AU_sequenceNumber = au_sn;
 	sampleDuration = (u32) (sampleDuration * rtp->ts_scale);
 
-	return gf_rtp_builder_process(rtp->packetizer, data, size, (u8) au_end, fullsize, sampleDuration, sampleDescIndex);
+	e = gf_rtp_builder_process(rtp->packetizer, data, size, (u8) au_end, fullsize, sampleDuration, sampleDescIndex);
+	/*packets not allowed by the pacing are sent by the next calls*/
+	rtp_stream_flush(rtp, 0);
+	return e;
 }
 
 GF_Err gf_rtp_streamer_send_au(GF_RTPStreamer *rtp, char *data, u32 size, u64 cts, u64 dts, Bool is_rap)
@@ -727,6 +863,8 @@ void gf_rtp_streamer_disable_auto_rtcp(GF_RTPStreamer *streamer)
 
 GF_Err gf_rtp_streamer_send_rtcp(GF_RTPStreamer *streamer, Bool force_ts, u32 rtp_ts)
 {
+	/*the report covers all packets given so far*/
+	rtp_stream_flush(streamer, 1);
 	if (force_ts) streamer->channel->last_pck_ts = rtp_ts;
 	return gf_rtp_send_rtcp_report(streamer->channel, NULL, NULL);
 }
@@ -469,7 +469,7 @@ GF_Err RTSP_ParseCommandHeader(GF_RTSPSession *sess, GF_RTSPCommand *com, u32 Bo
 	com->service_name = gf_strdup(ValBuf);
 	
 	//RTSP version
-	Pos = gf_token_get(LineBuffer, Pos, "\t\r\n", ValBuf, 1024);
+	Pos = gf_token_get(LineBuffer, Pos, " \t\r\n", ValBuf, 1024);
 	if (Pos <= 0) return GF_OK;
 	if (strcmp(ValBuf, GF_RTSP_VERSION)) {
 		com->StatusCode = NC_RTSP_RTSP_Version_Not_Supported;
@@ -501,7 +501,7 @@ GF_Err gf_rtsp_get_command(GF_RTSPSession *sess, GF_RTSPCommand *com)
 	e = gf_rtsp_fill_buffer(sess);
 	if (e) goto exit;
 	//this is upcoming, interleaved data
-	if (strncmp(sess->TCPBuffer+sess->CurrentPos, "RTSP", 4)) {
+	if (sess->TCPBuffer[sess->CurrentPos] == '$') {
 		e = GF_IP_NETWORK_EMPTY;
 		goto exit;
 	}
@@ -562,11 +562,11 @@ GF_Err RTSP_WriteResponse(GF_RTSPSession *sess, GF_RTSPResponse *rsp,
 	//RTP Infos
 	count = gf_list_count(rsp->RTP_Infos);
 	if (count) {
-		RTSP_WRITE_ALLOC_STR(buffer, size, cur_pos, "RTPInfo: ");
+		RTSP_WRITE_ALLOC_STR(buffer, size, cur_pos, "RTP-Info: ");
 
 		for (i=0; i<count; i++) {
 			//line separator for headers
-			if (i) RTSP_WRITE_ALLOC_STR(buffer, size, cur_pos, "\r\n ,");
+			if (i) RTSP_WRITE_ALLOC_STR(buffer, size, cur_pos, ",");
 			info = (GF_RTPInfo*)gf_list_get(rsp->RTP_Infos, i);
 			
 			if (info->url) {
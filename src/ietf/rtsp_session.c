@@ -689,7 +689,7 @@ GF_RTSPSession *gf_rtsp_session_new_server(GF_Socket *rtsp_listener)
 	sess->ConnectionType = fam;
 	gf_sk_get_host_name(name);
 	sess->Server = gf_strdup(name);
-	
+	sess->mx = gf_mx_new("RTSPSession");
 	sess->TCPChannels = gf_list_new();
 	return sess;
 }
@@ -774,4 +774,10 @@ GF_Err gf_rtsp_get_remote_address(GF_RTSPSession *sess, char *buf)
 	return gf_sk_get_remote_address(sess->connection, buf);
 }
 
+GF_EXPORT
+GF_Socket *gf_rtsp_get_session_socket(GF_RTSPSession *sess)
+{
+	return sess ? sess->connection : NULL;
+}
+
 #endif /*GPAC_DISABLE_STREAMING*/
@@ -314,6 +314,7 @@ void ctts_del(GF_Box *s)
 {
 	GF_CompositionOffsetBox *ptr = (GF_CompositionOffsetBox *)s;
 	if (ptr->entries) gf_free(ptr->entries);
+	if (ptr->r_idx_first_sample) gf_free(ptr->r_idx_first_sample);
 	gf_free(ptr);
 }
 
@@ -4479,6 +4480,7 @@ void stbl_del(GF_Box *s)
 	if (ptr->PaddingBits) gf_isom_box_del((GF_Box *) ptr->PaddingBits);
 	if (ptr->Fragments) gf_isom_box_del((GF_Box *) ptr->Fragments);
 	if (ptr->SubSamples) gf_isom_box_del((GF_Box *) ptr->SubSamples);
+	if (ptr->r_cts_index) gf_free(ptr->r_cts_index);
 
 	gf_free(ptr);
 }
@@ -4922,6 +4924,7 @@ void stsc_del(GF_Box *s)
 	GF_SampleToChunkBox *ptr = (GF_SampleToChunkBox *)s;
 	if (ptr == NULL) return;
 	if (ptr->entries) gf_free(ptr->entries);
+	if (ptr->r_idx_first_sample) gf_free(ptr->r_idx_first_sample);
 	gf_free(ptr);
 }
 
@@ -5626,6 +5629,8 @@ void stts_del(GF_Box *s)
 {
 	GF_TimeToSampleBox *ptr = (GF_TimeToSampleBox *)s;
 	if (ptr->entries) gf_free(ptr->entries);
+	if (ptr->r_idx_first_sample) gf_free(ptr->r_idx_first_sample);
+	if (ptr->r_idx_dts) gf_free(ptr->r_idx_dts);
 	gf_free(ptr);
 }
 
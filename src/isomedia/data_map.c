@@ -141,8 +141,12 @@ GF_Err gf_isom_datamap_new(const char *location, const char *parentPath, u8 mode
 		} else {
 			*outDataMap = gf_isom_fmo_new(sPath, mode);
 		}
-#else
+#elif defined(WIN32)
 		*outDataMap = gf_isom_fdm_new(sPath, mode);
+#else
+		/*POSIX mapping only maps a window of the file when the address space is too small, so large files are fine*/
+		*outDataMap = gf_isom_fmo_new(sPath, mode);
+		if (! (*outDataMap)) *outDataMap = gf_isom_fdm_new(sPath, mode);
 #endif
 	} else {
 		*outDataMap = gf_isom_fdm_new(sPath, mode);
@@ -233,6 +237,13 @@ u32 gf_isom_datamap_get_data(GF_DataMap *map, char *buffer, u32 bufferLength, u6
 	}
 }
 
+const char *gf_isom_datamap_get_data_ptr(GF_DataMap *map, u32 bufferLength, u64 Offset)
+{
+	if (!map) return NULL;
+	if (map->type != GF_ISOM_DATA_FILE_MAPPING) return NULL;
+	return gf_isom_fmo_get_data_ptr((GF_FileMappingDataMap *)map, bufferLength, Offset);
+}
+
 
 #ifndef GPAC_DISABLE_ISOM_WRITE
 
@@ -296,6 +307,7 @@ GF_DataMap *gf_isom_fdm_new_temp(const char *sPath)
 		gf_free(tmp);
 		return NULL;
 	}
+	gf_bs_set_output_buffering(tmp->bs, GF_ISOM_DEFAULT_OUTPUT_BUFFERING);
 	return (GF_DataMap *)tmp;
 }
 
@@ -351,6 +363,8 @@ GF_DataMap *gf_isom_fdm_new(const char *sPath, u8 mode)
 		gf_free(tmp);
 		return NULL;
 	}
+	/*gather the many small writes of boxes and samples*/
+	if (bs_mode == GF_BITSTREAM_WRITE) gf_bs_set_output_buffering(tmp->bs, GF_ISOM_DEFAULT_OUTPUT_BUFFERING);
 	return (GF_DataMap *)tmp;
 }
 
@@ -378,8 +392,9 @@ u32 gf_isom_fdm_get_data(GF_FileDataMap *ptr, char *buffer, u32 bufferLength, u6
 	//can we seek till that point ???
 	if (fileOffset > gf_bs_get_size(ptr->bs)) return 0;
 
-	//ouch, we are not at the previous location, do a seek
-	if (ptr->curPos != fileOffset) {
+	//ouch, we are not at the previous location, do a seek - the bitstream may also have been moved
+	//by box parsing when refreshing a progressive file
+	if ((ptr->curPos != fileOffset) || (gf_bs_get_position(ptr->bs) != fileOffset)) {
 		if (gf_bs_seek(ptr->bs, fileOffset) != GF_OK) return 0;
 		ptr->curPos = fileOffset;
 	}
@@ -437,8 +452,7 @@ GF_Err FDM_AddData(GF_FileDataMap *ptr, char *data, u32 dataSize)
 		return GF_IO_ERR;
 	}
 	ptr->curPos = gf_bs_get_position(ptr->bs);
-	//flush the stream !!
-	fflush(ptr->stream);
+	//the data is flushed by the bitstream before any read or seek, don't flush the stream at each sample
 	return GF_OK;
 }
 
@@ -551,6 +565,130 @@ u32 gf_isom_fmo_get_data(GF_FileMappingDataMap *ptr, char *buffer, u32 bufferLen
 	return bufferLength;
 }
 
+const char *gf_isom_fmo_get_data_ptr(GF_FileMappingDataMap *ptr, u32 bufferLength, u64 fileOffset)
+{
+	if (fileOffset + bufferLength > ptr->file_size) return NULL;
+	return ptr->byte_map + fileOffset;
+}
+
+#elif defined(GPAC_CONFIG_LINUX) || defined(GPAC_CONFIG_FREEBSD) || defined(GPAC_CONFIG_DARWIN) || defined(GPAC_CONFIG_SUNOS)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*size of the mapped window on 32 bits platforms, where large files cannot be mapped at once*/
+#define GF_ISOM_FMO_WINDOW_SIZE	(32*1024*1024)
+
+GF_DataMap *gf_isom_fmo_new(const char *sPath, u8 mode)
+{
+	GF_FileMappingDataMap *tmp;
+
+	//only in read only
+	if (mode != GF_ISOM_DATA_MAP_READ) return NULL;
+
+	tmp = (GF_FileMappingDataMap *) gf_malloc(sizeof(GF_FileMappingDataMap));
+	if (!tmp) return NULL;
+	memset(tmp, 0, sizeof(GF_FileMappingDataMap));
+	tmp->type = GF_ISOM_DATA_FILE_MAPPING;
+	tmp->mode = mode;	
+
+	tmp->stream = gf_f64_open(sPath, "rb");
+	if (!tmp->stream) {
+		gf_free(tmp);
+		return NULL;
+	}
+	/*boxes are parsed from the file, the mapping is only used for media data and is created on first access*/
+	tmp->bs = gf_bs_from_file(tmp->stream, GF_BITSTREAM_READ);
+	if (!tmp->bs) {
+		fclose(tmp->stream);
+		gf_free(tmp);
+		return NULL;
+	}
+	tmp->name = gf_strdup(sPath);
+	tmp->file_size = gf_bs_get_size(tmp->bs);
+	return (GF_DataMap *)tmp;
+}
+
+void gf_isom_fmo_del(GF_FileMappingDataMap *ptr)
+{
+	if (!ptr || (ptr->type != GF_ISOM_DATA_FILE_MAPPING)) return;
+
+	if (ptr->bs) gf_bs_del(ptr->bs);
+	if (ptr->byte_map) munmap(ptr->byte_map, (size_t) ptr->byte_map_size);
+	if (ptr->stream) fclose(ptr->stream);
+	gf_free(ptr->name);
+	gf_free(ptr);
+}
+
+/*maps the window containing the given range*/
+static Bool fmo_map_window(GF_FileMappingDataMap *ptr, u64 fileOffset, u32 bufferLength)
+{
+	void *map;
+	u64 start, end, page_size;
+
+	/*the file may have grown since it was opened. Don't refresh the bitstream size here, this is used
+	to detect new fragments*/
+	if (fileOffset + bufferLength > ptr->file_size) {
+		struct stat st;
+		if (fstat(fileno(ptr->stream), &st) != 0) return 0;
+		ptr->file_size = (u64) st.st_size;
+		if (fileOffset + bufferLength > ptr->file_size) return 0;
+	}
+	/*mapping already failed on this file, don't retry at each read*/
+	if (ptr->map_failed) return 0;
+	if (ptr->byte_map) {
+		munmap(ptr->byte_map, (size_t) ptr->byte_map_size);
+		ptr->byte_map = NULL;
+		ptr->byte_map_size = 0;
+	}
+
+	/*map the whole file if the address space allows it*/
+	if (sizeof(size_t) > 4) {
+		start = 0;
+		end = ptr->file_size;
+	} else {
+		page_size = (u64) sysconf(_SC_PAGESIZE);
+		start = fileOffset - (fileOffset % page_size);
+		end = start + GF_ISOM_FMO_WINDOW_SIZE;
+		if (end < fileOffset + bufferLength) end = fileOffset + bufferLength;
+		if (end > ptr->file_size) end = ptr->file_size;
+	}
+	if (end == start) return 0;
+
+	map = mmap(NULL, (size_t) (end - start), PROT_READ, MAP_PRIVATE, fileno(ptr->stream), (off_t) start);
+	if (map == MAP_FAILED) {
+		GF_LOG(GF_LOG_WARNING, GF_LOG_CONTAINER, ("[iso file] Failed to map file %s at offset "LLU" - using regular IO\n", ptr->name, start));
+		ptr->map_failed = 1;
+		return 0;
+	}
+	ptr->byte_map = (char *) map;
+	ptr->byte_pos = start;
+	ptr->byte_map_size = end - start;
+	return 1;
+}
+
+const char *gf_isom_fmo_get_data_ptr(GF_FileMappingDataMap *ptr, u32 bufferLength, u64 fileOffset)
+{
+	if (!ptr->byte_map || (fileOffset < ptr->byte_pos) || (fileOffset + bufferLength > ptr->byte_pos + ptr->byte_map_size)) {
+		if (!fmo_map_window(ptr, fileOffset, bufferLength)) return NULL;
+	}
+	return ptr->byte_map + (fileOffset - ptr->byte_pos);
+}
+
+u32 gf_isom_fmo_get_data(GF_FileMappingDataMap *ptr, char *buffer, u32 bufferLength, u64 fileOffset)
+{
+	const char *data = gf_isom_fmo_get_data_ptr(ptr, bufferLength, fileOffset);
+	if (data) {
+		memcpy(buffer, data, bufferLength);
+		return bufferLength;
+	}
+	/*incomplete data or mapping failure, use regular IO (this gives back the number of bytes available)*/
+	if (fileOffset > gf_bs_get_size(ptr->bs)) return 0;
+	if (gf_bs_seek(ptr->bs, fileOffset) != GF_OK) return 0;
+	return gf_bs_read_data(ptr->bs, buffer, bufferLength);
+}
+
 #else
 
 GF_DataMap *gf_isom_fmo_new(const char *sPath, u8 mode) { return gf_isom_fdm_new(sPath, mode); }
@@ -559,6 +697,7 @@ u32 gf_isom_fmo_get_data(GF_FileMappingDataMap *ptr, char *buffer, u32 bufferLen
 {
 	return gf_isom_fdm_get_data((GF_FileDataMap *)ptr, buffer, bufferLength, fileOffset);
 }
+const char *gf_isom_fmo_get_data_ptr(GF_FileMappingDataMap *ptr, u32 bufferLength, u64 fileOffset) { return NULL; }
 
 #endif
 
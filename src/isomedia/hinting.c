@@ -789,7 +789,7 @@ GF_Err gf_isom_reset_hint_reader(GF_ISOFile *the_file, u32 trackNumber, u32 samp
 	if (!trak) return GF_BAD_PARAM;
 
 	if (!sample_start) return GF_BAD_PARAM;
-	if (sample_start>=trak->Media->information->sampleTable->SampleSize->sampleCount) return GF_BAD_PARAM;
+	if (sample_start>trak->Media->information->sampleTable->SampleSize->sampleCount) return GF_BAD_PARAM;
 
 	e = Media_GetSampleDesc(trak->Media, 1, (GF_SampleEntryBox **) &entry, NULL);
 	if (e) return e;
@@ -850,7 +850,7 @@ static GF_ISOSample *gf_isom_get_data_sample(GF_HintSample *hsamp, GF_TrackBox *
 	}
 
 	samp = gf_isom_sample_new();
-	Media_GetSample(trak->Media, sample_num, &samp, &i, 0, NULL);
+	Media_GetSample(trak->Media, sample_num, &samp, &i, 0, NULL, GF_ISOM_SAMPLE_DATA_ALLOC);
 	if (!samp) return NULL;
 	GF_SAFEALLOC(hdc, GF_HintDataCache);
 	hdc->samp = samp;
@@ -982,4 +982,391 @@ GF_Err gf_isom_next_hint_packet(GF_ISOFile *the_file, u32 trackNumber, char **pc
 	return GF_OK;
 }
 
+
+/*
+		RTP packet cache
+
+	layout of the cache image, in host byte order: header, packet index, then packet data
+*/
+
+#define GF_HINT_CACHE_MAGIC		GF_4CC('G', 'H', 'P', 'C')
+#define GF_HINT_CACHE_VERSION	2
+
+typedef struct
+{
+	u32 magic, version;
+	u32 timescale, nb_packets, max_size, reserved;
+	/*size of the whole image*/
+	u64 image_size;
+	/*size and modification time of the file the cache was built from, 0 if unknown*/
+	u64 source_size, source_mtime;
+} GF_HintCacheHeader;
+
+typedef struct
+{
+	/*offset of the packet in the data section*/
+	u64 offset;
+	/*DTS of the hint sample of the packet*/
+	u64 send_time;
+	u32 size, rtp_ts, sample_num;
+	/*1: disposable, 2: repeated*/
+	u32 flags;
+} GF_HintCacheEntry;
+
+enum
+{
+	GF_HINT_CACHE_ALLOC = 0,
+	GF_HINT_CACHE_MAPPED,
+};
+
+struct __tag_isom_hint_cache
+{
+	char *image;
+	u64 image_size;
+	u32 storage;
+	GF_HintCacheHeader *hdr;
+	GF_HintCacheEntry *entries;
+	char *data;
+};
+
+static GF_Err gf_isom_hint_cache_setup(GF_ISOHintCache *cache)
+{
+	u64 index_end;
+	u32 i;
+	if (cache->image_size < sizeof(GF_HintCacheHeader)) return GF_NON_COMPLIANT_BITSTREAM;
+	cache->hdr = (GF_HintCacheHeader *) cache->image;
+	if ((cache->hdr->magic != GF_HINT_CACHE_MAGIC) || (cache->hdr->version != GF_HINT_CACHE_VERSION)) return GF_NOT_SUPPORTED;
+	if (cache->hdr->image_size != cache->image_size) return GF_NON_COMPLIANT_BITSTREAM;
+	index_end = sizeof(GF_HintCacheHeader) + ((u64) cache->hdr->nb_packets) * sizeof(GF_HintCacheEntry);
+	if (index_end > cache->image_size) return GF_NON_COMPLIANT_BITSTREAM;
+	cache->entries = (GF_HintCacheEntry *) (cache->image + sizeof(GF_HintCacheHeader));
+	cache->data = cache->image + index_end;
+	/*never trust a file*/
+	for (i=0; i<cache->hdr->nb_packets; i++) {
+		GF_HintCacheEntry *ent = &cache->entries[i];
+		if ((ent->size < 12) || (ent->size > cache->hdr->max_size) || (index_end + ent->offset + ent->size > cache->image_size)) return GF_NON_COMPLIANT_BITSTREAM;
+	}
+	return GF_OK;
+}
+
+static void gf_isom_hint_cache_get_source(GF_ISOFile *the_file, u64 *size, u64 *mtime)
+{
+	FILE *f;
+	*size = *mtime = 0;
+	if (!the_file->fileName) return;
+	f = gf_f64_open(the_file->fileName, "rb");
+	if (!f) return;
+	gf_f64_seek(f, 0, SEEK_END);
+	*size = gf_f64_tell(f);
+	fclose(f);
+	*mtime = gf_file_modification_time(the_file->fileName);
+}
+
+GF_EXPORT
+GF_Err gf_isom_hint_cache_new(GF_ISOFile *the_file, u32 trackNumber, GF_ISOHintCache **out_cache)
+{
+	GF_Err e;
+	GF_BitStream *bs;
+	GF_ISOHintCache *cache;
+	GF_HintCacheEntry *entries;
+	GF_HintCacheHeader hdr;
+	char *data;
+	u32 nb_alloc, data_size;
+
+	*out_cache = NULL;
+	e = gf_isom_reset_hint_reader(the_file, trackNumber, 1, 0, 0, 0);
+	if (e) return e;
+
+	memset(&hdr, 0, sizeof(GF_HintCacheHeader));
+	hdr.magic = GF_HINT_CACHE_MAGIC;
+	hdr.version = GF_HINT_CACHE_VERSION;
+	hdr.timescale = gf_isom_get_media_timescale(the_file, trackNumber);
+	gf_isom_hint_cache_get_source(the_file, &hdr.source_size, &hdr.source_mtime);
+
+	nb_alloc = 0;
+	entries = NULL;
+	bs = gf_bs_new(NULL, 0, GF_BITSTREAM_WRITE);
+	while (1) {
+		char *pck;
+		u32 size, rtp_ts, sample_num;
+		Bool disposable, repeated;
+		GF_HintCacheEntry *ent;
+
+		e = gf_isom_next_hint_packet(the_file, trackNumber, &pck, &size, &disposable, &repeated, &rtp_ts, &sample_num);
+		if (e) break;
+		if (size < 12) {
+			gf_free(pck);
+			e = GF_ISOM_INVALID_MEDIA;
+			break;
+		}
+		if (hdr.nb_packets == nb_alloc) {
+			nb_alloc = nb_alloc ? 2*nb_alloc : 1024;
+			entries = (GF_HintCacheEntry *) gf_realloc(entries, sizeof(GF_HintCacheEntry) * nb_alloc);
+		}
+		ent = &entries[hdr.nb_packets];
+		ent->offset = gf_bs_get_position(bs);
+		ent->send_time = gf_isom_get_sample_dts(the_file, trackNumber, sample_num);
+		ent->size = size;
+		ent->rtp_ts = rtp_ts;
+		ent->sample_num = sample_num;
+		ent->flags = (disposable ? 1 : 0) | (repeated ? 2 : 0);
+		if (size > hdr.max_size) hdr.max_size = size;
+		hdr.nb_packets++;
+		gf_bs_write_data(bs, pck, size);
+		gf_free(pck);
+	}
+	if (e != GF_EOS) {
+		gf_bs_del(bs);
+		if (entries) gf_free(entries);
+		return e;
+	}
+
+	data = NULL;
+	data_size = 0;
+	gf_bs_get_content(bs, &data, &data_size);
+	gf_bs_del(bs);
+
+	GF_SAFEALLOC(cache, GF_ISOHintCache);
+	if (cache) {
+		hdr.image_size = sizeof(GF_HintCacheHeader) + ((u64) hdr.nb_packets) * sizeof(GF_HintCacheEntry) + data_size;
+		cache->image_size = hdr.image_size;
+		cache->image = (char *) gf_malloc(sizeof(char) * (size_t) cache->image_size);
+		cache->storage = GF_HINT_CACHE_ALLOC;
+	}
+	if (!cache || !cache->image) {
+		if (cache) gf_free(cache);
+		if (entries) gf_free(entries);
+		if (data) gf_free(data);
+		return GF_OUT_OF_MEM;
+	}
+	memcpy(cache->image, &hdr, sizeof(GF_HintCacheHeader));
+	if (hdr.nb_packets) memcpy(cache->image + sizeof(GF_HintCacheHeader), entries, sizeof(GF_HintCacheEntry) * hdr.nb_packets);
+	if (data_size) memcpy(cache->image + sizeof(GF_HintCacheHeader) + sizeof(GF_HintCacheEntry) * hdr.nb_packets, data, data_size);
+	if (entries) gf_free(entries);
+	if (data) gf_free(data);
+
+	gf_isom_hint_cache_setup(cache);
+	*out_cache = cache;
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_Err gf_isom_hint_cache_save(GF_ISOHintCache *cache, const char *fileName)
+{
+	FILE *f;
+	size_t written;
+	if (!cache || !fileName) return GF_BAD_PARAM;
+	f = gf_f64_open(fileName, "wb");
+	if (!f) return GF_IO_ERR;
+	written = fwrite(cache->image, 1, (size_t) cache->image_size, f);
+	fclose(f);
+	return (written == (size_t) cache->image_size) ? GF_OK : GF_IO_ERR;
+}
+
+#if defined(WIN32)
+
+#include <windows.h>
+
+static char *gf_isom_hint_cache_map(const char *fileName, u64 *size)
+{
+	char *map;
+	HANDLE fileH, fileMapH;
+	DWORD size_high;
+#ifdef _WIN32_WCE
+	unsigned short sWPath[MAX_PATH];
+	CE_CharToWide((char *)fileName, sWPath);
+	fileH = CreateFileForMapping(sWPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, NULL);
+#else
+	fileH = CreateFile(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, NULL);
+#endif
+	if (fileH == INVALID_HANDLE_VALUE) return NULL;
+	*size = GetFileSize(fileH, &size_high);
+	*size |= ((u64) size_high) << 32;
+	fileMapH = CreateFileMapping(fileH, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!fileMapH) {
+		CloseHandle(fileH);
+		return NULL;
+	}
+	map = (char *) MapViewOfFile(fileMapH, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(fileMapH);
+	CloseHandle(fileH);
+	return map;
+}
+
+static void gf_isom_hint_cache_unmap(char *map, u64 size)
+{
+	UnmapViewOfFile(map);
+}
+
+#elif defined(GPAC_CONFIG_LINUX) || defined(GPAC_CONFIG_FREEBSD) || defined(GPAC_CONFIG_DARWIN) || defined(GPAC_CONFIG_SUNOS)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static char *gf_isom_hint_cache_map(const char *fileName, u64 *size)
+{
+	void *map;
+	struct stat st;
+	FILE *f = gf_f64_open(fileName, "rb");
+	if (!f) return NULL;
+	if ((fstat(fileno(f), &st) != 0) || !st.st_size || ((u64) st.st_size != (u64) (size_t) st.st_size)) {
+		fclose(f);
+		return NULL;
+	}
+	*size = (u64) st.st_size;
+	map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fileno(f), 0);
+	/*the mapping stays valid once the file is closed*/
+	fclose(f);
+	return (map == MAP_FAILED) ? NULL : (char *) map;
+}
+
+static void gf_isom_hint_cache_unmap(char *map, u64 size)
+{
+	munmap(map, (size_t) size);
+}
+
+#else
+
+static char *gf_isom_hint_cache_map(const char *fileName, u64 *size) { return NULL; }
+static void gf_isom_hint_cache_unmap(char *map, u64 size) { }
+
+#endif
+
+GF_EXPORT
+GF_Err gf_isom_hint_cache_load(const char *fileName, GF_ISOFile *the_file, GF_ISOHintCache **out_cache)
+{
+	GF_Err e;
+	GF_ISOHintCache *cache;
+
+	*out_cache = NULL;
+	if (!fileName) return GF_BAD_PARAM;
+	GF_SAFEALLOC(cache, GF_ISOHintCache);
+	if (!cache) return GF_OUT_OF_MEM;
+
+	cache->image = gf_isom_hint_cache_map(fileName, &cache->image_size);
+	if (cache->image) {
+		cache->storage = GF_HINT_CACHE_MAPPED;
+	} else {
+		/*no mapping available, load in memory*/
+		FILE *f = gf_f64_open(fileName, "rb");
+		if (!f) {
+			gf_free(cache);
+			return GF_URL_ERROR;
+		}
+		gf_f64_seek(f, 0, SEEK_END);
+		cache->image_size = gf_f64_tell(f);
+		gf_f64_seek(f, 0, SEEK_SET);
+		cache->image = (char *) gf_malloc(sizeof(char) * (size_t) cache->image_size);
+		if (!cache->image || (fread(cache->image, 1, (size_t) cache->image_size, f) != (size_t) cache->image_size)) {
+			fclose(f);
+			if (cache->image) gf_free(cache->image);
+			gf_free(cache);
+			return GF_IO_ERR;
+		}
+		fclose(f);
+		cache->storage = GF_HINT_CACHE_ALLOC;
+	}
+	e = gf_isom_hint_cache_setup(cache);
+	/*cache of another file, or of a previous version of this one*/
+	if (!e && the_file) {
+		u64 size, mtime;
+		gf_isom_hint_cache_get_source(the_file, &size, &mtime);
+		if (!size || (size != cache->hdr->source_size) || (mtime != cache->hdr->source_mtime)) e = GF_NOT_SUPPORTED;
+	}
+	if (e) {
+		gf_isom_hint_cache_del(cache);
+		return e;
+	}
+	*out_cache = cache;
+	return GF_OK;
+}
+
+GF_EXPORT
+void gf_isom_hint_cache_del(GF_ISOHintCache *cache)
+{
+	if (!cache) return;
+	if (cache->storage == GF_HINT_CACHE_MAPPED) gf_isom_hint_cache_unmap(cache->image, cache->image_size);
+	else if (cache->image) gf_free(cache->image);
+	gf_free(cache);
+}
+
+GF_EXPORT
+u32 gf_isom_hint_cache_get_packet_count(GF_ISOHintCache *cache)
+{
+	return cache ? cache->hdr->nb_packets : 0;
+}
+
+GF_EXPORT
+u32 gf_isom_hint_cache_get_timescale(GF_ISOHintCache *cache)
+{
+	return cache ? cache->hdr->timescale : 0;
+}
+
+GF_EXPORT
+u32 gf_isom_hint_cache_get_max_size(GF_ISOHintCache *cache)
+{
+	return cache ? cache->hdr->max_size : 0;
+}
+
+GF_EXPORT
+u32 gf_isom_hint_cache_find_packet(GF_ISOHintCache *cache, u64 send_time)
+{
+	u32 low, high;
+	if (!cache || !cache->hdr->nb_packets) return 0;
+	/*last packet sent at or before the given time*/
+	low = 0;
+	high = cache->hdr->nb_packets - 1;
+	while (low < high) {
+		u32 mid = (low + high + 1) / 2;
+		if (cache->entries[mid].send_time <= send_time) low = mid;
+		else high = mid - 1;
+	}
+	/*first packet of its hint sample*/
+	while (low && (cache->entries[low-1].sample_num == cache->entries[low].sample_num)) low--;
+	return low + 1;
+}
+
+GF_EXPORT
+GF_Err gf_isom_hint_cache_get_packet(GF_ISOHintCache *cache, u32 pck_num, const char **pck_data, u32 *pck_size, u64 *send_time, u32 *rtp_ts, Bool *disposable, Bool *repeated, u32 *sample_num)
+{
+	GF_HintCacheEntry *ent;
+	if (!cache || !pck_num) return GF_BAD_PARAM;
+	if (pck_num > cache->hdr->nb_packets) return GF_EOS;
+	ent = &cache->entries[pck_num-1];
+	if (pck_data) *pck_data = cache->data + ent->offset;
+	if (pck_size) *pck_size = ent->size;
+	if (send_time) *send_time = ent->send_time;
+	if (rtp_ts) *rtp_ts = ent->rtp_ts;
+	if (disposable) *disposable = (ent->flags & 1) ? 1 : 0;
+	if (repeated) *repeated = (ent->flags & 2) ? 1 : 0;
+	if (sample_num) *sample_num = ent->sample_num;
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_Err gf_isom_hint_cache_write_packet(GF_ISOHintCache *cache, u32 pck_num, char *buffer, u32 buffer_size, u32 *pck_size, u16 seq_num, u32 ts_offset, u32 ssrc)
+{
+	u32 ts;
+	GF_HintCacheEntry *ent;
+	if (!cache || !pck_num || !buffer) return GF_BAD_PARAM;
+	if (pck_num > cache->hdr->nb_packets) return GF_EOS;
+	ent = &cache->entries[pck_num-1];
+	if (ent->size > buffer_size) return GF_BUFFER_TOO_SMALL;
+
+	memcpy(buffer, cache->data + ent->offset, ent->size);
+	buffer[2] = (seq_num >> 8) & 0xFF;
+	buffer[3] = seq_num & 0xFF;
+	ts = ent->rtp_ts + ts_offset;
+	buffer[4] = (ts >> 24) & 0xFF;
+	buffer[5] = (ts >> 16) & 0xFF;
+	buffer[6] = (ts >> 8) & 0xFF;
+	buffer[7] = ts & 0xFF;
+	buffer[8] = (ssrc >> 24) & 0xFF;
+	buffer[9] = (ssrc >> 16) & 0xFF;
+	buffer[10] = (ssrc >> 8) & 0xFF;
+	buffer[11] = ssrc & 0xFF;
+	if (pck_size) *pck_size = ent->size;
+	return GF_OK;
+}
+
 #endif /* !defined(GPAC_DISABLE_ISOM) && !defined(GPAC_DISABLE_ISOM_HINTING)*/
@@ -95,6 +95,7 @@ GF_Err gf_isom_parse_movie_boxes(GF_ISOFile *mov, u64 *bytesMissing)
 	/*restart from where we stopped last*/
 	totSize = mov->current_top_box_start;
 	gf_bs_seek(mov->movieFileMap->bs, mov->current_top_box_start);
+	mov->parsed_size = gf_bs_get_size(mov->movieFileMap->bs);
 #endif
 
 
@@ -303,6 +304,9 @@ GF_ISOFile *gf_isom_new_movie()
 	
 	/*default storage mode is flat*/
 	mov->storageMode = GF_ISOM_STORE_FLAT;
+#ifndef GPAC_DISABLE_ISOM_WRITE
+	mov->output_buffering = GF_ISOM_DEFAULT_OUTPUT_BUFFERING;
+#endif
 	return mov;
 }
 
@@ -81,11 +81,20 @@ GF_EXPORT
 void gf_isom_sample_del(GF_ISOSample **samp)
 {
 	if (! *samp) return;
-	if ((*samp)->data && (*samp)->dataLength) gf_free((*samp)->data);
+	if ((*samp)->data && ((*samp)->dataLength || (*samp)->alloc_size) && !(*samp)->data_lent) gf_free((*samp)->data);
 	gf_free(*samp);
 	*samp = NULL;
 }
 
+GF_EXPORT
+void gf_isom_sample_release(GF_ISOSample *samp)
+{
+	if (!samp || !samp->data_lent) return;
+	samp->data = NULL;
+	samp->dataLength = 0;
+	samp->data_lent = 0;
+}
+
 GF_EXPORT
 Bool gf_isom_probe_file(const char *fileName)
 {
@@ -1085,7 +1094,7 @@ GF_ISOSample *gf_isom_get_sample(GF_ISOFile *the_file, u32 trackNumber, u32 samp
 	sampleNumber -= trak->sample_count_at_seg_start;
 #endif
 
-	e = Media_GetSample(trak->Media, sampleNumber, &samp, &descIndex, 0, NULL);
+	e = Media_GetSample(trak->Media, sampleNumber, &samp, &descIndex, 0, NULL, GF_ISOM_SAMPLE_DATA_ALLOC);
 	if (e) {
 		gf_isom_set_last_error(the_file, e);
 		gf_isom_sample_del(&samp);
@@ -1099,6 +1108,34 @@ GF_ISOSample *gf_isom_get_sample(GF_ISOFile *the_file, u32 trackNumber, u32 samp
 	return samp;
 }
 
+GF_EXPORT
+GF_ISOSample *gf_isom_get_sample_ex(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber, u32 *sampleDescriptionIndex, GF_ISOSample *static_sample, Bool lend_data)
+{
+	GF_Err e;
+	u32 descIndex;
+	GF_TrackBox *trak;
+	if (!static_sample) return NULL;
+	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	if (!trak) return NULL;
+
+	if (!sampleNumber) return NULL;
+#ifndef	GPAC_DISABLE_ISOM_FRAGMENTS
+	if (sampleNumber<=trak->sample_count_at_seg_start) return NULL;
+	sampleNumber -= trak->sample_count_at_seg_start;
+#endif
+
+	e = Media_GetSample(trak->Media, sampleNumber, &static_sample, &descIndex, 0, NULL, lend_data ? GF_ISOM_SAMPLE_DATA_LEND : GF_ISOM_SAMPLE_DATA_REUSE);
+	if (e) {
+		gf_isom_set_last_error(the_file, e);
+		return NULL;
+	}
+	if (sampleDescriptionIndex) *sampleDescriptionIndex = descIndex;
+#ifndef	GPAC_DISABLE_ISOM_FRAGMENTS
+	static_sample->DTS += trak->dts_at_seg_start;
+#endif
+	return static_sample;
+}
+
 GF_EXPORT
 u32 gf_isom_get_sample_duration(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber)
 {
@@ -1129,7 +1166,7 @@ GF_ISOSample *gf_isom_get_sample_info(GF_ISOFile *the_file, u32 trackNumber, u32
 	if (!sampleNumber) return NULL;
 	samp = gf_isom_sample_new();
 	if (!samp) return NULL;
-	e = Media_GetSample(trak->Media, sampleNumber, &samp, sampleDescriptionIndex, 1, data_offset);
+	e = Media_GetSample(trak->Media, sampleNumber, &samp, sampleDescriptionIndex, 1, data_offset, GF_ISOM_SAMPLE_DATA_ALLOC);
 	if (e) {
 		gf_isom_set_last_error(the_file, e);
 		gf_isom_sample_del(&samp);
@@ -1138,6 +1175,31 @@ GF_ISOSample *gf_isom_get_sample_info(GF_ISOFile *the_file, u32 trackNumber, u32
 	return samp;
 }
 
+GF_EXPORT
+GF_ISOSample *gf_isom_get_sample_info_ex(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber, u32 *sampleDescriptionIndex, u64 *data_offset, GF_ISOSample *static_sample)
+{
+	GF_Err e;
+	GF_TrackBox *trak;
+	if (!static_sample) return NULL;
+	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	if (!trak) return NULL;
+
+	if (!sampleNumber) return NULL;
+#ifndef	GPAC_DISABLE_ISOM_FRAGMENTS
+	if (sampleNumber<=trak->sample_count_at_seg_start) return NULL;
+	sampleNumber -= trak->sample_count_at_seg_start;
+#endif
+	e = Media_GetSample(trak->Media, sampleNumber, &static_sample, sampleDescriptionIndex, 1, data_offset, GF_ISOM_SAMPLE_DATA_REUSE);
+	if (e) {
+		gf_isom_set_last_error(the_file, e);
+		return NULL;
+	}
+#ifndef	GPAC_DISABLE_ISOM_FRAGMENTS
+	static_sample->DTS += trak->dts_at_seg_start;
+#endif
+	return static_sample;
+}
+
 //same as gf_isom_get_sample but doesn't fetch media data
 GF_EXPORT
 u64 gf_isom_get_sample_dts(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumber)
@@ -1147,9 +1209,10 @@ u64 gf_isom_get_sample_dts(GF_ISOFile *the_file, u32 trackNumber, u32 sampleNumb
 	trak = gf_isom_get_track_from_file(the_file, trackNumber);
 	if (!trak) return 0;
 
-	if (!sampleNumber) return 0;
+	if (sampleNumber<=trak->sample_count_at_seg_start) return 0;
+	sampleNumber -= trak->sample_count_at_seg_start;
 	if (stbl_GetSampleDTS(trak->Media->information->sampleTable->TimeToSample, sampleNumber, &dts) != GF_OK) return 0;
-	return dts;
+	return dts + trak->dts_at_seg_start;
 }
 
 
@@ -1175,7 +1238,7 @@ u32 gf_isom_get_sample_from_dts(GF_ISOFile *the_file, u32 trackNumber, u64 dts)
 
 	stbl = trak->Media->information->sampleTable;
 
-	e = findEntryForTime(stbl, dts, 1, &sampleNumber, &prevSampleNumber);
+	e = findEntryForTime(stbl, dts, 0, &sampleNumber, &prevSampleNumber);
 	if (e) return 0;
 	return sampleNumber;
 }
@@ -1304,7 +1367,7 @@ GF_Err gf_isom_get_sample_for_media_time(GF_ISOFile *the_file, u32 trackNumber,
 		}
 	}
 
-	e = Media_GetSample(trak->Media, sampleNumber, sample, StreamDescriptionIndex, 0, NULL);
+	e = Media_GetSample(trak->Media, sampleNumber, sample, StreamDescriptionIndex, 0, NULL, GF_ISOM_SAMPLE_DATA_ALLOC);
 	if (e) {
 		gf_isom_sample_del(sample);
 		return e;
@@ -1335,6 +1398,45 @@ GF_Err gf_isom_get_sample_for_media_time(GF_ISOFile *the_file, u32 trackNumber,
 	return GF_OK;
 }
 
+GF_EXPORT
+GF_Err gf_isom_get_sample_for_composition_time(GF_ISOFile *the_file, u32 trackNumber, u64 desiredTime, u32 *sampleNumber, u32 *syncSampleNumber)
+{
+	GF_Err e;
+	u32 sampNum, prevSampNum, syncNum;
+	GF_TrackBox *trak;
+	GF_SampleTableBox *stbl;
+
+	if (!sampleNumber || !syncSampleNumber) return GF_BAD_PARAM;
+	*sampleNumber = *syncSampleNumber = 0;
+
+	trak = gf_isom_get_track_from_file(the_file, trackNumber);
+	if (!trak) return GF_BAD_PARAM;
+
+	stbl = trak->Media->information->sampleTable;
+
+#ifndef	GPAC_DISABLE_ISOM_FRAGMENTS
+	if (desiredTime < trak->dts_at_seg_start) return GF_BAD_PARAM;
+	desiredTime -= trak->dts_at_seg_start;
+#endif
+
+	/*lookup in composition order - this falls back to DTS if no CTS offsets*/
+	e = findEntryForTime(stbl, desiredTime, 1, &sampNum, &prevSampNum);
+	if (e) return e;
+	/*the sample being presented at the desired time*/
+	if (!sampNum) sampNum = prevSampNum;
+	if (!sampNum) return GF_EOS;
+
+	/*closest sync sample before it in decoding order*/
+	syncNum = sampNum;
+	if (stbl->SyncSample) {
+		e = Media_FindSyncSample(stbl, sampNum, &syncNum, GF_ISOM_SEARCH_SYNC_BACKWARD);
+		if (e) return e;
+	}
+	*sampleNumber = sampNum;
+	*syncSampleNumber = syncNum;
+	return GF_OK;
+}
+
 GF_EXPORT
 GF_Err gf_isom_get_sample_for_movie_time(GF_ISOFile *the_file, u32 trackNumber, u64 movieTime, u32 *StreamDescriptionIndex, u8 SearchMode, GF_ISOSample **sample, u32 *sampleNumber)
 {
@@ -1565,7 +1667,8 @@ GF_Err gf_isom_get_sample_padding_bits(GF_ISOFile *the_file, u32 trackNumber, u3
 
 	trak = gf_isom_get_track_from_file(the_file, trackNumber);
 	if (!trak) return GF_BAD_PARAM;
-
+	if (sampleNumber<=trak->sample_count_at_seg_start) return GF_BAD_PARAM;
+	sampleNumber -= trak->sample_count_at_seg_start;
 
 	//Padding info
 	return stbl_GetPaddingBits(trak->Media->information->sampleTable->PaddingBits,
@@ -1848,9 +1951,10 @@ GF_Err gf_isom_refresh_fragmented(GF_ISOFile *movie, u64 *MissingBytes)
 	if (!movie || !movie->moov || !movie->moov->mvex) return GF_BAD_PARAM;
 	if (movie->openMode != GF_ISOM_OPEN_READ) return GF_BAD_PARAM;
 
-	/*refresh size*/
-	size = gf_bs_get_size(movie->movieFileMap->bs);
-	prevsize = gf_bs_get_refreshed_size(movie->movieFileMap->bs);
+	/*refresh size - reading samples may already have refreshed the bitstream size, so compare with the size
+	at the last parsing*/
+	prevsize = movie->parsed_size;
+	size = gf_bs_get_refreshed_size(movie->movieFileMap->bs);
 	if (prevsize==size) return GF_OK;
 
 	//ok parse root boxes
@@ -1858,6 +1962,56 @@ GF_Err gf_isom_refresh_fragmented(GF_ISOFile *movie, u64 *MissingBytes)
 #endif
 }
 
+#ifndef	GPAC_DISABLE_ISOM_FRAGMENTS
+/*destroys the sample tables of the track, following samples keep their number and decoding time*/
+static void gf_isom_reset_track_tables(GF_TrackBox *trak)
+{
+	u32 type, dur;
+	u64 dts;
+	GF_SampleTableBox *stbl = trak->Media->information->sampleTable;
+	if (!stbl->SampleSize->sampleCount) return;
+	trak->sample_count_at_seg_start += stbl->SampleSize->sampleCount;
+	stbl_GetSampleDTS_and_Duration(stbl->TimeToSample, stbl->SampleSize->sampleCount, &dts, &dur);
+	trak->dts_at_seg_start += dts + dur;
+
+#define RECREATE_BOX(_a, __cast)	\
+	if (_a) {	\
+		type = _a->type;\
+		gf_isom_box_del((GF_Box *)_a);\
+		_a = __cast gf_isom_box_new(type);\
+	}\
+
+	RECREATE_BOX(stbl->ChunkOffset, (GF_Box *));
+	RECREATE_BOX(stbl->CompositionOffset, (GF_CompositionOffsetBox *));
+	RECREATE_BOX(stbl->DegradationPriority, (GF_DegradationPriorityBox *));
+	RECREATE_BOX(stbl->PaddingBits, (GF_PaddingBitsBox *));
+	RECREATE_BOX(stbl->SampleDep, (GF_SampleDependencyTypeBox *));
+	RECREATE_BOX(stbl->SampleSize, (GF_SampleSizeBox *));
+	RECREATE_BOX(stbl->SampleToChunk, (GF_SampleToChunkBox *));
+	RECREATE_BOX(stbl->ShadowSync, (GF_ShadowSyncBox *));
+	RECREATE_BOX(stbl->SyncSample, (GF_SyncSampleBox *));
+	RECREATE_BOX(stbl->TimeToSample, (GF_TimeToSampleBox *));
+	/*the composition time index may have the same sample count as the new tables*/
+	stbl->r_cts_index_count = 0;
+}
+#endif
+
+GF_EXPORT
+GF_Err gf_isom_reset_tables(GF_ISOFile *movie)
+{
+#ifndef	GPAC_DISABLE_ISOM_FRAGMENTS
+	u32 i;
+	if (!movie || !movie->moov || !movie->moov->mvex) return GF_BAD_PARAM;
+	if (movie->openMode != GF_ISOM_OPEN_READ) return GF_BAD_PARAM;
+	for (i=0; i<gf_list_count(movie->moov->trackList); i++) {
+		gf_isom_reset_track_tables((GF_TrackBox *) gf_list_get(movie->moov->trackList, i));
+	}
+	return GF_OK;
+#else
+	return GF_NOT_SUPPORTED;
+#endif
+}
+
 GF_EXPORT
 GF_Err gf_isom_release_segment(GF_ISOFile *movie, Bool reset_tables)
 {
@@ -1870,33 +2024,7 @@ GF_Err gf_isom_release_segment(GF_ISOFile *movie, Bool reset_tables)
 		if (trak->Media->information->dataHandler == movie->movieFileMap) {
 			trak->Media->information->dataHandler = NULL;
 		}
-		if (reset_tables) {
-			u32 type, dur;
-			u64 dts;
-			GF_SampleTableBox *stbl = trak->Media->information->sampleTable;
-			trak->sample_count_at_seg_start += stbl->SampleSize->sampleCount;
-			if (trak->sample_count_at_seg_start) {
-				stbl_GetSampleDTS_and_Duration(stbl->TimeToSample, stbl->SampleSize->sampleCount, &dts, &dur);
-				trak->dts_at_seg_start += dts + dur;
-			}
-#define RECREATE_BOX(_a, __cast)	\
-		if (_a) {	\
-			type = _a->type;\
-			gf_isom_box_del((GF_Box *)_a);\
-			_a = __cast gf_isom_box_new(type);\
-		}\
-
-			RECREATE_BOX(stbl->ChunkOffset, (GF_Box *));
-			RECREATE_BOX(stbl->CompositionOffset, (GF_CompositionOffsetBox *));
-			RECREATE_BOX(stbl->DegradationPriority, (GF_DegradationPriorityBox *));
-			RECREATE_BOX(stbl->PaddingBits, (GF_PaddingBitsBox *));
-			RECREATE_BOX(stbl->SampleDep, (GF_SampleDependencyTypeBox *));
-			RECREATE_BOX(stbl->SampleSize, (GF_SampleSizeBox *));
-			RECREATE_BOX(stbl->SampleToChunk, (GF_SampleToChunkBox *));
-			RECREATE_BOX(stbl->ShadowSync, (GF_ShadowSyncBox *));
-			RECREATE_BOX(stbl->SyncSample, (GF_SyncSampleBox *));
-			RECREATE_BOX(stbl->TimeToSample, (GF_TimeToSampleBox *));
-		}
+		if (reset_tables) gf_isom_reset_track_tables(trak);
 	}
 
 	movie->first_moof_merged = 0;
@@ -79,14 +79,29 @@ typedef struct
 	GF_Box *stco;
 } TrackWriter;
 
+/*a run of consecutive self-contained samples of one track, in mdat order*/
+typedef struct
+{
+	TrackWriter *writer;
+	u32 first_sample, nb_samples;
+} WriteRun;
+
 typedef struct
 {
 	char *buffer;
 	u32 size;
 	GF_ISOFile *movie;
 	u32 total_samples, nb_done;
+	/*mdat layout recorded during the emulation pass when planning is on. The write pass then replays
+	it instead of running the interleaving again - memory is linear in the number of chunks*/
+	Bool plan;
+	WriteRun *runs;
+	u32 nb_runs, alloc_runs;
 } MovieWriter;
 
+/*max size of a block of contiguous samples copied at once when replaying the plan*/
+#define GF_ISOM_WRITE_SPAN_SIZE	0x100000
+
 void CleanWriters(GF_List *writers)
 {
 	TrackWriter *writer;
@@ -321,12 +336,28 @@ u64 GetMoovAndMetaSize(GF_ISOFile *movie, GF_List *writers)
 	return size;
 }
 
-//Write a sample to the file - this is only called for self-contained media
-GF_Err WriteSample(MovieWriter *mw, u32 size, u64 offset, u8 isEdited, GF_BitStream *bs)
+//Write a block of contiguous samples to the file - this is only called for self-contained media
+static GF_Err WriteSamples(MovieWriter *mw, u32 size, u64 offset, u8 isEdited, GF_BitStream *bs, u32 nb_samples)
 {
 	GF_DataMap *map;
+	const char *data;
 	u32 bytes;
 
+	if (isEdited) {
+		map = mw->movie->editFileMap;
+	} else {
+		map = mw->movie->movieFileMap;
+	}
+	/*mapped source: write the payload straight from the map*/
+	data = gf_isom_datamap_get_data_ptr(map, size, offset);
+	if (data) {
+		bytes = gf_bs_write_data(bs, data, size);
+		if (bytes != size) return GF_IO_ERR;
+		mw->nb_done += nb_samples;
+		gf_set_progress("ISO File Writing", mw->nb_done, mw->total_samples);
+		return GF_OK;
+	}
+
 	if (size>mw->size) {
 		mw->buffer = (char*)gf_realloc(mw->buffer, size);
 		mw->size = size;
@@ -334,11 +365,6 @@ GF_Err WriteSample(MovieWriter *mw, u32 size, u64 offset, u8 isEdited, GF_BitStr
 
 	if (!mw->buffer) return GF_OUT_OF_MEM;
 
-	if (isEdited) {
-		map = mw->movie->editFileMap;
-	} else {
-		map = mw->movie->movieFileMap;
-	}
 	//get the payload...
 	bytes = gf_isom_datamap_get_data(map, mw->buffer, size, offset);
 	if (bytes != size) return GF_IO_ERR;
@@ -346,11 +372,88 @@ GF_Err WriteSample(MovieWriter *mw, u32 size, u64 offset, u8 isEdited, GF_BitStr
 	bytes = gf_bs_write_data(bs, mw->buffer, size);
 	if (bytes != size) return GF_IO_ERR;
 
-	mw->nb_done++;
+	mw->nb_done += nb_samples;
 	gf_set_progress("ISO File Writing", mw->nb_done, mw->total_samples);
 	return GF_OK;
 }
 
+//Write a sample to the file - this is only called for self-contained media
+GF_Err WriteSample(MovieWriter *mw, u32 size, u64 offset, u8 isEdited, GF_BitStream *bs)
+{
+	return WriteSamples(mw, size, offset, isEdited, bs, 1);
+}
+
+//record the current sample of the writer in the mdat plan
+static GF_Err PlanSample(MovieWriter *mw, TrackWriter *writer)
+{
+	WriteRun *run;
+	if (!mw->plan) return GF_OK;
+
+	if (mw->nb_runs) {
+		run = &mw->runs[mw->nb_runs-1];
+		if ((run->writer == writer) && (run->first_sample + run->nb_samples == writer->sampleNumber)) {
+			run->nb_samples++;
+			return GF_OK;
+		}
+	}
+	if (mw->nb_runs == mw->alloc_runs) {
+		mw->alloc_runs = mw->alloc_runs ? 2*mw->alloc_runs : 256;
+		mw->runs = (WriteRun*)gf_realloc(mw->runs, sizeof(WriteRun)*mw->alloc_runs);
+		if (!mw->runs) {
+			mw->nb_runs = mw->alloc_runs = 0;
+			return GF_OUT_OF_MEM;
+		}
+	}
+	run = &mw->runs[mw->nb_runs];
+	run->writer = writer;
+	run->first_sample = writer->sampleNumber;
+	run->nb_samples = 1;
+	mw->nb_runs++;
+	return GF_OK;
+}
+
+//write the samples in the order recorded by the planning pass. Samples contiguous in the source are copied at once
+static GF_Err WritePlannedSamples(MovieWriter *mw, GF_BitStream *bs)
+{
+	GF_Err e;
+	u32 i, j, chunkNumber, descIndex, sampSize, span_size, span_count;
+	u64 sampOffset, span_offset;
+	u8 isEdited, span_edited;
+	WriteRun *run;
+	GF_SampleTableBox *stbl;
+
+	span_size = span_count = 0;
+	span_offset = 0;
+	span_edited = 0;
+	for (i=0; i<mw->nb_runs; i++) {
+		run = &mw->runs[i];
+		stbl = run->writer->mdia->information->sampleTable;
+		for (j=run->first_sample; j<run->first_sample + run->nb_samples; j++) {
+			e = stbl_GetSampleInfos(stbl, j, &sampOffset, &chunkNumber, &descIndex, &isEdited);
+			if (e) return e;
+			e = stbl_GetSampleSize(stbl->SampleSize, j, &sampSize);
+			if (e) return e;
+
+			if (span_count && (isEdited == span_edited) && (span_offset + span_size == sampOffset)
+				&& (span_size + sampSize <= GF_ISOM_WRITE_SPAN_SIZE)) {
+				span_size += sampSize;
+				span_count++;
+				continue;
+			}
+			if (span_count) {
+				e = WriteSamples(mw, span_size, span_offset, span_edited, bs, span_count);
+				if (e) return e;
+			}
+			span_offset = sampOffset;
+			span_size = sampSize;
+			span_edited = isEdited;
+			span_count = 1;
+		}
+	}
+	if (span_count) return WriteSamples(mw, span_size, span_offset, span_edited, bs, span_count);
+	return GF_OK;
+}
+
 
 GF_Err DoWriteMeta(GF_ISOFile *file, GF_MetaBox *meta, GF_BitStream *bs, Bool Emulation, u64 baseOffset, u64 *mdatSize)
 {
@@ -507,6 +610,8 @@ GF_Err DoWrite(MovieWriter *mw, GF_List *writers, GF_BitStream *bs, u8 Emulation
 			}
 		}
 	}
+	/*layout already planned*/
+	if (!Emulation && mw->plan) return WritePlannedSamples(mw, bs);
 
 	offset = StartOffset;
 	predOffset = 0;
@@ -534,6 +639,10 @@ GF_Err DoWrite(MovieWriter *mw, GF_List *writers, GF_BitStream *bs, u8 Emulation
 			if (Media_IsSelfContained(writer->mdia, descIndex) ) {
 				e = stbl_SetChunkAndOffset(writer->mdia->information->sampleTable, writer->sampleNumber, descIndex, writer->stsc, &writer->stco, offset, force);
 				if (e) return e;
+				if (Emulation) {
+					e = PlanSample(mw, writer);
+					if (e) return e;
+				}
 				if (movie->openMode == GF_ISOM_OPEN_WRITE) {
 					predOffset = sampOffset + sampSize;
 				} else {
@@ -717,8 +826,9 @@ GF_Err WriteFlat(MovieWriter *mw, u8 moovFirst, GF_BitStream *bs)
 		e = gf_isom_box_write((GF_Box *)movie->pdin, bs);
 		if (e) goto exit;
 	}
-	//What we will do is first emulate the write from the begining...
+	//What we will do is first emulate the write from the begining, recording the mdat layout...
 	//note: this will set the size of the mdat
+	mw->plan = 1;
 	e = DoWrite(mw, writers, bs, 1, gf_bs_get_position(bs));
 	if (e) goto exit;
 	
@@ -743,8 +853,7 @@ GF_Err WriteFlat(MovieWriter *mw, u8 moovFirst, GF_BitStream *bs)
 	e = gf_isom_box_write((GF_Box *)movie->mdat, bs);
 	if (e) goto exit;
 
-	//we don't need the offset as the moov is already written...
-	ResetWriters(writers);
+	//we don't need the offset as the moov is already written, replay the planned layout
 	e = DoWrite(mw, writers, bs, 0, 0);
 	if (e) goto exit;
 	//then the rest
@@ -858,6 +967,8 @@ GF_Err DoFullInterleave(MovieWriter *mw, GF_List *writers, GF_BitStream *bs, u8
 				if (Media_IsSelfContained(curWriter->mdia, descIndex) ) {
 					e = stbl_SetChunkAndOffset(curWriter->mdia->information->sampleTable, curWriter->sampleNumber, descIndex, curWriter->stsc, &curWriter->stco, offset, forceNewChunk);
 					if (e) return e;
+					e = PlanSample(mw, curWriter);
+					if (e) return e;
 					offset += sampSize;
 					totSize += sampSize;
 				} else {
@@ -960,6 +1071,9 @@ GF_Err DoInterleave(MovieWriter *mw, GF_List *writers, GF_BitStream *bs, u8 Emul
 
 
 
+	/*layout already planned*/
+	if (!Emulation && mw->plan) return WritePlannedSamples(mw, bs);
+
 	if (movie->storageMode == GF_ISOM_STORE_TIGHT) 
 		return DoFullInterleave(mw, writers, bs, Emulation, StartOffset);
 
@@ -1045,6 +1159,8 @@ GF_Err DoInterleave(MovieWriter *mw, GF_List *writers, GF_BitStream *bs, u8 Emul
 						if (Media_IsSelfContained(curWriter->mdia, descIndex) ) {
 							e = stbl_SetChunkAndOffset(curWriter->mdia->information->sampleTable, curWriter->sampleNumber, descIndex, curWriter->stsc, &curWriter->stco, offset, forceNewChunk);
 							if (e) return e;
+							e = PlanSample(mw, curWriter);
+							if (e) return e;
 							offset += sampSize;
 							mdatSize += sampSize;
 						} else {
@@ -1137,6 +1253,8 @@ static GF_Err WriteInterleaved(MovieWriter *mw, GF_BitStream *bs, Bool drift_int
 		if (e) goto exit;
 	}
 
+	/*plan the mdat layout*/
+	mw->plan = 1;
 	e = DoInterleave(mw, writers, bs, 1, gf_bs_get_position(bs), drift_inter);
 	if (e) goto exit;
 
@@ -1166,8 +1284,7 @@ static GF_Err WriteInterleaved(MovieWriter *mw, GF_BitStream *bs, Bool drift_int
 		if (e) goto exit;
 	}
 
-	//we don't need the offset as we are writing...
-	ResetWriters(writers);
+	//we don't need the offset as we are writing, replay the planned layout
 	e = DoInterleave(mw, writers, bs, 0, 0, drift_inter);
 	if (e) goto exit;
 
@@ -1215,6 +1332,7 @@ GF_Err WriteToFile(GF_ISOFile *movie)
 	//capture mode: we don't need a new bitstream
 	if (movie->openMode == GF_ISOM_OPEN_WRITE) {
 		e = WriteFlat(&mw, 0, movie->editFileMap->bs);
+		if (!e) e = gf_bs_flush(movie->editFileMap->bs);
 	} else {
 		//OK, we need a new bitstream
 		stream = gf_f64_open(movie->finalName, "w+b");
@@ -1224,6 +1342,7 @@ GF_Err WriteToFile(GF_ISOFile *movie)
 			fclose(stream);
 			return GF_OUT_OF_MEM;
 		}
+		gf_bs_set_output_buffering(bs, movie->output_buffering);
 
 		switch (movie->storageMode) {
 		case GF_ISOM_STORE_TIGHT:
@@ -1240,11 +1359,13 @@ GF_Err WriteToFile(GF_ISOFile *movie)
 			e = WriteFlat(&mw, 0, bs);
 			break;
 		}
-		
+		/*catch write errors in the cached data*/
+		if (!e) e = gf_bs_flush(bs);
 		gf_bs_del(bs);
 		fclose(stream);
 	}
 	if (mw.buffer) gf_free(mw.buffer);
+	if (mw.runs) gf_free(mw.runs);
 	if (mw.nb_done<mw.total_samples) {
 		gf_set_progress("ISO File Writing", mw.total_samples, mw.total_samples);
 	}
@@ -850,6 +850,7 @@ GF_Err gf_isom_set_last_sample_duration(GF_ISOFile *movie, u32 trackNumber, u32
 	mdur = trak->Media->mediaHeader->duration;
 	stts = trak->Media->information->sampleTable->TimeToSample;
 	if (!stts->nb_entries) return GF_BAD_PARAM;
+	trak->Media->information->sampleTable->r_cts_index_count = 0;
 	//get the last entry
 	ent = (GF_SttsEntry*) &stts->entries[stts->nb_entries-1];
 
@@ -1935,6 +1936,18 @@ u32 gf_isom_get_interleave_time(GF_ISOFile *movie)
 	return movie ? movie->interleavingTime : 0;
 }
 
+GF_EXPORT
+GF_Err gf_isom_set_output_buffering(GF_ISOFile *movie, u32 size)
+{
+	if (!movie) return GF_BAD_PARAM;
+	if (movie->openMode == GF_ISOM_OPEN_READ) return GF_ISOM_INVALID_MODE;
+	movie->output_buffering = size;
+	/*file where samples are currently written*/
+	if (movie->editFileMap && (movie->editFileMap->type == GF_ISOM_DATA_FILE)) 
+		return gf_bs_set_output_buffering(movie->editFileMap->bs, size);
+	return GF_OK;
+}
+
 //set the storage mode of a file (FLAT, STREAMABLE, INTERLEAVED)
 u8 gf_isom_get_storage_mode(GF_ISOFile *movie)
 {
@@ -2958,6 +2971,7 @@ GF_Err gf_isom_modify_cts_offset(GF_ISOFile *the_file, u32 trackNumber, u32 samp
 	if (!trak->Media->information->sampleTable->CompositionOffset->unpack_mode) return GF_BAD_PARAM;
 	/*we're in unpack mode: one entry per sample*/
 	trak->Media->information->sampleTable->CompositionOffset->entries[sample_number - 1].decodingOffset = offset;
+	trak->Media->information->sampleTable->r_cts_index_count = 0;
 	return GF_OK;
 }
 
@@ -2969,6 +2983,7 @@ GF_Err gf_isom_remove_cts_info(GF_ISOFile *the_file, u32 trackNumber)
 	
 	gf_isom_box_del((GF_Box *)trak->Media->information->sampleTable->CompositionOffset);
 	trak->Media->information->sampleTable->CompositionOffset = NULL;
+	trak->Media->information->sampleTable->r_cts_index_count = 0;
 	return GF_OK;
 }
 
@@ -265,7 +265,7 @@ Bool Media_IsSampleSyncShadow(GF_ShadowSyncBox *stsh, u32 sampleNumber)
 	return 0;
 }
 
-GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp, u32 *sIDX, Bool no_data, u64 *out_offset)
+GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp, u32 *sIDX, Bool no_data, u64 *out_offset, u32 data_mode)
 {
 	GF_Err e;
 	u32 bytesRead;
@@ -345,8 +345,31 @@ GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp,
 	if (out_offset) *out_offset = offset;
 	if (no_data) return GF_OK;
 
+	/*lend the data of the file mapping if we don't have to rewrite it*/
+	if ((data_mode==GF_ISOM_SAMPLE_DATA_LEND) && !mdia->mediaTrack->padding_bytes 
+		&& (mdia->handler->handlerType != GF_ISOM_MEDIA_OD) && !mdia->mediaTrack->moov->mov->convert_streaming_text) {
+		const char *data = gf_isom_datamap_get_data_ptr(mdia->information->dataHandler, (*samp)->dataLength, offset);
+		if (data) {
+			if ((*samp)->data && !(*samp)->data_lent) gf_free((*samp)->data);
+			(*samp)->data = (char *) data;
+			(*samp)->data_lent = 1;
+			(*samp)->alloc_size = 0;
+			mdia->BytesMissing = 0;
+			return GF_OK;
+		}
+	}
+	if ((*samp)->data_lent) {
+		(*samp)->data = NULL;
+		(*samp)->data_lent = 0;
+	}
+
 	/*and finally get the data, include padding if needed*/
- 	(*samp)->data = (char *) gf_malloc(sizeof(char) * ( (*samp)->dataLength + mdia->mediaTrack->padding_bytes) );
+	if (data_mode==GF_ISOM_SAMPLE_DATA_ALLOC) {
+ 		(*samp)->data = (char *) gf_malloc(sizeof(char) * ( (*samp)->dataLength + mdia->mediaTrack->padding_bytes) );
+	} else if (!(*samp)->data || ((*samp)->alloc_size < (*samp)->dataLength + mdia->mediaTrack->padding_bytes)) {
+		(*samp)->alloc_size = (*samp)->dataLength + mdia->mediaTrack->padding_bytes;
+		(*samp)->data = (char *) gf_realloc((*samp)->data, sizeof(char) * (*samp)->alloc_size);
+	}
 	if (mdia->mediaTrack->padding_bytes)
 		memset((*samp)->data + (*samp)->dataLength, 0, sizeof(char) * mdia->mediaTrack->padding_bytes);
 
@@ -371,6 +394,7 @@ GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp,
 	if (mdia->handler->handlerType == GF_ISOM_MEDIA_OD) {
 		e = Media_RewriteODFrame(mdia, *samp);
 		if (e) return e;
+		if ((*samp)->alloc_size) (*samp)->alloc_size = (*samp)->dataLength;
 	}
 	else if (mdia->mediaTrack->moov->mov->convert_streaming_text 
 		&& ((mdia->handler->handlerType == GF_ISOM_MEDIA_TEXT) || (mdia->handler->handlerType == GF_ISOM_MEDIA_SUBT)) 
@@ -384,6 +408,7 @@ GF_Err Media_GetSample(GF_MediaBox *mdia, u32 sampleNumber, GF_ISOSample **samp,
 		}
 		e = gf_isom_rewrite_text_sample(*samp, *sIDX, (u32) dur);
 		if (e) return e;
+		if ((*samp)->alloc_size) (*samp)->alloc_size = (*samp)->dataLength;
 	}
 	return GF_OK;
 }
@@ -1017,6 +1017,7 @@ GF_Err gf_isom_start_segment(GF_ISOFile *movie, char *SegName)
 	if (SegName) {
 		gf_isom_datamap_del(movie->editFileMap);
 		e = gf_isom_datamap_new(SegName, NULL, GF_ISOM_DATA_MAP_WRITE, & movie->editFileMap);
+		if (!e) gf_bs_set_output_buffering(movie->editFileMap->bs, movie->output_buffering);
 		movie->segment_start = 0;
 		return e;
 	}	
@@ -26,25 +26,209 @@
 
 #ifndef GPAC_DISABLE_ISOM
 
+/*the read indexes are built on first random access and extended as the tables grow. Except when
+rewriting a table (in which case the writer resets r_idx_nb), entries are only appended or the last one
+is modified in place, so only the tail of the index has to be recomputed*/
+static GF_Err stbl_UpdateTimeIndex(GF_TimeToSampleBox *stts)
+{
+	u32 i;
+	u32 *first_sample;
+	u64 *dts;
+
+	if (stts->r_idx_nb > stts->nb_entries) stts->r_idx_nb = stts->nb_entries;
+
+	if (stts->r_idx_alloc < stts->nb_entries + 1) {
+		u32 new_alloc = (stts->r_idx_alloc*3)/2;
+		if (new_alloc < stts->nb_entries + 1) new_alloc = stts->nb_entries + 1;
+		first_sample = (u32*)gf_realloc(stts->r_idx_first_sample, sizeof(u32)*new_alloc);
+		if (!first_sample) return GF_OUT_OF_MEM;
+		stts->r_idx_first_sample = first_sample;
+		dts = (u64*)gf_realloc(stts->r_idx_dts, sizeof(u64)*new_alloc);
+		if (!dts) return GF_OUT_OF_MEM;
+		stts->r_idx_dts = dts;
+		stts->r_idx_alloc = new_alloc;
+	}
+	first_sample = stts->r_idx_first_sample;
+	dts = stts->r_idx_dts;
+
+	i = stts->r_idx_nb;
+	if (!i) {
+		first_sample[0] = 1;
+		dts[0] = 0;
+		i = 1;
+	}
+	//the terminating slot is always recomputed since the last entry may have changed
+	for (; i<=stts->nb_entries; i++) {
+		first_sample[i] = first_sample[i-1] + stts->entries[i-1].sampleCount;
+		dts[i] = dts[i-1] + (u64) stts->entries[i-1].sampleCount * stts->entries[i-1].sampleDelta;
+	}
+	stts->r_idx_nb = stts->nb_entries;
+	return GF_OK;
+}
+
+/*returns the index of the entry holding the sample (index must be up to date and the sample in the table)*/
+static u32 stbl_FindTimeEntryForSample(GF_TimeToSampleBox *stts, u32 SampleNumber)
+{
+	u32 low, high, mid;
+	low = 0;
+	high = stts->nb_entries - 1;
+	//last entry starting at or before this sample - empty entries are skipped since they share their first sample with the next one
+	while (low < high) {
+		mid = (low + high + 1) / 2;
+		if (stts->r_idx_first_sample[mid] <= SampleNumber) low = mid;
+		else high = mid - 1;
+	}
+	return low;
+}
+
+static int stbl_CompareCTSIndexEntries(const void *_a, const void *_b)
+{
+	const GF_CTSIndexEntry *a = (const GF_CTSIndexEntry *)_a;
+	const GF_CTSIndexEntry *b = (const GF_CTSIndexEntry *)_b;
+	if (a->CTS < b->CTS) return -1;
+	if (a->CTS > b->CTS) return 1;
+	/*keep decoding order for samples sharing the same CTS*/
+	if (a->sampleNumber < b->sampleNumber) return -1;
+	if (a->sampleNumber > b->sampleNumber) return 1;
+	return 0;
+}
+
+/*builds the list of samples sorted by composition time. The tables are walked once, 
+samples not described in the ctts have a 0 offset*/
+static GF_Err stbl_UpdateCompositionIndex(GF_SampleTableBox *stbl)
+{
+	u32 i, j, k, count, sampleNumber, ctts_left;
+	u64 dts;
+	GF_CTSIndexEntry *idx;
+	GF_TimeToSampleBox *stts = stbl->TimeToSample;
+	GF_CompositionOffsetBox *ctts = stbl->CompositionOffset;
+
+	count = stbl->SampleSize ? stbl->SampleSize->sampleCount : 0;
+	if (stbl->r_cts_index && (stbl->r_cts_index_count == count)) return GF_OK;
+
+	idx = (GF_CTSIndexEntry *)gf_realloc(stbl->r_cts_index, sizeof(GF_CTSIndexEntry) * (count ? count : 1));
+	if (!idx) return GF_OUT_OF_MEM;
+	stbl->r_cts_index = idx;
+
+	dts = 0;
+	sampleNumber = 0;
+	k = 0;
+	ctts_left = (ctts && ctts->nb_entries) ? ctts->entries[0].sampleCount : 0;
+	for (i=0; (i<stts->nb_entries) && (sampleNumber<count); i++) {
+		for (j=0; (j<stts->entries[i].sampleCount) && (sampleNumber<count); j++) {
+			while (!ctts_left && ctts && (k+1 < ctts->nb_entries)) {
+				k++;
+				ctts_left = ctts->entries[k].sampleCount;
+			}
+			idx[sampleNumber].CTS = dts;
+			if (ctts_left) {
+				idx[sampleNumber].CTS += ctts->entries[k].decodingOffset;
+				ctts_left--;
+			}
+			idx[sampleNumber].sampleNumber = sampleNumber + 1;
+			sampleNumber++;
+			dts += stts->entries[i].sampleDelta;
+		}
+	}
+	/*samples not covered by the stts: same behaviour as stbl_GetSampleDTS*/
+	for (; sampleNumber<count; sampleNumber++) {
+		idx[sampleNumber].CTS = dts;
+		idx[sampleNumber].sampleNumber = sampleNumber + 1;
+	}
+	qsort(idx, count, sizeof(GF_CTSIndexEntry), stbl_CompareCTSIndexEntries);
+	stbl->r_cts_index_count = count;
+	return GF_OK;
+}
+
+/*composition time version of findEntryForTime*/
+static GF_Err stbl_FindEntryForCTS(GF_SampleTableBox *stbl, u64 CTS, u32 *sampleNumber, u32 *prevSampleNumber)
+{
+	GF_Err e;
+	u32 low, high, mid;
+
+	e = stbl_UpdateCompositionIndex(stbl);
+	if (e) return e;
+	if (!stbl->r_cts_index_count) return GF_OK;
+
+	//first sample in composition order with a CTS greater than or equal to the requested one
+	low = 0;
+	high = stbl->r_cts_index_count;
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (stbl->r_cts_index[mid].CTS < CTS) low = mid + 1;
+		else high = mid;
+	}
+	//after the last sample, return as is
+	if (low == stbl->r_cts_index_count) return GF_OK;
+
+	if (stbl->r_cts_index[low].CTS == CTS) {
+		(*sampleNumber) = stbl->r_cts_index[low].sampleNumber;
+	} else if (low) {
+		(*prevSampleNumber) = stbl->r_cts_index[low-1].sampleNumber;
+	} else {
+		//exception for the first sample (we need to "load" the playback)
+		(*prevSampleNumber) = stbl->r_cts_index[0].sampleNumber;
+	}
+	return GF_OK;
+}
+
 //Get the sample number
 GF_Err findEntryForTime(GF_SampleTableBox *stbl, u64 DTS, u8 useCTS, u32 *sampleNumber, u32 *prevSampleNumber)
 {
-	u32 i, j, curSampNum, CTSOffset, count;
+	u32 i, j, curSampNum, count;
 	u64 curDTS;
 	GF_SttsEntry *ent;
 	(*sampleNumber) = 0;
 	(*prevSampleNumber) = 0;
 
-	if (!stbl->CompositionOffset) useCTS = 0;
-	/*FIXME: CTS is ALWAYS disabled for now to make sure samples are fetched in 
-	decoding order. */
-	useCTS = 0;
+	/*composition time lookup, using the CTS index*/
+	if (useCTS && stbl->CompositionOffset) 
+		return stbl_FindEntryForCTS(stbl, DTS, sampleNumber, prevSampleNumber);
+
+	//use the index: locate the first sample with a DTS greater than or equal to the requested one
+	if (stbl->TimeToSample->nb_entries && (stbl_UpdateTimeIndex(stbl->TimeToSample)==GF_OK)) {
+		u32 low, high, mid;
+		GF_TimeToSampleBox *stts = stbl->TimeToSample;
+		count = stts->nb_entries;
+
+		low = 0;
+		high = count;
+		while (low < high) {
+			mid = (low + high) / 2;
+			if (stts->r_idx_dts[mid] < DTS) low = mid + 1;
+			else high = mid;
+		}
+		curSampNum = 0;
+		curDTS = 0;
+		i = low;
+		//the sample may be inside the previous entry
+		if (low) {
+			ent = &stts->entries[low-1];
+			if (ent->sampleDelta) {
+				j = (u32) ((DTS - stts->r_idx_dts[low-1] + ent->sampleDelta - 1) / ent->sampleDelta);
+				if (j < ent->sampleCount) {
+					i = low-1;
+					curSampNum = stts->r_idx_first_sample[i] + j;
+					curDTS = stts->r_idx_dts[i] + (u64) j * ent->sampleDelta;
+				}
+			}
+		}
+		if (!curSampNum) {
+			//after the last sample, return as is
+			if ((low == count) || (stts->r_idx_first_sample[low] == stts->r_idx_first_sample[count])) return GF_OK;
+			curSampNum = stts->r_idx_first_sample[low];
+			curDTS = stts->r_idx_dts[low];
+		}
+		//move our cache to this entry
+		stts->r_currentEntryIndex = i;
+		stts->r_FirstSampleInEntry = stts->r_idx_first_sample[i];
+		stts->r_CurrentDTS = stts->r_idx_dts[i];
+		goto entry_found;
+	}
 
 	//our cache
 	if (stbl->TimeToSample->r_FirstSampleInEntry &&
 		(DTS >= stbl->TimeToSample->r_CurrentDTS) ) {
-		//if we're using CTS, we don't really know whether we're in the good entry or not
-		//(eg, the real DTS of the sample could be in a previous entry
 		i = stbl->TimeToSample->r_currentEntryIndex;
 		curDTS = stbl->TimeToSample->r_CurrentDTS;
 		curSampNum = stbl->TimeToSample->r_FirstSampleInEntry;
@@ -55,40 +239,12 @@ GF_Err findEntryForTime(GF_SampleTableBox *stbl, u64 DTS, u8 useCTS, u32 *sample
 		stbl->TimeToSample->r_currentEntryIndex = 0;
 	}
 
-	//we need to validate our cache if we are using CTS because of B-frames and co...
-	if (i && useCTS) {
-		while (1) {
-			stbl_GetSampleCTS(stbl->CompositionOffset, curSampNum, &CTSOffset);
-			//we're too far, rewind
-			if ( i && (curDTS + CTSOffset > DTS) ) {
-				ent = &stbl->TimeToSample->entries[i];
-				curSampNum -= ent->sampleCount;
-				curDTS -= ent->sampleDelta * ent->sampleCount;
-				i --;
-			} else if (!i) {
-				//begining of the table, no choice
-				curDTS = stbl->TimeToSample->r_CurrentDTS = 0;
-				curSampNum = stbl->TimeToSample->r_FirstSampleInEntry = 1;
-				stbl->TimeToSample->r_currentEntryIndex = 0;
-				break;
-			} else {
-				//OK now we're good
-				break;
-			}
-		}
-	}
-
 	//look for the DTS from this entry
 	count = stbl->TimeToSample->nb_entries;
 	for (; i<count; i++) {
 		ent = &stbl->TimeToSample->entries[i];
-		if (useCTS) {
-			stbl_GetSampleCTS(stbl->CompositionOffset, curSampNum, &CTSOffset);
-		} else {
-			CTSOffset = 0;
-		}
 		for (j=0; j<ent->sampleCount; j++) {
-			if (curDTS + CTSOffset >= DTS) goto entry_found;
+			if (curDTS >= DTS) goto entry_found;
 			curSampNum += 1;
 			curDTS += ent->sampleDelta;
 		}
@@ -102,11 +258,7 @@ GF_Err findEntryForTime(GF_SampleTableBox *stbl, u64 DTS, u8 useCTS, u32 *sample
 
 entry_found:
 	//do we have the exact time ?
-	if (curDTS + CTSOffset == DTS) {
-		(*sampleNumber) = curSampNum;
-	}
-	//if we match the exact DTS also select this sample 
-	else if (curDTS == DTS) {
+	if (curDTS == DTS) {
 		(*sampleNumber) = curSampNum;
 	} else {
 		//exception for the first sample (we need to "load" the playback)
@@ -136,6 +288,35 @@ GF_Err stbl_GetSampleSize(GF_SampleSizeBox *stsz, u32 SampleNumber, u32 *Size)
 
 
 
+static GF_Err stbl_UpdateCTSOffsetIndex(GF_CompositionOffsetBox *ctts)
+{
+	u32 i;
+
+	if (ctts->r_idx_nb > ctts->nb_entries) ctts->r_idx_nb = ctts->nb_entries;
+	if (ctts->r_idx_nb == ctts->nb_entries) return GF_OK;
+
+	if (ctts->r_idx_alloc < ctts->nb_entries) {
+		u32 *first_sample;
+		u32 new_alloc = (ctts->r_idx_alloc*3)/2;
+		if (new_alloc < ctts->nb_entries) new_alloc = ctts->nb_entries;
+		first_sample = (u32*)gf_realloc(ctts->r_idx_first_sample, sizeof(u32)*new_alloc);
+		if (!first_sample) return GF_OUT_OF_MEM;
+		ctts->r_idx_first_sample = first_sample;
+		ctts->r_idx_alloc = new_alloc;
+	}
+
+	i = ctts->r_idx_nb;
+	if (!i) {
+		ctts->r_idx_first_sample[0] = 1;
+		i = 1;
+	}
+	for (; i<ctts->nb_entries; i++) {
+		ctts->r_idx_first_sample[i] = ctts->r_idx_first_sample[i-1] + ctts->entries[i-1].sampleCount;
+	}
+	ctts->r_idx_nb = ctts->nb_entries;
+	return GF_OK;
+}
+
 //Get the CTS offset of a given sample
 GF_Err stbl_GetSampleCTS(GF_CompositionOffsetBox *ctts, u32 SampleNumber, u32 *CTSoffset)
 {
@@ -145,6 +326,30 @@ GF_Err stbl_GetSampleCTS(GF_CompositionOffsetBox *ctts, u32 SampleNumber, u32 *C
 	//test on SampleNumber is done before
 	if (!ctts || !SampleNumber) return GF_BAD_PARAM;
 
+	if (ctts->r_FirstSampleInEntry && (ctts->r_FirstSampleInEntry <= SampleNumber) 
+		&& (ctts->r_currentEntryIndex < ctts->nb_entries)
+		&& (SampleNumber < ctts->r_FirstSampleInEntry + ctts->entries[ctts->r_currentEntryIndex].sampleCount) ) {
+		(*CTSoffset) = ctts->entries[ctts->r_currentEntryIndex].decodingOffset;
+		return GF_OK;
+	}
+	//not in the current entry, use the index to locate it
+	if (ctts->nb_entries && (stbl_UpdateCTSOffsetIndex(ctts)==GF_OK)) {
+		u32 low, high, mid;
+		low = 0;
+		high = ctts->nb_entries - 1;
+		while (low < high) {
+			mid = (low + high + 1) / 2;
+			if (ctts->r_idx_first_sample[mid] <= SampleNumber) low = mid;
+			else high = mid - 1;
+		}
+		ctts->r_currentEntryIndex = low;
+		ctts->r_FirstSampleInEntry = ctts->r_idx_first_sample[low];
+		/*asked for a sample not in table - this means CTTS is 0 (that's due to out internal packing construction of CTTS)*/
+		if (SampleNumber >= ctts->r_FirstSampleInEntry + ctts->entries[low].sampleCount) return GF_OK;
+		(*CTSoffset) = ctts->entries[low].decodingOffset;
+		return GF_OK;
+	}
+
 	if (ctts->r_FirstSampleInEntry && (ctts->r_FirstSampleInEntry < SampleNumber) ) {
 		i = ctts->r_currentEntryIndex;
 	} else {
@@ -181,9 +386,20 @@ GF_Err stbl_GetSampleDTS_and_Duration(GF_TimeToSampleBox *stts, u32 SampleNumber
 	if (stts->r_FirstSampleInEntry 
 		&& (stts->r_FirstSampleInEntry <= SampleNumber)
 		//this is for read/write access
-		&& (stts->r_currentEntryIndex < count) ) {
+		&& (stts->r_currentEntryIndex < count) 
+		&& (SampleNumber < stts->r_FirstSampleInEntry + stts->entries[stts->r_currentEntryIndex].sampleCount) ) {
 
 		i = stts->r_currentEntryIndex;
+	} 
+	//not in the current entry, use the index to locate it
+	else if (count && (stbl_UpdateTimeIndex(stts)==GF_OK)) {
+		if (SampleNumber >= stts->r_idx_first_sample[count]) {
+			(*DTS) = stts->r_idx_dts[count];
+			return GF_OK;
+		}
+		i = stts->r_currentEntryIndex = stbl_FindTimeEntryForSample(stts, SampleNumber);
+		stts->r_FirstSampleInEntry = stts->r_idx_first_sample[i];
+		stts->r_CurrentDTS = stts->r_idx_dts[i];
 	} else {
 		i = stts->r_currentEntryIndex = 0;
 		stts->r_FirstSampleInEntry = 1;
@@ -226,7 +442,7 @@ GF_Err stbl_GetSampleDTS(GF_TimeToSampleBox *stts, u32 SampleNumber, u64 *DTS)
 //Set the RAP flag of a sample
 GF_Err stbl_GetSampleRAP(GF_SyncSampleBox *stss, u32 SampleNumber, u8 *IsRAP, u32 *prevRAP, u32 *nextRAP)
 {
-	u32 i;
+	u32 low, high, mid;
 
 	if (prevRAP) *prevRAP = 0;
 	if (nextRAP) *nextRAP = 0;
@@ -234,30 +450,29 @@ GF_Err stbl_GetSampleRAP(GF_SyncSampleBox *stss, u32 SampleNumber, u8 *IsRAP, u3
 	(*IsRAP) = 0;
 	if (!stss || !SampleNumber) return GF_BAD_PARAM;
 
-	if (stss->r_LastSyncSample && (stss->r_LastSyncSample < SampleNumber) ) {
-		i = stss->r_LastSampleIndex;
-	} else {
-		i = 0;
+	//sync samples are sorted: locate the first one after our sample
+	low = 0;
+	high = stss->nb_entries;
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (stss->sampleNumbers[mid] <= SampleNumber) low = mid + 1;
+		else high = mid;
 	}
-	for (; i < stss->nb_entries; i++) {
-		//get the entry
-		if (stss->sampleNumbers[i] == SampleNumber) {
+	if (low) {
+		if (stss->sampleNumbers[low-1] == SampleNumber) {
 			//update the cache
 			stss->r_LastSyncSample = SampleNumber;
-			stss->r_LastSampleIndex = i;
+			stss->r_LastSampleIndex = low-1;
 			(*IsRAP) = 1;
 		}
-		else if (stss->sampleNumbers[i] > SampleNumber) {
-			if (nextRAP) *nextRAP = stss->sampleNumbers[i];
-			return GF_OK;
-		}
-		if (prevRAP) *prevRAP = stss->sampleNumbers[i];
+		if (prevRAP) *prevRAP = stss->sampleNumbers[low-1];
 	}
+	if (nextRAP && (low < stss->nb_entries)) *nextRAP = stss->sampleNumbers[low];
 	return GF_OK;
 }
 
 //get the number of "ghost chunk" (implicit chunks described by an entry)
-void GetGhostNum(GF_StscEntry *ent, u32 EntryIndex, u32 count, GF_SampleTableBox *stbl)
+static u32 stbl_GetGhostNum(GF_StscEntry *ent, u32 EntryIndex, u32 count, GF_SampleTableBox *stbl)
 {
 	GF_StscEntry *nextEnt;
 	GF_ChunkOffsetBox *stco;
@@ -282,7 +497,43 @@ void GetGhostNum(GF_StscEntry *ent, u32 EntryIndex, u32 count, GF_SampleTableBox
 	} else {
 		ghostNum = (ent->nextChunk > ent->firstChunk) ? (ent->nextChunk - ent->firstChunk) : 1;
 	}
-	stbl->SampleToChunk->ghostNumber = ghostNum;
+	return ghostNum;
+}
+
+void GetGhostNum(GF_StscEntry *ent, u32 EntryIndex, u32 count, GF_SampleTableBox *stbl)
+{
+	stbl->SampleToChunk->ghostNumber = stbl_GetGhostNum(ent, EntryIndex, count, stbl);
+}
+
+static GF_Err stbl_UpdateChunkIndex(GF_SampleTableBox *stbl)
+{
+	u32 i, ghost;
+	GF_SampleToChunkBox *stsc = stbl->SampleToChunk;
+
+	if (stsc->r_idx_nb > stsc->nb_entries) stsc->r_idx_nb = stsc->nb_entries;
+	if (stsc->r_idx_nb == stsc->nb_entries) return GF_OK;
+
+	if (stsc->r_idx_alloc < stsc->nb_entries) {
+		u32 *first_sample;
+		u32 new_alloc = (stsc->r_idx_alloc*3)/2;
+		if (new_alloc < stsc->nb_entries) new_alloc = stsc->nb_entries;
+		first_sample = (u32*)gf_realloc(stsc->r_idx_first_sample, sizeof(u32)*new_alloc);
+		if (!first_sample) return GF_OUT_OF_MEM;
+		stsc->r_idx_first_sample = first_sample;
+		stsc->r_idx_alloc = new_alloc;
+	}
+
+	i = stsc->r_idx_nb;
+	if (!i) {
+		stsc->r_idx_first_sample[0] = 1;
+		i = 1;
+	}
+	for (; i<stsc->nb_entries; i++) {
+		ghost = stbl_GetGhostNum(&stsc->entries[i-1], i-1, stsc->nb_entries, stbl);
+		stsc->r_idx_first_sample[i] = stsc->r_idx_first_sample[i-1] + ghost * stsc->entries[i-1].samplesPerChunk;
+	}
+	stsc->r_idx_nb = stsc->nb_entries;
+	return GF_OK;
 }
 
 //Get the offset, descIndex and chunkNumber of a sample...
@@ -315,6 +566,40 @@ GF_Err stbl_GetSampleInfos(GF_SampleTableBox *stbl, u32 sampleNumber, u64 *offse
 		return GF_OK;
 	}
 
+	//locate the entry through the index, and the chunk within this entry
+	if (stbl_UpdateChunkIndex(stbl)==GF_OK) {
+		u32 low, high, mid, count, chunk;
+		GF_SampleToChunkBox *stsc = stbl->SampleToChunk;
+		count = stsc->nb_entries;
+		if (!count) return GF_ISOM_INVALID_FILE;
+
+		//check the current entry first, for sequential access
+		i = stsc->currentIndex;
+		if ((i >= count) || (stsc->r_idx_first_sample[i] > sampleNumber)
+			|| ((i+1 < count) && (stsc->r_idx_first_sample[i+1] <= sampleNumber)) ) {
+
+			low = 0;
+			high = count - 1;
+			while (low < high) {
+				mid = (low + high + 1) / 2;
+				if (stsc->r_idx_first_sample[mid] <= sampleNumber) low = mid;
+				else high = mid - 1;
+			}
+			i = low;
+		}
+		ent = &stsc->entries[i];
+		if (!ent->samplesPerChunk) return GF_ISOM_INVALID_FILE;
+		stsc->ghostNumber = stbl_GetGhostNum(ent, i, count, stbl);
+		chunk = (sampleNumber - stsc->r_idx_first_sample[i]) / ent->samplesPerChunk;
+		//if we get here, gasp, the sample was not found
+		if (chunk >= stsc->ghostNumber) return GF_ISOM_INVALID_FILE;
+
+		stsc->currentIndex = i;
+		stsc->currentChunk = chunk + 1;
+		stsc->firstSampleInCurrentChunk = stsc->r_idx_first_sample[i] + chunk * ent->samplesPerChunk;
+		goto sample_found;
+	}
+
 	//check our cache
 	if (stbl->SampleToChunk->firstSampleInCurrentChunk &&
 		(stbl->SampleToChunk->firstSampleInCurrentChunk < sampleNumber)) {
@@ -103,8 +103,7 @@ GF_Err stbl_AddDTS(GF_SampleTableBox *stbl, u64 DTS, u32 *sampleNumber, u32 Last
 
 	GF_TimeToSampleBox *stts = stbl->TimeToSample;
 
-	//reset the reading cache when adding a sample
-	stts->r_FirstSampleInEntry = 0;
+	stbl->r_cts_index_count = 0;
 
 	*sampleNumber = 0;
 	//if we don't have an entry, that's the first one...
@@ -162,6 +161,11 @@ GF_Err stbl_AddDTS(GF_SampleTableBox *stbl, u64 DTS, u32 *sampleNumber, u32 Last
 	}
 
 
+	//the table is rewritten below, reset the reading cache and index
+	//(appending keeps them valid: existing entries never move and the index tail is recomputed on read)
+	stts->r_FirstSampleInEntry = 0;
+	stts->r_idx_nb = 0;
+
 	//unpack the DTSs and locate new sample...
 	DTSs = (u64*)gf_malloc(sizeof(u64) * (stbl->SampleSize->sampleCount+2) );
 	if (!DTSs) return GF_OUT_OF_MEM;
@@ -249,6 +253,7 @@ GF_Err stbl_AddCTS(GF_SampleTableBox *stbl, u32 sampleNumber, u32 CTSoffset)
 
 	GF_CompositionOffsetBox *ctts = stbl->CompositionOffset;
 
+	stbl->r_cts_index_count = 0;
 	/*in unpack mode we're sure to have 1 ctts entry per sample*/
 	if (ctts->unpack_mode) {
 		if (ctts->nb_entries==ctts->alloc_size) {
@@ -272,6 +277,7 @@ GF_Err stbl_AddCTS(GF_SampleTableBox *stbl, u32 sampleNumber, u32 CTSoffset)
 	}
 
 	//NOPE we are inserting a sample...
+	ctts->r_idx_nb = 0;
 	CTSs = (u32*)gf_malloc(sizeof(u32) * (stbl->SampleSize->sampleCount+1) );
 	if (!CTSs) return GF_OUT_OF_MEM;
 	sampNum = 0;
@@ -322,6 +328,7 @@ GF_Err stbl_repackCTS(GF_CompositionOffsetBox *ctts)
 
 	if (!ctts->unpack_mode) return GF_OK;
 	ctts->unpack_mode = 0;
+	ctts->r_idx_nb = 0;
 
 	j=0;
 	for (i=1; i<ctts->nb_entries; i++) {
@@ -346,6 +353,7 @@ GF_Err stbl_unpackCTS(GF_SampleTableBox *stbl)
 	ctts = stbl->CompositionOffset;
 	if (ctts->unpack_mode) return GF_OK;
 	ctts->unpack_mode = 1;
+	ctts->r_idx_nb = 0;
 
 	packed = ctts->entries;
 	count = ctts->nb_entries;
@@ -687,6 +695,7 @@ GF_Err stbl_AddChunkOffset(GF_MediaBox *mdia, u32 sampleNumber, u32 StreamDescIn
 		for (i = sampleNumber; i<stsc->nb_entries+1; i++) {
 			stsc->entries[i].firstChunk++;
 		}
+		stsc->r_idx_nb = 0;
 	}
 	stsc->nb_entries++;
 	return GF_OK;
@@ -736,6 +745,7 @@ GF_Err stbl_SetSampleCTS(GF_SampleTableBox *stbl, u32 sampleNumber, u32 offset)
 	GF_CompositionOffsetBox *ctts = stbl->CompositionOffset;
 
 	assert(ctts->unpack_mode);
+	stbl->r_cts_index_count = 0;
 
 	//if we're setting the CTS of a sample we've skipped...
 	if (ctts->w_LastSampleNumber < sampleNumber) {
@@ -857,12 +867,14 @@ GF_Err stbl_RemoveDTS(GF_SampleTableBox *stbl, u32 sampleNumber, u32 LastAUDefDu
 	GF_TimeToSampleBox *stts;
 
 	stts = stbl->TimeToSample;
+	stbl->r_cts_index_count = 0;
 
 	//we're removing the only sample: empty the sample table 
 	if (stbl->SampleSize->sampleCount == 1) {
 		stts->nb_entries = 0;
 		stts->r_FirstSampleInEntry = stts->r_currentEntryIndex = 0;
 		stts->r_CurrentDTS = 0;
+		stts->r_idx_nb = 0;
 		return GF_OK;
 	}
 	//we're removing the last sample
@@ -920,6 +932,7 @@ GF_Err stbl_RemoveDTS(GF_SampleTableBox *stbl, u32 sampleNumber, u32 LastAUDefDu
 	//reset read the cache to the begining
 	stts->r_FirstSampleInEntry = stts->r_currentEntryIndex = 0;
 	stts->r_CurrentDTS = 0;
+	stts->r_idx_nb = 0;
 	return GF_OK;
 }
 
@@ -929,6 +942,7 @@ GF_Err stbl_RemoveCTS(GF_SampleTableBox *stbl, u32 sampleNumber)
 {
 	GF_CompositionOffsetBox *ctts = stbl->CompositionOffset;
 	assert(ctts->unpack_mode);
+	stbl->r_cts_index_count = 0;
 
 	//last one...
 	if (stbl->SampleSize->sampleCount == 1) {
@@ -944,6 +958,7 @@ GF_Err stbl_RemoveCTS(GF_SampleTableBox *stbl, u32 sampleNumber)
 
 	ctts->nb_entries--;
 	memmove(&ctts->entries[sampleNumber-1], &ctts->entries[sampleNumber], sizeof(GF_DttsEntry)*ctts->nb_entries);
+	ctts->r_idx_nb = 0;
 
 	ctts->w_LastSampleNumber -= 1;
 	return GF_OK;
@@ -992,6 +1007,7 @@ GF_Err stbl_RemoveChunk(GF_SampleTableBox *stbl, u32 sampleNumber)
 	stbl->SampleToChunk->currentIndex = 0;
 	stbl->SampleToChunk->currentChunk = 1;
 	stbl->SampleToChunk->ghostNumber = 1;
+	stbl->SampleToChunk->r_idx_nb = 0;
 
 	//realloc the chunk offset
 	if (stbl->ChunkOffset->type == GF_ISOM_BOX_TYPE_STCO) {
@@ -1706,6 +1722,8 @@ GF_Err stbl_SetChunkAndOffset(GF_SampleTableBox *stbl, u32 sampleNumber, u32 Str
 			//OK, it's the same SampleToChunk, so delete it
 			ent->nextChunk = cur_ent->firstChunk;
 			the_stsc->nb_entries--;
+			//and drop it from the read index
+			if (the_stsc->r_idx_nb > the_stsc->nb_entries) the_stsc->r_idx_nb = the_stsc->nb_entries;
 		}
 	}
 
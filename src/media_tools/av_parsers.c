@@ -27,6 +27,11 @@
 #include <gpac/constants.h>
 #include <gpac/math.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define GPAC_SSE2_START_CODE
+#endif
+
 
 GF_EXPORT
 const char *gf_m4v_get_profile_name(u8 video_pl)
@@ -99,8 +104,108 @@ const char *gf_m4v_get_profile_name(u8 video_pl)
 }
 
 
+GF_EXPORT
+u32 gf_media_next_zero_pair(const u8 *data, u32 data_len)
+{
+	u32 pos = 0;
+#ifdef GPAC_SSE2_START_CODE
+	__m128i zero = _mm_setzero_si128();
+	/*compare 16 positions at once: byte i and byte i+1 shall both be 0*/
+	while (pos + 17 <= data_len) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (data + pos));
+		__m128i b = _mm_loadu_si128((const __m128i *) (data + pos + 1));
+		u32 mask = (u32) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, zero), _mm_cmpeq_epi8(b, zero)));
+		if (mask) {
+			while (!(mask & 1)) {
+				mask >>= 1;
+				pos++;
+			}
+			return pos;
+		}
+		pos += 16;
+	}
+#else
+	/*word at a time: no pair can start in a word without zero bytes*/
+	while (pos + 5 <= data_len) {
+		u32 v;
+		memcpy(&v, data + pos, 4);
+		if ((v - 0x01010101) & ~v & 0x80808080) {
+			u32 i;
+			for (i=0; i<4; i++) {
+				if (!data[pos+i] && !data[pos+i+1]) return pos+i;
+			}
+		}
+		pos += 4;
+	}
+#endif
+	for (; pos + 1 < data_len; pos++) {
+		if (!data[pos] && !data[pos+1]) return pos;
+	}
+	return data_len;
+}
+
+GF_EXPORT
+u32 gf_media_nalu_next_start_code(const u8 *data, u32 data_len, u32 *sc_size)
+{
+	u32 pos = 0;
+	while (pos + 2 < data_len) {
+		/*only look for pairs followed by a third byte*/
+		pos += gf_media_next_zero_pair(data + pos, data_len - pos - 1);
+		if (pos + 2 >= data_len) break;
+
+		if (data[pos+2] == 1) {
+			if (pos && !data[pos-1]) {
+				if (sc_size) *sc_size = 4;
+				return pos - 1;
+			}
+			if (sc_size) *sc_size = 3;
+			return pos;
+		}
+		/*00 00 00: a start code may begin at the next byte, otherwise not before 3 bytes*/
+		pos += data[pos+2] ? 3 : 1;
+	}
+	if (sc_size) *sc_size = 0;
+	return data_len;
+}
+
 #ifndef GPAC_DISABLE_AV_PARSERS
 
+/*looks for the next start code prefix in the bitstream through a cache, without moving the bitstream position.
+@trailing_bytes: number of bytes that must follow the prefix in the bitstream for it to be reported
+@sc_start: position of the 0x000001 prefix
+returns the start code size (4 if the prefix is preceded by a zero byte, 3 otherwise), 0 if not found*/
+#define SC_CACHE_SIZE	4096
+static u32 gf_bs_next_start_code(GF_BitStream *bs, u32 trailing_bytes, u64 *sc_start)
+{
+	u8 sc_cache[SC_CACHE_SIZE];
+	u32 keep, load_size, pos, sc_size;
+	u64 cache_start, start;
+	
+	start = cache_start = gf_bs_get_position(bs);
+	keep = 0;
+	sc_size = 0;
+	while (gf_bs_available(bs)) {
+		load_size = SC_CACHE_SIZE - keep;
+		if (load_size > gf_bs_available(bs)) load_size = (u32) gf_bs_available(bs);
+		gf_bs_read_data(bs, (char *) sc_cache + keep, load_size);
+		load_size += keep;
+
+		if (load_size > trailing_bytes) {
+			pos = gf_media_nalu_next_start_code(sc_cache, load_size - trailing_bytes, &sc_size);
+			if (sc_size) {
+				*sc_start = cache_start + pos + sc_size - 3;
+				break;
+			}
+		}
+		/*keep the last bytes, a start code may cross the cache boundary*/
+		keep = (load_size < 3 + trailing_bytes) ? load_size : 3 + trailing_bytes;
+		memmove(sc_cache, sc_cache + load_size - keep, keep);
+		cache_start += load_size - keep;
+	}
+	gf_bs_seek(bs, start);
+	return sc_size;
+}
+
 #define MPEG12_START_CODE_PREFIX		0x000001
 #define MPEG12_PICTURE_START_CODE		0x00000100
 #define MPEG12_SLICE_MIN_START			0x00000101
@@ -114,24 +219,16 @@ const char *gf_m4v_get_profile_name(u8 video_pl)
 
 s32 gf_mv12_next_start_code(unsigned char *pbuffer, u32 buflen, u32 *optr, u32 *scode)
 {
-  u32 value;
-  u32 offset;
+  u32 offset, sc_size;
 
   if (buflen < 4) return -1;
-  for (offset = 0; offset < buflen - 3; offset++, pbuffer++) {
-#ifdef GPAC_BIG_ENDIAN
-	value = *(u32 *)pbuffer >> 8;
-#else
-	value = (pbuffer[0] << 16) | (pbuffer[1] << 8) | (pbuffer[2] << 0); 
-#endif
-
-	if (value == MPEG12_START_CODE_PREFIX) {
-	  *optr = offset;
-	  *scode = (value << 8) | pbuffer[3];
-	  return 0;
-	}
-  }
-  return -1;
+  /*the start code value shall be in the buffer*/
+  offset = gf_media_nalu_next_start_code(pbuffer, buflen - 1, &sc_size);
+  if (!sc_size) return -1;
+  offset += sc_size - 3;
+  *optr = offset;
+  *scode = (MPEG12_START_CODE_PREFIX << 8) | pbuffer[offset+3];
+  return 0;
 }
 
 s32 gf_mv12_next_slice_start(unsigned char *pbuffer, u32 startoffset, u32 buflen, u32 *slice_offset)
@@ -203,38 +300,16 @@ void gf_m4v_parser_del(GF_M4VParser *m4v)
 }
 
 
-#define M4V_CACHE_SIZE		4096
 s32 M4V_LoadObject(GF_M4VParser *m4v)
 {
-	u32 v, bpos, found;
-	char m4v_cache[M4V_CACHE_SIZE];
-	u64 end, cache_start, load_size;
+	u64 end;
 	if (!m4v) return 0;
-	bpos = 0;
-	found = 0;
-	load_size = 0;
-	end = 0;
-	cache_start = 0;
-	v = 0xffffffff;
-	while (!end) {
-		/*refill cache*/
-		if (bpos == (u32) load_size) {
-			if (!gf_bs_available(m4v->bs)) break;
-			load_size = gf_bs_available(m4v->bs);
-			if (load_size>M4V_CACHE_SIZE) load_size=M4V_CACHE_SIZE;
-			bpos = 0;
-			cache_start = gf_bs_get_position(m4v->bs);
-			gf_bs_read_data(m4v->bs, m4v_cache, (u32) load_size);
-		}
-		v = ( (v<<8) & 0xFFFFFF00) | ((u8) m4v_cache[bpos]);
-		bpos++;
-		if ((v & 0xFFFFFF00) == 0x00000100) {
-			end = cache_start+bpos-4;
-			found = 1;
-			break;
-		}
+	/*the object type shall follow the start code*/
+	if (!gf_bs_next_start_code(m4v->bs, 1, &end)) {
+		/*no more objects, skip remaining data*/
+		gf_bs_seek(m4v->bs, gf_bs_get_size(m4v->bs));
+		return -1;
 	}
-	if (!found) return -1;
 	m4v->current_object_start = end;
 	gf_bs_seek(m4v->bs, end+3);
 	m4v->current_object_type = gf_bs_read_u8(m4v->bs);
@@ -1596,38 +1671,17 @@ u32 AVC_IsStartCode(GF_BitStream *bs)
 	return is_sc;
 }
 
-/*read that amount of data at each IO access rather than fetching byte by byte...*/
-#define AVC_CACHE_SIZE	4096
 u32 AVC_NextStartCode(GF_BitStream *bs)
 {
-	u32 v, bpos;
-	char avc_cache[AVC_CACHE_SIZE];
-	u64 end, cache_start, load_size;
+	u32 sc_size;
+	u64 end;
 	u64 start = gf_bs_get_position(bs);
 	if (start<3) return 0;
 	
-	load_size = 0;
-	bpos = 0;
-	cache_start = 0;
-	end = 0;
-	v = 0xffffffff;
-	while (!end) {
-		/*refill cache*/
-		if (bpos == (u32) load_size) {
-			if (!gf_bs_available(bs)) break;
-			load_size = gf_bs_available(bs);
-			if (load_size>AVC_CACHE_SIZE) load_size=AVC_CACHE_SIZE;
-			bpos = 0;
-			cache_start = gf_bs_get_position(bs);
-			gf_bs_read_data(bs, avc_cache, (u32) load_size);
-		}
-		v = ( (v<<8) & 0xFFFFFF00) | ((u32) avc_cache[bpos]);
-		bpos++;
-		if (v == 0x00000001) end = cache_start+bpos-4;
-		else if ( (v & 0x00FFFFFF) == 0x00000001) end = cache_start+bpos-3;
-	}
-	gf_bs_seek(bs, start);
-	if (!end) end = gf_bs_get_size(bs);
+	sc_size = gf_bs_next_start_code(bs, 0, &end);
+	/*the leading zero of a 4 bytes start code is not part of the NAL*/
+	if (sc_size==4) end--;
+	else if (!sc_size) end = gf_bs_get_size(bs);
 	return (u32) (end-start);
 }
 
@@ -198,6 +198,16 @@ void gf_isom_streamer_reset(GF_ISOMRTPStreamer *streamer, Bool is_loop)
 	if (is_loop) streamer->timelineOrigin = 0;
 }
 
+/*sends the packets left in the paced queues of the tracks*/
+static void gf_isom_streamer_flush(GF_ISOMRTPStreamer *streamer, Bool force)
+{
+	GF_RTPTrack *track = streamer->stream;
+	while (track) {
+		gf_rtp_streamer_flush(track->rtp, force);
+		track = track->next;
+	}
+}
+
 GF_Err gf_isom_streamer_send_next_packet(GF_ISOMRTPStreamer *streamer, s32 send_ahead_delay, s32 max_sleep_time) 
 {
 	GF_Err e = GF_OK;
@@ -254,13 +264,18 @@ GF_Err gf_isom_streamer_send_next_packet(GF_ISOMRTPStreamer *streamer, s32 send_
 	}
 
 	/*no input data ...*/
-	if( !to_send) return GF_EOS;
+	if( !to_send) {
+		gf_isom_streamer_flush(streamer, 1);
+		return GF_EOS;
+	}
 	min_ts /= 1000;
 
 	if (max_sleep_time) {
 		diff = ((u32) min_ts) - gf_sys_clock();	
-		if (diff>max_sleep_time) 
+		if (diff>max_sleep_time) {
+			gf_isom_streamer_flush(streamer, 0);
 			return GF_OK;
+		}
 	}
 
 	/*sleep until TS is mature*/
@@ -268,6 +283,7 @@ GF_Err gf_isom_streamer_send_next_packet(GF_ISOMRTPStreamer *streamer, s32 send_
 		diff = ((u32) min_ts) - gf_sys_clock();
 		
 		if (diff > send_ahead_delay) {
+			gf_isom_streamer_flush(streamer, 0);
 			gf_sleep(1);
 		} else {
 			if (diff<10) {
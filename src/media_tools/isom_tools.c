@@ -27,6 +27,7 @@
 #include <gpac/media_tools.h>
 #include <gpac/constants.h>
 #include <gpac/config_file.h>
+#include <gpac/thread.h>
 
 #ifndef GPAC_DISABLE_ISOM
 
@@ -626,25 +627,33 @@ typedef struct
 } TrackFragmenter;
 
 
-GF_EXPORT
-GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_duration_sec, u32 dash_mode, Double dash_duration_sec, char *seg_rad_name, char *seg_ext, u32 fragments_per_sidx, Bool daisy_chain_sidx, Bool use_url_template, const char *dash_ctx_file)
+/*fragments one representation. In DASH mode, the Representation element is written in mpd and the duration of the 
+presentation is returned in period_duration. If seg_bounds is set, segments are split at the given times (expressed in
+seg_bounds_timescale) of the reference track rather than after dash_duration_sec.
+If mx is set, representations are segmented in parallel: the global state of the library (open error of the ISO 
+files and progress report) is only accessed under this lock, and the progress is reported by the caller*/
+static GF_Err gf_media_fragment_representation(GF_ISOFile *input, char *output_file, Double max_duration_sec, u32 dash_mode, Double dash_duration_sec, char *seg_rad_name, char *seg_ext, u32 fragments_per_sidx, Bool daisy_chain_sidx, Bool use_url_template, const char *dash_ctx_file, 
+											  u64 *seg_bounds, u32 nb_seg_bounds, u32 seg_bounds_timescale, FILE *mpd, Double *period_duration, GF_Mutex *mx)
 {
 	u8 NbBits;
-	u32 i, TrackNum, descIndex, j, count, nb_sync, ref_track_id, nb_tracks_done;
+	u32 i, TrackNum, descIndex, count, nb_sync, ref_track_id, nb_tracks_done;
 	u32 defaultDuration, defaultSize, defaultDescriptionIndex, defaultRandomAccess, nb_samp, nb_done;
 	u8 defaultPadding;
 	u16 defaultDegradationPriority;
 	GF_Err e;
 	u32 cur_seg;
 	GF_ISOFile *output;
-	GF_ISOSample *sample, *next;
+	GF_ISOSample *sample, *next, *next_sample;
 	GF_List *fragmenters;
 	u32 MaxFragmentDuration, MaxSegmentDuration, SegmentDuration, maxFragDurationOverSegment;
 	Double average_duration, file_duration;
 	u32 nb_segments, width, height, sample_rate, nb_channels;
 	char langCode[5];
 	Bool switch_segment = 0;
-	Bool split_seg_at_rap = (dash_mode==2) ? 1 : 0;
+	/*with forced segment boundaries, RAPs were already taken into account when computing them*/
+	Bool split_seg_at_rap = ((dash_mode==2) && !seg_bounds) ? 1 : 0;
+	Bool seg_bound_reached = 0;
+	u32 cur_bound = 0;
 	Bool split_at_rap = 0;
 	Bool has_rap = 0;
 	Bool next_sample_rap = 0;
@@ -654,7 +663,6 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 	u32 tfref_timescale = 0;
 	u32 bandwidth = 0;
 	TrackFragmenter *tf, *tfref;
-	FILE *mpd = NULL;
 	FILE *mpd_segs = NULL;
 	char *SegName = NULL;
 	const char *opt;
@@ -666,6 +674,7 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 	SegmentDuration = 0;
 	nb_samp = 0;
 	fragmenters = NULL;
+	sample = next_sample = NULL;
 	if (!seg_ext) seg_ext = "m4s";
 
 	//create output file
@@ -688,6 +697,7 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 		if (!SegName) return GF_OUT_OF_MEM;
 
 		opt = dash_ctx ? gf_cfg_get_key(dash_ctx, "DASH", "InitializationSegment") : NULL;
+		if (mx) gf_mx_p(mx);
 		if (opt) {
 			output = gf_isom_open(opt, GF_ISOM_OPEN_CAT_FRAGMENTS, NULL);
 			dash_moov_setup = 1;
@@ -696,19 +706,15 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 			strcat(SegName, ".mp4");
 			output = gf_isom_open(SegName, GF_ISOM_OPEN_WRITE, NULL);
 		}
-		if (!output) {
-			e = gf_isom_last_error(NULL);
-			goto err_exit;
-		}
+		if (!output) e = gf_isom_last_error(NULL);
+		if (mx) gf_mx_v(mx);
+		if (!output) goto err_exit;
 
 		if (store_dash_params) {
 			gf_cfg_set_key(dash_ctx, "DASH", "InitializationSegment", SegName);
 		}
 
 
-		strcpy(SegName, output_file);
-		strcat(SegName, ".mpd");
-		mpd = gf_f64_open(SegName, "wt");
 		mpd_segs = gf_temp_file_new();
 	} else {
 		output = gf_isom_open(output_file, GF_ISOM_OPEN_WRITE, NULL);
@@ -892,6 +898,13 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 		if (opt) cur_seg = atoi(opt);
 	}
 
+	sample = gf_isom_sample_new();
+	next_sample = gf_isom_sample_new();
+	if (!sample || !next_sample) {
+		e = GF_OUT_OF_MEM;
+		goto err_exit;
+	}
+
 	while ( (count = gf_list_count(fragmenters)) ) {
 
 		if (switch_segment) {
@@ -921,7 +934,6 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 		maxFragDurationOverSegment=0;
 		e = gf_isom_start_fragment(output, 1);
 		if (e) goto err_exit;
-		sample = NULL;
 
 		for (i=0; i<count; i++) {
 			tf = (TrackFragmenter *)gf_list_get(fragmenters, i);
@@ -932,7 +944,7 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 		//process track by track
 		for (i=0; i<count; i++) {
 			/*start with ref*/
-			if (tfref && split_seg_at_rap ) {
+			if (tfref && (split_seg_at_rap || seg_bounds) ) {
 				if (i==0) {
 					tf = tfref;
 					has_rap=0;
@@ -952,12 +964,18 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 			//ok write samples
 			while (1) {
 				Bool stop_frag = 0;
-				if (!sample) {
-					sample = gf_isom_get_sample(input, tf->OriginalTrack, tf->SampleNum + 1, &descIndex);
+				/*sample and next are reused, and the sample data is lent by the input file when possible*/
+				if (!gf_isom_get_sample_ex(input, tf->OriginalTrack, tf->SampleNum + 1, &descIndex, sample, 1)) {
+					e = gf_isom_last_error(input);
+					if (!e) e = GF_IO_ERR;
+					goto err_exit;
 				}
 				gf_isom_get_sample_padding_bits(input, tf->OriginalTrack, tf->SampleNum+1, &NbBits);
 
-				next = gf_isom_get_sample(input, tf->OriginalTrack, tf->SampleNum + 2, &j);
+				/*only timing and RAP info are needed for the next sample*/
+				next = NULL;
+				if (tf->SampleNum + 1 < tf->SampleCount) 
+					next = gf_isom_get_sample_info_ex(input, tf->OriginalTrack, tf->SampleNum + 2, NULL, NULL, next_sample);
 				if (next) {
 					defaultDuration = (u32) (next->DTS - sample->DTS);
 				} else {
@@ -980,14 +998,13 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 				if (e) 
 					goto err_exit;
 
-				gf_set_progress("ISO File Fragmenting", nb_done, nb_samp);
+				if (!mx) gf_set_progress("ISO File Fragmenting", nb_done, nb_samp);
 				nb_done++;
 
 				tf->last_sample_cts = sample->DTS + sample->CTS_Offset;
 				tf->next_sample_dts = sample->DTS + defaultDuration;
 
-				gf_isom_sample_del(&sample);
-				sample = next;
+				gf_isom_sample_release(sample);
 				tf->FragmentLength += defaultDuration;
 				tf->SampleNum += 1;
 
@@ -1015,6 +1032,16 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 					next_sample_rap = 0;
 				}
 
+				/*aligned segments: stop before the first sample of the next segment*/
+				if (seg_bounds && (tf==tfref) && next && (cur_bound < nb_seg_bounds)
+					&& (next->DTS * seg_bounds_timescale >= seg_bounds[cur_bound] * tf->TimeScale) ) {
+					stop_frag = 1;
+					seg_bound_reached = 1;
+					/*a gap in the samples may cover several bounds, skip them all so that no empty segment is produced*/
+					while ((cur_bound < nb_seg_bounds) && (next->DTS * seg_bounds_timescale >= seg_bounds[cur_bound] * tf->TimeScale))
+						cur_bound++;
+				}
+
 				if (tf->SampleNum==tf->SampleCount) {
 					stop_frag = 1;
 				} else if (tf==tfref) {
@@ -1030,8 +1057,6 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 				}
 
 				if (stop_frag) {
-					gf_isom_sample_del(&next);
-					sample = next = NULL;
 					if (maxFragDurationOverSegment<=tf->FragmentLength*1000/tf->TimeScale) {
 						maxFragDurationOverSegment = tf->FragmentLength*1000/tf->TimeScale;
 					}
@@ -1058,7 +1083,8 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 			SegmentDuration += maxFragDurationOverSegment;
 			maxFragDurationOverSegment=0;
 
-			if ((SegmentDuration >= MaxSegmentDuration) && (!split_seg_at_rap || next_sample_rap)) {
+			if (seg_bounds ? seg_bound_reached : ((SegmentDuration >= MaxSegmentDuration) && (!split_seg_at_rap || next_sample_rap)) ) {
+				seg_bound_reached = 0;
 				average_duration += SegmentDuration;
 				nb_segments++;
 
@@ -1136,16 +1162,9 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 			fprintf(mpd_segs, "    <UrlTemplate sourceURL=\"%s\" startIndex=\"1\" endIndex=\"%d\" />\n", SegName, cur_seg-1);	
 		}
 
-		h = (u32) (file_duration/3600);
-		m = (u32) (file_duration-h*60)/60;
-		s = file_duration - h*3600 - m*60;
+		if (period_duration) *period_duration = file_duration;
 		bandwidth = (u32) (file_size * 8 / file_duration);
 
-		fprintf(mpd, "<MPD type=\"OnDemand\" xmlns=\"urn:3GPP:ns:PSS:AdaptiveHTTPStreamingMPD:2009\">\n");
-	    fprintf(mpd, " <ProgramInformation moreInformationURL=\"http://gpac.sourceforge.net\">\n");
-		fprintf(mpd, "  <Title>Media Presentation Description for file %s generated with GPAC </Title>\n", gf_isom_get_filename(input));
-        fprintf(mpd, " </ProgramInformation>\n");
-        fprintf(mpd, " <Period start=\"PT0S\" duration=\"PT%dH%dM%.2fS\">\n", h, m, s);	
 		fprintf(mpd, "  <Representation mimeType=\"video/mp4\"");
 		if (width && height) fprintf(mpd, " width=\"%d\" height=\"%d\"", width, height);
 		if (sample_rate && nb_channels) fprintf(mpd, " sampleRate=\"%d\" numChannels=\"%d\"", sample_rate, nb_channels);
@@ -1158,7 +1177,7 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 		fprintf(mpd, ">\n");
 
 		h = (u32) (dash_duration_sec/3600);
-		m = (u32) (dash_duration_sec-h*60)/60;
+		m = (u32) (dash_duration_sec-h*3600)/60;
 		s = dash_duration_sec - h*3600 - m*60;
 		if (m) {
 			fprintf(mpd, "   <SegmentInfo duration=\"PT%dM%.2fS\"", m, s);	
@@ -1183,8 +1202,6 @@ GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_d
 
 		fprintf(mpd, "   </SegmentInfo>\n");
         fprintf(mpd, "  </Representation>\n");
-        fprintf(mpd, " </Period>\n");
-        fprintf(mpd, "</MPD>");
 	}
 
 	/*store context*/
@@ -1210,16 +1227,827 @@ err_exit:
 		}
 		gf_list_del(fragmenters);
 	}
+	if (sample) gf_isom_sample_del(&sample);
+	if (next_sample) gf_isom_sample_del(&next_sample);
+	/*writing the file reports its progress*/
+	if (mx) gf_mx_p(mx);
 	if (e) gf_isom_delete(output);
 	else gf_isom_close(output);
-	gf_set_progress("ISO File Fragmenting", nb_samp, nb_samp);
+	if (mx) gf_mx_v(mx);
+	else gf_set_progress("ISO File Fragmenting", nb_samp, nb_samp);
 	if (SegName) gf_free(SegName);
-	if (mpd) fclose(mpd);
 	if (mpd_segs) fclose(mpd_segs);
 	if (dash_ctx) gf_cfg_del(dash_ctx);
 	return e;
 }
 
+static void dash_write_mpd(FILE *mpd, const char *mpd_type, const char *src_name, Double period_duration, FILE **reps, u32 nb_reps)
+{
+	u32 i, h, m;
+	Double s;
+	char buffer[1000];
+
+	h = (u32) (period_duration/3600);
+	m = (u32) (period_duration-h*3600)/60;
+	s = period_duration - h*3600 - m*60;
+
+	fprintf(mpd, "<MPD type=\"%s\" xmlns=\"urn:3GPP:ns:PSS:AdaptiveHTTPStreamingMPD:2009\">\n", mpd_type);
+    fprintf(mpd, " <ProgramInformation moreInformationURL=\"http://gpac.sourceforge.net\">\n");
+	fprintf(mpd, "  <Title>Media Presentation Description for file %s generated with GPAC </Title>\n", src_name);
+    fprintf(mpd, " </ProgramInformation>\n");
+    fprintf(mpd, " <Period start=\"PT0S\" duration=\"PT%dH%dM%.2fS\">\n", h, m, s);	
+
+	for (i=0; i<nb_reps; i++) {
+		gf_f64_seek(reps[i], 0, SEEK_SET);
+		while (!feof(reps[i])) {
+			u32 r = fread(buffer, 1, 1000, reps[i]);
+			if (!r) break;
+			fwrite(buffer, 1, r, mpd);
+		}
+	}
+    fprintf(mpd, " </Period>\n");
+    fprintf(mpd, "</MPD>");
+}
+
+GF_EXPORT
+GF_Err gf_media_fragment_file(GF_ISOFile *input, char *output_file, Double max_duration_sec, u32 dash_mode, Double dash_duration_sec, char *seg_rad_name, char *seg_ext, u32 fragments_per_sidx, Bool daisy_chain_sidx, Bool use_url_template, const char *dash_ctx_file)
+{
+	GF_Err e;
+	char *szMPD;
+	FILE *mpd, *rep;
+	Double period_duration;
+
+	if (!dash_mode) 
+		return gf_media_fragment_representation(input, output_file, max_duration_sec, 0, 0, NULL, NULL, 0, 0, 0, NULL, NULL, 0, 0, NULL, NULL, NULL);
+
+	szMPD = gf_malloc(sizeof(char) * (strlen(output_file) + 5));
+	if (!szMPD) return GF_OUT_OF_MEM;
+	strcpy(szMPD, output_file);
+	strcat(szMPD, ".mpd");
+	mpd = gf_f64_open(szMPD, "wt");
+	gf_free(szMPD);
+	if (!mpd) return GF_IO_ERR;
+	rep = gf_temp_file_new();
+	if (!rep) {
+		fclose(mpd);
+		return GF_IO_ERR;
+	}
+	period_duration = 0;
+	e = gf_media_fragment_representation(input, output_file, max_duration_sec, dash_mode, dash_duration_sec, seg_rad_name, seg_ext, fragments_per_sidx, daisy_chain_sidx, use_url_template, dash_ctx_file, NULL, 0, 0, rep, &period_duration, NULL);
+	if (!e) dash_write_mpd(mpd, "OnDemand", gf_isom_get_filename(input), period_duration, &rep, 1);
+	fclose(rep);
+	fclose(mpd);
+	return e;
+}
+
+/*same rules as gf_media_fragment_file for the choice of the reference track*/
+static u32 dash_get_reference_track(GF_ISOFile *input)
+{
+	u32 i, count, nb_sync, ref_track, first_track, visual_track;
+	nb_sync = ref_track = first_track = visual_track = 0;
+	for (i=0; i<gf_isom_get_track_count(input); i++) {
+		u32 mtype = gf_isom_get_media_type(input, i+1);
+		if (mtype == GF_ISOM_MEDIA_HINT) continue;
+		count = gf_isom_get_sample_count(input, i+1);
+		if (count==1) continue;
+		if (!first_track) first_track = i+1;
+
+		if (gf_isom_get_sync_point_count(input, i+1)>nb_sync) { 
+			ref_track = i+1;
+			nb_sync = gf_isom_get_sync_point_count(input, i+1);
+		}
+		if (!visual_track && (count>=10) && ((mtype==GF_ISOM_MEDIA_TEXT) || (mtype==GF_ISOM_MEDIA_VISUAL)) )
+			visual_track = i+1;
+	}
+	if (ref_track) return ref_track;
+	if (visual_track) return visual_track;
+	return first_track;
+}
+
+/*computes segment boundaries on the reference track: a segment starts on the first sample (RAP if requested) 
+at least dash_duration_sec after the start of the previous one*/
+static GF_Err dash_get_segment_bounds(GF_ISOFile *input, Double dash_duration_sec, Bool at_rap, u64 **out_bounds, u32 *out_nb_bounds, u32 *out_timescale)
+{
+	u32 i, track, count, nb_bounds, nb_alloc;
+	u64 seg_dur, next_bound;
+	u64 *bounds;
+	GF_ISOSample *samp;
+
+	*out_bounds = NULL;
+	*out_nb_bounds = *out_timescale = 0;
+	track = dash_get_reference_track(input);
+	if (!track) return GF_BAD_PARAM;
+
+	*out_timescale = gf_isom_get_media_timescale(input, track);
+	seg_dur = (u64) (dash_duration_sec * (*out_timescale));
+	if (!seg_dur) seg_dur = 1;
+
+	samp = gf_isom_sample_new();
+	if (!samp) return GF_OUT_OF_MEM;
+	bounds = NULL;
+	nb_bounds = nb_alloc = 0;
+	next_bound = seg_dur;
+	count = gf_isom_get_sample_count(input, track);
+	for (i=2; i<=count; i++) {
+		if (!gf_isom_get_sample_info_ex(input, track, i, NULL, NULL, samp)) break;
+		if (samp->DTS < next_bound) continue;
+		if (at_rap && !samp->IsRAP) continue;
+
+		if (nb_bounds==nb_alloc) {
+			nb_alloc = nb_alloc ? 2*nb_alloc : 64;
+			bounds = gf_realloc(bounds, sizeof(u64)*nb_alloc);
+			if (!bounds) {
+				gf_isom_sample_del(&samp);
+				return GF_OUT_OF_MEM;
+			}
+		}
+		bounds[nb_bounds] = samp->DTS;
+		nb_bounds++;
+		next_bound = samp->DTS + seg_dur;
+	}
+	gf_isom_sample_del(&samp);
+	*out_bounds = bounds;
+	*out_nb_bounds = nb_bounds;
+	return GF_OK;
+}
+
+typedef struct
+{
+	GF_ISOFile *input;
+	char *output_file;
+	char *seg_rad_name;
+	/*Representation element of the MPD*/
+	FILE *mpd_rep;
+	Double duration;
+	GF_Err e;
+} DashRepresentation;
+
+typedef struct
+{
+	DashRepresentation *reps;
+	u32 nb_reps, next_rep, nb_reps_done;
+	/*protects the representation queue and the global state of the library*/
+	GF_Mutex *mx;
+
+	Double max_duration_sec, dash_duration_sec;
+	u32 dash_mode, fragments_per_sidx;
+	char *seg_ext;
+	Bool daisy_chain_sidx, use_url_template;
+	u64 *seg_bounds;
+	u32 nb_seg_bounds, seg_bounds_timescale;
+} DashSegmenter;
+
+static u32 dash_segmenter_run(void *par)
+{
+	DashSegmenter *dseg = (DashSegmenter *)par;
+	while (1) {
+		DashRepresentation *rep;
+		gf_mx_p(dseg->mx);
+		rep = (dseg->next_rep < dseg->nb_reps) ? &dseg->reps[dseg->next_rep] : NULL;
+		dseg->next_rep++;
+		gf_mx_v(dseg->mx);
+		if (!rep) break;
+
+		rep->e = gf_media_fragment_representation(rep->input, rep->output_file, dseg->max_duration_sec, dseg->dash_mode, dseg->dash_duration_sec, 
+							rep->seg_rad_name, dseg->seg_ext, dseg->fragments_per_sidx, dseg->daisy_chain_sidx, dseg->use_url_template, NULL, 
+							dseg->seg_bounds, dseg->nb_seg_bounds, dseg->seg_bounds_timescale, rep->mpd_rep, &rep->duration, dseg->mx);
+
+		gf_mx_p(dseg->mx);
+		dseg->nb_reps_done++;
+		gf_set_progress("DASH Segmenting", dseg->nb_reps_done, dseg->nb_reps);
+		gf_mx_v(dseg->mx);
+	}
+	return 0;
+}
+
+GF_EXPORT
+GF_Err gf_media_fragment_files(GF_ISOFile **inputs, char **output_files, char **seg_rad_names, u32 nb_inputs, const char *mpd_name, Double max_duration_sec, u32 dash_mode, Double dash_duration_sec, char *seg_ext, u32 fragments_per_sidx, Bool daisy_chain_sidx, Bool use_url_template, u32 nb_threads)
+{
+	u32 i;
+	GF_Err e;
+	FILE *mpd;
+	FILE **reps;
+	Double period_duration;
+	GF_Thread **threads;
+	DashSegmenter dseg;
+
+	if (!inputs || !output_files || !nb_inputs || !mpd_name || !dash_mode) return GF_BAD_PARAM;
+
+	memset(&dseg, 0, sizeof(DashSegmenter));
+	dseg.max_duration_sec = max_duration_sec;
+	dseg.dash_mode = dash_mode;
+	dseg.dash_duration_sec = dash_duration_sec;
+	dseg.seg_ext = seg_ext;
+	dseg.fragments_per_sidx = fragments_per_sidx;
+	dseg.daisy_chain_sidx = daisy_chain_sidx;
+	dseg.use_url_template = use_url_template;
+
+	/*segment boundaries are given by the first representation so that all representations switch at the same time*/
+	e = dash_get_segment_bounds(inputs[0], dash_duration_sec, (dash_mode==2) ? 1 : 0, &dseg.seg_bounds, &dseg.nb_seg_bounds, &dseg.seg_bounds_timescale);
+	if (e) return e;
+	/*no boundary: single segment, but we still need aligned mode*/
+	if (!dseg.seg_bounds) {
+		dseg.seg_bounds = gf_malloc(sizeof(u64));
+		if (!dseg.seg_bounds) return GF_OUT_OF_MEM;
+	}
+
+	threads = NULL;
+	reps = NULL;
+	mpd = NULL;
+	dseg.reps = gf_malloc(sizeof(DashRepresentation) * nb_inputs);
+	reps = gf_malloc(sizeof(FILE *) * nb_inputs);
+	dseg.mx = gf_mx_new("DASHSegmenter");
+	if (!dseg.reps || !reps || !dseg.mx) {
+		e = GF_OUT_OF_MEM;
+		goto exit;
+	}
+	memset(dseg.reps, 0, sizeof(DashRepresentation) * nb_inputs);
+	memset(reps, 0, sizeof(FILE *) * nb_inputs);
+	for (i=0; i<nb_inputs; i++) {
+		dseg.reps[i].input = inputs[i];
+		dseg.reps[i].output_file = output_files[i];
+		dseg.reps[i].seg_rad_name = seg_rad_names ? seg_rad_names[i] : NULL;
+		dseg.reps[i].mpd_rep = reps[i] = gf_temp_file_new();
+		if (!reps[i]) {
+			e = GF_IO_ERR;
+			goto exit;
+		}
+	}
+	dseg.nb_reps = nb_inputs;
+
+	mpd = gf_f64_open(mpd_name, "wt");
+	if (!mpd) {
+		e = GF_IO_ERR;
+		goto exit;
+	}
+
+	/*the calling thread is one of the workers*/
+	if (!nb_threads) nb_threads = gf_sys_get_cpu_count();
+	if (!nb_threads || (nb_threads > nb_inputs)) nb_threads = nb_inputs;
+	threads = gf_malloc(sizeof(GF_Thread *) * nb_threads);
+	if (!threads) {
+		e = GF_OUT_OF_MEM;
+		goto exit;
+	}
+	memset(threads, 0, sizeof(GF_Thread *) * nb_threads);
+	for (i=1; i<nb_threads; i++) {
+		threads[i] = gf_th_new("DASHSegmenter");
+		if (!threads[i]) break;
+		if (gf_th_run(threads[i], dash_segmenter_run, &dseg) != GF_OK) break;
+	}
+	dash_segmenter_run(&dseg);
+	for (i=1; i<nb_threads; i++) {
+		if (!threads[i]) continue;
+		gf_th_stop(threads[i]);
+		gf_th_del(threads[i]);
+	}
+
+	period_duration = 0;
+	for (i=0; i<nb_inputs; i++) {
+		if (dseg.reps[i].e) {
+			e = dseg.reps[i].e;
+			GF_LOG(GF_LOG_ERROR, GF_LOG_AUTHOR, ("[DASH] Error while segmenting representation %s: %s\n", output_files[i], gf_error_to_string(e)));
+		}
+		if (dseg.reps[i].duration > period_duration) period_duration = dseg.reps[i].duration;
+	}
+	if (!e) dash_write_mpd(mpd, "OnDemand", gf_isom_get_filename(inputs[0]), period_duration, reps, nb_inputs);
+
+exit:
+	if (mpd) fclose(mpd);
+	if (reps) {
+		for (i=0; i<nb_inputs; i++) {
+			if (reps[i]) fclose(reps[i]);
+		}
+		gf_free(reps);
+	}
+	if (threads) gf_free(threads);
+	if (dseg.reps) gf_free(dseg.reps);
+	if (dseg.mx) gf_mx_del(dseg.mx);
+	gf_free(dseg.seg_bounds);
+	return e;
+}
+
+typedef struct
+{
+	GF_ISOSample *samp;
+	u32 duration, descIndex;
+	u8 padding;
+} LiveSample;
+
+typedef struct
+{
+	u32 TrackID, TimeScale, MediaType;
+	/*source track when samples are pulled from an ISO file*/
+	GF_ISOFile *input;
+	u32 OriginalTrack, SampleNum;
+	/*last received sample, queued once the DTS of the next one gives its duration*/
+	LiveSample pending;
+	/*samples of the fragment being built - track fragments are written in a single run*/
+	GF_List *samples;
+	u32 DefaultDuration, last_duration;
+	Bool has_dts;
+	/*DTS of the first sample not yet written*/
+	u64 next_sample_dts;
+} LiveTrackFragmenter;
+
+struct __dash_live_segmenter
+{
+	GF_ISOFile *output;
+	char *output_file, *seg_rad_name, *seg_ext, *SegName;
+	u32 MaxFragmentDuration, MaxSegmentDuration;
+	Bool seg_at_rap, daisy_chain_sidx;
+	u32 fragments_per_sidx;
+
+	GF_List *tracks;
+	LiveTrackFragmenter *tfref;
+	/*init segment has been written*/
+	Bool setup_done;
+	Bool in_segment;
+	Bool segments_start_with_rap;
+	u32 cur_seg;
+	/*decode times of the reference track at segment and fragment start*/
+	u64 seg_start_dts, frag_start_dts;
+	u64 start_range, init_seg_size, file_size;
+	FILE *mpd_segs;
+
+	u32 width, height, sample_rate, nb_channels;
+	char langCode[5];
+};
+
+GF_EXPORT
+GF_DASHLiveSegmenter *gf_dash_live_new(char *output_file, char *seg_rad_name, char *seg_ext, Double max_duration_sec, Double dash_duration_sec, Bool seg_at_rap, u32 fragments_per_sidx, Bool daisy_chain_sidx)
+{
+	GF_DASHLiveSegmenter *dasher;
+	if (!output_file || !dash_duration_sec) return NULL;
+
+	GF_SAFEALLOC(dasher, GF_DASHLiveSegmenter);
+	if (!dasher) return NULL;
+	dasher->output_file = gf_strdup(output_file);
+	if (seg_rad_name) dasher->seg_rad_name = gf_strdup(seg_rad_name);
+	dasher->seg_ext = gf_strdup(seg_ext ? seg_ext : "m4s");
+	dasher->SegName = gf_malloc(sizeof(char) * (strlen(output_file) + (seg_rad_name ? strlen(seg_rad_name) : 0) + strlen(dasher->seg_ext) + 100));
+	dasher->tracks = gf_list_new();
+	dasher->mpd_segs = gf_temp_file_new();
+	if (!dasher->output_file || !dasher->seg_ext || !dasher->SegName || !dasher->tracks || !dasher->mpd_segs) {
+		gf_dash_live_del(dasher);
+		return NULL;
+	}
+	dasher->MaxFragmentDuration = (u32) (max_duration_sec * 1000);
+	dasher->MaxSegmentDuration = (u32) (dash_duration_sec * 1000);
+	if (!dasher->MaxFragmentDuration || (dasher->MaxFragmentDuration > dasher->MaxSegmentDuration))
+		dasher->MaxFragmentDuration = dasher->MaxSegmentDuration;
+	dasher->seg_at_rap = seg_at_rap;
+	dasher->fragments_per_sidx = fragments_per_sidx;
+	dasher->daisy_chain_sidx = daisy_chain_sidx;
+	dasher->segments_start_with_rap = 1;
+	dasher->cur_seg = 1;
+
+	sprintf(dasher->SegName, "%s.mp4", output_file);
+	dasher->output = gf_isom_open(dasher->SegName, GF_ISOM_OPEN_WRITE, NULL);
+	if (!dasher->output) {
+		gf_dash_live_del(dasher);
+		return NULL;
+	}
+	return dasher;
+}
+
+GF_EXPORT
+GF_ISOFile *gf_dash_live_get_movie(GF_DASHLiveSegmenter *dasher)
+{
+	return dasher ? dasher->output : NULL;
+}
+
+GF_EXPORT
+GF_Err gf_dash_live_add_track(GF_DASHLiveSegmenter *dasher, GF_ISOFile *input, u32 trackNumber, u32 *TrackID)
+{
+	GF_Err e;
+	u32 TrackNum, mtype, _w, _h, _sr, _nb_ch;
+	u32 defaultDuration, defaultSize, defaultDescriptionIndex, defaultRandomAccess;
+	u8 defaultPadding;
+	u16 defaultDegradationPriority;
+	LiveTrackFragmenter *tf;
+
+	if (!dasher || dasher->setup_done) return GF_BAD_PARAM;
+
+	if (input) {
+		if (!gf_list_count(dasher->tracks) && !gf_isom_get_track_count(dasher->output)) {
+			e = gf_isom_clone_movie(input, dasher->output, 0, 0);
+			if (e) return e;
+		}
+		e = gf_isom_clone_track(input, trackNumber, dasher->output, 0, &TrackNum);
+		if (e) return e;
+		if (gf_isom_is_track_in_root_od(input, trackNumber)) gf_isom_add_track_to_root_od(dasher->output, TrackNum);
+		/*live sources have no meaningful edit list*/
+		gf_isom_remove_edit_segments(dasher->output, TrackNum);
+		gf_isom_get_fragment_defaults(input, trackNumber, &defaultDuration, &defaultSize, &defaultDescriptionIndex, &defaultRandomAccess, &defaultPadding, &defaultDegradationPriority);
+	} else {
+		TrackNum = trackNumber;
+		if (!gf_isom_get_track_id(dasher->output, TrackNum)) return GF_BAD_PARAM;
+		defaultDuration = defaultSize = defaultRandomAccess = defaultPadding = defaultDegradationPriority = 0;
+		defaultDescriptionIndex = 1;
+	}
+
+	e = gf_isom_setup_track_fragment(dasher->output, gf_isom_get_track_id(dasher->output, TrackNum),
+				defaultDescriptionIndex, defaultDuration,
+				defaultSize, (u8) defaultRandomAccess,
+				defaultPadding, defaultDegradationPriority);
+	if (e) return e;
+
+	GF_SAFEALLOC(tf, LiveTrackFragmenter);
+	if (!tf) return GF_OUT_OF_MEM;
+	tf->samples = gf_list_new();
+	tf->TrackID = gf_isom_get_track_id(dasher->output, TrackNum);
+	tf->TimeScale = gf_isom_get_media_timescale(dasher->output, TrackNum);
+	tf->MediaType = mtype = gf_isom_get_media_type(dasher->output, TrackNum);
+	tf->DefaultDuration = defaultDuration;
+	tf->input = input;
+	tf->OriginalTrack = trackNumber;
+	gf_list_add(dasher->tracks, tf);
+
+	/*reference track is the first visual track, or the first track*/
+	if (!dasher->tfref || ((mtype==GF_ISOM_MEDIA_VISUAL) && (dasher->tfref->MediaType!=GF_ISOM_MEDIA_VISUAL)) )
+		dasher->tfref = tf;
+
+	switch (mtype) {
+	case GF_ISOM_MEDIA_TEXT:
+		gf_isom_get_media_language(dasher->output, TrackNum, dasher->langCode);
+	case GF_ISOM_MEDIA_VISUAL:
+	case GF_ISOM_MEDIA_SCENE:
+	case GF_ISOM_MEDIA_DIMS:
+		gf_isom_get_track_layout_info(dasher->output, TrackNum, &_w, &_h, NULL, NULL, NULL);
+		if (_w>dasher->width) dasher->width = _w;
+		if (_h>dasher->height) dasher->height = _h;
+		break;
+	case GF_ISOM_MEDIA_AUDIO:
+		_sr = _nb_ch = 0;
+		gf_isom_get_audio_info(dasher->output, TrackNum, 1, &_sr, &_nb_ch, NULL);
+		if (_sr>dasher->sample_rate) dasher->sample_rate=_sr;
+		if (_nb_ch>dasher->nb_channels) dasher->nb_channels = _nb_ch;
+		gf_isom_get_media_language(dasher->output, TrackNum, dasher->langCode);
+		break;
+	}
+	if (TrackID) *TrackID = tf->TrackID;
+	return GF_OK;
+}
+
+static Double dash_live_get_duration(GF_DASHLiveSegmenter *dasher)
+{
+	u32 i;
+	Double dur, max_dur = 0;
+	for (i=0; i<gf_list_count(dasher->tracks); i++) {
+		LiveTrackFragmenter *tf = gf_list_get(dasher->tracks, i);
+		dur = ((Double) (s64) tf->next_sample_dts) / tf->TimeScale;
+		if (dur>max_dur) max_dur = dur;
+	}
+	return max_dur;
+}
+
+/*rewrites the MPD with all segments produced so far*/
+static GF_Err dash_live_write_mpd(GF_DASHLiveSegmenter *dasher, Bool is_final)
+{
+	u32 h, m, bandwidth;
+	Double s, duration;
+	char buffer[1000];
+	FILE *mpd, *rep;
+
+	rep = gf_temp_file_new();
+	if (!rep) return GF_IO_ERR;
+	sprintf(dasher->SegName, "%s.mpd", dasher->output_file);
+	mpd = gf_f64_open(dasher->SegName, "wt");
+	if (!mpd) {
+		fclose(rep);
+		return GF_IO_ERR;
+	}
+
+	duration = dash_live_get_duration(dasher);
+	bandwidth = duration ? (u32) (dasher->file_size * 8 / duration) : 0;
+
+	fprintf(rep, "  <Representation mimeType=\"video/mp4\"");
+	if (dasher->width && dasher->height) fprintf(rep, " width=\"%d\" height=\"%d\"", dasher->width, dasher->height);
+	if (dasher->sample_rate && dasher->nb_channels) fprintf(rep, " sampleRate=\"%d\" numChannels=\"%d\"", dasher->sample_rate, dasher->nb_channels);
+	if (dasher->langCode[0]) fprintf(rep, " lang=\"%s\"", dasher->langCode);
+	fprintf(rep, " startWithRAP=\"%s\"", (dasher->segments_start_with_rap || dasher->seg_at_rap) ? "true" : "false");
+	fprintf(rep, " bandwidth=\"%d\"", bandwidth);
+	fprintf(rep, " minBufferTime=\"%d\"", dasher->MaxFragmentDuration);
+	fprintf(rep, ">\n");
+
+	s = ((Double) dasher->MaxSegmentDuration) / 1000;
+	h = (u32) (s/3600);
+	m = (u32) (s-h*3600)/60;
+	s = s - h*3600 - m*60;
+	if (m) {
+		fprintf(rep, "   <SegmentInfo duration=\"PT%dM%.2fS\"", m, s);	
+	} else {
+		fprintf(rep, "   <SegmentInfo duration=\"PT%.2fS\"", s);	
+	}
+	fprintf(rep, ">\n");
+	fprintf(rep, "    <InitialisationSegmentURL sourceURL=\"%s.mp4\"", dasher->output_file);	
+	if (!dasher->seg_rad_name) fprintf(rep, " range=\"0-"LLD"\"", dasher->init_seg_size);
+	fprintf(rep, "/>\n");
+
+	gf_f64_seek(dasher->mpd_segs, 0, SEEK_SET);
+	while (!feof(dasher->mpd_segs)) {
+		u32 r = fread(buffer, 1, 1000, dasher->mpd_segs);
+		if (!r) break;
+		fwrite(buffer, 1, r, rep);
+	}
+	gf_f64_seek(dasher->mpd_segs, 0, SEEK_END);
+
+	fprintf(rep, "   </SegmentInfo>\n");
+	fprintf(rep, "  </Representation>\n");
+
+	dash_write_mpd(mpd, is_final ? "OnDemand" : "Live", dasher->output_file, duration, &rep, 1);
+	fclose(rep);
+	fclose(mpd);
+	return GF_OK;
+}
+
+static GF_Err dash_live_close_segment(GF_DASHLiveSegmenter *dasher, Bool last_segment)
+{
+	GF_Err e;
+	u64 end_range;
+	e = gf_isom_close_segment(dasher->output, dasher->fragments_per_sidx, dasher->tfref->TrackID, dasher->seg_start_dts, dasher->daisy_chain_sidx, last_segment);
+	dasher->in_segment = 0;
+	if (e) return e;
+
+	if (!dasher->seg_rad_name) {
+		end_range = gf_isom_get_file_size(dasher->output);
+		fprintf(dasher->mpd_segs, "    <Url range=\""LLD"-"LLD"\"/>\n", dasher->start_range, end_range);	
+		dasher->file_size = end_range;
+	} else {
+		fprintf(dasher->mpd_segs, "    <Url sourceURL=\"%s_seg%d.%s\"/>\n", dasher->seg_rad_name, dasher->cur_seg-1, dasher->seg_ext);	
+		dasher->file_size += gf_isom_get_file_size(dasher->output);
+	}
+	fflush(dasher->mpd_segs);
+	/*the segment is complete: advertise it*/
+	return dash_live_write_mpd(dasher, last_segment);
+}
+
+/*writes a fragment with all queued samples decoded before ref_bound (in the reference track timescale), or all
+queued samples if flush_all is set*/
+static GF_Err dash_live_write_fragment(GF_DASHLiveSegmenter *dasher, u64 ref_bound, Bool flush_all)
+{
+	GF_Err e;
+	u32 i;
+	LiveSample *ls;
+	LiveTrackFragmenter *tf;
+	LiveTrackFragmenter *tfref = dasher->tfref;
+
+	if (!dasher->in_segment) {
+		dasher->start_range = gf_isom_get_file_size(dasher->output);
+		if (dasher->seg_rad_name) {
+			sprintf(dasher->SegName, "%s_seg%d.%s", dasher->seg_rad_name, dasher->cur_seg, dasher->seg_ext);
+			e = gf_isom_start_segment(dasher->output, dasher->SegName);
+		} else {
+			e = gf_isom_start_segment(dasher->output, NULL);
+		}
+		if (e) return e;
+		dasher->cur_seg++;
+		dasher->in_segment = 1;
+		dasher->seg_start_dts = tfref->next_sample_dts;
+		ls = gf_list_get(tfref->samples, 0);
+		if (!ls || !ls->samp->IsRAP) dasher->segments_start_with_rap = 0;
+	}
+
+	e = gf_isom_start_fragment(dasher->output, 1);
+	if (e) return e;
+
+	for (i=0; i<gf_list_count(dasher->tracks); i++) {
+		tf = (LiveTrackFragmenter *)gf_list_get(dasher->tracks, i);
+		gf_isom_set_traf_base_media_decode_time(dasher->output, tf->TrackID, tf->next_sample_dts);
+
+		while ((ls = (LiveSample *)gf_list_get(tf->samples, 0)) ) {
+			if (!flush_all && (ls->samp->DTS * tfref->TimeScale >= ref_bound * tf->TimeScale)) break;
+
+			e = gf_isom_fragment_add_sample(dasher->output, tf->TrackID, ls->samp, ls->descIndex, ls->duration, ls->padding, 0);
+			if (e) return e;
+			tf->next_sample_dts = ls->samp->DTS + ls->duration;
+			gf_list_rem(tf->samples, 0);
+			gf_isom_sample_del(&ls->samp);
+			gf_free(ls);
+		}
+	}
+	dasher->frag_start_dts = ref_bound;
+	return GF_OK;
+}
+
+/*queues the pending sample of the track, its duration being given by the DTS of the next sample if known. 
+Fragment and segment boundaries are decided when samples of the reference track are queued*/
+static GF_Err dash_live_queue_pending(GF_DASHLiveSegmenter *dasher, LiveTrackFragmenter *tf, u64 next_dts, Bool has_next)
+{
+	GF_Err e;
+	LiveSample *ls;
+	GF_ISOSample *samp = tf->pending.samp;
+
+	if (!samp) return GF_OK;
+
+	ls = (LiveSample *)gf_malloc(sizeof(LiveSample));
+	if (!ls) return GF_OUT_OF_MEM;
+	*ls = tf->pending;
+	tf->pending.samp = NULL;
+
+	if (has_next && (next_dts > samp->DTS)) ls->duration = (u32) (next_dts - samp->DTS);
+	else if (tf->last_duration) ls->duration = tf->last_duration;
+	else ls->duration = tf->DefaultDuration ? tf->DefaultDuration : 1;
+	tf->last_duration = ls->duration;
+
+	if (!tf->has_dts) {
+		tf->next_sample_dts = samp->DTS;
+		tf->has_dts = 1;
+		if (tf==dasher->tfref) dasher->seg_start_dts = dasher->frag_start_dts = samp->DTS;
+	}
+
+	if ((tf==dasher->tfref) && gf_list_count(tf->samples)) {
+		u64 seg_elapsed = samp->DTS - dasher->seg_start_dts;
+		u64 frag_elapsed = samp->DTS - dasher->frag_start_dts;
+		Bool seg_due = (seg_elapsed*1000 >= (u64) dasher->MaxSegmentDuration*tf->TimeScale) && (!dasher->seg_at_rap || samp->IsRAP);
+
+		if (seg_due || (frag_elapsed*1000 >= (u64) dasher->MaxFragmentDuration*tf->TimeScale)) {
+			e = dash_live_write_fragment(dasher, samp->DTS, 0);
+			if (!e && seg_due) e = dash_live_close_segment(dasher, 0);
+			if (e) {
+				gf_isom_sample_del(&ls->samp);
+				gf_free(ls);
+				return e;
+			}
+		}
+	}
+	return gf_list_add(tf->samples, ls);
+}
+
+/*takes ownership of the sample*/
+static GF_Err dash_live_push_sample(GF_DASHLiveSegmenter *dasher, LiveTrackFragmenter *tf, GF_ISOSample *samp, u32 descIndex, u8 padding)
+{
+	GF_Err e;
+	if (!dasher->setup_done) {
+		if (!dasher->tfref) {
+			gf_isom_sample_del(&samp);
+			return GF_BAD_PARAM;
+		}
+		/*write the initialization segment*/
+		e = gf_isom_finalize_for_fragment(dasher->output, 1);
+		if (e) {
+			gf_isom_sample_del(&samp);
+			return e;
+		}
+		dasher->init_seg_size = dasher->file_size = gf_isom_get_file_size(dasher->output);
+		dasher->setup_done = 1;
+	}
+	if (tf->pending.samp && (samp->DTS <= tf->pending.samp->DTS)) {
+		GF_LOG(GF_LOG_WARNING, GF_LOG_AUTHOR, ("[DASH] Track %d: non increasing DTS "LLD" - previous "LLD"\n", tf->TrackID, samp->DTS, tf->pending.samp->DTS));
+	}
+	e = dash_live_queue_pending(dasher, tf, samp->DTS, 1);
+	if (e) {
+		gf_isom_sample_del(&samp);
+		return e;
+	}
+	tf->pending.samp = samp;
+	tf->pending.descIndex = descIndex ? descIndex : 1;
+	tf->pending.padding = padding;
+	return GF_OK;
+}
+
+static LiveTrackFragmenter *dash_live_get_track(GF_DASHLiveSegmenter *dasher, u32 TrackID)
+{
+	u32 i;
+	for (i=0; i<gf_list_count(dasher->tracks); i++) {
+		LiveTrackFragmenter *tf = gf_list_get(dasher->tracks, i);
+		if (tf->TrackID==TrackID) return tf;
+	}
+	return NULL;
+}
+
+GF_EXPORT
+GF_Err gf_dash_live_add_sample(GF_DASHLiveSegmenter *dasher, u32 TrackID, GF_ISOSample *sample, u32 sampleDescriptionIndex, u8 padding_bits)
+{
+	GF_ISOSample *samp;
+	LiveTrackFragmenter *tf;
+	if (!dasher || !sample) return GF_BAD_PARAM;
+	tf = dash_live_get_track(dasher, TrackID);
+	if (!tf) return GF_BAD_PARAM;
+
+	/*the sample is kept until its fragment is written*/
+	samp = gf_isom_sample_new();
+	if (!samp) return GF_OUT_OF_MEM;
+	samp->DTS = sample->DTS;
+	samp->CTS_Offset = sample->CTS_Offset;
+	samp->IsRAP = sample->IsRAP;
+	if (sample->dataLength) {
+		samp->data = gf_malloc(sizeof(char) * sample->dataLength);
+		if (!samp->data) {
+			gf_isom_sample_del(&samp);
+			return GF_OUT_OF_MEM;
+		}
+		memcpy(samp->data, sample->data, sample->dataLength);
+		samp->dataLength = sample->dataLength;
+	}
+	return dash_live_push_sample(dasher, tf, samp, sampleDescriptionIndex, padding_bits);
+}
+
+GF_EXPORT
+GF_Err gf_dash_live_process_input(GF_DASHLiveSegmenter *dasher, GF_ISOFile *input)
+{
+	GF_Err e;
+	u64 missing;
+	u32 i, descIndex;
+	u8 NbBits;
+	if (!dasher || !input) return GF_BAD_PARAM;
+
+	/*load new fragments*/
+	if (gf_isom_is_fragmented(input)) {
+		e = gf_isom_refresh_fragmented(input, &missing);
+		if (e && (e != GF_ISOM_INCOMPLETE_FILE)) return e;
+	}
+
+	/*interleave available samples of all tracks in decoding order*/
+	while (1) {
+		GF_ISOSample *samp;
+		Double dts, min_dts = 0;
+		LiveTrackFragmenter *tf = NULL;
+		for (i=0; i<gf_list_count(dasher->tracks); i++) {
+			LiveTrackFragmenter *atf = gf_list_get(dasher->tracks, i);
+			if (atf->input != input) continue;
+			if (atf->SampleNum >= gf_isom_get_sample_count(input, atf->OriginalTrack)) continue;
+			dts = ((Double) (s64) gf_isom_get_sample_dts(input, atf->OriginalTrack, atf->SampleNum+1)) / atf->TimeScale;
+			if (!tf || (dts < min_dts)) {
+				tf = atf;
+				min_dts = dts;
+			}
+		}
+		if (!tf) {
+			/*all loaded samples are consumed: drop their tables so that a long live input does not grow in memory*/
+			if (gf_isom_is_fragmented(input)) gf_isom_reset_tables(input);
+			break;
+		}
+
+		samp = gf_isom_get_sample(input, tf->OriginalTrack, tf->SampleNum+1, &descIndex);
+		if (!samp) {
+			e = gf_isom_last_error(input);
+			/*data not yet available, retry at next call*/
+			if (e == GF_ISOM_INCOMPLETE_FILE) return GF_OK;
+			return e ? e : GF_IO_ERR;
+		}
+		NbBits = 0;
+		gf_isom_get_sample_padding_bits(input, tf->OriginalTrack, tf->SampleNum+1, &NbBits);
+		tf->SampleNum++;
+		e = dash_live_push_sample(dasher, tf, samp, descIndex, NbBits);
+		if (e) return e;
+	}
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_Err gf_dash_live_close(GF_DASHLiveSegmenter *dasher)
+{
+	u32 i;
+	GF_Err e;
+	Bool has_samples = 0;
+	if (!dasher) return GF_BAD_PARAM;
+	if (!dasher->setup_done) return GF_OK;
+
+	for (i=0; i<gf_list_count(dasher->tracks); i++) {
+		LiveTrackFragmenter *tf = gf_list_get(dasher->tracks, i);
+		e = dash_live_queue_pending(dasher, tf, 0, 0);
+		if (e) return e;
+		if (gf_list_count(tf->samples)) has_samples = 1;
+	}
+	if (has_samples) {
+		e = dash_live_write_fragment(dasher, 0, 1);
+		if (e) return e;
+	}
+	if (dasher->in_segment) return dash_live_close_segment(dasher, 1);
+	return dash_live_write_mpd(dasher, 1);
+}
+
+GF_EXPORT
+void gf_dash_live_del(GF_DASHLiveSegmenter *dasher)
+{
+	if (!dasher) return;
+	if (dasher->tracks) {
+		while (gf_list_count(dasher->tracks)) {
+			LiveTrackFragmenter *tf = gf_list_last(dasher->tracks);
+			gf_list_rem_last(dasher->tracks);
+			if (tf->pending.samp) gf_isom_sample_del(&tf->pending.samp);
+			while (gf_list_count(tf->samples)) {
+				LiveSample *ls = gf_list_last(tf->samples);
+				gf_list_rem_last(tf->samples);
+				gf_isom_sample_del(&ls->samp);
+				gf_free(ls);
+			}
+			gf_list_del(tf->samples);
+			gf_free(tf);
+		}
+		gf_list_del(dasher->tracks);
+	}
+	if (dasher->output) gf_isom_close(dasher->output);
+	if (dasher->mpd_segs) fclose(dasher->mpd_segs);
+	if (dasher->output_file) gf_free(dasher->output_file);
+	if (dasher->seg_rad_name) gf_free(dasher->seg_rad_name);
+	if (dasher->seg_ext) gf_free(dasher->seg_ext);
+	if (dasher->SegName) gf_free(dasher->SegName);
+	gf_free(dasher);
+}
+
 GF_EXPORT
 GF_Err gf_media_import_chapters(GF_ISOFile *file, char *chap_file, Double import_fps)
 {
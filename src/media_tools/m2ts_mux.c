@@ -1441,7 +1441,8 @@ u32 gf_m2ts_get_ts_clock(GF_M2TS_Mux *muxer)
 }
 
 
-const char *gf_m2ts_mux_process(GF_M2TS_Mux *muxer, u32 *status)
+/*produces the next packet in dst_pck, or returns the null packet*/
+static const char *gf_m2ts_mux_process_packet(GF_M2TS_Mux *muxer, u32 *status, char *dst_pck)
 {
 	GF_M2TS_Mux_Program *program;
 	GF_M2TS_Mux_Stream *stream, *stream_to_process;
@@ -1567,13 +1568,13 @@ send_pck:
 		}
 	} else {
 		if (stream_to_process->tables) {
-			gf_m2ts_mux_table_get_next_packet(stream_to_process, muxer->dst_pck);
+			gf_m2ts_mux_table_get_next_packet(stream_to_process, dst_pck);
 			GF_LOG(GF_LOG_DEBUG, GF_LOG_CONTAINER, ("[MPEG2-TS Muxer] Send table from PID %d at %d:%09d - mux time %d:%09d\n", stream_to_process->pid, time.sec, time.nanosec, muxer->time.sec, muxer->time.nanosec));
 		} else {
-			gf_m2ts_mux_pes_get_next_packet(stream_to_process, muxer->dst_pck);
+			gf_m2ts_mux_pes_get_next_packet(stream_to_process, dst_pck);
 			GF_LOG(GF_LOG_DEBUG, GF_LOG_CONTAINER, ("[MPEG2-TS Muxer] Send PES from PID %d at %d:%09d - mux time %d:%09d\n", stream_to_process->pid, time.sec, time.nanosec, muxer->time.sec, muxer->time.nanosec));
 		}
-		ret = muxer->dst_pck;
+		ret = dst_pck;
 		*status = GF_M2TS_STATE_DATA;
 	}
 	if (ret) {
@@ -1594,5 +1595,27 @@ send_pck:
 	return ret;
 }
 
+const char *gf_m2ts_mux_process(GF_M2TS_Mux *muxer, u32 *status)
+{
+	return gf_m2ts_mux_process_packet(muxer, status, muxer->dst_pck);
+}
+
+u32 gf_m2ts_mux_process_packets(GF_M2TS_Mux *muxer, char *buffer, u32 nb_packets, u32 *status)
+{
+	const char *pck;
+	u32 nb_done = 0;
+
+	*status = GF_M2TS_STATE_IDLE;
+	while (nb_done < nb_packets) {
+		/*data packets are built in place, only null packets are copied*/
+		pck = gf_m2ts_mux_process_packet(muxer, status, buffer + 188*nb_done);
+		if (!pck) break;
+		if (pck != buffer + 188*nb_done) memcpy(buffer + 188*nb_done, pck, 188);
+		nb_done++;
+		if (*status >= GF_M2TS_STATE_PADDING) break;
+	}
+	return nb_done;
+}
+
 #endif /*GPAC_DISABLE_MPEG2TS_MUX*/
 
@@ -117,9 +117,14 @@ static void gf_m2ts_reframe_avc_h264(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, u64
 
 	while (sc_pos<data_len) {
 		/* u32 sctype=0;*/
-		unsigned char *start = (unsigned char *)memchr(data+sc_pos, 0, data_len-sc_pos);
-		if (!start) break;
-		sc_pos = start - data;
+		unsigned char *start;
+		/*only 2 consecutive zero bytes may start a start code or an escape code*/
+		u32 skip = gf_media_next_zero_pair(data+sc_pos, data_len-sc_pos);
+		if (skip == data_len-sc_pos) break;
+		/*a single zero byte in the skipped data resets the escape code state*/
+		if (skip && esc_code_found && memchr(data+sc_pos, 0, skip)) esc_code_found=0;
+		sc_pos += skip;
+		start = data + sc_pos;
 
 		/*0x00000001 start code*/
 		if (!start[1] && !start[2] && (start[3]==1)) {
@@ -251,9 +256,13 @@ void gf_m2ts_reframe_mpeg_video(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, u64 DTS,
 	pck.flags = 0;
 
 	while (sc_pos+4<data_len) {
-		unsigned char *start = (unsigned char*)memchr(data+sc_pos, 0, data_len-sc_pos);
-		if (!start) break;
-		sc_pos = start - (unsigned char*)data;
+		unsigned char *start;
+		/*the start code value shall be in the buffer*/
+		u32 sc_size;
+		u32 pos = gf_media_nalu_next_start_code(data+sc_pos, data_len-sc_pos-1, &sc_size);
+		if (!sc_size) break;
+		sc_pos += pos + sc_size - 3;
+		start = data + sc_pos;
 
 		/*found picture or sequence start_code*/
 		if (!start[1] && (start[2]==0x01)) {
@@ -654,19 +663,17 @@ static void gf_m2ts_reframe_mpeg_audio(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, u6
 }
 #endif /*GPAC_DISABLE_AV_PARSERS*/
 
-static u32 gf_m2ts_sync(GF_M2TS_Demuxer *ts, Bool simple_check)
+/*locates the next packet start from pos. A sync byte is trusted when two consecutive ones are found,
+or when it starts the incomplete packet at the end of the data*/
+static u32 gf_m2ts_sync(char *data, u32 data_size, u32 pos)
 {
-	u32 i=0;
-	/*if first byte is sync assume we're sync*/
-	if (simple_check && (ts->buffer[i]==0x47)) return 0;
-
-	while (i<ts->buffer_size) {
-		if (i+188>ts->buffer_size) return ts->buffer_size;
-		if ((ts->buffer[i]==0x47) && (ts->buffer[i+188]==0x47)) break;
+	u32 i = pos;
+	while (i<data_size) {
+		if ((data[i]==0x47) && ((i+188>=data_size) || (data[i+188]==0x47))) break;
 		i++;
 	}
-	if (i) {
-		GF_LOG(GF_LOG_DEBUG, GF_LOG_CONTAINER, ("[MPEG-2 TS] re-sync skipped %d bytes\n", i) );
+	if (i>pos) {
+		GF_LOG(GF_LOG_DEBUG, GF_LOG_CONTAINER, ("[MPEG-2 TS] re-sync skipped %d bytes\n", i-pos) );
 	}
 	return i;
 }
@@ -1177,6 +1184,8 @@ static void gf_m2ts_process_nit(GF_M2TS_Demuxer *ts, GF_M2TS_SECTION_ES *nit_es,
 
 }
 
+#define GF_M2TS_PID_ALLOWED(_ts, _pid)	((_ts)->pid_filter[(_pid)>>5] & (1U<<((_pid)&31)))
+
 static void gf_m2ts_process_pmt(GF_M2TS_Demuxer *ts, GF_M2TS_SECTION_ES *pmt, GF_List *sections, u8 table_id, u16 ex_table_id, u8 version_number, u8 last_section_number, u32 status)
 {
 	u32 info_length, pos, desc_len, evt_type, nb_es,i;
@@ -1208,6 +1217,8 @@ static void gf_m2ts_process_pmt(GF_M2TS_Demuxer *ts, GF_M2TS_SECTION_ES *pmt, GF
 	data_size = section->data_size;
 
 	pmt->program->pcr_pid = ((data[0] & 0x1f) << 8) | data[1];
+	if (ts->selected_program && (ts->selected_program == pmt->program->number)) 
+		gf_m2ts_demux_allow_pid(ts, pmt->program->pcr_pid, 1);
 
 	info_length = ((data[2]&0xf)<<8) | data[3];
 	if (info_length != 0) {
@@ -1265,6 +1276,16 @@ static void gf_m2ts_process_pmt(GF_M2TS_Demuxer *ts, GF_M2TS_SECTION_ES *pmt, GF
 		desc_len = ((data[3] & 0xf) << 8) | data[4];
 		reg_desc_format = 0;
 
+		if (ts->pid_filtering) {
+			if (ts->selected_program == pmt->program->number) gf_m2ts_demux_allow_pid(ts, pid, 1);
+			/*filtered out, don't create the stream*/
+			if (!GF_M2TS_PID_ALLOWED(ts, pid)) {
+				pos += 5 + desc_len;
+				data += 5 + desc_len;
+				continue;
+			}
+		}
+
 		switch (stream_type) {
 		  printf("stream_type :%d \n",stream_type);
 		/* PES */
@@ -1463,8 +1484,11 @@ static void gf_m2ts_process_pmt(GF_M2TS_Demuxer *ts, GF_M2TS_SECTION_ES *pmt, GF
 		}
 	}
 	
-	if (nb_es) {
-		if(ts->nb_prog_pmt_received == gf_list_count(ts->programs)){
+	/*the first PMT is always signaled, even if all its streams are filtered out*/
+	if (nb_es || (status&GF_M2TS_TABLE_FOUND)) {
+		if ((ts->nb_prog_pmt_received == gf_list_count(ts->programs)) 
+			/*other PMTs are filtered out*/
+			|| (ts->selected_program == pmt->program->number)) {
 		    ts->all_prog_pmt_received = 1;
 		}
 		evt_type = (status&GF_M2TS_TABLE_FOUND) ? GF_M2TS_EVT_PMT_FOUND : GF_M2TS_EVT_PMT_UPDATE;
@@ -1528,6 +1552,8 @@ static void gf_m2ts_process_pat(GF_M2TS_Demuxer *ts, GF_M2TS_SECTION_ES *ses, GF
 			pmt->program = prog;
 			ts->ess[pmt->pid] = (GF_M2TS_ES *)pmt;
 			pmt->sec = gf_m2ts_section_filter_new(gf_m2ts_process_pmt, 0);
+			/*PMTs always go through the PID filter, unless another program is selected*/
+			if (!ts->selected_program || (ts->selected_program == number)) gf_m2ts_demux_allow_pid(ts, pid, 1);
 		}
 	}
 
@@ -1687,11 +1713,6 @@ static void gf_m2ts_process_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, GF_M2TS_H
 
 	if (hdr->payload_start) {
 		flush_pes = 1;
-		pes->pes_start_packet_number = ts->pck_number;
-		pes->before_last_pcr_value = pes->program->before_last_pcr_value;
-		pes->before_last_pcr_value_pck_number = pes->program->before_last_pcr_value_pck_number;
-		pes->last_pcr_value = pes->program->last_pcr_value;
-		pes->last_pcr_value_pck_number = pes->program->last_pcr_value_pck_number;
 	} else if (pes->pes_len && (pes->data_len + data_size  == pes->pes_len + 6)) {
 		/* 6 = startcode+stream_id+length*/
 		/*reassemble pes*/
@@ -1768,6 +1789,15 @@ static void gf_m2ts_process_pes(GF_M2TS_Demuxer *ts, GF_M2TS_PES *pes, GF_M2TS_H
 		pes->rap = 0;
 		if (!data_size) return;
 	}
+	/*only set once the previous PES is flushed, so that its packets carry their own start and PCR*/
+	if (hdr->payload_start) {
+		pes->pes_start_packet_number = ts->pck_number;
+		pes->pes_start_byte_pos = ts->pck_byte_pos;
+		pes->before_last_pcr_value = pes->program->before_last_pcr_value;
+		pes->before_last_pcr_value_pck_number = pes->program->before_last_pcr_value_pck_number;
+		pes->last_pcr_value = pes->program->last_pcr_value;
+		pes->last_pcr_value_pck_number = pes->program->last_pcr_value_pck_number;
+	}
 	/*we need to wait for first packet of PES*/
 	if (!pes->data_len && !hdr->payload_start) {
 		GF_LOG(GF_LOG_DEBUG, GF_LOG_CONTAINER, ("[MPEG-2 TS] PID %d: Waiting for PES header, trashing data\n", hdr->pid));
@@ -1837,6 +1867,8 @@ static void gf_m2ts_process_packet(GF_M2TS_Demuxer *ts, unsigned char *data)
 	hdr.payload_start = (data[1] & 0x40) ? 1 : 0;
 	hdr.priority = (data[1] & 0x20) ? 1 : 0;
 	hdr.pid = ( (data[1]&0x1f) << 8) | data[2];
+	/*filtered out: nothing more is parsed*/
+	if (ts->pid_filtering && !GF_M2TS_PID_ALLOWED(ts, hdr.pid)) return;
 	hdr.scrambling_ctrl = (data[3] >> 6) & 0x3;
 	hdr.adaptation_field = (data[3] >> 4) & 0x3;
 	hdr.continuity_counter = data[3] & 0xf;
@@ -1942,54 +1974,46 @@ static void gf_m2ts_process_packet(GF_M2TS_Demuxer *ts, unsigned char *data)
 
 GF_Err gf_m2ts_process_data(GF_M2TS_Demuxer *ts, char *data, u32 data_size)
 {
-	u32 pos;
-	Bool is_align = 1;
-	if (ts->buffer) {
-		if (ts->alloc_size < ts->buffer_size+data_size) {
-			ts->alloc_size = ts->buffer_size+data_size;
-			ts->buffer = (char*)gf_realloc(ts->buffer, sizeof(char)*ts->alloc_size);
-		}
-		memcpy(ts->buffer + ts->buffer_size, data, sizeof(char)*data_size);
-		ts->buffer_size += data_size;
-		is_align = 0;
-	} else {
-		ts->buffer = data;
-		ts->buffer_size = data_size;
-	}
+	u32 pos, left;
 
-	/*sync input data*/
-	pos = gf_m2ts_sync(ts, is_align);
-	if (pos==ts->buffer_size) {
-		if (is_align) {
-			ts->buffer = (char*)gf_malloc(sizeof(char)*data_size);
-			memcpy(ts->buffer, data, sizeof(char)*data_size);
-			ts->alloc_size = ts->buffer_size = data_size;
+	pos = 0;
+	/*complete the packet left over by the previous call*/
+	if (ts->buffer_size) {
+		left = 188 - ts->buffer_size;
+		if (data_size < left) {
+			memcpy(ts->buffer + ts->buffer_size, data, sizeof(char)*data_size);
+			ts->buffer_size += data_size;
+			ts->data_pos += data_size;
+			return GF_OK;
 		}
-		return GF_OK;
+		/*only use it if the new data is still in sync, otherwise drop it*/
+		if ((data_size == left) || (data[left]==0x47)) {
+			memcpy(ts->buffer + ts->buffer_size, data, sizeof(char)*left);
+			ts->pck_byte_pos = ts->data_pos - ts->buffer_size;
+			gf_m2ts_process_packet(ts, (unsigned char *) ts->buffer);
+			pos = left;
+		}
+		ts->buffer_size = 0;
 	}
-	for (;;) {
-		/*wait for a complete packet*/
-		if (ts->buffer_size - pos < 188) {
-			ts->buffer_size -= pos;
-			if (!ts->buffer_size) {
-				if (!is_align) gf_free(ts->buffer);
-				ts->buffer = NULL;
-				return GF_OK;
-			}
-			if (is_align) {
-				data = ts->buffer+pos;
-				ts->buffer = (char*)gf_malloc(sizeof(char)*ts->buffer_size);
-				memcpy(ts->buffer, data, sizeof(char)*ts->buffer_size);
-				ts->alloc_size = ts->buffer_size;
-			} else {
-				memmove(ts->buffer, ts->buffer + pos, sizeof(char)*ts->buffer_size);
-			}
-			return GF_OK;
+
+	/*process packets straight from the input, only resync when a packet does not start with a sync byte*/
+	while (pos + 188 <= data_size) {
+		if (data[pos] != 0x47) {
+			pos = gf_m2ts_sync(data, data_size, pos);
+			if (pos + 188 > data_size) break;
 		}
-		/*process*/		
-		gf_m2ts_process_packet(ts, ts->buffer+pos);
+		ts->pck_byte_pos = ts->data_pos + pos;
+		gf_m2ts_process_packet(ts, (unsigned char *) data+pos);
 		pos += 188;
 	}
+
+	/*keep the incomplete packet*/
+	if (pos < data_size) {
+		if (data[pos] != 0x47) pos = gf_m2ts_sync(data, data_size, pos);
+		ts->buffer_size = data_size - pos;
+		if (ts->buffer_size) memcpy(ts->buffer, data+pos, sizeof(char)*ts->buffer_size);
+	}
+	ts->data_pos += data_size;
 	return GF_OK;
 }
 
@@ -2151,6 +2175,98 @@ GF_Err gf_m2ts_set_pes_framing(GF_M2TS_PES *pes, u32 mode)
 	return GF_OK;
 }
 
+void gf_m2ts_demux_allow_pid(GF_M2TS_Demuxer *ts, u32 pid, Bool allow)
+{
+	if (pid >= GF_M2TS_MAX_STREAMS) return;
+	if (allow) ts->pid_filter[pid>>5] |= 1U<<(pid&31);
+	else ts->pid_filter[pid>>5] &= ~(1U<<(pid&31));
+}
+
+void gf_m2ts_demux_set_pid_filtering(GF_M2TS_Demuxer *ts, Bool enable)
+{
+	u32 i, count;
+	ts->pid_filtering = enable;
+	if (!enable) return;
+	/*the PAT is always needed, and so are the PMTs unless a program is selected*/
+	gf_m2ts_demux_allow_pid(ts, GF_M2TS_PID_PAT, 1);
+	/*PAT already received*/
+	count = gf_list_count(ts->programs);
+	for (i=0; i<count; i++) {
+		GF_M2TS_Program *prog = (GF_M2TS_Program *)gf_list_get(ts->programs, i);
+		if (!ts->selected_program || (prog->number == ts->selected_program)) gf_m2ts_demux_allow_pid(ts, prog->pmt_pid, 1);
+	}
+}
+
+void gf_m2ts_demux_select_program(GF_M2TS_Demuxer *ts, u32 program_number)
+{
+	ts->selected_program = program_number;
+	gf_m2ts_demux_set_pid_filtering(ts, 1);
+}
+
+/*receive ring between the receive thread and the demux worker, with a single producer and a single consumer and
+no lock where a memory barrier is available. Positions are byte offsets in [0, size[ and one byte is always left free 
+to tell a full ring from an empty one*/
+#define GF_M2TS_RING_PACKETS	8192
+/*max packets demuxed by the worker before giving the room back to the receive thread*/
+#define GF_M2TS_RING_BATCH	64
+
+#if defined(__GNUC__)
+#define GF_M2TS_RING_LOCK_FREE
+#define GF_M2TS_MEMORY_BARRIER()	__sync_synchronize()
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define GF_M2TS_RING_LOCK_FREE
+/*x86 and x64 only: they do not reorder stores with stores nor loads with loads, so only the compiler must be prevented 
+from doing so. Other targets use the locked path*/
+#define GF_M2TS_MEMORY_BARRIER()	_ReadWriteBarrier()
+#endif
+
+#ifdef GF_M2TS_RING_LOCK_FREE
+#define GF_M2TS_RING_LOCK(_ring)
+#define GF_M2TS_RING_UNLOCK(_ring)
+#else
+/*positions are exchanged under the ring mutex, which also orders the accesses to the data*/
+#define GF_M2TS_MEMORY_BARRIER()
+#define GF_M2TS_RING_LOCK(_ring)	gf_mx_p((_ring)->mx)
+#define GF_M2TS_RING_UNLOCK(_ring)	gf_mx_v((_ring)->mx)
+#endif
+
+typedef struct __m2ts_pck_ring
+{
+	char *data;
+	u32 size;
+	volatile u32 read_pos, write_pos;
+	/*signaled by the receive thread when data is pushed, the worker waits on it when the ring is empty*/
+	GF_Semaphore *data_sema;
+#ifndef GF_M2TS_RING_LOCK_FREE
+	GF_Mutex *mx;
+#endif
+} GF_M2TS_PacketRing;
+
+static void gf_m2ts_ring_del(GF_M2TS_PacketRing *ring)
+{
+	if (ring->data_sema) gf_sema_del(ring->data_sema);
+#ifndef GF_M2TS_RING_LOCK_FREE
+	if (ring->mx) gf_mx_del(ring->mx);
+#endif
+	if (ring->data) gf_free(ring->data);
+	gf_free(ring);
+}
+
+static u32 gf_m2ts_ring_used(GF_M2TS_PacketRing *ring, u32 read_pos, u32 write_pos)
+{
+	return (write_pos>=read_pos) ? (write_pos - read_pos) : (ring->size - read_pos + write_pos);
+}
+
+void gf_m2ts_demux_get_ring_stats(GF_M2TS_Demuxer *ts, u32 *occupancy, u32 *max_occupancy, u32 *capacity, u32 *drops)
+{
+	GF_M2TS_PacketRing *ring = ts->ring;
+	if (occupancy) *occupancy = ring ? gf_m2ts_ring_used(ring, ring->read_pos, ring->write_pos) / 188 : 0;
+	if (max_occupancy) *max_occupancy = ts->ring_max_occupancy;
+	if (capacity) *capacity = ring ? (ring->size - 1) / 188 : 0;
+	if (drops) *drops = ts->ring_drops;
+}
+
 GF_M2TS_Demuxer *gf_m2ts_demux_new()
 {
 	GF_M2TS_Demuxer *ts;
@@ -2190,7 +2306,6 @@ void gf_m2ts_demux_del(GF_M2TS_Demuxer *ts)
 	for (i=0; i<GF_M2TS_MAX_STREAMS; i++) {
 		if (ts->ess[i]) gf_m2ts_es_del(ts->ess[i]);
 	}
-	if (ts->buffer) gf_free(ts->buffer);
 	while (gf_list_count(ts->programs)) {
 		GF_M2TS_Program *p = (GF_M2TS_Program *)gf_list_last(ts->programs);
 		gf_list_rem_last(ts->programs);
@@ -2208,6 +2323,8 @@ void gf_m2ts_demux_del(GF_M2TS_Demuxer *ts)
 	gf_m2ts_reset_sdt(ts);
 	gf_list_del(ts->SDTs);
 
+	if (ts->ring) gf_m2ts_ring_del(ts->ring);
+
 #ifdef DUMP_MPE_IP_DATAGRAMS
 	gf_dvb_mpe_shutdown(ts);
 #endif
@@ -2223,8 +2340,404 @@ void gf_m2ts_print_info(GF_M2TS_Demuxer *ts)
 }
 
 
+/*TS seek index*/
+
+/*minimal PTS distance between two index entries, 90 kHz*/
+#define GF_M2TS_INDEX_MIN_INTERVAL	45000
+/*TS packets read at once by the index builder*/
+#define GF_M2TS_INDEX_READ_PACKETS	1024
+#define GF_M2TS_INDEX_VERSION	2
+
+/*brings a 33 bits PTS in the unwrapped time line of ref*/
+static u64 gf_m2ts_index_unwrap(u64 ref, u64 pts)
+{
+	u64 wrap = ((u64) 1) << 33;
+	u64 res = (ref & ~(wrap-1)) | (pts & (wrap-1));
+	if (res + wrap/2 < ref) res += wrap;
+	else if ((res > ref + wrap/2) && (res >= wrap)) res -= wrap;
+	return res;
+}
+
+static Bool gf_m2ts_index_is_video(u32 stream_type)
+{
+	switch (stream_type) {
+	case GF_M2TS_VIDEO_MPEG1:
+	case GF_M2TS_VIDEO_MPEG2:
+	case GF_M2TS_VIDEO_MPEG4:
+	case GF_M2TS_VIDEO_H264:
+	case GF_M2TS_VIDEO_VC1:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static void gf_m2ts_index_on_event(GF_M2TS_Demuxer *ts, u32 evt_type, void *par)
+{
+	GF_M2TS_Index *idx = (GF_M2TS_Index *) ts->user;
+
+	switch (evt_type) {
+	case GF_M2TS_EVT_PMT_FOUND:
+	case GF_M2TS_EVT_PMT_UPDATE:
+	{
+		u32 i, count;
+		GF_M2TS_Program *prog = (GF_M2TS_Program *) par;
+		if (idx->program_number && (idx->program_number != prog->number)) break;
+		count = gf_list_count(prog->streams);
+		if (!idx->pid) {
+			for (i=0; i<count; i++) {
+				GF_M2TS_ES *es = (GF_M2TS_ES *)gf_list_get(prog->streams, i);
+				if (es->flags & GF_M2TS_ES_IS_SECTION) continue;
+				if (!idx->pid || gf_m2ts_index_is_video(es->stream_type)) idx->pid = es->pid;
+				if (gf_m2ts_index_is_video(es->stream_type)) break;
+			}
+			if (!idx->pid) break;
+		}
+		idx->program_number = prog->number;
+		/*only the PMT, the PCR and the indexed stream are needed*/
+		gf_m2ts_demux_set_pid_filtering(ts, 1);
+		gf_m2ts_demux_allow_pid(ts, prog->pmt_pid, 1);
+		gf_m2ts_demux_allow_pid(ts, prog->pcr_pid, 1);
+		gf_m2ts_demux_allow_pid(ts, idx->pid, 1);
+		for (i=0; i<count; i++) {
+			GF_M2TS_ES *es = (GF_M2TS_ES *)gf_list_get(prog->streams, i);
+			if (es->pid == idx->pid) gf_m2ts_set_pes_framing((GF_M2TS_PES *)es, GF_M2TS_PES_FRAMING_DEFAULT);
+		}
+	}
+		break;
+	case GF_M2TS_EVT_PES_PCK:
+	{
+		u64 pts;
+		GF_M2TS_PES_PCK *pck = (GF_M2TS_PES_PCK *) par;
+		if (pck->stream->pid != idx->pid) break;
+
+		if (!idx->has_pts) {
+			idx->has_pts = 1;
+			idx->first_pts = idx->last_pts = pck->PTS;
+		}
+		pts = gf_m2ts_index_unwrap(idx->last_pts, pck->PTS);
+		if (pts > idx->last_pts) idx->last_pts = pts;
+
+		if (!(pck->flags & GF_M2TS_PES_PCK_RAP)) break;
+		if (pts < idx->first_pts) break;
+		if (idx->nb_entries && (pts < idx->entries[idx->nb_entries-1].pts + GF_M2TS_INDEX_MIN_INTERVAL)) break;
+		if (idx->nb_entries == idx->alloc_entries) {
+			u32 alloc = idx->alloc_entries ? 2*idx->alloc_entries : 256;
+			GF_M2TS_IndexEntry *entries = (GF_M2TS_IndexEntry *)gf_realloc(idx->entries, sizeof(GF_M2TS_IndexEntry)*alloc);
+			/*out of memory: the index stays coarser but valid*/
+			if (!entries) break;
+			idx->entries = entries;
+			idx->alloc_entries = alloc;
+		}
+		/*byte positions are counted from where this demuxer started*/
+		idx->entries[idx->nb_entries].offset = idx->demux_start + pck->stream->pes_start_byte_pos;
+		idx->entries[idx->nb_entries].pts = pts;
+		idx->entries[idx->nb_entries].pcr = pck->stream->last_pcr_value;
+		idx->nb_entries++;
+	}
+		break;
+	}
+}
+
+GF_M2TS_Index *gf_m2ts_index_new()
+{
+	GF_M2TS_Index *idx;
+	GF_SAFEALLOC(idx, GF_M2TS_Index);
+	if (!idx) return NULL;
+	idx->mx = gf_mx_new("M2TS Index");
+	return idx;
+}
+
+void gf_m2ts_index_del(GF_M2TS_Index *idx)
+{
+	if (idx->demux) gf_m2ts_demux_del(idx->demux);
+	if (idx->entries) gf_free(idx->entries);
+	if (idx->buffer) gf_free(idx->buffer);
+	gf_mx_del(idx->mx);
+	gf_free(idx);
+}
+
+GF_Err gf_m2ts_index_update(GF_M2TS_Index *idx, FILE *ts_file, u64 max_size)
+{
+	u64 done = 0;
+
+	if (!idx->buffer) {
+		idx->buffer = (char *)gf_malloc(sizeof(char)*188*GF_M2TS_INDEX_READ_PACKETS);
+		if (!idx->buffer) return GF_OUT_OF_MEM;
+	}
+	if (!idx->demux) {
+		idx->demux = gf_m2ts_demux_new();
+		idx->demux->on_event = gf_m2ts_index_on_event;
+		idx->demux->user = idx;
+		idx->demux_start = idx->indexed_size;
+	}
+
+	while (!max_size || (done < max_size)) {
+		u32 size;
+		gf_f64_seek(ts_file, idx->indexed_size, SEEK_SET);
+		size = (u32) fread(idx->buffer, 1, 188*GF_M2TS_INDEX_READ_PACKETS, ts_file);
+		/*a growing file may end with a partial packet, it is indexed with the next call*/
+		size -= size % 188;
+		if (!size) break;
+
+		gf_mx_p(idx->mx);
+		gf_m2ts_process_data(idx->demux, idx->buffer, size);
+		idx->indexed_size += size;
+		gf_mx_v(idx->mx);
+		done += size;
+	}
+	return done ? GF_OK : GF_EOS;
+}
+
+GF_Err gf_m2ts_index_find(GF_M2TS_Index *idx, Double start, u64 *offset, u64 *pts)
+{
+	u32 low, high;
+	u64 target;
+	GF_Err e = GF_OK;
+
+	gf_mx_p(idx->mx);
+	if (!idx->nb_entries) {
+		if (offset) *offset = 0;
+		if (pts) *pts = idx->first_pts;
+		gf_mx_v(idx->mx);
+		return GF_EOS;
+	}
+	target = idx->first_pts + (u64) (start * 90000);
+	if (target > idx->last_pts) e = GF_EOS;
+
+	/*entries[low] is the last one at or before the target, or the first one*/
+	low = 0;
+	high = idx->nb_entries;
+	while (low + 1 < high) {
+		u32 mid = (low + high) / 2;
+		if (idx->entries[mid].pts <= target) low = mid;
+		else high = mid;
+	}
+	if (offset) *offset = idx->entries[low].offset;
+	if (pts) *pts = idx->entries[low].pts;
+	gf_mx_v(idx->mx);
+	return e;
+}
+
+Double gf_m2ts_index_get_duration(GF_M2TS_Index *idx)
+{
+	Double dur;
+	gf_mx_p(idx->mx);
+	dur = idx->has_pts ? ((Double) (s64) (idx->last_pts - idx->first_pts)) / 90000 : 0;
+	gf_mx_v(idx->mx);
+	return dur;
+}
+
+GF_Err gf_m2ts_index_save(GF_M2TS_Index *idx, const char *file_name)
+{
+	u32 i;
+	GF_BitStream *bs;
+	FILE *f = gf_f64_open(file_name, "wb");
+	if (!f) return GF_IO_ERR;
+	bs = gf_bs_from_file(f, GF_BITSTREAM_WRITE);
+
+	gf_mx_p(idx->mx);
+	gf_bs_write_u32(bs, GF_4CC('G','T','S','I'));
+	gf_bs_write_u8(bs, GF_M2TS_INDEX_VERSION);
+	gf_bs_write_u16(bs, idx->program_number);
+	gf_bs_write_u16(bs, idx->pid);
+	gf_bs_write_u64(bs, idx->first_pts);
+	gf_bs_write_u64(bs, idx->last_pts);
+	gf_bs_write_u64(bs, idx->indexed_size);
+	gf_bs_write_u64(bs, idx->source_size);
+	gf_bs_write_u64(bs, idx->source_mtime);
+	gf_bs_write_u32(bs, idx->nb_entries);
+	/*offsets are byte positions, the file may not start on a packet boundary*/
+	for (i=0; i<idx->nb_entries; i++) {
+		gf_bs_write_u64(bs, idx->entries[i].offset);
+		gf_bs_write_u64(bs, idx->entries[i].pts);
+		gf_bs_write_u64(bs, idx->entries[i].pcr);
+	}
+	gf_mx_v(idx->mx);
+
+	gf_bs_del(bs);
+	fclose(f);
+	return GF_OK;
+}
+
+GF_Err gf_m2ts_index_load(GF_M2TS_Index *idx, const char *file_name)
+{
+	u32 i, nb_entries;
+	GF_Err e = GF_OK;
+	GF_BitStream *bs;
+	FILE *f = gf_f64_open(file_name, "rb");
+	if (!f) return GF_URL_ERROR;
+	bs = gf_bs_from_file(f, GF_BITSTREAM_READ);
+
+	if ((gf_bs_read_u32(bs) != GF_4CC('G','T','S','I')) || (gf_bs_read_u8(bs) != GF_M2TS_INDEX_VERSION)) {
+		e = GF_NON_COMPLIANT_BITSTREAM;
+		goto exit;
+	}
+	gf_mx_p(idx->mx);
+	idx->program_number = gf_bs_read_u16(bs);
+	idx->pid = gf_bs_read_u16(bs);
+	idx->first_pts = gf_bs_read_u64(bs);
+	idx->last_pts = gf_bs_read_u64(bs);
+	idx->indexed_size = gf_bs_read_u64(bs);
+	idx->source_size = gf_bs_read_u64(bs);
+	idx->source_mtime = gf_bs_read_u64(bs);
+	idx->has_pts = idx->indexed_size ? 1 : 0;
+	nb_entries = gf_bs_read_u32(bs);
+	/*24 bytes per entry*/
+	if (gf_bs_available(bs) < (u64) nb_entries * 24) {
+		e = GF_NON_COMPLIANT_BITSTREAM;
+		nb_entries = 0;
+	}
+	idx->nb_entries = 0;
+	if (nb_entries > idx->alloc_entries) {
+		GF_M2TS_IndexEntry *entries = (GF_M2TS_IndexEntry *)gf_realloc(idx->entries, sizeof(GF_M2TS_IndexEntry)*nb_entries);
+		if (entries) {
+			idx->entries = entries;
+			idx->alloc_entries = nb_entries;
+		} else {
+			e = GF_OUT_OF_MEM;
+			nb_entries = 0;
+		}
+	}
+	for (i=0; i<nb_entries; i++) {
+		idx->entries[i].offset = gf_bs_read_u64(bs);
+		idx->entries[i].pts = gf_bs_read_u64(bs);
+		idx->entries[i].pcr = gf_bs_read_u64(bs);
+	}
+	idx->nb_entries = nb_entries;
+	if (e) {
+		idx->indexed_size = idx->source_size = idx->source_mtime = 0;
+		idx->has_pts = 0;
+		idx->pid = idx->program_number = 0;
+	}
+	/*next update restarts demuxing where the saved index stopped*/
+	if (idx->demux) {
+		gf_m2ts_demux_del(idx->demux);
+		idx->demux = NULL;
+	}
+	gf_mx_v(idx->mx);
+
+exit:
+	gf_bs_del(bs);
+	fclose(f);
+	return e;
+}
+
+
 /* DVB fonction */
 
+/*demux worker of live sources: processes the packets pushed in the ring by the receive thread*/
+static u32 TSDemux_DemuxWorker(void *_p)
+{
+	GF_M2TS_Demuxer *ts = _p;
+	GF_M2TS_PacketRing *ring = ts->ring;
+
+	while (ts->run_state == 1) {
+		u32 r, w, size;
+		GF_M2TS_RING_LOCK(ring);
+		w = ring->write_pos;
+		/*the write position must be read before the data it covers*/
+		GF_M2TS_MEMORY_BARRIER();
+		r = ring->read_pos;
+		GF_M2TS_RING_UNLOCK(ring);
+		if (r == w) {
+			/*woken up by the next push, or by TSDemux_StopWorker*/
+			gf_sema_wait(ring->data_sema);
+			continue;
+		}
+		/*contiguous data only, packets split by the end of the ring are handled by the resync buffer*/
+		size = (w > r) ? (w - r) : (ring->size - r);
+		if (size > 188*GF_M2TS_RING_BATCH) size = 188*GF_M2TS_RING_BATCH;
+		gf_m2ts_process_data(ts, ring->data + r, size);
+		/*done with the data before giving the room back*/
+		GF_M2TS_MEMORY_BARRIER();
+		GF_M2TS_RING_LOCK(ring);
+		ring->read_pos = (r + size) % ring->size;
+		GF_M2TS_RING_UNLOCK(ring);
+	}
+	return 0;
+}
+
+static void TSDemux_StartWorker(GF_M2TS_Demuxer *ts)
+{
+	if (!ts->ring) {
+		GF_SAFEALLOC(ts->ring, GF_M2TS_PacketRing);
+		if (!ts->ring) return;
+		ts->ring->size = 188*GF_M2TS_RING_PACKETS;
+		ts->ring->data = gf_malloc(sizeof(char)*ts->ring->size);
+		ts->ring->data_sema = gf_sema_new(1, 0);
+#ifndef GF_M2TS_RING_LOCK_FREE
+		ts->ring->mx = gf_mx_new("M2TS Receive Ring");
+		if (!ts->ring->mx) {
+			gf_m2ts_ring_del(ts->ring);
+			ts->ring = NULL;
+			return;
+		}
+#endif
+		if (!ts->ring->data || !ts->ring->data_sema) {
+			gf_m2ts_ring_del(ts->ring);
+			ts->ring = NULL;
+			return;
+		}
+	}
+	ts->ring->read_pos = ts->ring->write_pos = 0;
+	ts->ring_max_occupancy = ts->ring_drops = 0;
+
+	ts->demux_th = gf_th_new("MPEG-2 TS Demux Worker");
+	if (gf_th_run(ts->demux_th, TSDemux_DemuxWorker, ts) != GF_OK) {
+		GF_LOG(GF_LOG_WARNING, GF_LOG_CONTAINER, ("[M2TSDemux] Cannot start demux worker, demuxing on the receive thread\n"));
+		gf_th_del(ts->demux_th);
+		ts->demux_th = NULL;
+	}
+}
+
+static void TSDemux_StopWorker(GF_M2TS_Demuxer *ts)
+{
+	if (!ts->demux_th) return;
+	/*run_state is no longer 1, wake the worker up and wait for it to exit*/
+	gf_sema_notify(ts->ring->data_sema, 1);
+	gf_th_stop(ts->demux_th);
+	gf_th_del(ts->demux_th);
+	ts->demux_th = NULL;
+	GF_LOG(GF_LOG_INFO, GF_LOG_CONTAINER, ("[M2TSDemux] Receive ring: max occupancy %d / %d packets - %d packets dropped\n", ts->ring_max_occupancy, GF_M2TS_RING_PACKETS - 1, ts->ring_drops));
+}
+
+/*hands data received from a live source to the demux worker, or demuxes it directly if there is none*/
+static void TSDemux_OnData(GF_M2TS_Demuxer *ts, char *data, u32 data_size)
+{
+	u32 used, w, n;
+	GF_M2TS_PacketRing *ring = ts->ring;
+	if (!ts->demux_th) {
+		gf_m2ts_process_data(ts, data, data_size);
+		return;
+	}
+	GF_M2TS_RING_LOCK(ring);
+	w = ring->write_pos;
+	used = gf_m2ts_ring_used(ring, ring->read_pos, w);
+	GF_M2TS_RING_UNLOCK(ring);
+	/*never block the receive thread: drop the chunk, the demuxer resyncs on the next one*/
+	if (used + data_size >= ring->size) {
+		ts->ring_drops += (data_size + 187) / 188;
+		GF_LOG(GF_LOG_DEBUG, GF_LOG_CONTAINER, ("[M2TSDemux] Receive ring full, dropping %d bytes\n", data_size));
+		return;
+	}
+	used = (used + data_size) / 188;
+	if (used > ts->ring_max_occupancy) ts->ring_max_occupancy = used;
+
+	n = MIN(data_size, ring->size - w);
+	memcpy(ring->data + w, data, sizeof(char)*n);
+	if (n < data_size) memcpy(ring->data, data + n, sizeof(char)*(data_size - n));
+	/*the data must be visible before the new write position*/
+	GF_M2TS_MEMORY_BARRIER();
+	GF_M2TS_RING_LOCK(ring);
+	ring->write_pos = (w + data_size) % ring->size;
+	GF_M2TS_RING_UNLOCK(ring);
+	gf_sema_notify(ring->data_sema, 1);
+}
+
+/*max number of datagrams fetched from the socket at once*/
+#define GF_M2TS_UDP_BATCH	16
+
 static u32 TSDemux_DemuxRun(void *_p)
 {
 	GF_Err e;
@@ -2239,6 +2752,15 @@ static u32 TSDemux_DemuxRun(void *_p)
 	ts->run_state = 1;
 
 	gf_m2ts_reset_parsers(ts);
+
+	/*live sources cannot be regulated, keep receiving while the worker demuxes*/
+	if (ts->th && (ts->sock
+#ifdef GPAC_HAS_LINUX_DVB
+		|| ts->tuner
+#endif
+	)) {
+		TSDemux_StartWorker(ts);
+	}
 	
 #ifdef GPAC_HAS_LINUX_DVB
 
@@ -2246,34 +2768,46 @@ static u32 TSDemux_DemuxRun(void *_p)
 		// in case of DVB
 		while (ts->run_state) {
 			s32 ts_size = read(ts->tuner->ts_fd, dvbts, DVB_BUFFER_SIZE);
-			if (ts_size>0) gf_m2ts_process_data(ts, dvbts, (u32) ts_size);
+			if (ts_size>0) TSDemux_OnData(ts, dvbts, (u32) ts_size);
 		}
 	} else
 #endif
 	 if (ts->sock) {
 		Bool first_run, is_rtp;
+		char *buffers[GF_M2TS_UDP_BATCH];
+		u32 i, nb_dgrams, lengths[GF_M2TS_UDP_BATCH], sizes[GF_M2TS_UDP_BATCH];
+		/*one datagram per slot of the reception buffer*/
+		for (i=0; i<GF_M2TS_UDP_BATCH; i++) {
+			buffers[i] = data + i*(UDP_BUFFER_SIZE/GF_M2TS_UDP_BATCH);
+			lengths[i] = UDP_BUFFER_SIZE/GF_M2TS_UDP_BATCH;
+		}
 		first_run = 1;
 		is_rtp = 0;
 		while (ts->run_state) {
-			size = 0;
-			/*m2ts chunks by chunks*/
-			e = gf_sk_receive(ts->sock, data, UDP_BUFFER_SIZE, 0, &size);
-			if (!size || e) {
+			nb_dgrams = 0;
+			/*m2ts chunks by chunks, all pending datagrams at once*/
+			e = gf_sk_receive_multiple(ts->sock, buffers, lengths, GF_M2TS_UDP_BATCH, sizes, &nb_dgrams, NULL);
+			if (!nb_dgrams || e) {
 				gf_sleep(1);
 				continue;
 			}
-			if (first_run) {
-				first_run = 0;
-				/*FIXME: we assume only simple RTP packaging (no CSRC nor extensions)*/
-				if ((data[0] != 0x47) && ((data[1] & 0x7F) == 33) ) {
-					is_rtp = 1;
+			for (i=0; i<nb_dgrams; i++) {
+				char *dgram = buffers[i];
+				size = sizes[i];
+				if (!size) continue;
+				if (first_run) {
+					first_run = 0;
+					/*FIXME: we assume only simple RTP packaging (no CSRC nor extensions)*/
+					if ((dgram[0] != 0x47) && ((dgram[1] & 0x7F) == 33) ) {
+						is_rtp = 1;
+					}
+				}
+				/*process chunk*/
+				if (is_rtp) {
+					if (size > 12) TSDemux_OnData(ts, dgram+12, size-12);
+				} else {
+					TSDemux_OnData(ts, dgram, size);
 				}
-			}
-			/*process chunk*/
-			if (is_rtp) {
-				gf_m2ts_process_data(ts, data+12, size-12);
-			} else {
-				gf_m2ts_process_data(ts, data, size);
 			}
 		}
 	 } else if (ts->dnload) {
@@ -2282,10 +2816,20 @@ static u32 TSDemux_DemuxRun(void *_p)
 			 gf_sleep(1); 	 
 		 }
 	 } else if (ts->file) {
-		u32 pos = 0;
-		if (ts->start_range && ts->duration) {
+		u64 pos = 0;
+		Bool indexed = 0;
+		if (ts->start_range && ts->index) {
+			u64 offset;
+			e = gf_m2ts_index_find(ts->index, ((Double) ts->start_range) / 1000, &offset, NULL);
+			/*beyond the indexed part of the file, use the size estimation if possible*/
+			if ((e == GF_OK) || ((e == GF_EOS) && !ts->duration)) {
+				pos = offset;
+				indexed = 1;
+			}
+		}
+		if (!indexed && ts->start_range && ts->duration) {
 			Double perc = ts->start_range / (1000 * ts->duration);
-			pos = (u32) (s64) (perc * ts->file_size);
+			pos = (u64) (s64) (perc * ts->file_size);
 			/*align to TS packet size*/
 			while (pos%188) pos++;
 			if (pos>=ts->file_size) {
@@ -2341,6 +2885,7 @@ restart_file:
 			}
 		}
 	}
+	TSDemux_StopWorker(ts);
 	ts->run_state = 2;
 	return 0;
 }
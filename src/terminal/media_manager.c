@@ -30,6 +30,8 @@
 
 
 u32 MM_Loop(void *par);
+static struct _codec_pool *mm_pool_new(GF_Terminal *term);
+static void mm_pool_del(struct _codec_pool *pool);
 
 
 enum
@@ -41,6 +43,16 @@ enum
 	/*only used by threaded decs to signal end of thread*/
 	GF_MM_CE_DEAD = 1<<4,
 	GF_MM_CE_DISCRADED = 1<<5,
+	/*run by the worker pool*/
+	GF_MM_CE_POOLED = 1<<6,
+};
+
+/*state of a codec in the worker pool*/
+enum
+{
+	MM_TASK_IDLE = 0,
+	MM_TASK_QUEUED,
+	MM_TASK_RUNNING,
 };
 
 typedef struct
@@ -50,12 +62,21 @@ typedef struct
 	/*for threaded decoders*/
 	GF_Thread *thread;
 	GF_Mutex *mx;
+	/*deadline scheduling: time in ms before the composition buffer runs dry, and set if the buffer
+	is below its min level or about to run dry*/
+	s32 slack;
+	Bool critical;
+	/*worker pool: task state, index of the worker the codec last ran on and set if the codec
+	was woken up while running*/
+	u32 task_state, worker;
+	Bool rerun;
 } CodecEntry;
 
 GF_Err gf_term_init_scheduler(GF_Terminal *term, u32 threading_mode)
 {
 	term->mm_mx = gf_mx_new("MediaManager");
 	term->codecs = gf_list_new();
+	term->codec_schedule = gf_list_new();
 
 	term->frame_duration = 33;
 	switch (threading_mode) {
@@ -64,6 +85,10 @@ GF_Err gf_term_init_scheduler(GF_Terminal *term, u32 threading_mode)
 	case GF_TERM_THREAD_MULTI: 
 		term->flags |= GF_TERM_MULTI_THREAD;
 		break;
+	case GF_TERM_THREAD_POOL: 
+		term->flags |= GF_TERM_WORKER_POOL;
+		term->codec_pool = mm_pool_new(term);
+		break;
 	default:
 		break;
 	}
@@ -101,7 +126,10 @@ void gf_term_stop_scheduler(GF_Terminal *term)
 		assert(! gf_list_count(term->codecs));
 		gf_th_del(term->mm_thread);
 	}
+	if (term->codec_pool) mm_pool_del(term->codec_pool);
+	term->codec_pool = NULL;
 	gf_list_del(term->codecs);
+	gf_list_del(term->codec_schedule);
 	gf_mx_del(term->mm_mx);
 }
 
@@ -115,6 +143,245 @@ static CodecEntry *mm_get_codec(GF_List *list, GF_Codec *codec)
 	return NULL;
 }
 
+/*worker pool: media codecs are tasks, queued when they get new input or free composition units and run by
+a fixed number of workers. Each worker has its own queue, a codec being queued on the worker it last ran on
+to keep its decoder state in that processor cache. A worker with an empty queue takes tasks from the end of the
+queue of a busy worker. The pool mutex only protects the queues and task states and is never held while decoding.
+Once created, the pool lives until gf_term_stop_scheduler, since gf_term_wakeup_codec uses it without the media
+manager mutex*/
+#define MM_POOL_IDLE_WAIT	10
+
+typedef struct
+{
+	struct _codec_pool *pool;
+	GF_Thread *th;
+	/*notified when a task is queued for this worker*/
+	GF_Semaphore *sema;
+	GF_List *tasks;
+	Bool busy;
+} MM_Worker;
+
+struct _codec_pool
+{
+	GF_Terminal *term;
+	GF_Mutex *mx;
+	MM_Worker *workers;
+	u32 nb_workers, next_worker;
+	Bool run;
+	/*number of attached codecs, workers do not look for tasks to steal when there is none*/
+	u32 nb_tasks;
+	/*notified when a task completes while codecs being detached wait for their task to complete*/
+	GF_Semaphore *task_done;
+	u32 nb_detach_waiters;
+};
+
+/*pool mutex is held*/
+static void mm_pool_queue(struct _codec_pool *pool, CodecEntry *ce)
+{
+	MM_Worker *wk;
+	if (ce->task_state == MM_TASK_QUEUED) return;
+	if (ce->task_state == MM_TASK_RUNNING) {
+		ce->rerun = 1;
+		return;
+	}
+	wk = &pool->workers[ce->worker];
+	ce->task_state = MM_TASK_QUEUED;
+	gf_list_add(wk->tasks, ce);
+	gf_sema_notify(wk->sema, 1);
+}
+
+static void mm_pool_attach(GF_Terminal *term, CodecEntry *ce)
+{
+	struct _codec_pool *pool = term->codec_pool;
+	gf_mx_p(pool->mx);
+	ce->worker = pool->next_worker;
+	pool->next_worker = (pool->next_worker + 1) % pool->nb_workers;
+	ce->task_state = MM_TASK_IDLE;
+	ce->rerun = 0;
+	ce->dec->pool_task = ce;
+	/*wake up the idle workers so that they look for tasks to steal again*/
+	if (!pool->nb_tasks) {
+		u32 i;
+		for (i=0; i<pool->nb_workers; i++) gf_sema_notify(pool->workers[i].sema, 1);
+	}
+	pool->nb_tasks++;
+	gf_mx_v(pool->mx);
+}
+
+/*removes the codec from the pool, waiting for the worker running it if any*/
+static void mm_pool_detach(GF_Terminal *term, CodecEntry *ce)
+{
+	struct _codec_pool *pool = term->codec_pool;
+	gf_mx_p(pool->mx);
+	ce->dec->pool_task = NULL;
+	if (ce->task_state == MM_TASK_QUEUED) 
+		gf_list_del_item(pool->workers[ce->worker].tasks, ce);
+	while (ce->task_state == MM_TASK_RUNNING) {
+		pool->nb_detach_waiters++;
+		gf_mx_v(pool->mx);
+		gf_sema_wait(pool->task_done);
+		gf_mx_p(pool->mx);
+	}
+	ce->task_state = MM_TASK_IDLE;
+	pool->nb_tasks--;
+	gf_mx_v(pool->mx);
+}
+
+void gf_term_wakeup_codec(GF_Codec *codec)
+{
+	struct _codec_pool *pool;
+	if (!codec || !codec->pool_task) return;
+	pool = codec->odm->term->codec_pool;
+	if (!pool) return;
+	gf_mx_p(pool->mx);
+	if (codec->pool_task) mm_pool_queue(pool, (CodecEntry *) codec->pool_task);
+	gf_mx_v(pool->mx);
+}
+
+/*gets the next task of the worker, from its own queue or from a busy worker*/
+static CodecEntry *mm_pool_next_task(struct _codec_pool *pool, u32 wk_idx)
+{
+	u32 i, count;
+	CodecEntry *ce = NULL;
+	MM_Worker *wk = &pool->workers[wk_idx];
+
+	gf_mx_p(pool->mx);
+	if (gf_list_count(wk->tasks)) {
+		ce = (CodecEntry *) gf_list_get(wk->tasks, 0);
+		gf_list_rem(wk->tasks, 0);
+	} else {
+		for (i=1; i<pool->nb_workers; i++) {
+			MM_Worker *victim = &pool->workers[(wk_idx + i) % pool->nb_workers];
+			if (!victim->busy) continue;
+			count = gf_list_count(victim->tasks);
+			if (!count) continue;
+			ce = (CodecEntry *) gf_list_get(victim->tasks, count-1);
+			gf_list_rem(victim->tasks, count-1);
+			ce->worker = wk_idx;
+			break;
+		}
+	}
+	if (ce) {
+		ce->task_state = MM_TASK_RUNNING;
+		wk->busy = 1;
+	}
+	gf_mx_v(pool->mx);
+	return ce;
+}
+
+static void mm_pool_run_task(struct _codec_pool *pool, u32 wk_idx, CodecEntry *ce)
+{
+	GF_Err e;
+	u32 nb_frames;
+	Bool progress = 0;
+	MM_Worker *wk = &pool->workers[wk_idx];
+
+	gf_mx_p(ce->mx);
+	if (ce->flags & GF_MM_CE_RUNNING) {
+		nb_frames = ce->dec->nb_dec_frames;
+		e = gf_codec_process(ce->dec, pool->term->frame_duration);
+		if (e) gf_term_message(pool->term, ce->dec->odm->net_service->url, "Decoding Error", e);
+		progress = (nb_frames != ce->dec->nb_dec_frames) ? 1 : 0;
+		if (!ce->dec->CB || (ce->dec->CB->UnitCount == ce->dec->CB->Capacity)) 
+			ce->dec->PriorityBoost = 0;
+	}
+	gf_mx_v(ce->mx);
+
+	gf_mx_p(pool->mx);
+	wk->busy = 0;
+	ce->task_state = MM_TASK_IDLE;
+	/*more work may be pending: back at the end of our queue, letting the other codecs run*/
+	if ((progress || ce->rerun) && (ce->flags & GF_MM_CE_RUNNING) && ce->dec->pool_task) {
+		ce->task_state = MM_TASK_QUEUED;
+		gf_list_add(wk->tasks, ce);
+	}
+	ce->rerun = 0;
+	/*each waiter checks its own task and waits again if still running*/
+	if (pool->nb_detach_waiters) {
+		gf_sema_notify(pool->task_done, pool->nb_detach_waiters);
+		pool->nb_detach_waiters = 0;
+	}
+	gf_mx_v(pool->mx);
+}
+
+static u32 MM_PoolWorker(void *par)
+{
+	MM_Worker *wk = (MM_Worker *) par;
+	struct _codec_pool *pool = wk->pool;
+	u32 wk_idx = (u32) (wk - pool->workers);
+
+	GF_LOG(GF_LOG_DEBUG, GF_LOG_CORE, ("[MediaManager] Entering decoder worker %d thread ID %d\n", wk_idx, gf_th_id() ));
+	while (pool->run) {
+		CodecEntry *ce = mm_pool_next_task(pool, wk_idx);
+		if (ce) mm_pool_run_task(pool, wk_idx, ce);
+		/*nothing to do, wait for a task or for tasks to steal*/
+		else if (pool->nb_tasks) gf_sema_wait_for(wk->sema, MM_POOL_IDLE_WAIT);
+		/*no codec in the pool, wait for one to be attached*/
+		else gf_sema_wait(wk->sema);
+	}
+	return 0;
+}
+
+static struct _codec_pool *mm_pool_new(GF_Terminal *term)
+{
+	u32 i;
+	struct _codec_pool *pool;
+	GF_SAFEALLOC(pool, struct _codec_pool);
+	if (!pool) return NULL;
+	pool->term = term;
+	pool->mx = gf_mx_new("DecoderPool");
+	pool->task_done = gf_sema_new(0xFFFF, 0);
+	pool->nb_workers = gf_sys_get_cpu_count();
+	pool->workers = (MM_Worker *) gf_malloc(sizeof(MM_Worker) * pool->nb_workers);
+	memset(pool->workers, 0, sizeof(MM_Worker) * pool->nb_workers);
+	pool->run = 1;
+	for (i=0; i<pool->nb_workers; i++) {
+		MM_Worker *wk = &pool->workers[i];
+		wk->pool = pool;
+		wk->tasks = gf_list_new();
+		wk->sema = gf_sema_new(0xFFFF, 0);
+		wk->th = gf_th_new("DecoderWorker");
+		gf_th_run(wk->th, MM_PoolWorker, wk);
+		gf_th_set_priority(wk->th, term->priority);
+	}
+	GF_LOG(GF_LOG_INFO, GF_LOG_MEDIA, ("[MediaManager] Decoder pool started with %d workers\n", pool->nb_workers));
+	return pool;
+}
+
+/*all codecs shall be detached*/
+static void mm_pool_del(struct _codec_pool *pool)
+{
+	u32 i;
+	pool->run = 0;
+	for (i=0; i<pool->nb_workers; i++) gf_sema_notify(pool->workers[i].sema, 1);
+	for (i=0; i<pool->nb_workers; i++) {
+		MM_Worker *wk = &pool->workers[i];
+		gf_th_stop(wk->th);
+		gf_th_del(wk->th);
+		gf_sema_del(wk->sema);
+		gf_list_del(wk->tasks);
+	}
+	gf_free(pool->workers);
+	gf_sema_del(pool->task_done);
+	gf_mx_del(pool->mx);
+	gf_free(pool);
+}
+
+/*queues all running pooled codecs, so that codecs fetching their input (no data arrival signaled) or blocked
+on a non-full composition buffer are run at least once per media manager cycle - mm_mx is held*/
+static void mm_pool_tick(GF_Terminal *term)
+{
+	u32 i;
+	CodecEntry *ce;
+	struct _codec_pool *pool = term->codec_pool;
+	if (!pool) return;
+	gf_mx_p(pool->mx);
+	i=0;
+	while ((ce = (CodecEntry*)gf_list_enum(term->codecs, &i))) {
+		if ((ce->flags & GF_MM_CE_POOLED) && (ce->flags & GF_MM_CE_RUNNING)) mm_pool_queue(pool, ce);
+	}
+	gf_mx_v(pool->mx);
+}
 
 void gf_term_add_codec(GF_Terminal *term, GF_Codec *codec)
 {
@@ -148,6 +415,14 @@ void gf_term_add_codec(GF_Terminal *term, GF_Codec *codec)
 		if ((codec->type==0x04) || (codec->type==0x05)) threaded = 1;
 	} else if (term->flags & GF_TERM_SINGLE_THREAD) {
 		threaded = 0;
+	} else if (term->flags & GF_TERM_WORKER_POOL) {
+		if (threaded || (codec->type==0x04) || (codec->type==0x05)) {
+			cd->mx = gf_mx_new(cd->dec->decio->module_name);
+			cd->flags |= GF_MM_CE_POOLED;
+			mm_pool_attach(term, cd);
+			gf_list_add(term->codecs, cd);
+			goto exit;
+		}
 	}
 	
 	if (threaded) {
@@ -226,6 +501,11 @@ void gf_term_remove_codec(GF_Terminal *term, GF_Codec *codec)
 	while ((ce = (CodecEntry*)gf_list_enum(term->codecs, &i))) {
 		if (ce->dec != codec) continue;
 
+		if (ce->flags & GF_MM_CE_POOLED) {
+			mm_pool_detach(term, ce);
+			gf_mx_del(ce->mx);
+			ce->mx = NULL;
+		}
 		if (ce->thread) {
 			if (ce->flags & GF_MM_CE_RUNNING) {
 				ce->flags &= ~GF_MM_CE_RUNNING;
@@ -257,27 +537,14 @@ Bool gf_term_find_codec(GF_Terminal *term, GF_Codec *codec)
 	return 0;
 }
 
-static u32 MM_SimulationStep_Decoder(GF_Terminal *term)
+/*legacy scheduler: codecs are processed in turn with a time slice proportional to their priority*/
+static u32 MM_Schedule_RoundRobin(GF_Terminal *term)
 {
 	CodecEntry *ce;
 	GF_Err e;
 	u32 count, remain;
 	u32 time_taken, time_slice, time_left;
-	
-#ifndef GF_DISABLE_LOG
-	term->compositor->networks_time = gf_sys_clock();
-#endif
-
-//	GF_LOG(GF_LOG_DEBUG, GF_LOG_MEDIA, ("[Media Manager] Entering simultion step\n"));
-	gf_term_handle_services(term);
-
-#ifndef GF_DISABLE_LOG
-	term->compositor->networks_time = gf_sys_clock() - term->compositor->networks_time;
-#endif
 
-#ifndef GF_DISABLE_LOG
-	term->compositor->decoders_time = gf_sys_clock();
-#endif
 	gf_mx_p(term->mm_mx);
 
 	count = gf_list_count(term->codecs);
@@ -286,12 +553,11 @@ static u32 MM_SimulationStep_Decoder(GF_Terminal *term)
 	if (term->last_codec >= count) term->last_codec = 0;
 	remain = count;
 
-	/*this is ultra basic a nice scheduling system would be much better*/
 	while (remain) {
 		ce = (CodecEntry*)gf_list_get(term->codecs, term->last_codec);
 		if (!ce) break;
 
-		if (!(ce->flags & GF_MM_CE_RUNNING) || (ce->flags & GF_MM_CE_THREADED) ) {
+		if (!(ce->flags & GF_MM_CE_RUNNING) || (ce->flags & (GF_MM_CE_THREADED | GF_MM_CE_POOLED)) ) {
 			remain--;
 			if (!remain) break;
 			term->last_codec = (term->last_codec + 1) % count;
@@ -332,6 +598,154 @@ static u32 MM_SimulationStep_Decoder(GF_Terminal *term)
 		}
 	}
 	gf_mx_v(term->mm_mx);
+	return time_left;
+}
+
+/*computes how soon the codec must run: systems codecs have no composition buffer and are driven by
+their DTS, media codecs must deliver before the last unit of their composition buffer is consumed*/
+static void mm_set_deadline(GF_Terminal *term, CodecEntry *ce)
+{
+	GF_CompositionMemory *cb = ce->dec->CB;
+	ce->slack = 0;
+	ce->critical = 1;
+	if (!cb || !cb->UnitCount || !ce->dec->ck) return;
+
+	/*input is the next free unit, its previous one the last delivered*/
+	ce->slack = (s32) (cb->input->prev->TS - gf_clock_time(ce->dec->ck));
+	if ((cb->Status == CB_BUFFER) || (cb->UnitCount < cb->Min)) return;
+	if (ce->slack < (s32) term->frame_duration) return;
+	ce->critical = 0;
+}
+
+static u32 mm_get_weight(CodecEntry *ce)
+{
+	u32 weight = ce->dec->Priority + 1;
+	if (ce->critical || ce->dec->PriorityBoost) weight *= 2;
+	return weight;
+}
+
+/*critical codecs first, then by deadline then by priority*/
+static Bool mm_is_before(CodecEntry *ce, CodecEntry *other)
+{
+	if (ce->critical != other->critical) return ce->critical;
+	if (ce->slack != other->slack) return (ce->slack < other->slack) ? 1 : 0;
+	return (ce->dec->Priority > other->dec->Priority) ? 1 : 0;
+}
+
+/*deadline scheduler: codecs are processed by increasing deadline, each with a share of the remaining budget
+proportional to its priority, so that the time left unused by a codec goes to the next ones. The budget is the
+frame duration minus the time reserved for the compositor when it runs in the same thread. The media manager
+mutex is only held while a codec is processed, so that the compositor can fetch units in between*/
+static u32 MM_Schedule_Deadline(GF_Terminal *term, u32 compositor_reserve)
+{
+	CodecEntry *ce;
+	GF_Err e;
+	u32 i, j, count, weight, w;
+	u32 time_taken, time_slice, time_left;
+
+	/*never leave less than half a frame to the decoders*/
+	if (compositor_reserve > term->frame_duration/2) compositor_reserve = term->frame_duration/2;
+	time_left = term->frame_duration - compositor_reserve;
+
+	gf_mx_p(term->mm_mx);
+	gf_list_reset(term->codec_schedule);
+	weight = 0;
+	i=0;
+	while ((ce = (CodecEntry*)gf_list_enum(term->codecs, &i))) {
+		if (ce->flags & GF_MM_CE_DISCRADED) {
+			gf_list_rem(term->codecs, i-1);
+			gf_free(ce);
+			i--;
+			continue;
+		}
+		if (!(ce->flags & GF_MM_CE_RUNNING) || (ce->flags & (GF_MM_CE_THREADED | GF_MM_CE_POOLED))) continue;
+
+		mm_set_deadline(term, ce);
+		weight += mm_get_weight(ce);
+		count = gf_list_count(term->codec_schedule);
+		for (j=0; j<count; j++) {
+			if (mm_is_before(ce, (CodecEntry*)gf_list_get(term->codec_schedule, j))) break;
+		}
+		gf_list_insert(term->codec_schedule, ce, j);
+	}
+	gf_mx_v(term->mm_mx);
+
+	count = gf_list_count(term->codec_schedule);
+	for (i=0; i<count; i++) {
+		if (!time_left) break;
+		ce = (CodecEntry*)gf_list_get(term->codec_schedule, i);
+
+		gf_mx_p(term->mm_mx);
+		/*codec removed or stopped while the mutex was released*/
+		if ((gf_list_find(term->codecs, ce)<0) || !(ce->flags & GF_MM_CE_RUNNING) || (ce->flags & (GF_MM_CE_THREADED | GF_MM_CE_POOLED | GF_MM_CE_DISCRADED))) {
+			gf_mx_v(term->mm_mx);
+			continue;
+		}
+		w = mm_get_weight(ce);
+		time_slice = weight ? time_left * w / weight : time_left;
+		if (!time_slice) time_slice = 1;
+		weight = (weight > w) ? weight - w : 0;
+
+		time_taken = gf_sys_clock();
+		e = gf_codec_process(ce->dec, time_slice);
+		time_taken = gf_sys_clock() - time_taken;
+
+		/*the codec may have been unregistered while processing*/
+		if (gf_list_find(term->codecs, ce)<0) {
+			gf_mx_v(term->mm_mx);
+		} else {
+#ifndef GPAC_DISABLE_LOG
+			if (e) {
+				GF_LOG(GF_LOG_WARNING, GF_LOG_MEDIA, ("[ODM%d] Decoding Error %s\n", ce->dec->odm->OD->objectDescriptorID, gf_error_to_string(e) ));
+			} else {
+				GF_LOG(GF_LOG_DEBUG, GF_LOG_MEDIA, ("[%s] Decode time slice %d ms out of %d ms - deadline in %d ms%s\n", ce->dec->decio->module_name, time_taken, time_slice, ce->slack, ce->critical ? " (critical)" : "" ));
+			}
+#endif
+			if (ce->flags & GF_MM_CE_DISCRADED) {
+				gf_list_del_item(term->codecs, ce);
+				gf_free(ce);
+			} else if (ce->dec->CB && (ce->dec->CB->UnitCount >= ce->dec->CB->Min)) {
+				ce->dec->PriorityBoost = 0;
+			}
+			gf_mx_v(term->mm_mx);
+		}
+
+		if (time_left > time_taken) time_left -= time_taken;
+		else time_left = 0;
+	}
+	gf_list_reset(term->codec_schedule);
+	return time_left + compositor_reserve;
+}
+
+static u32 MM_SimulationStep_Decoder(GF_Terminal *term, u32 compositor_reserve)
+{
+	u32 time_left;
+	
+#ifndef GF_DISABLE_LOG
+	term->compositor->networks_time = gf_sys_clock();
+#endif
+
+//	GF_LOG(GF_LOG_DEBUG, GF_LOG_MEDIA, ("[Media Manager] Entering simultion step\n"));
+	gf_term_handle_services(term);
+
+#ifndef GF_DISABLE_LOG
+	term->compositor->networks_time = gf_sys_clock() - term->compositor->networks_time;
+#endif
+
+#ifndef GF_DISABLE_LOG
+	term->compositor->decoders_time = gf_sys_clock();
+#endif
+	/*the pool outlives the pool mode, only tick it while used*/
+	if (term->codec_pool && (term->flags & GF_TERM_WORKER_POOL)) {
+		gf_mx_p(term->mm_mx);
+		mm_pool_tick(term);
+		gf_mx_v(term->mm_mx);
+	}
+	if (term->flags & GF_TERM_ROUND_ROBIN) 
+		time_left = MM_Schedule_RoundRobin(term);
+	else
+		time_left = MM_Schedule_Deadline(term, compositor_reserve);
+
 #ifndef GF_DISABLE_LOG
 	term->compositor->decoders_time = gf_sys_clock() - term->compositor->decoders_time;
 #endif
@@ -345,6 +759,8 @@ u32 MM_SimulationStep_Compositor(GF_Terminal *term, u32 time_left)
 	u32 time_taken = gf_sys_clock();
 	gf_sc_draw_frame(term->compositor);
 	time_taken = gf_sys_clock() - time_taken;
+	/*smoothed, reserved from the decoders budget*/
+	term->compositor_time = (3*term->compositor_time + time_taken) / 4;
 	if (time_left>time_taken) 
 		time_left -= time_taken;
 	else
@@ -366,7 +782,7 @@ u32 MM_Loop(void *par)
 
 	while (term->flags & GF_TERM_RUNNING) {
 		u32 left;
-		if (do_codec) left = MM_SimulationStep_Decoder(term);
+		if (do_codec) left = MM_SimulationStep_Decoder(term, do_scene ? term->compositor_time : 0);
 		else left = term->frame_duration;
 		
 		if (do_scene) left = MM_SimulationStep_Compositor(term, left);
@@ -447,7 +863,7 @@ void gf_term_start_codec(GF_Codec *codec)
 		if (ce->thread) {
 			gf_th_run(ce->thread, RunSingleDec, ce);
 			gf_th_set_priority(ce->thread, term->priority);
-		} else {
+		} else if (!(ce->flags & GF_MM_CE_POOLED)) {
 			term->cumulated_priority += ce->dec->Priority+1;
 		}
 	}
@@ -455,6 +871,8 @@ void gf_term_start_codec(GF_Codec *codec)
 	/*unlock dec*/
 	if (ce->mx)
 		gf_mx_v(ce->mx);
+
+	if (ce->flags & GF_MM_CE_POOLED) gf_term_wakeup_codec(codec);
 }
 
 void gf_term_stop_codec(GF_Codec *codec)
@@ -495,7 +913,7 @@ void gf_term_stop_codec(GF_Codec *codec)
 	/*don't wait for end of thread since this can be triggered within the decoding thread*/
 	if (ce->flags & GF_MM_CE_RUNNING) {
 		ce->flags &= ~GF_MM_CE_RUNNING;
-		if (!ce->thread) 
+		if (!ce->thread && !(ce->flags & GF_MM_CE_POOLED)) 
 			term->cumulated_priority -= codec->Priority+1;
 	}
 
@@ -507,39 +925,47 @@ void gf_term_stop_codec(GF_Codec *codec)
 void gf_term_set_threading(GF_Terminal *term, u32 mode)
 {
 	u32 i;
-	Bool thread_it, restart_it;
+	Bool thread_it, pool_it, restart_it;
 	CodecEntry *ce;
 
 	switch (mode) {
 	case GF_TERM_THREAD_SINGLE: 
 		if (term->flags & GF_TERM_SINGLE_THREAD) return;
-		term->flags &= ~GF_TERM_MULTI_THREAD;
+		term->flags &= ~(GF_TERM_MULTI_THREAD | GF_TERM_WORKER_POOL);
 		term->flags |= GF_TERM_SINGLE_THREAD;
 		break;
 	case GF_TERM_THREAD_MULTI: 
 		if (term->flags & GF_TERM_MULTI_THREAD) return;
-		term->flags &= ~GF_TERM_SINGLE_THREAD;
+		term->flags &= ~(GF_TERM_SINGLE_THREAD | GF_TERM_WORKER_POOL);
 		term->flags |= GF_TERM_MULTI_THREAD;
 		break;
+	case GF_TERM_THREAD_POOL: 
+		if (term->flags & GF_TERM_WORKER_POOL) return;
+		term->flags &= ~(GF_TERM_SINGLE_THREAD | GF_TERM_MULTI_THREAD);
+		term->flags |= GF_TERM_WORKER_POOL;
+		break;
 	default:
-		if (!(term->flags & (GF_TERM_MULTI_THREAD | GF_TERM_SINGLE_THREAD) ) ) return;
-		term->flags &= ~GF_TERM_SINGLE_THREAD;
-		term->flags &= ~GF_TERM_MULTI_THREAD;
+		if (!(term->flags & (GF_TERM_MULTI_THREAD | GF_TERM_SINGLE_THREAD | GF_TERM_WORKER_POOL) ) ) return;
+		term->flags &= ~(GF_TERM_SINGLE_THREAD | GF_TERM_MULTI_THREAD | GF_TERM_WORKER_POOL);
 		break;
 	}
 
 	gf_mx_p(term->mm_mx);
 
+	if ((mode == GF_TERM_THREAD_POOL) && !term->codec_pool) term->codec_pool = mm_pool_new(term);
 
 	i=0;
 	while ((ce = (CodecEntry*)gf_list_enum(term->codecs, &i))) {
-		thread_it = 0;
+		thread_it = pool_it = 0;
 		/*free mode, decoder wants threading - do */
 		if ((mode == GF_TERM_THREAD_FREE) && (ce->flags & GF_MM_CE_REQ_THREAD)) thread_it = 1;
 		else if (mode == GF_TERM_THREAD_MULTI) thread_it = 1;
+		/*pool mode, media decoders and decoders wanting threading*/
+		else if ((mode == GF_TERM_THREAD_POOL) && ((ce->flags & GF_MM_CE_REQ_THREAD) || (ce->dec->type==0x04) || (ce->dec->type==0x05))) pool_it = 1;
 
 		if (thread_it && (ce->flags & GF_MM_CE_THREADED)) continue;
-		if (!thread_it && !(ce->flags & GF_MM_CE_THREADED)) continue;
+		if (pool_it && (ce->flags & GF_MM_CE_POOLED)) continue;
+		if (!thread_it && !pool_it && !(ce->flags & (GF_MM_CE_THREADED | GF_MM_CE_POOLED))) continue;
 
 		restart_it = 0;
 		if (ce->flags & GF_MM_CE_RUNNING) {
@@ -556,7 +982,12 @@ void gf_term_set_threading(GF_Terminal *term, u32 mode)
 			gf_mx_del(ce->mx);
 			ce->mx = NULL;
 			ce->flags &= ~GF_MM_CE_THREADED;
-		} else {
+		} else if (ce->flags & GF_MM_CE_POOLED) {
+			mm_pool_detach(term, ce);
+			gf_mx_del(ce->mx);
+			ce->mx = NULL;
+			ce->flags &= ~GF_MM_CE_POOLED;
+		} else if (restart_it) {
 			term->cumulated_priority -= ce->dec->Priority+1;
 		}
 
@@ -564,6 +995,10 @@ void gf_term_set_threading(GF_Terminal *term, u32 mode)
 			ce->flags |= GF_MM_CE_THREADED;
 			ce->thread = gf_th_new(ce->dec->decio->module_name);
 			ce->mx = gf_mx_new(ce->dec->decio->module_name);
+		} else if (pool_it) {
+			ce->flags |= GF_MM_CE_POOLED;
+			ce->mx = gf_mx_new(ce->dec->decio->module_name);
+			mm_pool_attach(term, ce);
 		}
 
 		if (restart_it) {
@@ -571,11 +1006,14 @@ void gf_term_set_threading(GF_Terminal *term, u32 mode)
 			if (ce->thread) {
 				gf_th_run(ce->thread, RunSingleDec, ce);
 				gf_th_set_priority(ce->thread, term->priority);
+			} else if (ce->flags & GF_MM_CE_POOLED) {
+				gf_term_wakeup_codec(ce->dec);
 			} else {
 				term->cumulated_priority += ce->dec->Priority+1;
 			}
 		}
 	}
+	/*no more pooled codecs, but the pool is only destroyed by gf_term_stop_scheduler: its workers are now idle*/
 	gf_mx_v(term->mm_mx);
 }
 
@@ -612,6 +1050,10 @@ void gf_term_set_priority(GF_Terminal *term, s32 Priority)
 		if (ce->flags & GF_MM_CE_THREADED)
 			gf_th_set_priority(ce->thread, Priority);
 	}
+	if (term->codec_pool) {
+		for (i=0; i<term->codec_pool->nb_workers; i++) 
+			gf_th_set_priority(term->codec_pool->workers[i].th, Priority);
+	}
 	term->priority = Priority;
 	gf_mx_v(term->mm_mx);
 }
@@ -622,7 +1064,7 @@ GF_Err gf_term_process_step(GF_Terminal *term)
 	u32 left = 0;
 
 	if (term->flags & GF_TERM_NO_DECODER_THREAD) {
-		left = MM_SimulationStep_Decoder(term);
+		left = MM_SimulationStep_Decoder(term, (term->flags & GF_TERM_NO_COMPOSITOR_THREAD) ? term->compositor_time : 0);
 	} else {
 		left = term->frame_duration;
 	}
@@ -31,6 +31,60 @@
 
 #define NO_TEMPORAL_SCALABLE	1
 
+/*units are always delivered in order when the decoder reorders frames itself or when temporal scalability is disabled*/
+#if NO_TEMPORAL_SCALABLE
+#define CM_IS_FIFO(_codec_reordering)	1
+#else
+#define CM_IS_FIFO(_codec_reordering)	(_codec_reordering)
+#endif
+
+/*lock-free handoff between the decoder (single producer) and the compositor (single consumer): the unit payload
+is published by its dataLength, and UnitCount is updated by both sides with atomic operations*/
+#if defined(__GNUC__)
+#define CM_LOCK_FREE
+#define CM_MEMORY_BARRIER()	__sync_synchronize()
+#define CM_ATOMIC_INC(_v)	__sync_add_and_fetch(&(_v), 1)
+#define CM_ATOMIC_DEC(_v)	__sync_sub_and_fetch(&(_v), 1)
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define CM_LOCK_FREE
+/*x86 and x64 only: they do not reorder stores with stores nor loads with loads, so only the compiler must be prevented 
+from doing so. Other MSVC targets (ARM) have a weaker memory model and use the locked path*/
+#define CM_MEMORY_BARRIER()	_ReadWriteBarrier()
+#define CM_ATOMIC_INC(_v)	_InterlockedIncrement((long volatile *) &(_v))
+#define CM_ATOMIC_DEC(_v)	_InterlockedDecrement((long volatile *) &(_v))
+#endif
+
+/*only multi-unit buffers with their own memory: images may be reset by the decoder, and raw media units point to
+the decoder memory*/
+static void gf_cm_check_lock_free(GF_CompositionMemory *cb)
+{
+#ifdef CM_LOCK_FREE
+	cb->lock_free = ((cb->Capacity>1) && !cb->no_allocation) ? 1 : 0;
+#else
+	cb->lock_free = 0;
+#endif
+}
+
+/*locks the buffer for operations changing the units or the input/output positions. The decoder no longer publishes units
+without lock until the buffer is unlocked*/
+static void gf_cm_lock(GF_CompositionMemory *cb, Bool do_lock)
+{
+	if (do_lock) {
+		gf_odm_lock(cb->odm, 1);
+#ifdef CM_LOCK_FREE
+		/*full barrier, then wait for the unit being published if any*/
+		CM_ATOMIC_INC(cb->lf_control);
+		while (cb->lf_publish) gf_sleep(0);
+#endif
+	} else {
+#ifdef CM_LOCK_FREE
+		CM_ATOMIC_DEC(cb->lf_control);
+#endif
+		gf_odm_lock(cb->odm, 0);
+	}
+}
+
 
 GF_DBUnit *gf_db_unit_new()
 {
@@ -140,6 +194,7 @@ GF_CompositionMemory *gf_cm_new(u32 UnitSize, u32 capacity, Bool no_allocation)
 	that will be ready for composition will be filled in the input*/
 	tmp->output = tmp->input;
 
+	gf_cm_check_lock_free(tmp);
 	tmp->Status = CB_STOP;
 	return tmp;
 }
@@ -165,7 +220,11 @@ void gf_cm_del(GF_CompositionMemory *cb)
 void gf_cm_rewind_input(GF_CompositionMemory *cb)
 {
 	if (cb->UnitCount) {
-		cb->UnitCount--;
+#ifdef CM_LOCK_FREE
+		if (cb->lock_free) CM_ATOMIC_DEC(cb->UnitCount);
+		else
+#endif
+			cb->UnitCount--;
 		cb->input = cb->input->prev;
 		cb->input->dataLength = 0; 
 	}
@@ -184,6 +243,10 @@ GF_CMUnit *gf_cm_lock_input(GF_CompositionMemory *cb, u32 TS, Bool codec_reorder
 				return cb->input;
 			return NULL;
 		}
+#ifdef CM_LOCK_FREE
+		/*the unit was released by the compositor, make sure we don't write it before*/
+		if (cb->lock_free) CM_MEMORY_BARRIER();
+#endif
 		cb->input->TS = TS;
 		return cb->input;
 
@@ -331,6 +394,30 @@ void gf_cm_unlock_input(GF_CompositionMemory *cb, GF_CMUnit *cu, u32 cu_size, Bo
 		cu->TS = 0;
 		return;
 	}
+
+#ifdef CM_LOCK_FREE
+	/*regular playback: publish the unit without blocking on the compositor. Buffering state changes are still
+	done under lock*/
+	if (cb->lock_free && CM_IS_FIFO(codec_reordering)) {
+		/*full barrier, checked against the buffer being reset or resized*/
+		CM_ATOMIC_INC(cb->lf_publish);
+		if (!cb->lf_control && (cb->Status != CB_BUFFER) && (cu == cb->input) && !cu->dataLength) {
+			cu->RenderedLength = 0;
+			cb->input = cb->input->next;
+			/*count the unit before it becomes visible so that the compositor never drops it first - this is also a full barrier,
+			the unit payload and TS are written before the unit is published*/
+			CM_ATOMIC_INC(cb->UnitCount);
+			cu->dataLength = cu_size;
+			CM_ATOMIC_DEC(cb->lf_publish);
+
+			if ((cb->odm->codec->type==GF_STREAM_VISUAL) && cb->odm->mo && cb->odm->mo->num_open) {
+				gf_term_invalidate_compositor(cb->odm->term);
+			}
+			return;
+		}
+		CM_ATOMIC_DEC(cb->lf_publish);
+	}
+#endif
 	gf_odm_lock(cb->odm, 1);
 
 	if (cu->TS < cb->input->TS)
@@ -346,7 +433,13 @@ void gf_cm_unlock_input(GF_CompositionMemory *cb, GF_CMUnit *cu, u32 cu_size, Bo
 
 	if (cu) {
 		/*FIXME - if the CU already has data, this is spatial scalability so same num buffers*/
-		if (!cu->dataLength) cb->UnitCount += 1;
+		if (!cu->dataLength) {
+#ifdef CM_LOCK_FREE
+			if (cb->lock_free) CM_ATOMIC_INC(cb->UnitCount);
+			else
+#endif
+				cb->UnitCount += 1;
+		}
 		cu->dataLength = cu_size;
 		cu->RenderedLength = 0;
 
@@ -375,7 +468,7 @@ void gf_cm_reset(GF_CompositionMemory *cb)
 {
 	GF_CMUnit *cu;
 
-	gf_odm_lock(cb->odm, 1);
+	gf_cm_lock(cb, 1);
 
 	cu = cb->input;
 	cu->RenderedLength = 0;
@@ -393,7 +486,7 @@ void gf_cm_reset(GF_CompositionMemory *cb)
 	cb->HasSeenEOS = 0;
 
 	if (cb->odm->mo) cb->odm->mo->timestamp = 0;
-	gf_odm_lock(cb->odm, 0);
+	gf_cm_lock(cb, 0);
 }
 
 /*resize buffers (blocking)*/
@@ -403,7 +496,7 @@ void gf_cm_resize(GF_CompositionMemory *cb, u32 newCapacity)
 	if (!newCapacity) return;
 
 	/*lock buffer*/
-	gf_odm_lock(cb->odm, 1);
+	gf_cm_lock(cb, 1);
 	cu = cb->input;
 
 	cb->UnitSize = newCapacity;
@@ -424,7 +517,7 @@ void gf_cm_resize(GF_CompositionMemory *cb, u32 newCapacity)
 		cu = cu->next;
 	}
 
-	gf_odm_lock(cb->odm, 0);
+	gf_cm_lock(cb, 0);
 }
 
 
@@ -436,7 +529,7 @@ void gf_cm_reinit(GF_CompositionMemory *cb, u32 UnitSize, u32 Capacity)
 	u32 i;
 	if (!Capacity || !UnitSize) return;
 
-	gf_odm_lock(cb->odm, 1);
+	gf_cm_lock(cb, 1);
 	if (cb->input){
 	  /*break the loop and destroy*/
 	  cb->input->prev->next = NULL;
@@ -471,7 +564,8 @@ void gf_cm_reinit(GF_CompositionMemory *cb, u32 UnitSize, u32 Capacity)
 	cu->next = cb->input;
 	cb->input->prev = cu;
 	cb->output = cb->input;
-	gf_odm_lock(cb->odm, 0);
+	gf_cm_check_lock_free(cb);
+	gf_cm_lock(cb, 0);
 }
 
 /*access to the first available CU for rendering
@@ -508,6 +602,10 @@ GF_CMUnit *gf_cm_get_output(GF_CompositionMemory *cb)
 		}
 		goto exit;
 	}
+#ifdef CM_LOCK_FREE
+	/*don't read any other field of the unit before its dataLength*/
+	if (cb->lock_free) CM_MEMORY_BARRIER();
+#endif
 
 	/*update the timing*/
 	if ((cb->Status != CB_STOP) && cb->odm && cb->odm->codec) {
@@ -552,14 +650,28 @@ void gf_cm_drop_output(GF_CompositionMemory *cb)
 	}
 	
 	/*reset the output*/
-	cb->output->dataLength = 0;
-	cb->output->TS = 0;
-	cb->output = cb->output->next;
-	cb->UnitCount -= 1;
+#ifdef CM_LOCK_FREE
+	if (cb->lock_free) {
+		GF_CMUnit *cu = cb->output;
+		cb->output = cu->next;
+		/*full barrier: the unit is no longer read when released to the decoder*/
+		CM_ATOMIC_DEC(cb->UnitCount);
+		cu->TS = 0;
+		CM_MEMORY_BARRIER();
+		cu->dataLength = 0;
+	} else
+#endif
+	{
+		cb->output->dataLength = 0;
+		cb->output->TS = 0;
+		cb->output = cb->output->next;
+		cb->UnitCount -= 1;
+	}
 
 	if (!cb->HasSeenEOS && cb->UnitCount <= cb->Min) {
 		cb->odm->codec->PriorityBoost = 1;
 	}
+	gf_term_wakeup_codec(cb->odm->codec);
 }
 
 void gf_cm_set_status(GF_CompositionMemory *cb, u32 Status)
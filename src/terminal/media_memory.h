@@ -90,7 +90,8 @@ typedef struct _composition_unit {
 	/*this is for audio CU in case the whole CU is not consumed in one shot*/
 	u32 RenderedLength;
 
-	u32 dataLength;
+	/*set last by the decoder when the unit is ready and reset last by the compositor when the unit is released*/
+	volatile u32 dataLength;
 	char* data;
 } GF_CMUnit;
 
@@ -111,11 +112,16 @@ struct _composition_memory
 	/*Unit size is the size of each buffer*/
 	u32 UnitSize;
 	Bool no_allocation;
+	/*set when units are exchanged between the decoder and the compositor without locking the object manager.
+	UnitCount and the unit dataLength are then the only fields shared without lock*/
+	Bool lock_free;
+	/*number of units being published without lock and of reset/resize operations in progress*/
+	volatile u32 lf_publish, lf_control;
 
 	/*Status of the buffer*/
 	u32 Status;
 	/*Number of active units*/
-	u32 UnitCount;
+	volatile u32 UnitCount;
 
 	/*OD manager ruling this CB*/
 	struct _od_manager *odm;
@@ -291,10 +291,17 @@ static void gf_term_reload_cfg(GF_Terminal *term)
 			mode = GF_TERM_THREAD_FREE;
 			if (!stricmp(sOpt, "Single")) mode = GF_TERM_THREAD_SINGLE;
 			else if (!stricmp(sOpt, "Multi")) mode = GF_TERM_THREAD_MULTI;
+			else if (!stricmp(sOpt, "Pool")) mode = GF_TERM_THREAD_POOL;
 			gf_term_set_threading(term, mode);
 		}
 	}
 
+	sOpt = gf_cfg_get_key(term->user->config, "Systems", "DecoderScheduler");
+	if (sOpt && !stricmp(sOpt, "RoundRobin"))
+		term->flags |= GF_TERM_ROUND_ROBIN;
+	else
+		term->flags &= ~GF_TERM_ROUND_ROBIN;
+
 	/*default data timeout is 20 sec*/
 	term->net_data_timeout = 20000;
 	sOpt = gf_cfg_get_key(term->user->config, "Network", "DataTimeout");
@@ -56,8 +56,27 @@ struct __tag_bitstream
 
 	void (*EndOfStream)(void *par);
 	void *par;
+
+	/*write cache for file write mode*/
+	char *cache_write;
+	u32 cache_write_size, buffer_written;
+	/*first error met when writing to the file, reported by gf_bs_flush*/
+	GF_Err write_error;
 };
 
+/*writes the cached data to the file - the stdio buffer is flushed as well, so that the file can be read or
+queried right after*/
+static GF_Err BS_FlushCache(GF_BitStream *bs)
+{
+	if (!bs->buffer_written) return GF_OK;
+	if ((fwrite(bs->cache_write, bs->buffer_written, 1, bs->stream) != 1) || fflush(bs->stream)) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_CORE, ("[BitStream] Failed to write %d cached bytes to file\n", bs->buffer_written));
+		if (!bs->write_error) bs->write_error = GF_IO_ERR;
+	}
+	bs->buffer_written = 0;
+	return bs->write_error;
+}
+
 
 GF_EXPORT
 GF_BitStream *gf_bs_new(const char *buffer, u64 BufferSize, u32 mode)
@@ -143,6 +162,10 @@ void gf_bs_del(GF_BitStream *bs)
 	if (!bs) return;
 	/*if we are in dynamic mode (alloc done by the bitstream), free the buffer if still present*/
 	if ((bs->bsmode == GF_BITSTREAM_WRITE_DYN) && bs->original) gf_free(bs->original);
+	if (bs->cache_write) {
+		BS_FlushCache(bs);
+		gf_free(bs->cache_write);
+	}
 	gf_free(bs);
 }
 
@@ -171,6 +194,7 @@ static u8 BS_ReadByte(GF_BitStream *bs)
 		return (u32) bs->original[bs->position++];
 	}
 	/*we are in FILE mode, test for end of file*/
+	if (bs->buffer_written) BS_FlushCache(bs);
 	if (!feof(bs->stream)) {
 		bs->position++;
 		return (u32) fgetc(bs->stream);
@@ -183,7 +207,6 @@ static u8 BS_ReadByte(GF_BitStream *bs)
 
 #ifndef NO_OPTS
 static u32 bit_mask[] = {0x80, 0x40, 0x20, 0x10, 0x8, 0x4, 0x2, 0x1};
-static u32 bits_mask[] = {0x0, 0x1, 0x3, 0x7, 0xF, 0x1F, 0x3F, 0x7F};
 #endif
 
 GF_EXPORT
@@ -207,18 +230,64 @@ u8 gf_bs_read_bit(GF_BitStream *bs)
 
 }
 
+/*loads the 64 bits starting at the given byte of a memory stream, MSB first. Bytes past the end of the buffer are read as 0*/
+static GFINLINE u64 BS_LoadWord(GF_BitStream *bs, u64 byte_pos)
+{
+	u32 i, nb_bytes;
+	u64 word;
+	const u8 *ptr = (const u8 *) bs->original + byte_pos;
+	if (byte_pos + 8 <= bs->size) {
+		return ((u64) ptr[0] << 56) | ((u64) ptr[1] << 48) | ((u64) ptr[2] << 40) | ((u64) ptr[3] << 32)
+			| ((u64) ptr[4] << 24) | ((u64) ptr[5] << 16) | ((u64) ptr[6] << 8) | (u64) ptr[7];
+	}
+	nb_bytes = (u32) (bs->size - byte_pos);
+	word = 0;
+	for (i=0; i<8; i++) {
+		word <<= 8;
+		if (i<nb_bytes) word |= ptr[i];
+	}
+	return word;
+}
+
+/*extracts nBits (1 to 32) from a memory stream at the given bit position, which shall not go past the end of the buffer*/
+static GFINLINE u32 BS_GetBits(GF_BitStream *bs, u64 bit_pos, u32 nBits)
+{
+	u64 word = BS_LoadWord(bs, bit_pos >> 3);
+	return (u32) ((word << (bit_pos & 7)) >> (64 - nBits));
+}
+
+/*bit position of the next bit to read in a memory stream - bytes are fetched before being read, so that
+position is the index of the next byte to fetch and nbBits the number of bits already read in the current byte.
+Only valid if position < size: once the end of the stream has been reached, the current byte is no longer
+the one before position*/
+#define BS_BIT_POS(_bs)	( ((_bs)->position << 3) - (8 - (_bs)->nbBits) )
+
 GF_EXPORT
 u32 gf_bs_read_int(GF_BitStream *bs, u32 nBits)
 {
 	u32 ret;
 
-#ifndef NO_OPTS
+	/*bits left in the current byte: current holds the byte shifted by the number of bits already read*/
 	if (nBits + bs->nbBits <= 8) {
+		if (!nBits) return 0;
+		ret = (bs->current >> (8 - nBits)) & ((1 << nBits) - 1);
+		bs->current <<= nBits;
 		bs->nbBits += nBits;
-        ret = (bs->current >> (8 - bs->nbBits) ) & bits_mask[nBits];
 		return ret;
 	}
-#endif
+	/*memory mode: read all bits at once, leaving the stream in the same state as bit by bit reading*/
+	if ((bs->bsmode == GF_BITSTREAM_READ) && (bs->position < bs->size) && (nBits <= 32)) {
+		u64 bit_pos = BS_BIT_POS(bs);
+		if (bit_pos + nBits <= (bs->size << 3)) {
+			ret = BS_GetBits(bs, bit_pos, nBits);
+			bit_pos += nBits;
+			bs->position = (bit_pos + 7) >> 3;
+			bs->nbBits = (u32) (bit_pos - ((bs->position - 1) << 3));
+			bs->current = ((u8) bs->original[bs->position - 1]) << bs->nbBits;
+			return ret;
+		}
+	}
+
 	ret = 0;
 	while (nBits-- > 0) {
 		ret <<= 1;
@@ -336,6 +405,7 @@ u32 gf_bs_read_data(GF_BitStream *bs, char *data, u32 nbBytes)
 			return nbBytes;
 		case GF_BITSTREAM_FILE_READ:
 		case GF_BITSTREAM_FILE_WRITE:
+			BS_FlushCache(bs);
 			nbBytes = fread(data, 1, nbBytes, bs->stream);
 			bs->position += nbBytes;
 			return nbBytes;
@@ -375,7 +445,13 @@ static void BS_WriteByte(GF_BitStream *bs, u8 val)
 		return;
 	}
 	/*we are in FILE mode, no pb for any gf_realloc...*/
-	fputc(val, bs->stream);
+	if (bs->cache_write) {
+		if (bs->buffer_written == bs->cache_write_size) BS_FlushCache(bs);
+		bs->cache_write[bs->buffer_written] = val;
+		bs->buffer_written++;
+	} else if (fputc(val, bs->stream) == EOF) {
+		bs->write_error = GF_IO_ERR;
+	}
 	/*check we didn't rewind the stream*/
 	if (bs->size == bs->position) bs->size++;
 	bs->position += 1;
@@ -519,7 +595,21 @@ u32 gf_bs_write_data(GF_BitStream *bs, const char *data, u32 nbBytes)
 			return nbBytes;
 		case GF_BITSTREAM_FILE_READ:
 		case GF_BITSTREAM_FILE_WRITE:
-			if (fwrite(data, nbBytes, 1, bs->stream) != 1) return 0;
+			if (bs->cache_write) {
+				/*gather small writes, larger ones go straight to the file*/
+				if ((bs->buffer_written + nbBytes > bs->cache_write_size) && BS_FlushCache(bs)) return 0;
+				if (nbBytes < bs->cache_write_size) {
+					memcpy(bs->cache_write + bs->buffer_written, data, nbBytes);
+					bs->buffer_written += nbBytes;
+					if (bs->size == bs->position) bs->size += nbBytes;
+					bs->position += nbBytes;
+					return nbBytes;
+				}
+			}
+			if (fwrite(data, nbBytes, 1, bs->stream) != 1) {
+				bs->write_error = GF_IO_ERR;
+				return 0;
+			}
 			if (bs->size == bs->position) bs->size += nbBytes;
 			bs->position += nbBytes;
 			return nbBytes;
@@ -577,6 +667,7 @@ u64 gf_bs_available(GF_BitStream *bs)
 	/*FILE READ: assume size hasn't changed, otherwise the user shall call gf_bs_get_refreshed_size*/
 	if (bs->bsmode==GF_BITSTREAM_FILE_READ) return (bs->size - bs->position);
 
+	BS_FlushCache(bs);
 	cur = gf_f64_tell(bs->stream);
 	gf_f64_seek(bs->stream, 0, SEEK_END);
 	end = gf_f64_tell(bs->stream);
@@ -641,6 +732,7 @@ void gf_bs_skip_bytes(GF_BitStream *bs, u64 nbBytes)
 	
 	/*special case for file skipping...*/
 	if ((bs->bsmode == GF_BITSTREAM_FILE_WRITE) || (bs->bsmode == GF_BITSTREAM_FILE_READ)) {
+		BS_FlushCache(bs);
 		gf_f64_seek(bs->stream, nbBytes, SEEK_CUR);
 		bs->position += nbBytes;
 		return;
@@ -698,6 +790,7 @@ static GF_Err BS_SeekIntern(GF_BitStream *bs, u64 offset)
 		return GF_OK;
 	}
 
+	BS_FlushCache(bs);
 	gf_f64_seek(bs->stream, offset, SEEK_SET);
 
 	bs->position = offset;
@@ -728,6 +821,12 @@ u32 gf_bs_peek_bits(GF_BitStream *bs, u32 numBits, u32 byte_offset)
 	if ( (bs->bsmode != GF_BITSTREAM_READ) && (bs->bsmode != GF_BITSTREAM_FILE_READ)) return 0;
 	if (!numBits || (bs->size < bs->position + byte_offset)) return 0;
 
+	/*memory mode: no need to move in the stream*/
+	if ((bs->bsmode == GF_BITSTREAM_READ) && (bs->position < bs->size) && (numBits <= 32)) {
+		u64 bit_pos = byte_offset ? ((bs->position + byte_offset) << 3) : BS_BIT_POS(bs);
+		if (bit_pos + numBits <= (bs->size << 3)) return BS_GetBits(bs, bit_pos, numBits);
+	}
+
 	/*store our state*/
 	curPos = bs->position;
 	curBits = bs->nbBits;
@@ -755,6 +854,7 @@ u64 gf_bs_get_refreshed_size(GF_BitStream *bs)
 		return bs->size;
 
 	default:
+		BS_FlushCache(bs);
 		offset = gf_f64_tell(bs->stream);
 		gf_f64_seek(bs->stream, 0, SEEK_END);
 		bs->size = gf_f64_tell(bs->stream);
@@ -850,6 +950,35 @@ u32 gf_bs_read_vluimsbf5(GF_BitStream *bs)
 	return gf_bs_read_int(bs, 4*nb_words);
 }
 
+GF_EXPORT
+GF_Err gf_bs_set_output_buffering(GF_BitStream *bs, u32 size)
+{
+	if (!bs) return GF_BAD_PARAM;
+	if (bs->bsmode != GF_BITSTREAM_FILE_WRITE) return GF_NOT_SUPPORTED;
+	if (BS_FlushCache(bs)) return bs->write_error;
+	if (!size) {
+		if (bs->cache_write) gf_free(bs->cache_write);
+		bs->cache_write = NULL;
+		bs->cache_write_size = 0;
+		return GF_OK;
+	}
+	bs->cache_write = (char*)gf_realloc(bs->cache_write, size);
+	if (!bs->cache_write) {
+		bs->cache_write_size = 0;
+		return GF_OUT_OF_MEM;
+	}
+	bs->cache_write_size = size;
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_Err gf_bs_flush(GF_BitStream *bs)
+{
+	if (!bs) return GF_BAD_PARAM;
+	if (bs->cache_write) BS_FlushCache(bs);
+	return bs->write_error;
+}
+
 GF_EXPORT
 void gf_bs_truncate(GF_BitStream *bs)
 {
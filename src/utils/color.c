@@ -55,22 +55,6 @@ static s32 R_V[256];
 
 static s32 is_init = 0;
 
-/**/
-static void yuv2rgb_init(void)
-{
-	s32 i;
-	if (is_init) return;
-
-	is_init = 1;
-	for(i = 0; i < 256; i++) {
-		RGB_Y[i] = FIX_OUT(1.164) * (i - 16);
-		B_U[i] = FIX_OUT(2.018) * (i - 128);
-		G_U[i] = FIX_OUT(0.391) * (i - 128);
-		G_V[i] = FIX_OUT(0.813) * (i - 128);
-		R_V[i] = FIX_OUT(1.596) * (i - 128);
-	}
-}
-
 static void gf_yuv_load_lines_planar(unsigned char *dst, s32 dststride, unsigned char *y_src, unsigned char *u_src, unsigned char * v_src, s32 y_stride, s32 uv_stride, s32 width)
 {
 	u32 hw, x;
@@ -167,8 +151,6 @@ static void gf_yuva_load_lines(unsigned char *dst, s32 dststride, unsigned char
 	unsigned char *y_src2 = y_src + y_stride;
 	unsigned char *a_src2 = a_src + y_stride;
 
-	yuv2rgb_init();
-
 	hw = width / 2;
 	for (x = 0; x < hw; x++) {
 		s32 u, v;
@@ -218,6 +200,304 @@ static void gf_yuva_load_lines(unsigned char *dst, s32 dststride, unsigned char
 	}
 }
 
+/*vectorized converters: same integer arithmetic as the lookup tables, 32 bits products are exact so the
+output is identical to the scalar code. SSE2 and NEON are used when the compiler targets them, AVX2 is
+checked at run time*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define GPAC_SSE2_COLOR
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))))
+#include <immintrin.h>
+#define GPAC_AVX2_COLOR
+#endif
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GPAC_NEON_COLOR
+#endif
+
+/*fixed point coefficients of the tables*/
+#define YUV_CY	9535
+#define YUV_CBU	16531
+#define YUV_CGU	3203
+#define YUV_CGV	6660
+#define YUV_CRV	13074
+
+typedef void (*yuv_load_lines_proto)(unsigned char *dst, s32 dststride, unsigned char *y_src, unsigned char *u_src, unsigned char *v_src, unsigned char *a_src, s32 y_stride, s32 uv_stride, s32 width);
+typedef void (*yuv_load_packed_proto)(unsigned char *dst, unsigned char *y_src, s32 width);
+
+static void yuv_load_lines_c(unsigned char *dst, s32 dststride, unsigned char *y_src, unsigned char *u_src, unsigned char *v_src, unsigned char *a_src, s32 y_stride, s32 uv_stride, s32 width)
+{
+	if (a_src) gf_yuva_load_lines(dst, dststride, y_src, u_src, v_src, a_src, y_stride, uv_stride, width);
+	else gf_yuv_load_lines_planar(dst, dststride, y_src, u_src, v_src, y_stride, uv_stride, width);
+}
+
+static void yuv_load_packed_c(unsigned char *dst, unsigned char *y_src, s32 width)
+{
+	gf_yuv_load_lines_packed(dst, 4*width, y_src, y_src+1, y_src+3, width);
+}
+
+#ifdef GPAC_SSE2_COLOR
+
+/*R, G and B of 8 pixels from (Y-16) and (U-128), (V-128) in 16 bits lanes*/
+static GFINLINE void yuv_sse2_rgb(__m128i y, __m128i u, __m128i v, __m128i *r, __m128i *g, __m128i *b)
+{
+	__m128i yv_lo = _mm_unpacklo_epi16(y, v);
+	__m128i yv_hi = _mm_unpackhi_epi16(y, v);
+	__m128i yu_lo = _mm_unpacklo_epi16(y, u);
+	__m128i yu_hi = _mm_unpackhi_epi16(y, u);
+	__m128i v_lo = _mm_unpacklo_epi16(v, _mm_setzero_si128());
+	__m128i v_hi = _mm_unpackhi_epi16(v, _mm_setzero_si128());
+	__m128i c_r = _mm_set1_epi32((YUV_CRV<<16) | YUV_CY);
+	__m128i c_b = _mm_set1_epi32((YUV_CBU<<16) | YUV_CY);
+	__m128i c_gu = _mm_set1_epi32((s32) (((u32) (0x10000 - YUV_CGU) << 16) | YUV_CY));
+	__m128i c_gv = _mm_set1_epi32(YUV_CGV);
+	__m128i lo, hi;
+
+	lo = _mm_srai_epi32(_mm_madd_epi16(yv_lo, c_r), SCALEBITS_OUT);
+	hi = _mm_srai_epi32(_mm_madd_epi16(yv_hi, c_r), SCALEBITS_OUT);
+	*r = _mm_packs_epi32(lo, hi);
+	lo = _mm_srai_epi32(_mm_madd_epi16(yu_lo, c_b), SCALEBITS_OUT);
+	hi = _mm_srai_epi32(_mm_madd_epi16(yu_hi, c_b), SCALEBITS_OUT);
+	*b = _mm_packs_epi32(lo, hi);
+	lo = _mm_srai_epi32(_mm_sub_epi32(_mm_madd_epi16(yu_lo, c_gu), _mm_madd_epi16(v_lo, c_gv)), SCALEBITS_OUT);
+	hi = _mm_srai_epi32(_mm_sub_epi32(_mm_madd_epi16(yu_hi, c_gu), _mm_madd_epi16(v_hi, c_gv)), SCALEBITS_OUT);
+	*g = _mm_packs_epi32(lo, hi);
+}
+
+/*clips and interleaves 8 pixels to RGBA, alpha in the 8 low bytes of a*/
+static GFINLINE void yuv_sse2_store(unsigned char *dst, __m128i r, __m128i g, __m128i b, __m128i a)
+{
+	__m128i rg = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), _mm_packus_epi16(g, g));
+	__m128i ba = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), a);
+	_mm_storeu_si128((__m128i *) dst, _mm_unpacklo_epi16(rg, ba));
+	_mm_storeu_si128((__m128i *) (dst+16), _mm_unpackhi_epi16(rg, ba));
+}
+
+static void yuv_load_lines_sse2(unsigned char *dst, s32 dststride, unsigned char *y_src, unsigned char *u_src, unsigned char *v_src, unsigned char *a_src, s32 y_stride, s32 uv_stride, s32 width)
+{
+	s32 x, i;
+	__m128i zero = _mm_setzero_si128();
+	__m128i c16 = _mm_set1_epi16(16);
+	__m128i c128 = _mm_set1_epi16(128);
+	__m128i opaque = _mm_set1_epi8((char) 0xFF);
+
+	for (x=0; x+16<=width; x+=16) {
+		__m128i u8 = _mm_loadl_epi64((const __m128i *) (u_src + x/2));
+		__m128i v8 = _mm_loadl_epi64((const __m128i *) (v_src + x/2));
+		__m128i u[2], v[2];
+		/*each chroma sample is shared by 2 pixels*/
+		u8 = _mm_unpacklo_epi8(u8, u8);
+		v8 = _mm_unpacklo_epi8(v8, v8);
+		u[0] = _mm_sub_epi16(_mm_unpacklo_epi8(u8, zero), c128);
+		u[1] = _mm_sub_epi16(_mm_unpackhi_epi8(u8, zero), c128);
+		v[0] = _mm_sub_epi16(_mm_unpacklo_epi8(v8, zero), c128);
+		v[1] = _mm_sub_epi16(_mm_unpackhi_epi8(v8, zero), c128);
+
+		/*both lines*/
+		for (i=0; i<2; i++) {
+			s32 j;
+			__m128i y8 = _mm_loadu_si128((const __m128i *) (y_src + i*y_stride + x));
+			__m128i a8 = a_src ? _mm_loadu_si128((const __m128i *) (a_src + i*y_stride + x)) : opaque;
+			for (j=0; j<2; j++) {
+				__m128i r, g, b, y;
+				y = _mm_sub_epi16(j ? _mm_unpackhi_epi8(y8, zero) : _mm_unpacklo_epi8(y8, zero), c16);
+				yuv_sse2_rgb(y, u[j], v[j], &r, &g, &b);
+				yuv_sse2_store(dst + i*dststride + 4*(x + 8*j), r, g, b, j ? _mm_srli_si128(a8, 8) : a8);
+			}
+		}
+	}
+	if (x<width) yuv_load_lines_c(dst + 4*x, dststride, y_src + x, u_src + x/2, v_src + x/2, a_src ? a_src + x : NULL, y_stride, uv_stride, width - x);
+}
+
+static void yuv_load_packed_sse2(unsigned char *dst, unsigned char *y_src, s32 width)
+{
+	s32 x;
+	__m128i c16 = _mm_set1_epi16(16);
+	__m128i c128 = _mm_set1_epi16(128);
+	__m128i mask = _mm_set1_epi16(0xFF);
+	__m128i opaque = _mm_set1_epi8((char) 0xFF);
+
+	for (x=0; x+8<=width; x+=8) {
+		/*Y0 U0 Y1 V0 ...*/
+		__m128i yuyv = _mm_loadu_si128((const __m128i *) (y_src + 2*x));
+		__m128i y = _mm_sub_epi16(_mm_and_si128(yuyv, mask), c16);
+		__m128i uv = _mm_srli_epi16(yuyv, 8);
+		__m128i u = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(2,2,0,0)), _MM_SHUFFLE(2,2,0,0));
+		__m128i v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(3,3,1,1)), _MM_SHUFFLE(3,3,1,1));
+		__m128i r, g, b;
+		yuv_sse2_rgb(y, _mm_sub_epi16(u, c128), _mm_sub_epi16(v, c128), &r, &g, &b);
+		yuv_sse2_store(dst + 4*x, r, g, b, opaque);
+	}
+	if (x<width) yuv_load_packed_c(dst + 4*x, y_src + 2*x, width - x);
+}
+
+#ifdef GPAC_AVX2_COLOR
+
+__attribute__((target("avx2")))
+static void yuv_load_lines_avx2(unsigned char *dst, s32 dststride, unsigned char *y_src, unsigned char *u_src, unsigned char *v_src, unsigned char *a_src, s32 y_stride, s32 uv_stride, s32 width)
+{
+	s32 x, i;
+	__m256i c16 = _mm256_set1_epi16(16);
+	__m256i c128 = _mm256_set1_epi16(128);
+	__m256i c_r = _mm256_set1_epi32((YUV_CRV<<16) | YUV_CY);
+	__m256i c_b = _mm256_set1_epi32((YUV_CBU<<16) | YUV_CY);
+	__m256i c_gu = _mm256_set1_epi32((s32) (((u32) (0x10000 - YUV_CGU) << 16) | YUV_CY));
+	__m256i c_gv = _mm256_set1_epi32(YUV_CGV);
+	__m128i opaque = _mm_set1_epi8((char) 0xFF);
+
+	for (x=0; x+16<=width; x+=16) {
+		__m128i u8 = _mm_loadl_epi64((const __m128i *) (u_src + x/2));
+		__m128i v8 = _mm_loadl_epi64((const __m128i *) (v_src + x/2));
+		/*16 pixels in order: unpack within 128 bits lanes and pack back give the same order*/
+		__m256i u = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(u8, u8)), c128);
+		__m256i v = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v8, v8)), c128);
+		__m256i v_lo = _mm256_unpacklo_epi16(v, _mm256_setzero_si256());
+		__m256i v_hi = _mm256_unpackhi_epi16(v, _mm256_setzero_si256());
+
+		for (i=0; i<2; i++) {
+			__m256i y, yv_lo, yv_hi, yu_lo, yu_hi, lo, hi, r, g, b;
+			__m128i r8, g8, b8, a8, rg, ba;
+			unsigned char *out = dst + i*dststride + 4*x;
+
+			y = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (y_src + i*y_stride + x))), c16);
+			yv_lo = _mm256_unpacklo_epi16(y, v);
+			yv_hi = _mm256_unpackhi_epi16(y, v);
+			yu_lo = _mm256_unpacklo_epi16(y, u);
+			yu_hi = _mm256_unpackhi_epi16(y, u);
+
+			lo = _mm256_srai_epi32(_mm256_madd_epi16(yv_lo, c_r), SCALEBITS_OUT);
+			hi = _mm256_srai_epi32(_mm256_madd_epi16(yv_hi, c_r), SCALEBITS_OUT);
+			r = _mm256_packs_epi32(lo, hi);
+			lo = _mm256_srai_epi32(_mm256_madd_epi16(yu_lo, c_b), SCALEBITS_OUT);
+			hi = _mm256_srai_epi32(_mm256_madd_epi16(yu_hi, c_b), SCALEBITS_OUT);
+			b = _mm256_packs_epi32(lo, hi);
+			lo = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_madd_epi16(yu_lo, c_gu), _mm256_madd_epi16(v_lo, c_gv)), SCALEBITS_OUT);
+			hi = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_madd_epi16(yu_hi, c_gu), _mm256_madd_epi16(v_hi, c_gv)), SCALEBITS_OUT);
+			g = _mm256_packs_epi32(lo, hi);
+
+			r8 = _mm_packus_epi16(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+			g8 = _mm_packus_epi16(_mm256_castsi256_si128(g), _mm256_extracti128_si256(g, 1));
+			b8 = _mm_packus_epi16(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1));
+			a8 = a_src ? _mm_loadu_si128((const __m128i *) (a_src + i*y_stride + x)) : opaque;
+
+			rg = _mm_unpacklo_epi8(r8, g8);
+			ba = _mm_unpacklo_epi8(b8, a8);
+			_mm_storeu_si128((__m128i *) out, _mm_unpacklo_epi16(rg, ba));
+			_mm_storeu_si128((__m128i *) (out+16), _mm_unpackhi_epi16(rg, ba));
+			rg = _mm_unpackhi_epi8(r8, g8);
+			ba = _mm_unpackhi_epi8(b8, a8);
+			_mm_storeu_si128((__m128i *) (out+32), _mm_unpacklo_epi16(rg, ba));
+			_mm_storeu_si128((__m128i *) (out+48), _mm_unpackhi_epi16(rg, ba));
+		}
+	}
+	if (x<width) yuv_load_lines_c(dst + 4*x, dststride, y_src + x, u_src + x/2, v_src + x/2, a_src ? a_src + x : NULL, y_stride, uv_stride, width - x);
+}
+
+#endif /*GPAC_AVX2_COLOR*/
+
+#endif /*GPAC_SSE2_COLOR*/
+
+#ifdef GPAC_NEON_COLOR
+
+/*converts and stores 8 pixels from (Y-16), (U-128) and (V-128)*/
+static GFINLINE void yuv_neon_store(unsigned char *dst, int16x8_t y, int16x8_t u, int16x8_t v, uint8x8_t a)
+{
+	int32x4_t lo, hi;
+	uint8x8x4_t px;
+
+	lo = vmlal_n_s16(vmull_n_s16(vget_low_s16(y), YUV_CY), vget_low_s16(v), YUV_CRV);
+	hi = vmlal_n_s16(vmull_n_s16(vget_high_s16(y), YUV_CY), vget_high_s16(v), YUV_CRV);
+	px.val[0] = vqmovun_s16(vcombine_s16(vqshrn_n_s32(lo, SCALEBITS_OUT), vqshrn_n_s32(hi, SCALEBITS_OUT)));
+
+	lo = vmlsl_n_s16(vmlsl_n_s16(vmull_n_s16(vget_low_s16(y), YUV_CY), vget_low_s16(u), YUV_CGU), vget_low_s16(v), YUV_CGV);
+	hi = vmlsl_n_s16(vmlsl_n_s16(vmull_n_s16(vget_high_s16(y), YUV_CY), vget_high_s16(u), YUV_CGU), vget_high_s16(v), YUV_CGV);
+	px.val[1] = vqmovun_s16(vcombine_s16(vqshrn_n_s32(lo, SCALEBITS_OUT), vqshrn_n_s32(hi, SCALEBITS_OUT)));
+
+	lo = vmlal_n_s16(vmull_n_s16(vget_low_s16(y), YUV_CY), vget_low_s16(u), YUV_CBU);
+	hi = vmlal_n_s16(vmull_n_s16(vget_high_s16(y), YUV_CY), vget_high_s16(u), YUV_CBU);
+	px.val[2] = vqmovun_s16(vcombine_s16(vqshrn_n_s32(lo, SCALEBITS_OUT), vqshrn_n_s32(hi, SCALEBITS_OUT)));
+
+	px.val[3] = a;
+	vst4_u8(dst, px);
+}
+
+#define YUV_NEON_S16(_v, _off)	vreinterpretq_s16_u16(vsubl_u8(_v, vdup_n_u8(_off)))
+
+static void yuv_load_lines_neon(unsigned char *dst, s32 dststride, unsigned char *y_src, unsigned char *u_src, unsigned char *v_src, unsigned char *a_src, s32 y_stride, s32 uv_stride, s32 width)
+{
+	s32 x, i;
+	uint8x8_t opaque = vdup_n_u8(0xFF);
+
+	for (x=0; x+16<=width; x+=16) {
+		/*each chroma sample is shared by 2 pixels*/
+		uint8x8x2_t u8 = vzip_u8(vld1_u8(u_src + x/2), vld1_u8(u_src + x/2));
+		uint8x8x2_t v8 = vzip_u8(vld1_u8(v_src + x/2), vld1_u8(v_src + x/2));
+
+		for (i=0; i<2; i++) {
+			uint8x16_t y8 = vld1q_u8(y_src + i*y_stride + x);
+			uint8x16_t a8 = a_src ? vld1q_u8(a_src + i*y_stride + x) : vcombine_u8(opaque, opaque);
+			unsigned char *out = dst + i*dststride + 4*x;
+			yuv_neon_store(out, YUV_NEON_S16(vget_low_u8(y8), 16), YUV_NEON_S16(u8.val[0], 128), YUV_NEON_S16(v8.val[0], 128), vget_low_u8(a8));
+			yuv_neon_store(out+32, YUV_NEON_S16(vget_high_u8(y8), 16), YUV_NEON_S16(u8.val[1], 128), YUV_NEON_S16(v8.val[1], 128), vget_high_u8(a8));
+		}
+	}
+	if (x<width) yuv_load_lines_c(dst + 4*x, dststride, y_src + x, u_src + x/2, v_src + x/2, a_src ? a_src + x : NULL, y_stride, uv_stride, width - x);
+}
+
+static void yuv_load_packed_neon(unsigned char *dst, unsigned char *y_src, s32 width)
+{
+	s32 x;
+	uint8x8_t opaque = vdup_n_u8(0xFF);
+
+	for (x=0; x+16<=width; x+=16) {
+		/*even Y, U, odd Y, V*/
+		uint8x8x4_t yuyv = vld4_u8(y_src + 2*x);
+		int16x8_t u = YUV_NEON_S16(yuyv.val[1], 128);
+		int16x8_t v = YUV_NEON_S16(yuyv.val[3], 128);
+		/*pixels in order*/
+		uint8x8x2_t y8 = vzip_u8(yuyv.val[0], yuyv.val[2]);
+		int16x8x2_t u16 = vzipq_s16(u, u);
+		int16x8x2_t v16 = vzipq_s16(v, v);
+		yuv_neon_store(dst + 4*x, YUV_NEON_S16(y8.val[0], 16), u16.val[0], v16.val[0], opaque);
+		yuv_neon_store(dst + 4*x + 32, YUV_NEON_S16(y8.val[1], 16), u16.val[1], v16.val[1], opaque);
+	}
+	if (x<width) yuv_load_packed_c(dst + 4*x, y_src + 2*x, width - x);
+}
+
+#endif /*GPAC_NEON_COLOR*/
+
+static yuv_load_lines_proto yuv_load_lines = yuv_load_lines_c;
+static yuv_load_packed_proto yuv_load_packed = yuv_load_packed_c;
+
+static void yuv2rgb_init(void)
+{
+	s32 i;
+	if (is_init) return;
+
+	for(i = 0; i < 256; i++) {
+		RGB_Y[i] = FIX_OUT(1.164) * (i - 16);
+		B_U[i] = FIX_OUT(2.018) * (i - 128);
+		G_U[i] = FIX_OUT(0.391) * (i - 128);
+		G_V[i] = FIX_OUT(0.813) * (i - 128);
+		R_V[i] = FIX_OUT(1.596) * (i - 128);
+	}
+
+#if defined(GPAC_SSE2_COLOR)
+	yuv_load_lines = yuv_load_lines_sse2;
+	yuv_load_packed = yuv_load_packed_sse2;
+#if defined(GPAC_AVX2_COLOR)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) yuv_load_lines = yuv_load_lines_avx2;
+#endif
+#elif defined(GPAC_NEON_COLOR)
+	yuv_load_lines = yuv_load_lines_neon;
+	yuv_load_packed = yuv_load_packed_neon;
+#endif
+	is_init = 1;
+}
+
 static s32 mul255(s32 a, s32 b)
 {
 	return ((a+1) * b) >> 8;
@@ -301,11 +581,87 @@ static void copy_row_bgr_24(u8 *src, u32 src_w, u8 *dst, u32 dst_w, s32 h_inc, s
 	}
 }
 
+#ifdef GPAC_SSE2_COLOR
+enum
+{
+	COPY_ROW_RGBX = 0,
+	COPY_ROW_BGRX,
+	COPY_ROW_RGBD,
+};
+
+/*4 bytes destinations with a linear pitch, 4 pixels at once. Source pixels are picked as in the scalar code,
+pixel i of the row being source pixel (i*h_inc)>>16*/
+static void copy_row_32_sse2(u8 *src, u8 *dst, u32 dst_w, s32 h_inc, u32 type)
+{
+	u32 i;
+	u64 pos = 0;
+	u32 *src32 = (u32 *)src;
+	__m128i zero = _mm_setzero_si128();
+	__m128i alpha = _mm_set1_epi32(0xFF000000);
+	__m128i green = _mm_set1_epi32(0x0000FF00);
+	__m128i blue = _mm_set1_epi32(0x000000FF);
+
+	for (i=0; i+4<=dst_w; i+=4) {
+		__m128i p, out, mask;
+		if (h_inc == 0x10000) {
+			p = _mm_loadu_si128((const __m128i *) (src32 + i));
+		} else {
+			u32 i0, i1, i2, i3;
+			i0 = (u32) (pos >> 16); pos += h_inc;
+			i1 = (u32) (pos >> 16); pos += h_inc;
+			i2 = (u32) (pos >> 16); pos += h_inc;
+			i3 = (u32) (pos >> 16); pos += h_inc;
+			p = _mm_set_epi32(src32[i3], src32[i2], src32[i1], src32[i0]);
+		}
+		if (type == COPY_ROW_RGBD) {
+			_mm_storeu_si128((__m128i *) dst, p);
+			dst += 16;
+			continue;
+		}
+		if (type == COPY_ROW_BGRX) {
+			out = _mm_or_si128(_mm_and_si128(p, green), _mm_slli_epi32(_mm_and_si128(p, blue), 16));
+			out = _mm_or_si128(out, _mm_and_si128(_mm_srli_epi32(p, 16), blue));
+			out = _mm_or_si128(out, alpha);
+		} else {
+			out = _mm_or_si128(p, alpha);
+		}
+		/*transparent source pixels leave the destination untouched*/
+		mask = _mm_cmpeq_epi32(_mm_and_si128(p, alpha), zero);
+		if (_mm_movemask_epi8(mask)) 
+			out = _mm_or_si128(_mm_and_si128(mask, _mm_loadu_si128((const __m128i *) dst)), _mm_andnot_si128(mask, out));
+		_mm_storeu_si128((__m128i *) dst, out);
+		dst += 16;
+	}
+	for (; i<dst_w; i++) {
+		u8 *s = src + 4 * ((h_inc == 0x10000) ? i : (u32) (pos >> 16));
+		pos += h_inc;
+		if (type == COPY_ROW_RGBD) {
+			dst[0] = s[0]; dst[1] = s[1]; dst[2] = s[2]; dst[3] = s[3];
+		} else if (s[3]) {
+			if (type == COPY_ROW_BGRX) {
+				dst[0] = s[2]; dst[1] = s[1]; dst[2] = s[0];
+			} else {
+				dst[0] = s[0]; dst[1] = s[1]; dst[2] = s[2];
+			}
+			dst[3] = 0xFF;
+		}
+		dst += 4;
+	}
+}
+#endif
+
 static void copy_row_bgrx(u8 *src, u32 src_w, u8 *dst, u32 dst_w, s32 h_inc, s32 x_pitch, u8 alpha)
 {
 	u8 a, r, g, b;
 	s32 pos = 0x10000L;
 
+#ifdef GPAC_SSE2_COLOR
+	if (x_pitch==4) {
+		copy_row_32_sse2(src, dst, dst_w, h_inc, COPY_ROW_BGRX);
+		return;
+	}
+#endif
+
 	while (dst_w) {
 		while ( pos >= 0x10000L ) {
 			r = *src++; g = *src++; b = *src++; a = *src++;
@@ -328,6 +684,13 @@ static void copy_row_rgbx(u8 *src, u32 src_w, u8 *dst, u32 dst_w, s32 h_inc, s32
 	u8 a, r, g, b;
 	s32 pos = 0x10000L;
 
+#ifdef GPAC_SSE2_COLOR
+	if (x_pitch==4) {
+		copy_row_32_sse2(src, dst, dst_w, h_inc, COPY_ROW_RGBX);
+		return;
+	}
+#endif
+
 	while ( dst_w) {
 		while ( pos >= 0x10000L ) {
 			r = *src++; g = *src++; b = *src++; a = *src++;
@@ -350,6 +713,13 @@ static void copy_row_rgbd(u8 *src, u32 src_w, u8 *dst, u32 dst_w, s32 h_inc, s32
 	u8 a, r, g, b;
 	s32 pos = 0x10000L;
 
+#ifdef GPAC_SSE2_COLOR
+	if (x_pitch==4) {
+		copy_row_32_sse2(src, dst, dst_w, h_inc, COPY_ROW_RGBD);
+		return;
+	}
+#endif
+
 	while ( dst_w) {
 		while ( pos >= 0x10000L ) {
 			r = *src++; g = *src++; b = *src++; a = *src++;
@@ -748,7 +1118,7 @@ static void load_line_yv12(char *src_bits, u32 x_offset, u32 y_offset, u32 y_pit
 	pY += x_offset + y_offset*y_pitch;
 	pU += x_offset/2 + y_offset*y_pitch/4;
 	pV += x_offset/2 + y_offset*y_pitch/4;
-	gf_yuv_load_lines_planar((unsigned char*)dst_bits, 4*width, pY, pU, pV, y_pitch, y_pitch/2, width);
+	yuv_load_lines((unsigned char*)dst_bits, 4*width, pY, pU, pV, NULL, y_pitch, y_pitch/2, width);
 }
 
 static void load_line_yuva(char *src_bits, u32 x_offset, u32 y_offset, u32 y_pitch, u32 width, u32 height, u8 *dst_bits)
@@ -763,16 +1133,13 @@ static void load_line_yuva(char *src_bits, u32 x_offset, u32 y_offset, u32 y_pit
 	pU += x_offset/2 + y_offset*y_pitch/4;
 	pV += x_offset/2 + y_offset*y_pitch/4;
 	pA += x_offset + y_offset*y_pitch;
-	gf_yuva_load_lines(dst_bits, 4*width, pY, pU, pV, pA, y_pitch, y_pitch/2, width);
+	yuv_load_lines(dst_bits, 4*width, pY, pU, pV, pA, y_pitch, y_pitch/2, width);
 }
 
 static void load_line_yuyv(u8 *src_bits, u32 x_offset, u32 y_offset, u32 y_pitch, u32 width, u8 *dst_bits)
 {
-	u8 *pY, *pU, *pV;
-	pY = (u8 *)src_bits + x_offset + y_offset*y_pitch;
-	pU = (u8 *)pY + 1;
-	pV = (u8 *)pY + 3;
-	gf_yuv_load_lines_packed((unsigned char*)dst_bits, 4*width, pY, pU, pV, width);
+	u8 *pY = (u8 *)src_bits + x_offset + y_offset*y_pitch;
+	yuv_load_packed((unsigned char*)dst_bits, pY, width);
 }
 
 
@@ -786,7 +1153,7 @@ GF_Err gf_stretch_bits(GF_VideoSurface *dst, GF_VideoSurface *src, GF_Window *ds
 	s32 src_row;
 	u32 i, yuv_planar_type = 0;
 	Bool no_memcpy;
-	Bool yuv_init = 0;
+	s32 yuv_pair = -1;
 	Bool has_alpha = (alpha!=0xFF) ? 1 : 0;
 	u32 dst_bpp, dst_w_size;
 	s32 pos_y, inc_y, inc_x, prev_row, x_off;
@@ -954,28 +1321,16 @@ GF_Err gf_stretch_bits(GF_VideoSurface *dst, GF_VideoSurface *src, GF_Window *ds
 		if (prev_row != src_row) {
 			u32 the_row = src_row - 1;
 			if (yuv_planar_type) {
-				if ( the_row % 2) {
-					if (!yuv_init) {
-						yuv_init = 1;
-						the_row --;
-						if (flip) the_row = src->height-2 - the_row;
-						if (yuv_planar_type==1) {
-							load_line_yv12(src->video_buffer, x_off, the_row, src->pitch_y, src_w, src->height, tmp);
-						} else {
-							load_line_yuva(src->video_buffer, x_off, the_row, src->pitch_y, src_w, src->height, tmp);
-						}
-						the_row = src_row - 1;
-					}
-					rows = flip ? tmp : tmp + src_w * 4;
-				} else {
-					if (flip) the_row = src->height-2 - the_row;
+				/*lines are converted by pairs sharing the same chroma*/
+				s32 pair = the_row & ~1;
+				if (pair != yuv_pair) {
+					u32 load_row = flip ? src->height-2 - pair : pair;
 					if (yuv_planar_type==1) {
-						load_line_yv12(src->video_buffer, x_off, the_row, src->pitch_y, src_w, src->height, tmp);
+						load_line_yv12(src->video_buffer, x_off, load_row, src->pitch_y, src_w, src->height, tmp);
 					} else {
-						load_line_yuva(src->video_buffer, x_off, the_row, src->pitch_y, src_w, src->height, tmp);
+						load_line_yuva(src->video_buffer, x_off, load_row, src->pitch_y, src_w, src->height, tmp);
 					}
-					yuv_init = 1;
-					rows = flip ? tmp + src_w * 4 : tmp;
+					yuv_pair = pair;
 
 					if (cmat) {
 						for (i=0; i<2*src_w; i++) {
@@ -1001,6 +1356,7 @@ GF_Err gf_stretch_bits(GF_VideoSurface *dst, GF_VideoSurface *src, GF_Window *ds
 						}
 					}
 				}
+				rows = ((the_row % 2) ^ flip) ? tmp + src_w * 4 : tmp;
 			} else {
 				if (flip) the_row = src->height-1 - the_row;
 				load_line((u8*)src->video_buffer, x_off, the_row, src->pitch_y, src_w, tmp);
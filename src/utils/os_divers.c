@@ -121,6 +121,21 @@ void gf_sleep(u32 ms)
 #endif
 }
 
+GF_EXPORT
+u32 gf_sys_get_cpu_count()
+{
+#if defined(WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors ? (u32) info.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	long nb = sysconf(_SC_NPROCESSORS_ONLN);
+	return (nb > 0) ? (u32) nb : 1;
+#else
+	return 1;
+#endif
+}
+
 #ifndef gettimeofday
 #ifdef _WIN32_WCE
 
@@ -22,6 +22,10 @@
  *
  */
 
+/*needed for sendmmsg/recvmmsg declarations*/
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
 
 #if defined(WIN32) || defined(_WIN32_WCE)
 
@@ -102,6 +106,17 @@ static int wsa_init = 0;
 
 #include <gpac/network.h>
 
+/*several datagrams per system call*/
+#if defined(__linux__) && defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 14)))
+#define GPAC_HAS_MMSG
+#endif
+
+/*socket readiness notification scaling with the number of sockets*/
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define GPAC_HAS_EPOLL
+#endif
+
 /*not defined on solaris*/
 #if !defined(INADDR_NONE)
 # if (defined(sun) && defined(__SVR4))
@@ -162,7 +177,9 @@ enum
 	GF_SOCK_IS_LISTENING = 1<<13,
 	/*socket is bound to a specific dest (server) or source (client) */
 	GF_SOCK_HAS_PEER = 1<<14,
-	GF_SOCK_IS_MIP = 1<<15
+	GF_SOCK_IS_MIP = 1<<15,
+	/*kernel reception timestamps are on*/
+	GF_SOCK_HAS_TIMESTAMPS = 1<<16
 };
 
 struct __tag_socket
@@ -854,6 +871,106 @@ GF_Err gf_sk_send(GF_Socket *sock, const char *buffer, u32 length)
 	return GF_OK;
 }
 
+/*max number of datagrams handled per system call*/
+#define GF_SK_MAX_MMSG	64
+/*max number of 1 ms waits for room in the send buffer before giving up with GF_IP_SOCK_WOULD_BLOCK*/
+#define GF_SK_MMSG_MAX_RETRY	10
+
+GF_EXPORT
+GF_Err gf_sk_send_multiple(GF_Socket *sock, const char **buffers, const u32 *lengths, u32 nb_buffers, u32 *nb_sent)
+{
+	GF_Err e;
+	u32 i;
+#ifdef GPAC_HAS_MMSG
+	struct mmsghdr msgs[GF_SK_MAX_MMSG];
+	struct iovec iovs[GF_SK_MAX_MMSG];
+	s32 ready, res;
+	u32 nb_msgs, done, nb_retry;
+	struct timeval timeout;
+	fd_set Group;
+#endif
+
+	if (nb_sent) *nb_sent = 0;
+	if (!sock || !sock->socket) return GF_BAD_PARAM;
+
+	e = GF_OK;
+#ifdef GPAC_HAS_MMSG
+	/*stream sockets may send partially, they use the regular path*/
+	if (!(sock->flags & GF_SOCK_IS_TCP)) {
+		done = nb_retry = 0;
+		while (done < nb_buffers) {
+			FD_ZERO(&Group);
+			FD_SET(sock->socket, &Group);
+			timeout.tv_sec = 0;
+			timeout.tv_usec = SOCK_MICROSEC_WAIT;
+			ready = select(sock->socket+1, NULL, &Group, NULL, &timeout);
+			if (ready == SOCKET_ERROR) {
+				switch (LASTSOCKERROR) {
+				case EAGAIN:
+					e = GF_IP_SOCK_WOULD_BLOCK;
+					break;
+				default:
+					e = GF_IP_NETWORK_FAILURE;
+					break;
+				}
+				break;
+			}
+			if (!ready || !FD_ISSET(sock->socket, &Group)) {
+				e = GF_IP_NETWORK_EMPTY;
+				break;
+			}
+
+			nb_msgs = nb_buffers - done;
+			if (nb_msgs > GF_SK_MAX_MMSG) nb_msgs = GF_SK_MAX_MMSG;
+			memset(msgs, 0, sizeof(struct mmsghdr)*nb_msgs);
+			for (i=0; i<nb_msgs; i++) {
+				iovs[i].iov_base = (void *) buffers[done+i];
+				iovs[i].iov_len = lengths[done+i];
+				msgs[i].msg_hdr.msg_iov = &iovs[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+				if (sock->flags & GF_SOCK_HAS_PEER) {
+					msgs[i].msg_hdr.msg_name = &sock->dest_addr;
+					msgs[i].msg_hdr.msg_namelen = sock->dest_addr_len;
+				}
+			}
+			res = sendmmsg(sock->socket, msgs, nb_msgs, 0);
+			if (res == SOCKET_ERROR) {
+				switch (LASTSOCKERROR) {
+				/*the send buffer is full: give it some time to drain, select may report the socket writable right away*/
+				case EAGAIN:
+					if (nb_retry < GF_SK_MMSG_MAX_RETRY) {
+						nb_retry++;
+						gf_sleep(1);
+						continue;
+					}
+					e = GF_IP_SOCK_WOULD_BLOCK;
+					break;
+				case ENOTCONN:
+				case ECONNRESET:
+					e = GF_IP_CONNECTION_CLOSED;
+					break;
+				default:
+					e = GF_IP_NETWORK_FAILURE;
+					break;
+				}
+				break;
+			}
+			done += res;
+			nb_retry = 0;
+		}
+		if (nb_sent) *nb_sent = done;
+		return e;
+	}
+#endif
+
+	for (i=0; i<nb_buffers; i++) {
+		e = gf_sk_send(sock, buffers[i], lengths[i]);
+		if (e) break;
+	}
+	if (nb_sent) *nb_sent = i;
+	return e;
+}
+
 
 u32 gf_sk_is_multicast_address(const char *multi_IPAdd)
 {
@@ -1147,6 +1264,156 @@ GF_Err gf_sk_receive(GF_Socket *sock, char *buffer, u32 length, u32 startFrom, u
 	return GF_OK;
 }
 
+/*reception time in microseconds since 1970, when the kernel does not give it*/
+static u64 gf_sk_get_receive_time()
+{
+	struct timeval now;
+#ifdef WIN32
+	s32 gettimeofday(struct timeval *tp, void *tz);
+#endif
+	gettimeofday(&now, NULL);
+	return ((u64) now.tv_sec) * 1000000 + now.tv_usec;
+}
+
+/*checks without waiting whether data can be read*/
+static Bool gf_sk_has_pending_data(GF_Socket *sock)
+{
+#ifndef __SYMBIAN32__
+	struct timeval timeout;
+	fd_set Group;
+	FD_ZERO(&Group);
+	FD_SET(sock->socket, &Group);
+	timeout.tv_sec = 0;
+	timeout.tv_usec = 0;
+	if (select(sock->socket+1, &Group, NULL, NULL, &timeout) <= 0) return 0;
+	return FD_ISSET(sock->socket, &Group) ? 1 : 0;
+#else
+	return 1;
+#endif
+}
+
+GF_EXPORT
+GF_Err gf_sk_receive_multiple(GF_Socket *sock, char **buffers, const u32 *lengths, u32 nb_buffers, u32 *sizes, u32 *nb_received, u64 *timestamps)
+{
+	GF_Err e;
+	u32 i;
+#ifdef GPAC_HAS_MMSG
+	struct mmsghdr msgs[GF_SK_MAX_MMSG];
+	struct iovec iovs[GF_SK_MAX_MMSG];
+	char ctrl[GF_SK_MAX_MMSG][CMSG_SPACE(sizeof(struct timeval))];
+	s32 ready, res;
+	u32 nb_msgs;
+	struct timeval timeout;
+	fd_set Group;
+#endif
+
+	*nb_received = 0;
+	if (!sock || !sock->socket || !nb_buffers) return GF_BAD_PARAM;
+
+#ifdef GPAC_HAS_MMSG
+	/*stream sockets have no datagram boundaries, they use the regular path*/
+	if (!(sock->flags & GF_SOCK_IS_TCP)) {
+		if (timestamps && !(sock->flags & GF_SOCK_HAS_TIMESTAMPS)) {
+			s32 on = 1;
+			if (setsockopt(sock->socket, SOL_SOCKET, SO_TIMESTAMP, (char *) &on, sizeof(on)) == 0) {
+				sock->flags |= GF_SOCK_HAS_TIMESTAMPS;
+			}
+		}
+
+		//can we read?
+		FD_ZERO(&Group);
+		FD_SET(sock->socket, &Group);
+		timeout.tv_sec = 0;
+		timeout.tv_usec = SOCK_MICROSEC_WAIT;
+		ready = select(sock->socket+1, &Group, NULL, NULL, &timeout);
+		if (ready == SOCKET_ERROR) {
+			switch (LASTSOCKERROR) {
+			case EBADF:
+				return GF_IP_CONNECTION_CLOSED;
+			case EAGAIN:
+				return GF_IP_SOCK_WOULD_BLOCK;
+			case EINTR:
+				return GF_IP_NETWORK_EMPTY;
+			default:
+				return GF_IP_NETWORK_FAILURE;
+			}
+		}
+		if (!ready || !FD_ISSET(sock->socket, &Group)) return GF_IP_NETWORK_EMPTY;
+
+		nb_msgs = (nb_buffers > GF_SK_MAX_MMSG) ? GF_SK_MAX_MMSG : nb_buffers;
+		memset(msgs, 0, sizeof(struct mmsghdr)*nb_msgs);
+		for (i=0; i<nb_msgs; i++) {
+			iovs[i].iov_base = buffers[i];
+			iovs[i].iov_len = lengths[i];
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			if (sock->flags & GF_SOCK_HAS_PEER) {
+				msgs[i].msg_hdr.msg_name = &sock->dest_addr;
+				msgs[i].msg_hdr.msg_namelen = sizeof(sock->dest_addr);
+			}
+			if (timestamps) {
+				msgs[i].msg_hdr.msg_control = ctrl[i];
+				msgs[i].msg_hdr.msg_controllen = sizeof(ctrl[i]);
+			}
+		}
+		/*only the datagrams already queued, select said there is at least one*/
+		res = recvmmsg(sock->socket, msgs, nb_msgs, MSG_DONTWAIT, NULL);
+		if (res == SOCKET_ERROR) {
+			res = LASTSOCKERROR;
+			switch (res) {
+			case EAGAIN:
+				return GF_IP_SOCK_WOULD_BLOCK;
+			case ENOTCONN:
+			case ECONNRESET:
+			case ECONNABORTED:
+				return GF_IP_CONNECTION_CLOSED;
+			default:
+				GF_LOG(GF_LOG_ERROR, GF_LOG_NETWORK, ("[socket] error reading - socket error %d\n",  res));
+				return GF_IP_NETWORK_FAILURE;
+			}
+		}
+		if (!res) return GF_IP_NETWORK_EMPTY;
+		if (sock->flags & GF_SOCK_HAS_PEER) sock->dest_addr_len = msgs[res-1].msg_hdr.msg_namelen;
+
+		for (i=0; i<(u32) res; i++) {
+			sizes[i] = msgs[i].msg_len;
+			/*never hand out a partial datagram*/
+			if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				GF_LOG(GF_LOG_WARNING, GF_LOG_NETWORK, ("[socket] datagram larger than the %d bytes reception buffer, dropped\n", lengths[i]));
+				sizes[i] = 0;
+				if (timestamps) timestamps[i] = 0;
+				continue;
+			}
+			if (timestamps) {
+				struct cmsghdr *cmsg;
+				timestamps[i] = 0;
+				for (cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+					if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_TIMESTAMP)) {
+						struct timeval tv;
+						memcpy(&tv, CMSG_DATA(cmsg), sizeof(struct timeval));
+						timestamps[i] = ((u64) tv.tv_sec) * 1000000 + tv.tv_usec;
+					}
+				}
+				if (!timestamps[i]) timestamps[i] = gf_sk_get_receive_time();
+			}
+		}
+		*nb_received = res;
+		return GF_OK;
+	}
+#endif
+
+	/*one datagram per call, stop at the first empty read. Only the first read waits for data*/
+	e = GF_OK;
+	for (i=0; i<nb_buffers; i++) {
+		if (i && !gf_sk_has_pending_data(sock)) break;
+		e = gf_sk_receive(sock, buffers[i], lengths[i], 0, &sizes[i]);
+		if (e || !sizes[i]) break;
+		if (timestamps) timestamps[i] = gf_sk_get_receive_time();
+		(*nb_received)++;
+	}
+	return (*nb_received) ? GF_OK : e;
+}
+
 
 GF_Err gf_sk_listen(GF_Socket *sock, u32 MaxConnection)
 {
@@ -1283,8 +1550,9 @@ GF_Err gf_sk_get_remote_address(GF_Socket *sock, char *buf)
 {
 #ifdef GPAC_HAS_IPV6
 	char clienthost[NI_MAXHOST];
- 	struct sockaddr_in6 * addrptr = (struct sockaddr_in6 *)(&sock->dest_addr_len);
-	if (!sock || sock->socket) return GF_BAD_PARAM;
+ 	struct sockaddr_in6 * addrptr;
+	if (!sock || !sock->socket) return GF_BAD_PARAM;
+	addrptr = (struct sockaddr_in6 *)(&sock->dest_addr);
 	if (getnameinfo((struct sockaddr *)addrptr, sock->dest_addr_len, clienthost, sizeof(clienthost), NULL, 0, NI_NUMERICHOST))
 		return GF_IP_ADDRESS_NOT_FOUND;
 	strcpy(buf, clienthost);
@@ -1504,3 +1772,157 @@ GF_Err gf_sk_send_wait(GF_Socket *sock, const char *buffer, u32 length, u32 Seco
 	return GF_OK;
 }
 
+
+struct __tag_sock_poll
+{
+	u32 max_sockets, nb_sockets;
+	/*watched sockets and their user data - only browsed by the select fallback*/
+	GF_Socket **socks;
+	void **udtas;
+#ifdef GPAC_HAS_EPOLL
+	s32 epfd;
+	struct epoll_event *events;
+#endif
+};
+
+GF_EXPORT
+GF_SockPoll *gf_sk_poll_new(u32 max_sockets)
+{
+	GF_SockPoll *poll;
+	if (!max_sockets) return NULL;
+#ifndef GPAC_HAS_EPOLL
+	if (max_sockets > FD_SETSIZE) max_sockets = FD_SETSIZE;
+#endif
+	GF_SAFEALLOC(poll, GF_SockPoll);
+	if (!poll) return NULL;
+	poll->max_sockets = max_sockets;
+	poll->socks = (GF_Socket **) gf_malloc(sizeof(GF_Socket *) * max_sockets);
+	poll->udtas = (void **) gf_malloc(sizeof(void *) * max_sockets);
+#ifdef GPAC_HAS_EPOLL
+	poll->events = (struct epoll_event *) gf_malloc(sizeof(struct epoll_event) * max_sockets);
+	poll->epfd = epoll_create(max_sockets);
+	if (poll->epfd < 0) {
+		GF_LOG(GF_LOG_ERROR, GF_LOG_NETWORK, ("[socket] cannot create epoll instance (error %d)\n", LASTSOCKERROR));
+		gf_sk_poll_del(poll);
+		return NULL;
+	}
+#endif
+	return poll;
+}
+
+GF_EXPORT
+void gf_sk_poll_del(GF_SockPoll *poll)
+{
+	if (!poll) return;
+#ifdef GPAC_HAS_EPOLL
+	if (poll->epfd >= 0) close(poll->epfd);
+	gf_free(poll->events);
+#endif
+	gf_free(poll->socks);
+	gf_free(poll->udtas);
+	gf_free(poll);
+}
+
+GF_EXPORT
+GF_Err gf_sk_poll_add(GF_SockPoll *poll, GF_Socket *sock, void *udta)
+{
+	u32 i;
+	if (!poll || !sock || !sock->socket) return GF_BAD_PARAM;
+	for (i=0; i<poll->nb_sockets; i++) {
+		if (poll->socks[i] == sock) return GF_BAD_PARAM;
+	}
+	if (poll->nb_sockets == poll->max_sockets) return GF_OUT_OF_MEM;
+#ifdef GPAC_HAS_EPOLL
+	{
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(struct epoll_event));
+		ev.events = EPOLLIN;
+		ev.data.ptr = udta;
+		if (epoll_ctl(poll->epfd, EPOLL_CTL_ADD, sock->socket, &ev) < 0) {
+			GF_LOG(GF_LOG_ERROR, GF_LOG_NETWORK, ("[socket] cannot add socket to epoll (error %d)\n", LASTSOCKERROR));
+			return GF_IP_NETWORK_FAILURE;
+		}
+	}
+#endif
+	poll->socks[poll->nb_sockets] = sock;
+	poll->udtas[poll->nb_sockets] = udta;
+	poll->nb_sockets++;
+	return GF_OK;
+}
+
+GF_EXPORT
+GF_Err gf_sk_poll_remove(GF_SockPoll *poll, GF_Socket *sock)
+{
+	u32 i;
+	if (!poll || !sock) return GF_BAD_PARAM;
+	for (i=0; i<poll->nb_sockets; i++) {
+		if (poll->socks[i] != sock) continue;
+#ifdef GPAC_HAS_EPOLL
+		{
+			/*non-NULL event for kernels before 2.6.9*/
+			struct epoll_event ev;
+			memset(&ev, 0, sizeof(struct epoll_event));
+			epoll_ctl(poll->epfd, EPOLL_CTL_DEL, sock->socket, &ev);
+		}
+#endif
+		poll->nb_sockets--;
+		poll->socks[i] = poll->socks[poll->nb_sockets];
+		poll->udtas[i] = poll->udtas[poll->nb_sockets];
+		return GF_OK;
+	}
+	return GF_BAD_PARAM;
+}
+
+GF_EXPORT
+GF_Err gf_sk_poll_wait(GF_SockPoll *poll, u32 timeout_ms, void **udtas, u32 max_udtas, u32 *nb_ready)
+{
+	s32 res;
+#ifdef GPAC_HAS_EPOLL
+	s32 i;
+#else
+	u32 i;
+	SOCKET max_fd;
+	struct timeval timeout;
+	fd_set Group;
+#endif
+
+	*nb_ready = 0;
+	if (!poll || !udtas || !max_udtas) return GF_BAD_PARAM;
+
+#ifdef GPAC_HAS_EPOLL
+	if (max_udtas > poll->max_sockets) max_udtas = poll->max_sockets;
+	res = epoll_wait(poll->epfd, poll->events, max_udtas, timeout_ms);
+	if (res < 0) {
+		if (LASTSOCKERROR == EINTR) return GF_IP_NETWORK_EMPTY;
+		GF_LOG(GF_LOG_ERROR, GF_LOG_NETWORK, ("[socket] cannot wait on epoll (error %d)\n", LASTSOCKERROR));
+		return GF_IP_NETWORK_FAILURE;
+	}
+	for (i=0; i<res; i++) udtas[i] = poll->events[i].data.ptr;
+	*nb_ready = res;
+#else
+	if (!poll->nb_sockets) {
+		gf_sleep(timeout_ms);
+		return GF_IP_NETWORK_EMPTY;
+	}
+	FD_ZERO(&Group);
+	max_fd = 0;
+	for (i=0; i<poll->nb_sockets; i++) {
+		FD_SET(poll->socks[i]->socket, &Group);
+		if (poll->socks[i]->socket > max_fd) max_fd = poll->socks[i]->socket;
+	}
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+	res = select(max_fd+1, &Group, NULL, NULL, &timeout);
+	if (res == SOCKET_ERROR) {
+		if (LASTSOCKERROR == EINTR) return GF_IP_NETWORK_EMPTY;
+		GF_LOG(GF_LOG_ERROR, GF_LOG_NETWORK, ("[socket] cannot select (error %d)\n", LASTSOCKERROR));
+		return GF_IP_NETWORK_FAILURE;
+	}
+	for (i=0; (i<poll->nb_sockets) && (*nb_ready < max_udtas); i++) {
+		if (!FD_ISSET(poll->socks[i]->socket, &Group)) continue;
+		udtas[*nb_ready] = poll->udtas[i];
+		(*nb_ready)++;
+	}
+#endif
+	return (*nb_ready) ? GF_OK : GF_IP_NETWORK_EMPTY;
+}